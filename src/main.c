@@ -3,6 +3,16 @@
 
 #include "renderer/vulkan_context.h"
 #include "renderer/pipeline.h"
+#include "renderer/frame.h"
+#include "renderer/pipeline_builder.h"
+#include "renderer/pipeline_registry.h"
+#include "renderer/spirv_reflect.h"
+#include "renderer/frame_governor.h"
+#include "renderer/render_graph.h"
+#include "renderer/parallel_recorder.h"
+#include "renderer/mesh.h"
+#include "renderer/gpu_culling.h"
+#include "renderer/depth_pyramid.h"
 
 #include <string.h>
 #include <stdbool.h>
@@ -14,8 +24,71 @@
 */
 #define SCREEN_WIDTH 800
 #define SCREEN_HEIGHT 600
+#define HEADLESS_TARGET_COUNT 2
+#define HEADLESS_FRAME_COUNT 1000
+#define PIPELINE_CACHE_SAVE_INTERVAL_NS 300000000000ULL // 5 minutes
 const char *WINDOW_TITLE = "Vulkan Renderer";
 
+typedef struct {
+    bool headless;
+    uint32_t frame_count;
+    uint32_t frames_in_flight; // 0 takes the present policy default
+    bool has_present_policy;
+    PresentPolicyProfile present_policy;
+    GovernorMode governor_mode;
+    double max_fps; // 0 follows the monitor refresh rate
+    const char *mesh_path;
+    bool gpu_culling;
+} AppOptions;
+
+AppOptions parse_app_options(int argc, char **argv) {
+    AppOptions options;
+    options.headless = false;
+    options.frame_count = HEADLESS_FRAME_COUNT;
+    options.frames_in_flight = 0;
+    options.has_present_policy = false;
+    options.governor_mode = GOVERNOR_FPS_CAP;
+    options.max_fps = 0.0;
+    options.mesh_path = get_mesh_path();
+    options.gpu_culling = true;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--headless") == 0) {
+            options.headless = true;
+        } else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            options.frame_count = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--frames-in-flight") == 0 && i + 1 < argc) {
+            options.frames_in_flight = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--present-policy") == 0 && i + 1 < argc) {
+            options.has_present_policy = parse_present_policy_profile(argv[++i], &options.present_policy);
+        } else if (strcmp(argv[i], "--governor") == 0 && i + 1 < argc) {
+            parse_governor_mode(argv[++i], &options.governor_mode);
+        } else if (strcmp(argv[i], "--max-fps") == 0 && i + 1 < argc) {
+            options.max_fps = strtod(argv[++i], NULL);
+            options.governor_mode = GOVERNOR_FPS_CAP;
+        } else if (strcmp(argv[i], "--mesh") == 0 && i + 1 < argc) {
+            options.mesh_path = argv[++i];
+        } else if (strcmp(argv[i], "--no-gpu-culling") == 0) {
+            options.gpu_culling = false;
+        } else {
+            fprintf(stderr, "unknown option: %s\n", argv[i]);
+        }
+    }
+
+    // Same binary serves interactive and batch runs, the profile picks the trade-off
+    if (!options.has_present_policy) {
+        options.present_policy = get_default_present_policy_profile(options.headless);
+        if (options.governor_mode == GOVERNOR_VSYNC && !options.headless) {
+            options.present_policy = PRESENT_POLICY_POWER_SAVE;
+        }
+    }
+    if (options.frames_in_flight == 0) {
+        options.frames_in_flight = get_present_policy(options.present_policy)->frames_in_flight;
+    }
+
+    return options;
+}
+
 /*
 * Window
 */
@@ -52,10 +125,685 @@ void debug_set_title(GLFWwindow *window, VkPhysicalDevice physical_device) {
     glfwSetWindowTitle(window, debug_title);
 }
 
+/*
+* Rendering
+*/
+// Matches the vertex shader's push constant block
+typedef struct {
+    float position_scale[4];
+    float position_offset[4];
+} MeshTransform;
+
+typedef struct {
+    VkRenderPass render_pass; // pipeline compatibility only, the graph owns the pass it records
+    RenderGraph *graph;
+    uint32_t render_target;
+    uint32_t depth;
+    uint32_t draw_records;
+    uint32_t draw_visibility;
+    uint32_t draw_commands;
+    uint32_t draw_count;
+    uint32_t depth_pyramid;
+    VkFormat depth_format;
+    VkPipelineLayout pipeline_layout;
+    ThreadPool *thread_pool;
+    ParallelRecorder *recorder;
+    PipelineBuilder *pipeline_builder;
+    PipelineRegistry *pipeline_registry;
+    ShaderPack *shader_pack;
+    PipelineFuture *pipeline;
+    Mesh *mesh;
+    MeshTransform mesh_transform;
+    GpuCuller *culler; // NULL draws every submesh from the CPU
+    DepthPyramid *pyramid; // with the culler only, sized for the render targets
+    FrameContext *frame_ctx;
+    FrameGovernor *governor; // windowed only
+    bool framebuffer_resized;
+    bool pipelines_settled; // the startup compiles have all finished and were saved
+    uint64_t pipeline_cache_saved_ns;
+
+    // Shared with the recording threads for the pass being recorded
+    VkPipeline draw_pipeline;
+    VkExtent2D draw_extent;
+    CullPhase draw_phase;
+    bool pyramid_built; // the late cull only tests occlusion against a pyramid from this frame
+} RenderState;
+
+// Runs on the recording threads, each secondary starts without any bound state
+void record_main_draws(VkCommandBuffer command_buffer, uint32_t first, uint32_t count, void *user_data) {
+    RenderState *state = user_data;
+    vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, state->draw_pipeline);
+
+    VkViewport viewport = { 0.0f, 0.0f, (float)state->draw_extent.width, (float)state->draw_extent.height, 0.0f, 1.0f };
+    vkCmdSetViewport(command_buffer, 0, 1, &viewport);
+
+    VkRect2D scissor = { {0, 0}, state->draw_extent };
+    vkCmdSetScissor(command_buffer, 0, 1, &scissor);
+
+    bind_mesh(command_buffer, state->mesh);
+    vkCmdPushConstants(command_buffer, state->pipeline_layout, VK_SHADER_STAGE_VERTEX_BIT, 0,
+        sizeof(MeshTransform), &state->mesh_transform);
+    if (state->culler != NULL && state->culler->culled) {
+        record_cull_draws(command_buffer, state->culler, state->frame_ctx->frame_index, state->draw_phase);
+        return;
+    }
+    for (uint32_t i = first; i < first + count; ++i) {
+        draw_submesh(command_buffer, state->mesh, i);
+    }
+}
+
+bool record_main_pass(VkCommandBuffer command_buffer, const RenderGraphPass *pass, void *user_data) {
+    RenderState *state = user_data;
+
+    // Draws are skipped until their pipeline finishes compiling
+    state->draw_pipeline = get_ready_pipeline(state->pipeline, VK_NULL_HANDLE);
+    if (state->draw_pipeline == VK_NULL_HANDLE) { return true; }
+    state->draw_extent = pass->extent;
+
+    // GPU culled draws are a handful of indirect calls, not worth splitting across threads.
+    // Without them every submesh is drawn from the CPU in the early pass and the late pass has nothing left
+    uint32_t item_count = state->mesh->submesh_count;
+    if (state->culler != NULL && state->culler->culled) {
+        item_count = 1;
+    } else if (state->draw_phase == CULL_PHASE_LATE) {
+        item_count = 0;
+    }
+    VkCommandBufferInheritanceInfo inheritance;
+    get_graph_pass_inheritance(pass, &inheritance);
+    return record_parallel_commands(state->recorder, command_buffer, &inheritance, item_count, record_main_draws, state);
+}
+
+bool record_main_early_pass(VkCommandBuffer command_buffer, const RenderGraphPass *pass, void *user_data) {
+    RenderState *state = user_data;
+    state->draw_phase = CULL_PHASE_EARLY;
+    return record_main_pass(command_buffer, pass, user_data);
+}
+
+bool record_main_late_pass(VkCommandBuffer command_buffer, const RenderGraphPass *pass, void *user_data) {
+    RenderState *state = user_data;
+    state->draw_phase = CULL_PHASE_LATE;
+    return record_main_pass(command_buffer, pass, user_data);
+}
+
+bool record_cull_reset_pass(VkCommandBuffer command_buffer, const RenderGraphPass *pass, void *user_data) {
+    RenderState *state = user_data;
+    record_cull_reset(command_buffer, state->culler, state->frame_ctx->frame_index);
+    return true;
+}
+
+bool record_cull_early_pass(VkCommandBuffer command_buffer, const RenderGraphPass *pass, void *user_data) {
+    RenderState *state = user_data;
+    record_cull_dispatch(command_buffer, state->culler, state->frame_ctx->frame_index, CULL_PHASE_EARLY, false);
+    return true;
+}
+
+bool record_depth_pyramid_pass(VkCommandBuffer command_buffer, const RenderGraphPass *pass, void *user_data) {
+    RenderState *state = user_data;
+    state->pyramid_built = record_depth_pyramid(command_buffer, state->pyramid);
+    return true;
+}
+
+bool record_cull_late_pass(VkCommandBuffer command_buffer, const RenderGraphPass *pass, void *user_data) {
+    RenderState *state = user_data;
+    record_cull_dispatch(command_buffer, state->culler, state->frame_ctx->frame_index, CULL_PHASE_LATE, state->pyramid_built);
+    return true;
+}
+
+// Centers the mesh and scales its largest half extent to just inside clip space
+float get_mesh_fit(const Mesh *mesh, float center[3]) {
+    float extent = 0.0f;
+    for (int axis = 0; axis < 3; ++axis) {
+        float half = (mesh->bounds_max[axis] - mesh->bounds_min[axis]) * 0.5f;
+        extent = half > extent ? half : extent;
+        center[axis] = mesh->bounds_min[axis] + half;
+    }
+    return extent > 0.0f ? 0.9f / extent : 1.0f;
+}
+
+// The mesh's dequantization is folded in so the shader does a single multiply add
+void compute_mesh_transform(const Mesh *mesh, MeshTransform *transform) {
+    float center[3];
+    float fit = get_mesh_fit(mesh, center);
+    for (int axis = 0; axis < 3; ++axis) {
+        transform->position_scale[axis] = mesh->position_scale[axis] * fit;
+        transform->position_offset[axis] = (mesh->position_offset[axis] - center[axis]) * fit;
+    }
+    transform->position_scale[3] = 0.0f;
+    transform->position_offset[3] = 0.0f;
+}
+
+// Same mapping as the vertex shader from decoded positions, column major, for culling in model space
+void compute_mesh_clip_matrix(const Mesh *mesh, float clip_from_model[16]) {
+    float center[3];
+    float fit = get_mesh_fit(mesh, center);
+    memset(clip_from_model, 0, 16 * sizeof(float));
+    clip_from_model[0] = fit;
+    clip_from_model[5] = -fit;
+    clip_from_model[10] = -0.5f * fit;
+    clip_from_model[12] = -center[0] * fit;
+    clip_from_model[13] = center[1] * fit;
+    clip_from_model[14] = 0.5f + 0.5f * center[2] * fit;
+    clip_from_model[15] = 1.0f;
+}
+
+// Imports the culler's buffers and the pyramid, the passes that use them are added in frame order
+bool import_cull_resources(RenderGraph *graph, RenderState *state) {
+    GpuCuller *culler = state->culler;
+    state->draw_records = import_graph_buffer(graph, "draw_records", culler->record_buffer,
+        culler->record_count * sizeof(GpuDrawRecord));
+    state->draw_visibility = import_graph_buffer(graph, "draw_visibility", culler->visibility_buffer,
+        culler->record_count * sizeof(uint32_t));
+    state->draw_commands = import_graph_buffer(graph, "draw_commands", culler->frames[0].command_buffer,
+        CULL_PHASE_COUNT * culler->record_count * sizeof(VkDrawIndexedIndirectCommand));
+    state->draw_count = import_graph_buffer(graph, "draw_count", culler->frames[0].count_buffer,
+        CULL_PHASE_COUNT * sizeof(uint32_t));
+
+    // Rebuilt from scratch every frame, nothing to wait for but the previous frame's cull reading it
+    GraphImageImport pyramid;
+    pyramid.image = state->pyramid->image;
+    pyramid.view = state->pyramid->view;
+    pyramid.format = DEPTH_PYRAMID_FORMAT;
+    pyramid.extent = state->pyramid->extent;
+    pyramid.initial_layout = VK_IMAGE_LAYOUT_UNDEFINED;
+    pyramid.initial_stage = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+    pyramid.final_layout = VK_IMAGE_LAYOUT_UNDEFINED;
+    state->depth_pyramid = import_graph_image(graph, "depth_pyramid", &pyramid);
+
+    return state->draw_records != GRAPH_RESOURCE_NONE && state->draw_visibility != GRAPH_RESOURCE_NONE
+        && state->draw_commands != GRAPH_RESOURCE_NONE && state->draw_count != GRAPH_RESOURCE_NONE
+        && state->depth_pyramid != GRAPH_RESOURCE_NONE;
+}
+
+// Both phases cull into their half of this frame's commands, each pass then draws its half indirectly
+bool add_cull_pass(RenderGraph *graph, RenderState *state, const char *name, GraphPassCallback callback, CullPhase phase) {
+    uint32_t pass = add_graph_pass(graph, name, GRAPH_PASS_COMPUTE, callback, state);
+    if (pass == GRAPH_RESOURCE_NONE) { return false; }
+
+    GraphAccess visibility_access = phase == CULL_PHASE_EARLY ? GRAPH_ACCESS_STORAGE_READ : GRAPH_ACCESS_STORAGE_WRITE;
+    bool used = use_graph_resource(graph, pass, state->draw_records, GRAPH_ACCESS_STORAGE_READ)
+        && use_graph_resource(graph, pass, state->draw_visibility, visibility_access)
+        && use_graph_resource(graph, pass, state->draw_commands, GRAPH_ACCESS_STORAGE_WRITE)
+        && use_graph_resource(graph, pass, state->draw_count, GRAPH_ACCESS_STORAGE_WRITE);
+    return used && (phase == CULL_PHASE_EARLY || use_graph_resource(graph, pass, state->depth_pyramid, GRAPH_ACCESS_SAMPLED));
+}
+
+// The first main pass clears, the late one keeps drawing into the same color and depth
+bool add_main_pass(RenderGraph *graph, RenderState *state, const char *name, GraphPassCallback callback, bool clear) {
+    VkClearValue clear_color = {{{0.0f, 0.0f, 0.0f, 1.0f}}};
+    VkClearValue clear_depth;
+    clear_depth.depthStencil.depth = 1.0f;
+    clear_depth.depthStencil.stencil = 0;
+
+    uint32_t pass = add_graph_pass(graph, name, GRAPH_PASS_GRAPHICS, callback, state);
+    if (pass == GRAPH_RESOURCE_NONE) { return false; }
+
+    set_graph_pass_secondary(graph, pass);
+    if (!use_graph_resource(graph, pass, state->render_target, GRAPH_ACCESS_COLOR_ATTACHMENT)
+        || !use_graph_resource(graph, pass, state->depth, GRAPH_ACCESS_DEPTH_ATTACHMENT)) {
+        return false;
+    }
+    if (clear && (!clear_graph_attachment(graph, pass, state->render_target, clear_color)
+        || !clear_graph_attachment(graph, pass, state->depth, clear_depth))) {
+        return false;
+    }
+
+    return state->culler == NULL || (use_graph_resource(graph, pass, state->draw_commands, GRAPH_ACCESS_INDIRECT)
+        && use_graph_resource(graph, pass, state->draw_count, GRAPH_ACCESS_INDIRECT));
+}
+
+// Two phase occlusion culling: last frame's visible set is drawn first, reduced into the depth pyramid,
+// and everything else is tested against it and drawn by the late pass
+bool add_culled_passes(RenderGraph *graph, RenderState *state) {
+    uint32_t reset_pass = add_graph_pass(graph, "reset_draw_count", GRAPH_PASS_TRANSFER, record_cull_reset_pass, state);
+    if (reset_pass == GRAPH_RESOURCE_NONE
+        || !use_graph_resource(graph, reset_pass, state->draw_count, GRAPH_ACCESS_TRANSFER_DST)
+        || !add_cull_pass(graph, state, "cull_early", record_cull_early_pass, CULL_PHASE_EARLY)
+        || !add_main_pass(graph, state, "main_early", record_main_early_pass, true)) {
+        return false;
+    }
+
+    uint32_t pyramid_pass = add_graph_pass(graph, "depth_pyramid", GRAPH_PASS_COMPUTE, record_depth_pyramid_pass, state);
+    if (pyramid_pass == GRAPH_RESOURCE_NONE
+        || !use_graph_resource(graph, pyramid_pass, state->depth, GRAPH_ACCESS_SAMPLED)
+        || !use_graph_resource(graph, pyramid_pass, state->depth_pyramid, GRAPH_ACCESS_STORAGE_WRITE)) {
+        return false;
+    }
+
+    return add_cull_pass(graph, state, "cull_late", record_cull_late_pass, CULL_PHASE_LATE)
+        && add_main_pass(graph, state, "main_late", record_main_late_pass, false);
+}
+
+// Rebuilt with the swapchain, the render target handles are swapped in every frame
+RenderGraph *create_frame_graph(VulkanContext *v_ctx, RenderState *state) {
+    RenderGraph *graph = create_render_graph(v_ctx->device, v_ctx->allocator);
+    if (graph == NULL) { return NULL; }
+
+    // Windowed targets are released by the acquire semaphore, headless ones are left ready to be copied out
+    GraphImageImport target;
+    target.image = VK_NULL_HANDLE;
+    target.view = VK_NULL_HANDLE;
+    target.format = get_render_format(v_ctx);
+    target.extent = get_render_extent(v_ctx);
+    target.initial_layout = VK_IMAGE_LAYOUT_UNDEFINED;
+    target.initial_stage = v_ctx->headless ? VK_PIPELINE_STAGE_ALL_COMMANDS_BIT : VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    target.final_layout = v_ctx->headless ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    state->render_target = import_graph_image(graph, "render_target", &target);
+
+    GraphImageDesc depth;
+    depth.format = state->depth_format;
+    depth.extent = target.extent;
+    depth.samples = VK_SAMPLE_COUNT_1_BIT;
+    state->depth = create_graph_image(graph, "depth", &depth);
+    if (state->render_target == GRAPH_RESOURCE_NONE || state->depth == GRAPH_RESOURCE_NONE) {
+        destroy_render_graph(graph);
+        return NULL;
+    }
+
+    state->draw_phase = CULL_PHASE_EARLY;
+    bool added = state->culler != NULL
+        ? import_cull_resources(graph, state) && add_culled_passes(graph, state)
+        : add_main_pass(graph, state, "main", record_main_early_pass, true);
+    if (!added || !compile_render_graph(graph)) {
+        destroy_render_graph(graph);
+        return NULL;
+    }
+
+    // The pyramid reads the graph's depth image, which only exists once the graph is compiled
+    if (state->pyramid != NULL) {
+        set_depth_pyramid_source(state->pyramid, get_graph_image_view(graph, state->depth));
+    }
+    return graph;
+}
+
+// Sized for the render targets, so it is rebuilt along with the graph
+bool create_frame_pyramid(VulkanContext *v_ctx, RenderState *state) {
+    ShaderBinary comp;
+    if (!find_shader_binary(state->shader_pack, "depth_pyramid.spv", &comp)) { return false; }
+
+    state->pyramid = create_depth_pyramid(v_ctx, state->pipeline_registry, state->pipeline_builder, &comp,
+        get_render_extent(v_ctx));
+    if (state->pyramid == NULL) { return false; }
+
+    set_cull_depth_pyramid(state->culler, state->pyramid->view, state->pyramid->sampler);
+    return true;
+}
+
+bool create_render_state(VulkanContext *v_ctx, RenderState *state, uint32_t frames_in_flight, const char *mesh_path, bool gpu_culling) {
+    // Pipelines compile on the workers while the frame loop starts up
+    state->framebuffer_resized = false;
+    state->pipelines_settled = false;
+    state->pipeline_cache_saved_ns = 0;
+    state->governor = NULL;
+    state->culler = NULL;
+    state->pyramid = NULL;
+    state->thread_pool = create_thread_pool(0);
+    if (state->thread_pool == NULL) {
+        fprintf(stderr, "failed to create thread pool\n");
+        return false;
+    }
+
+    state->pipeline_builder = create_pipeline_builder(v_ctx->device, v_ctx->pipeline_cache, state->thread_pool);
+    if (state->pipeline_builder == NULL) { return false; }
+
+    state->pipeline_registry = create_pipeline_registry(v_ctx->device, v_ctx->pipeline_cache);
+    if (state->pipeline_registry == NULL) { return false; }
+
+    // Occlusion culling samples the depth buffer, GPU culling is turned off when no depth format allows it
+    state->depth_format = gpu_culling ? get_depth_format(v_ctx, true) : VK_FORMAT_UNDEFINED;
+    if (gpu_culling && state->depth_format == VK_FORMAT_UNDEFINED) {
+        fprintf(stderr, "no sampled depth format, GPU culling disabled\n");
+        gpu_culling = false;
+    }
+    if (state->depth_format == VK_FORMAT_UNDEFINED) {
+        state->depth_format = get_depth_format(v_ctx, false);
+    }
+    if (state->depth_format == VK_FORMAT_UNDEFINED) {
+        fprintf(stderr, "failed to find a depth format\n");
+        return false;
+    }
+
+    // Headless targets are left ready to be copied out
+    RenderPassDesc render_pass_desc;
+    render_pass_desc.color_format = get_render_format(v_ctx);
+    render_pass_desc.depth_format = state->depth_format;
+    render_pass_desc.final_layout = v_ctx->headless ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    begin_trace_scope("create_render_targets");
+    state->render_pass = get_render_pass(state->pipeline_registry, &render_pass_desc);
+    end_trace_scope();
+    if (state->render_pass == NULL) {
+        fprintf(stderr, "failed to create render pass\n");
+        return false;
+    }
+
+    // Every shader comes from one mapping, pipelines reference it until shutdown
+    begin_trace_scope("open_shader_pack");
+    state->shader_pack = open_shader_pack(get_shader_pack_path());
+    end_trace_scope();
+    if (state->shader_pack == NULL) {
+        fprintf(stderr, "failed to open shader pack\n");
+        return false;
+    }
+
+    ShaderBinary vert, frag;
+    if (!find_shader_binary(state->shader_pack, "vert.spv", &vert)
+        || !find_shader_binary(state->shader_pack, "frag.spv", &frag)) {
+        return false;
+    }
+
+    // Layouts and vertex input come from what the shaders declare
+    begin_trace_scope("reflect_shaders");
+    ShaderReflection reflections[2];
+    bool reflected = reflect_shader(&vert, &reflections[0]) && reflect_shader(&frag, &reflections[1]);
+    end_trace_scope();
+    if (!reflected) { return false; }
+
+    begin_trace_scope("create_pipeline_layout");
+    state->pipeline_layout = create_reflected_pipeline_layout(state->pipeline_registry, reflections, 2);
+    end_trace_scope();
+    if (state->pipeline_layout == NULL) {
+        fprintf(stderr, "failed to create pipeline layout\n");
+        return false;
+    }
+
+    // The mesh's vertex format picks the attribute formats, so it loads before the pipeline is queued
+    begin_trace_scope("load_mesh");
+    state->mesh = load_mesh(v_ctx, mesh_path);
+    end_trace_scope();
+    if (state->mesh == NULL) {
+        fprintf(stderr, "failed to load mesh: %s\n", mesh_path);
+        return false;
+    }
+    compute_mesh_transform(state->mesh, &state->mesh_transform);
+
+    GraphicsPipelineDesc desc;
+    init_graphics_pipeline_desc(&desc, state->render_pass, state->pipeline_layout, &vert, &frag);
+    desc.front_face = VK_FRONT_FACE_COUNTER_CLOCKWISE; // cooked meshes keep the source winding
+    desc.depth_test_enable = VK_TRUE;
+    desc.depth_write_enable = VK_TRUE;
+    set_specialization_constant(&desc.vert_specialization, MESH_VERTEX_FORMAT_CONSTANT_ID, state->mesh->vertex_format);
+    if (!validate_specialization(&reflections[0], &desc.vert_specialization)
+        || !build_mesh_vertex_input(state->mesh, &reflections[0], &desc.vertex_input)) {
+        return false;
+    }
+    begin_trace_scope("queue_pipeline_builds");
+    state->pipeline = request_graphics_pipeline(state->pipeline_registry, state->pipeline_builder, &desc);
+    end_trace_scope();
+    if (state->pipeline == NULL) {
+        fprintf(stderr, "failed to queue pipeline builds\n");
+        return false;
+    }
+
+    begin_trace_scope("create_frame_context");
+    state->frame_ctx = create_frame_context(v_ctx, frames_in_flight);
+    end_trace_scope();
+    if (state->frame_ctx == NULL) {
+        fprintf(stderr, "failed to create frame context\n");
+        return false;
+    }
+
+    state->recorder = create_parallel_recorder(v_ctx->device, v_ctx->indices->graphics_index, state->thread_pool,
+        state->frame_ctx->frames_in_flight);
+    if (state->recorder == NULL) {
+        fprintf(stderr, "failed to create parallel recorder\n");
+        return false;
+    }
+
+    // One set of indirect buffers per frame in flight, so it follows the frame context
+    if (gpu_culling) {
+        ShaderBinary comp;
+        if (!find_shader_binary(state->shader_pack, "cull.spv", &comp)) { return false; }
+
+        begin_trace_scope("create_gpu_culler");
+        state->culler = create_gpu_culler(v_ctx, state->pipeline_registry, state->pipeline_builder, &comp,
+            state->mesh, state->frame_ctx->frames_in_flight);
+        end_trace_scope();
+        if (state->culler == NULL) { return false; }
+
+        float clip_from_model[16];
+        compute_mesh_clip_matrix(state->mesh, clip_from_model);
+        set_cull_transform(state->culler, clip_from_model);
+
+        begin_trace_scope("create_depth_pyramid");
+        bool created = create_frame_pyramid(v_ctx, state);
+        end_trace_scope();
+        if (!created) { return false; }
+    }
+
+    begin_trace_scope("create_render_graph");
+    state->graph = create_frame_graph(v_ctx, state);
+    end_trace_scope();
+    if (state->graph == NULL) {
+        fprintf(stderr, "failed to create render graph\n");
+        return false;
+    }
+    print_render_graph(state->graph);
+
+    return true;
+}
+
+/*
+* Window events
+*/
+// Anything the user can see change wakes the idle governor
+void mark_window_dirty(GLFWwindow *window) {
+    RenderState *state = glfwGetWindowUserPointer(window);
+    if (state->governor != NULL) {
+        mark_governor_dirty(state->governor);
+    }
+}
+
+// Resize callback only flags the change, recreation happens between frames
+void framebuffer_resize_callback(GLFWwindow *window, int width, int height) {
+    RenderState *state = glfwGetWindowUserPointer(window);
+    state->framebuffer_resized = true;
+    mark_window_dirty(window);
+}
+
+void key_callback(GLFWwindow *window, int key, int scancode, int action, int mods) {
+    mark_window_dirty(window);
+}
+
+void mouse_button_callback(GLFWwindow *window, int button, int action, int mods) {
+    mark_window_dirty(window);
+}
+
+void cursor_position_callback(GLFWwindow *window, double x, double y) {
+    mark_window_dirty(window);
+}
+
+void scroll_callback(GLFWwindow *window, double x_offset, double y_offset) {
+    mark_window_dirty(window);
+}
+
+void set_window_callbacks(GLFWwindow *window, RenderState *state) {
+    glfwSetWindowUserPointer(window, state);
+    glfwSetFramebufferSizeCallback(window, framebuffer_resize_callback);
+    glfwSetWindowRefreshCallback(window, mark_window_dirty);
+    glfwSetKeyCallback(window, key_callback);
+    glfwSetMouseButtonCallback(window, mouse_button_callback);
+    glfwSetCursorPosCallback(window, cursor_position_callback);
+    glfwSetScrollCallback(window, scroll_callback);
+}
+
+static void destroy_retired_graph(VkDevice device, void *user_data) {
+    destroy_render_graph(user_data);
+}
+
+static void destroy_retired_pyramid(VkDevice device, void *user_data) {
+    destroy_depth_pyramid(user_data);
+}
+
+// In flight frames keep rendering to the old swapchain, it is freed once their fences signal
+bool recreate_render_targets(GLFWwindow *window, VulkanContext *v_ctx, RenderState *state) {
+    // Minimized windows have no valid extent, wait until there is something to present to
+    int width = 0, height = 0;
+    glfwGetFramebufferSize(window, &width, &height);
+    while ((width == 0 || height == 0) && !glfwWindowShouldClose(window)) {
+        glfwWaitEvents();
+        glfwGetFramebufferSize(window, &width, &height);
+    }
+    if (width == 0 || height == 0) { return true; }
+
+    SwapchainContext *old_swapchain_ctx = recreate_swapchain_context(v_ctx, window);
+    if (old_swapchain_ctx == NULL) { return false; }
+
+    // The graph's framebuffers reference the old views, so it is retired ahead of the swapchain
+    DeletionPoint point = get_frame_deletion_point(state->frame_ctx);
+    if (!retire_with_callback(state->frame_ctx->deletion_queue, destroy_retired_graph, state->graph, point)
+        || !retire_swapchain(state->frame_ctx, old_swapchain_ctx)) {
+        return false;
+    }
+
+    // In flight culls still sample the old pyramid, it goes with the graph
+    if (state->pyramid != NULL) {
+        if (!retire_with_callback(state->frame_ctx->deletion_queue, destroy_retired_pyramid, state->pyramid, point)) {
+            return false;
+        }
+        state->pyramid = NULL;
+        if (!create_frame_pyramid(v_ctx, state)) {
+            fprintf(stderr, "failed to recreate depth pyramid\n");
+            return false;
+        }
+    }
+
+    state->graph = create_frame_graph(v_ctx, state);
+    if (state->graph == NULL) {
+        fprintf(stderr, "failed to recreate render graph\n");
+        return false;
+    }
+
+    state->framebuffer_resized = false;
+    state->frame_ctx->swapchain_out_of_date = false;
+    return true;
+}
+
+bool draw_frame(VulkanContext *v_ctx, RenderState *state) {
+    VkCommandBuffer command_buffer = begin_frame(v_ctx, state->frame_ctx);
+    if (command_buffer == NULL) {
+        // Out of date swapchains are not an error, the frame is skipped until recreation
+        return state->frame_ctx->swapchain_out_of_date;
+    }
+
+    // The slot's fence has signaled, so its secondaries can be reset with it
+    if (!reset_parallel_recorder(state->recorder, state->frame_ctx->frame_index)) { return false; }
+
+    uint32_t image_index = state->frame_ctx->image_index;
+    set_graph_image(state->graph, state->render_target, get_render_images(v_ctx)[image_index], get_render_image_views(v_ctx)[image_index]);
+    if (state->culler != NULL) {
+        const GpuCullFrame *cull_frame = &state->culler->frames[state->frame_ctx->frame_index];
+        set_graph_buffer(state->graph, state->draw_commands, cull_frame->command_buffer);
+        set_graph_buffer(state->graph, state->draw_count, cull_frame->count_buffer);
+        update_cull_frame(v_ctx->device, state->culler, state->frame_ctx->frame_index);
+    }
+    if (!execute_render_graph(state->graph, command_buffer)) { return false; }
+
+    return end_frame(v_ctx, state->frame_ctx);
+}
+
+bool are_pipelines_pending(RenderState *state) {
+    if (get_pipeline_status(state->pipeline) == PIPELINE_PENDING) { return true; }
+    if (state->culler != NULL && get_pipeline_status(state->culler->pipeline) == PIPELINE_PENDING) { return true; }
+    if (state->pyramid != NULL && get_pipeline_status(state->pyramid->pipeline) == PIPELINE_PENDING) { return true; }
+    return false;
+}
+
+// The cache is written once the startup compiles land, then on a slow timer so a crash keeps most of it
+void update_pipeline_cache(VulkanContext *v_ctx, RenderState *state) {
+    uint64_t now = get_trace_time_ns();
+    if (!state->pipelines_settled) {
+        if (are_pipelines_pending(state)) { return; }
+        state->pipelines_settled = true;
+    } else if (now - state->pipeline_cache_saved_ns < PIPELINE_CACHE_SAVE_INTERVAL_NS) {
+        return;
+    }
+
+    begin_trace_scope("flush_pipeline_cache");
+    flush_pipeline_cache(v_ctx);
+    end_trace_scope();
+    state->pipeline_cache_saved_ns = now;
+}
+
+void destroy_render_state(VulkanContext *v_ctx, RenderState *state) {
+    destroy_frame_context(v_ctx->device, state->frame_ctx);
+    if (state->culler != NULL) {
+        destroy_gpu_culler(v_ctx, state->culler);
+    }
+    if (state->pyramid != NULL) {
+        destroy_depth_pyramid(state->pyramid);
+    }
+    destroy_mesh(v_ctx, state->mesh);
+    destroy_pipeline_builder(state->pipeline_builder);
+    print_parallel_recorder_stats(state->recorder);
+    destroy_parallel_recorder(state->recorder);
+    destroy_thread_pool(state->thread_pool);
+    destroy_render_graph(state->graph);
+
+    // Registry owns the pipeline, layouts and render pass
+    print_pipeline_registry_stats(state->pipeline_registry);
+    destroy_pipeline_registry(state->pipeline_registry);
+    close_shader_pack(state->shader_pack);
+}
+
 /*
 * Application
 */
-int main() {
+// Worker builds finish after startup, so the trace is reported at shutdown
+void report_trace(void) {
+    print_trace_summary();
+
+    const char *trace_path = get_trace_path();
+    if (trace_path != NULL) {
+        write_trace_file(trace_path);
+    }
+}
+
+int run_headless(AppOptions *options) {
+    VkExtent2D extent = { SCREEN_WIDTH, SCREEN_HEIGHT };
+    begin_trace_scope("create_vulkan_context");
+    VulkanContext *v_ctx = create_headless_vulkan_context(extent, HEADLESS_TARGET_COUNT, DEFAULT_OFFSCREEN_FORMAT,
+        get_present_policy(options->present_policy));
+    end_trace_scope();
+    if (v_ctx == NULL) {
+        fprintf(stderr, "failed to create headless vulkan context\n");
+        return -1;
+    }
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(v_ctx->physical_device, &properties);
+    printf("Headless device: %s\n", properties.deviceName);
+
+    RenderState state;
+    begin_trace_scope("create_render_state");
+    bool created = create_render_state(v_ctx, &state, options->frames_in_flight, options->mesh_path, options->gpu_culling);
+    end_trace_scope();
+    if (!created) {
+        fprintf(stderr, "failed to create render state\n");
+        return -1;
+    }
+
+    printf("Rendering %u frames...\n", options->frame_count);
+    for (uint32_t i = 0; i < options->frame_count; ++i) {
+        if (!draw_frame(v_ctx, &state)) {
+            fprintf(stderr, "failed to draw frame %u\n", i);
+            break;
+        }
+    }
+
+    vkDeviceWaitIdle(v_ctx->device);
+    destroy_render_state(v_ctx, &state);
+    destroy_vulkan_context(v_ctx);
+    report_trace();
+
+    printf("Exit success\n");
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    AppOptions options = parse_app_options(argc, argv);
+    if (options.headless) {
+        return run_headless(&options);
+    }
+
     GLFWwindow *window = create_window(SCREEN_WIDTH, SCREEN_HEIGHT, WINDOW_TITLE);
     if (window == NULL) {
         fprintf(stderr, "failed to create GLFW window\n");
@@ -68,26 +816,60 @@ int main() {
         return -1;
     }
 
-    VulkanContext *v_ctx = create_vulkan_context(window);
+    begin_trace_scope("create_vulkan_context");
+    VulkanContext *v_ctx = create_vulkan_context(window, get_present_policy(options.present_policy));
+    end_trace_scope();
     debug_set_title(window, v_ctx->physical_device);
 
-    VkPipelineLayout main_pipeline = create_graphics_pipeline(v_ctx->device, v_ctx->swapchain_ctx, "vert.spv", "frag.spv");
+    RenderState state;
+    begin_trace_scope("create_render_state");
+    bool created = create_render_state(v_ctx, &state, options.frames_in_flight, options.mesh_path, options.gpu_culling);
+    end_trace_scope();
+    if (!created) {
+        fprintf(stderr, "failed to create render state\n");
+        return -1;
+    }
+
+    // Vsync pacing only holds when presentation itself blocks
+    VkPresentModeKHR present_mode = v_ctx->swapchain_ctx->present_mode;
+    bool present_paced = present_mode == VK_PRESENT_MODE_FIFO_KHR || present_mode == VK_PRESENT_MODE_FIFO_RELAXED_KHR;
+    double target_fps = options.max_fps > 0.0 ? options.max_fps : get_monitor_refresh_rate(window);
+    state.governor = create_frame_governor(options.governor_mode, target_fps, present_paced);
+    if (state.governor == NULL) { return -1; }
+    set_window_callbacks(window, &state);
 
     printf("Running...\n");
     while(!glfwWindowShouldClose(window)) {
-        // Input
-        glfwPollEvents();
+        // Input, the governor sleeps here until the next frame is due
+        if (!wait_for_next_frame(state.governor)) {
+            continue;
+        }
 
-        // Render
-        // vkBeginCommandBuffer(command_buffer, NULL);
+        // Swapchain
+        if (state.framebuffer_resized || state.frame_ctx->swapchain_out_of_date) {
+            if (!recreate_render_targets(window, v_ctx, &state)) {
+                fprintf(stderr, "failed to recreate render targets\n");
+                break;
+            }
+        }
 
-        // vkEndCommandBuffer(command_buffer);
+        // Render
+        if (!draw_frame(v_ctx, &state)) {
+            fprintf(stderr, "failed to draw frame\n");
+            break;
+        }
+        end_governed_frame(state.governor, state.frame_ctx->blocked_ns);
+        update_pipeline_cache(v_ctx, &state);
     }
 
-    vkDestroyPipelineLayout(v_ctx->device, main_pipeline, NULL);
+    // Shutdown is the one place a full drain is expected
+    vkDeviceWaitIdle(v_ctx->device);
+    destroy_frame_governor(state.governor);
+    destroy_render_state(v_ctx, &state);
 
     destroy_vulkan_context(v_ctx);
     clean_up(window);
+    report_trace();
 
     printf("Exit success\n");
     return 0;
@@ -0,0 +1,77 @@
+#include "arena.h"
+
+static _Thread_local Arena *scratch_arena = NULL;
+
+/*
+* Arena creation
+*/
+Arena *create_arena(size_t capacity) {
+    Arena *arena = malloc(sizeof(Arena));
+    if (arena == NULL) { return NULL; }
+
+    arena->data = malloc(capacity);
+    if (arena->data == NULL) {
+        fprintf(stderr, "failed to alloc arena of %zu bytes\n", capacity);
+        free(arena);
+        return NULL;
+    }
+
+    arena->capacity = capacity;
+    arena->offset = 0;
+    arena->peak = 0;
+    return arena;
+}
+
+/*
+* Allocation
+*/
+void *arena_alloc(Arena *arena, size_t size) {
+    size_t offset = (arena->offset + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1);
+    if (offset + size > arena->capacity) {
+        fprintf(stderr, "arena out of memory (%zu of %zu bytes used)\n", arena->offset, arena->capacity);
+        return NULL;
+    }
+
+    arena->offset = offset + size;
+    if (arena->offset > arena->peak) {
+        arena->peak = arena->offset;
+    }
+    return arena->data + offset;
+}
+
+ArenaMark get_arena_mark(Arena *arena) {
+    return arena->offset;
+}
+
+void reset_arena_to_mark(Arena *arena, ArenaMark mark) {
+    arena->offset = mark;
+}
+
+void reset_arena(Arena *arena) {
+    arena->offset = 0;
+}
+
+/*
+* Scratch arena
+*/
+Arena *get_scratch_arena(void) {
+    if (scratch_arena == NULL) {
+        scratch_arena = create_arena(SCRATCH_ARENA_SIZE);
+    }
+    return scratch_arena;
+}
+
+void destroy_scratch_arena(void) {
+    if (scratch_arena == NULL) { return; }
+
+    destroy_arena(scratch_arena);
+    scratch_arena = NULL;
+}
+
+/*
+* Cleanup
+*/
+void destroy_arena(Arena *arena) {
+    free(arena->data);
+    free(arena);
+}
@@ -0,0 +1,39 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define ARENA_ALIGNMENT 16
+#define SCRATCH_ARENA_SIZE (1024 * 1024)
+
+// Bump allocator, everything after a mark is released at once
+typedef struct {
+    uint8_t *data;
+    size_t capacity;
+    size_t offset;
+    size_t peak;
+} Arena;
+
+typedef size_t ArenaMark;
+
+// Arena creation
+Arena *create_arena(size_t capacity);
+
+// Allocation
+void *arena_alloc(Arena *arena, size_t size);
+ArenaMark get_arena_mark(Arena *arena);
+void reset_arena_to_mark(Arena *arena, ArenaMark mark);
+void reset_arena(Arena *arena);
+
+// Per thread scratch space for short lived query arrays
+Arena *get_scratch_arena(void);
+void destroy_scratch_arena(void);
+
+// Cleanup
+void destroy_arena(Arena *arena);
+
+#endif
@@ -1,6 +1,8 @@
 #ifndef CONFIG_H
 #define CONFIG_H
 
-#define SHADER_BIN_DIR "/Users/dquintero/Desktop/vrender/build/shaders/"
+#define SHADER_PACK_FILE "shaders.pack"
+#define PIPELINE_CACHE_FILE "pipeline_cache.bin"
+#define MESH_FILE "meshes/triangle.mesh"
 
 #endif
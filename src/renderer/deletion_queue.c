@@ -0,0 +1,187 @@
+#include "deletion_queue.h"
+
+/*
+* Queue creation
+*/
+DeletionQueue *create_deletion_queue(VkDevice device, GpuAllocator *allocator) {
+    DeletionQueue *queue = malloc(sizeof(DeletionQueue));
+    if (queue == NULL) {
+        fprintf(stderr, "failed to alloc DeletionQueue\n");
+        return NULL;
+    }
+
+    queue->entries = malloc(sizeof(DeletionEntry) * DELETION_QUEUE_INITIAL_CAPACITY);
+    if (queue->entries == NULL) {
+        free(queue);
+        return NULL;
+    }
+
+    queue->device = device;
+    queue->allocator = allocator;
+    queue->count = 0;
+    queue->capacity = DELETION_QUEUE_INITIAL_CAPACITY;
+    queue->destroyed_count = 0;
+    return queue;
+}
+
+/*
+* Retirement
+*/
+static DeletionEntry *push_deletion_entry(DeletionQueue *queue, DeletionKind kind, DeletionPoint point) {
+    if (queue->count == queue->capacity) {
+        DeletionEntry *grown = realloc(queue->entries, sizeof(DeletionEntry) * queue->capacity * 2);
+        if (grown == NULL) {
+            fprintf(stderr, "failed to grow deletion queue\n");
+            return NULL;
+        }
+        queue->entries = grown;
+        queue->capacity *= 2;
+    }
+
+    DeletionEntry *entry = &queue->entries[queue->count++];
+    memset(entry, 0, sizeof(DeletionEntry));
+    entry->kind = kind;
+    entry->point = point;
+    return entry;
+}
+
+bool retire_vulkan_handle(DeletionQueue *queue, DeletionKind kind, uint64_t handle, DeletionPoint point) {
+    if (handle == 0) { return true; }
+
+    DeletionEntry *entry = push_deletion_entry(queue, kind, point);
+    if (entry == NULL) { return false; }
+
+    entry->handle = handle;
+    return true;
+}
+
+bool retire_gpu_allocation(DeletionQueue *queue, const GpuAllocation *allocation, DeletionPoint point) {
+    if (allocation->memory == VK_NULL_HANDLE) { return true; }
+
+    DeletionEntry *entry = push_deletion_entry(queue, DELETION_MEMORY, point);
+    if (entry == NULL) { return false; }
+
+    entry->allocation = *allocation;
+    return true;
+}
+
+bool retire_with_callback(DeletionQueue *queue, DeletionCallback callback, void *user_data, DeletionPoint point) {
+    DeletionEntry *entry = push_deletion_entry(queue, DELETION_CALLBACK, point);
+    if (entry == NULL) { return false; }
+
+    entry->callback = callback;
+    entry->user_data = user_data;
+    return true;
+}
+
+/*
+* Destruction
+*/
+static void destroy_deletion_entry(DeletionQueue *queue, DeletionEntry *entry) {
+    VkDevice device = queue->device;
+    const VkAllocationCallbacks *host_allocator = get_host_allocator();
+
+    switch (entry->kind) {
+        case DELETION_BUFFER:
+            vkDestroyBuffer(device, (VkBuffer)entry->handle, host_allocator);
+            break;
+        case DELETION_IMAGE:
+            vkDestroyImage(device, (VkImage)entry->handle, host_allocator);
+            break;
+        case DELETION_IMAGE_VIEW:
+            vkDestroyImageView(device, (VkImageView)entry->handle, host_allocator);
+            break;
+        case DELETION_SAMPLER:
+            vkDestroySampler(device, (VkSampler)entry->handle, host_allocator);
+            break;
+        case DELETION_FRAMEBUFFER:
+            vkDestroyFramebuffer(device, (VkFramebuffer)entry->handle, host_allocator);
+            break;
+        case DELETION_RENDER_PASS:
+            vkDestroyRenderPass(device, (VkRenderPass)entry->handle, host_allocator);
+            break;
+        case DELETION_PIPELINE:
+            vkDestroyPipeline(device, (VkPipeline)entry->handle, host_allocator);
+            break;
+        case DELETION_PIPELINE_LAYOUT:
+            vkDestroyPipelineLayout(device, (VkPipelineLayout)entry->handle, host_allocator);
+            break;
+        case DELETION_DESCRIPTOR_SET_LAYOUT:
+            vkDestroyDescriptorSetLayout(device, (VkDescriptorSetLayout)entry->handle, host_allocator);
+            break;
+        case DELETION_DESCRIPTOR_POOL:
+            vkDestroyDescriptorPool(device, (VkDescriptorPool)entry->handle, host_allocator);
+            break;
+        case DELETION_SHADER_MODULE:
+            vkDestroyShaderModule(device, (VkShaderModule)entry->handle, host_allocator);
+            break;
+        case DELETION_SEMAPHORE:
+            vkDestroySemaphore(device, (VkSemaphore)entry->handle, host_allocator);
+            break;
+        case DELETION_FENCE:
+            vkDestroyFence(device, (VkFence)entry->handle, host_allocator);
+            break;
+        case DELETION_COMMAND_POOL:
+            vkDestroyCommandPool(device, (VkCommandPool)entry->handle, host_allocator);
+            break;
+        case DELETION_QUERY_POOL:
+            vkDestroyQueryPool(device, (VkQueryPool)entry->handle, host_allocator);
+            break;
+        case DELETION_MEMORY:
+            free_gpu_memory(queue->allocator, &entry->allocation);
+            break;
+        case DELETION_CALLBACK:
+            entry->callback(device, entry->user_data);
+            break;
+    }
+    ++queue->destroyed_count;
+}
+
+// Timeline values are polled, never waited on
+static bool is_deletion_point_complete(VkDevice device, const DeletionPoint *point, uint64_t completed_frames) {
+    if (point->frame >= completed_frames) { return false; }
+    if (point->timeline == VK_NULL_HANDLE) { return true; }
+
+    uint64_t value = 0;
+    if (vkGetSemaphoreCounterValue(device, point->timeline, &value) != VK_SUCCESS) { return false; }
+    return value >= point->timeline_value;
+}
+
+// Frames below completed_frames have finished on the GPU, everything they retired is destroyed in one pass
+// Entries are destroyed in retirement order, retire views before the images they reference
+uint32_t collect_deletion_queue(DeletionQueue *queue, uint64_t completed_frames) {
+    uint32_t kept = 0;
+    uint32_t destroyed = 0;
+    for (uint32_t i = 0; i < queue->count; ++i) {
+        DeletionEntry *entry = &queue->entries[i];
+        if (!is_deletion_point_complete(queue->device, &entry->point, completed_frames)) {
+            queue->entries[kept++] = *entry;
+            continue;
+        }
+
+        destroy_deletion_entry(queue, entry);
+        ++destroyed;
+    }
+
+    queue->count = kept;
+    return destroyed;
+}
+
+// Only valid once the device is idle
+void flush_deletion_queue(DeletionQueue *queue) {
+    for (uint32_t i = 0; i < queue->count; ++i) {
+        destroy_deletion_entry(queue, &queue->entries[i]);
+    }
+    queue->count = 0;
+}
+
+/*
+* Cleanup
+*/
+void destroy_deletion_queue(DeletionQueue *queue) {
+    printf("[DELETION] %llu resources destroyed after their frames completed, %u left at shutdown\n",
+        (unsigned long long)queue->destroyed_count, queue->count);
+    flush_deletion_queue(queue);
+    free(queue->entries);
+    free(queue);
+}
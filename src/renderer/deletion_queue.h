@@ -0,0 +1,84 @@
+#ifndef DELETION_QUEUE_H
+#define DELETION_QUEUE_H
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "gpu_allocator.h"
+#include "host_allocator.h"
+
+#define DELETION_QUEUE_INITIAL_CAPACITY 64
+
+// Non-dispatchable handles are 64 bit on every platform, stored untyped until destruction
+#define DELETION_HANDLE(handle) ((uint64_t)(handle))
+
+typedef enum {
+    DELETION_BUFFER,
+    DELETION_IMAGE,
+    DELETION_IMAGE_VIEW,
+    DELETION_SAMPLER,
+    DELETION_FRAMEBUFFER,
+    DELETION_RENDER_PASS,
+    DELETION_PIPELINE,
+    DELETION_PIPELINE_LAYOUT,
+    DELETION_DESCRIPTOR_SET_LAYOUT,
+    DELETION_DESCRIPTOR_POOL,
+    DELETION_SHADER_MODULE,
+    DELETION_SEMAPHORE,
+    DELETION_FENCE,
+    DELETION_COMMAND_POOL,
+    DELETION_QUERY_POOL,
+    DELETION_MEMORY,   // GpuAllocation returned to the allocator
+    DELETION_CALLBACK  // objects that own several handles, e.g. a swapchain context
+} DeletionKind;
+
+typedef void (*DeletionCallback)(VkDevice device, void *user_data);
+
+// Last GPU use of a resource, frames count submitted frames, the timeline covers other queues
+typedef struct {
+    uint64_t frame;
+    VkSemaphore timeline; // VK_NULL_HANDLE when only the frame matters
+    uint64_t timeline_value;
+} DeletionPoint;
+
+typedef struct {
+    DeletionKind kind;
+    DeletionPoint point;
+    uint64_t handle;
+    GpuAllocation allocation;
+    DeletionCallback callback;
+    void *user_data;
+} DeletionEntry;
+
+// Not thread safe, retire from the thread that records frames
+typedef struct {
+    VkDevice device;
+    GpuAllocator *allocator;
+    DeletionEntry *entries;
+    uint32_t count;
+    uint32_t capacity;
+    uint64_t destroyed_count;
+} DeletionQueue;
+
+// Queue creation
+DeletionQueue *create_deletion_queue(VkDevice device, GpuAllocator *allocator);
+
+// Retirement
+bool retire_vulkan_handle(DeletionQueue *queue, DeletionKind kind, uint64_t handle, DeletionPoint point);
+bool retire_gpu_allocation(DeletionQueue *queue, const GpuAllocation *allocation, DeletionPoint point);
+bool retire_with_callback(DeletionQueue *queue, DeletionCallback callback, void *user_data, DeletionPoint point);
+
+// Destruction
+uint32_t collect_deletion_queue(DeletionQueue *queue, uint64_t completed_frames);
+void flush_deletion_queue(DeletionQueue *queue);
+
+// Cleanup
+void destroy_deletion_queue(DeletionQueue *queue);
+
+#endif
@@ -0,0 +1,296 @@
+#include "depth_pyramid.h"
+
+#define PYRAMID_BINDING_DEPTH 0
+#define PYRAMID_BINDING_SOURCE 1
+#define PYRAMID_BINDING_DESTINATION 2
+
+/*
+* Pyramid creation
+*/
+static uint32_t get_level_size(uint32_t size, uint32_t level) {
+    uint32_t level_size = size >> level;
+    return level_size > 0 ? level_size : 1;
+}
+
+static VkImageView create_pyramid_view(DepthPyramid *pyramid, uint32_t base_level, uint32_t level_count) {
+    VkImageViewCreateInfo create_info;
+    create_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    create_info.pNext = NULL;
+    create_info.flags = 0;
+    create_info.image = pyramid->image;
+    create_info.viewType = VK_IMAGE_VIEW_TYPE_2D_ARRAY;
+    create_info.format = DEPTH_PYRAMID_FORMAT;
+    create_info.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
+    create_info.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
+    create_info.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
+    create_info.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
+    create_info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    create_info.subresourceRange.baseMipLevel = base_level;
+    create_info.subresourceRange.levelCount = level_count;
+    create_info.subresourceRange.baseArrayLayer = 0;
+    create_info.subresourceRange.layerCount = DEPTH_PYRAMID_LAYER_COUNT;
+
+    VkImageView view;
+    if (vkCreateImageView(pyramid->device, &create_info, get_host_allocator(), &view) != VK_SUCCESS) {
+        fprintf(stderr, "failed to create depth pyramid view\n");
+        return VK_NULL_HANDLE;
+    }
+    return view;
+}
+
+static bool create_pyramid_image(DepthPyramid *pyramid) {
+    VkImageCreateInfo create_info;
+    create_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    create_info.pNext = NULL;
+    create_info.flags = 0;
+    create_info.imageType = VK_IMAGE_TYPE_2D;
+    create_info.format = DEPTH_PYRAMID_FORMAT;
+    create_info.extent.width = pyramid->extent.width;
+    create_info.extent.height = pyramid->extent.height;
+    create_info.extent.depth = 1;
+    create_info.mipLevels = pyramid->level_count;
+    create_info.arrayLayers = DEPTH_PYRAMID_LAYER_COUNT;
+    create_info.samples = VK_SAMPLE_COUNT_1_BIT;
+    create_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+    create_info.usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+    create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    create_info.queueFamilyIndexCount = 0;
+    create_info.pQueueFamilyIndices = NULL;
+    create_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    if (vkCreateImage(pyramid->device, &create_info, get_host_allocator(), &pyramid->image) != VK_SUCCESS) {
+        fprintf(stderr, "failed to create depth pyramid image\n");
+        return false;
+    }
+
+    if (!allocate_image_memory(pyramid->allocator, pyramid->image, GPU_MEMORY_GPU_ONLY, &pyramid->allocation)) {
+        fprintf(stderr, "failed to allocate depth pyramid memory\n");
+        vkDestroyImage(pyramid->device, pyramid->image, get_host_allocator());
+        pyramid->image = VK_NULL_HANDLE;
+        return false;
+    }
+
+    pyramid->view = create_pyramid_view(pyramid, 0, pyramid->level_count);
+    if (pyramid->view == VK_NULL_HANDLE) { return false; }
+    for (uint32_t level = 0; level < pyramid->level_count; ++level) {
+        pyramid->level_views[level] = create_pyramid_view(pyramid, level, 1);
+        if (pyramid->level_views[level] == VK_NULL_HANDLE) { return false; }
+    }
+    return true;
+}
+
+static bool create_pyramid_sampler(DepthPyramid *pyramid) {
+    VkSamplerCreateInfo create_info;
+    memset(&create_info, 0, sizeof(create_info));
+    create_info.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    create_info.magFilter = VK_FILTER_NEAREST;
+    create_info.minFilter = VK_FILTER_NEAREST;
+    create_info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    create_info.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    create_info.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    create_info.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    create_info.maxLod = VK_LOD_CLAMP_NONE;
+    create_info.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
+    if (vkCreateSampler(pyramid->device, &create_info, get_host_allocator(), &pyramid->sampler) != VK_SUCCESS) {
+        fprintf(stderr, "failed to create depth pyramid sampler\n");
+        return false;
+    }
+    return true;
+}
+
+static bool create_pyramid_descriptor_sets(DepthPyramid *pyramid, VkDescriptorSetLayout set_layout) {
+    VkDescriptorPoolSize pool_sizes[2];
+    pool_sizes[0].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    pool_sizes[0].descriptorCount = 2 * pyramid->level_count;
+    pool_sizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    pool_sizes[1].descriptorCount = pyramid->level_count;
+
+    VkDescriptorPoolCreateInfo pool_create_info;
+    pool_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    pool_create_info.pNext = NULL;
+    pool_create_info.flags = 0;
+    pool_create_info.maxSets = pyramid->level_count;
+    pool_create_info.poolSizeCount = 2;
+    pool_create_info.pPoolSizes = pool_sizes;
+    if (vkCreateDescriptorPool(pyramid->device, &pool_create_info, get_host_allocator(), &pyramid->descriptor_pool) != VK_SUCCESS) {
+        fprintf(stderr, "failed to create depth pyramid descriptor pool\n");
+        return false;
+    }
+
+    VkDescriptorSetLayout set_layouts[DEPTH_PYRAMID_MAX_LEVELS];
+    for (uint32_t level = 0; level < pyramid->level_count; ++level) {
+        set_layouts[level] = set_layout;
+    }
+
+    VkDescriptorSetAllocateInfo alloc_info;
+    alloc_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    alloc_info.pNext = NULL;
+    alloc_info.descriptorPool = pyramid->descriptor_pool;
+    alloc_info.descriptorSetCount = pyramid->level_count;
+    alloc_info.pSetLayouts = set_layouts;
+    if (vkAllocateDescriptorSets(pyramid->device, &alloc_info, pyramid->descriptor_sets) != VK_SUCCESS) {
+        fprintf(stderr, "failed to allocate depth pyramid descriptor sets\n");
+        return false;
+    }
+    return true;
+}
+
+static bool queue_pyramid_pipeline(DepthPyramid *pyramid, PipelineRegistry *registry, PipelineBuilder *builder,
+    const ShaderBinary *comp, VkDescriptorSetLayout *set_layout) {
+    ShaderReflection reflection;
+    if (!reflect_shader(comp, &reflection)) { return false; }
+
+    pyramid->pipeline_layout = create_reflected_pipeline_layout(registry, &reflection, 1);
+    *set_layout = get_reflected_set_layout(registry, &reflection, 1, 0);
+    if (pyramid->pipeline_layout == VK_NULL_HANDLE || *set_layout == VK_NULL_HANDLE) {
+        fprintf(stderr, "failed to create depth pyramid pipeline layout\n");
+        return false;
+    }
+
+    ComputePipelineDesc desc;
+    init_compute_pipeline_desc(&desc, pyramid->pipeline_layout, comp);
+    pyramid->pipeline = request_compute_pipeline(registry, builder, &desc);
+    return pyramid->pipeline != NULL;
+}
+
+DepthPyramid *create_depth_pyramid(VulkanContext *v_ctx, PipelineRegistry *registry, PipelineBuilder *builder,
+    const ShaderBinary *comp, VkExtent2D depth_extent) {
+    DepthPyramid *pyramid = calloc(1, sizeof(DepthPyramid));
+    if (pyramid == NULL) { return NULL; }
+
+    pyramid->device = v_ctx->device;
+    pyramid->allocator = v_ctx->allocator;
+    pyramid->depth_extent = depth_extent;
+    pyramid->extent.width = get_level_size(depth_extent.width, 1);
+    pyramid->extent.height = get_level_size(depth_extent.height, 1);
+
+    // Down to 1x1, so any screen rectangle fits in 2x2 texels of some level
+    uint32_t size = pyramid->extent.width > pyramid->extent.height ? pyramid->extent.width : pyramid->extent.height;
+    pyramid->level_count = 1;
+    while ((size >> pyramid->level_count) > 0 && pyramid->level_count < DEPTH_PYRAMID_MAX_LEVELS) {
+        ++pyramid->level_count;
+    }
+
+    VkDescriptorSetLayout set_layout = VK_NULL_HANDLE;
+    bool created = create_pyramid_image(pyramid)
+        && create_pyramid_sampler(pyramid)
+        && queue_pyramid_pipeline(pyramid, registry, builder, comp, &set_layout)
+        && create_pyramid_descriptor_sets(pyramid, set_layout);
+    if (!created) {
+        fprintf(stderr, "failed to create depth pyramid\n");
+        destroy_depth_pyramid(pyramid);
+        return NULL;
+    }
+    return pyramid;
+}
+
+// Level 0 reads the depth attachment, the rest read the level above in GENERAL while the pass writes the next
+void set_depth_pyramid_source(DepthPyramid *pyramid, VkImageView depth_view) {
+    VkDescriptorImageInfo image_infos[DEPTH_PYRAMID_MAX_LEVELS][3];
+    VkWriteDescriptorSet writes[DEPTH_PYRAMID_MAX_LEVELS * 3];
+    uint32_t write_count = 0;
+
+    for (uint32_t level = 0; level < pyramid->level_count; ++level) {
+        // Level 0 never reads its source binding, it only has to hold a valid view
+        image_infos[level][PYRAMID_BINDING_DEPTH] = (VkDescriptorImageInfo){
+            pyramid->sampler, depth_view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+        image_infos[level][PYRAMID_BINDING_SOURCE] = (VkDescriptorImageInfo){
+            pyramid->sampler, pyramid->level_views[level > 0 ? level - 1 : 0], VK_IMAGE_LAYOUT_GENERAL };
+        image_infos[level][PYRAMID_BINDING_DESTINATION] = (VkDescriptorImageInfo){
+            VK_NULL_HANDLE, pyramid->level_views[level], VK_IMAGE_LAYOUT_GENERAL };
+
+        for (uint32_t binding = 0; binding < 3; ++binding) {
+            VkWriteDescriptorSet *write = &writes[write_count++];
+            write->sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            write->pNext = NULL;
+            write->dstSet = pyramid->descriptor_sets[level];
+            write->dstBinding = binding;
+            write->dstArrayElement = 0;
+            write->descriptorCount = 1;
+            write->descriptorType = binding == PYRAMID_BINDING_DESTINATION
+                ? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE : VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+            write->pImageInfo = &image_infos[level][binding];
+            write->pBufferInfo = NULL;
+            write->pTexelBufferView = NULL;
+        }
+    }
+    vkUpdateDescriptorSets(pyramid->device, write_count, writes, 0, NULL);
+}
+
+/*
+* Recording
+*/
+// The render graph moves the whole pyramid to GENERAL before this and to shader read after it
+bool record_depth_pyramid(VkCommandBuffer command_buffer, const DepthPyramid *pyramid) {
+    VkPipeline pipeline = get_ready_pipeline(pyramid->pipeline, VK_NULL_HANDLE);
+    if (pipeline == VK_NULL_HANDLE) { return false; }
+
+    vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+    DepthPyramidConstants constants;
+    constants.source_size[0] = pyramid->depth_extent.width;
+    constants.source_size[1] = pyramid->depth_extent.height;
+    for (uint32_t level = 0; level < pyramid->level_count; ++level) {
+        constants.destination_size[0] = get_level_size(pyramid->extent.width, level);
+        constants.destination_size[1] = get_level_size(pyramid->extent.height, level);
+        constants.depth_source = level == 0;
+
+        vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, pyramid->pipeline_layout, 0, 1,
+            &pyramid->descriptor_sets[level], 0, NULL);
+        vkCmdPushConstants(command_buffer, pyramid->pipeline_layout, VK_SHADER_STAGE_COMPUTE_BIT, 0,
+            sizeof(DepthPyramidConstants), &constants);
+        vkCmdDispatch(command_buffer,
+            (constants.destination_size[0] + DEPTH_PYRAMID_WORKGROUP_SIZE - 1) / DEPTH_PYRAMID_WORKGROUP_SIZE,
+            (constants.destination_size[1] + DEPTH_PYRAMID_WORKGROUP_SIZE - 1) / DEPTH_PYRAMID_WORKGROUP_SIZE, 1);
+
+        // The next level reads this one, the last level is left to the graph's barrier
+        if (level + 1 < pyramid->level_count) {
+            VkImageMemoryBarrier barrier;
+            barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+            barrier.pNext = NULL;
+            barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+            barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+            barrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+            barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+            barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.image = pyramid->image;
+            barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            barrier.subresourceRange.baseMipLevel = level;
+            barrier.subresourceRange.levelCount = 1;
+            barrier.subresourceRange.baseArrayLayer = 0;
+            barrier.subresourceRange.layerCount = DEPTH_PYRAMID_LAYER_COUNT;
+            vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                0, 0, NULL, 0, NULL, 1, &barrier);
+        }
+
+        constants.source_size[0] = constants.destination_size[0];
+        constants.source_size[1] = constants.destination_size[1];
+    }
+    return true;
+}
+
+/*
+* Cleanup
+*/
+// The pipeline and layouts belong to the registry
+void destroy_depth_pyramid(DepthPyramid *pyramid) {
+    VkDevice device = pyramid->device;
+    if (pyramid->descriptor_pool != VK_NULL_HANDLE) {
+        vkDestroyDescriptorPool(device, pyramid->descriptor_pool, get_host_allocator());
+    }
+    if (pyramid->sampler != VK_NULL_HANDLE) {
+        vkDestroySampler(device, pyramid->sampler, get_host_allocator());
+    }
+    for (uint32_t level = 0; level < pyramid->level_count; ++level) {
+        if (pyramid->level_views[level] != VK_NULL_HANDLE) {
+            vkDestroyImageView(device, pyramid->level_views[level], get_host_allocator());
+        }
+    }
+    if (pyramid->view != VK_NULL_HANDLE) {
+        vkDestroyImageView(device, pyramid->view, get_host_allocator());
+    }
+    if (pyramid->image != VK_NULL_HANDLE) {
+        vkDestroyImage(device, pyramid->image, get_host_allocator());
+        free_gpu_memory(pyramid->allocator, &pyramid->allocation);
+    }
+    free(pyramid);
+}
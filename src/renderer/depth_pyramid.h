@@ -0,0 +1,69 @@
+#ifndef DEPTH_PYRAMID_H
+#define DEPTH_PYRAMID_H
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "vulkan_context.h"
+#include "gpu_allocator.h"
+#include "pipeline.h"
+#include "pipeline_builder.h"
+#include "pipeline_registry.h"
+#include "spirv_reflect.h"
+
+// Matches the pyramid shader's local size
+#define DEPTH_PYRAMID_WORKGROUP_SIZE 8
+#define DEPTH_PYRAMID_MAX_LEVELS 16
+
+// Min and max live in two layers of a single channel image, R32_SFLOAT storage needs no extended formats
+#define DEPTH_PYRAMID_FORMAT VK_FORMAT_R32_SFLOAT
+#define DEPTH_PYRAMID_MIN_LAYER 0
+#define DEPTH_PYRAMID_MAX_LAYER 1
+#define DEPTH_PYRAMID_LAYER_COUNT 2
+
+// Matches the pyramid shader's push constant block
+typedef struct {
+    uint32_t source_size[2];
+    uint32_t destination_size[2];
+    uint32_t depth_source;
+} DepthPyramidConstants;
+
+// Hierarchical min/max depth, level 0 is half the depth attachment and each level halves again down to 1x1.
+// Sized for one depth extent, rebuilt with the render graph
+typedef struct {
+    VkDevice device;
+    GpuAllocator *allocator;
+    VkImage image;
+    GpuAllocation allocation;
+    VkImageView view; // every level, sampled by the occlusion test
+    VkImageView level_views[DEPTH_PYRAMID_MAX_LEVELS];
+    uint32_t level_count;
+    VkExtent2D depth_extent;
+    VkExtent2D extent; // level 0
+    VkSampler sampler; // nearest, texelFetch only
+    VkDescriptorPool descriptor_pool;
+    VkDescriptorSet descriptor_sets[DEPTH_PYRAMID_MAX_LEVELS];
+    VkPipelineLayout pipeline_layout;
+    PipelineFuture *pipeline;
+} DepthPyramid;
+
+// Pyramid creation, the reduction pipeline comes from the registry so rebuilds reuse it
+DepthPyramid *create_depth_pyramid(VulkanContext *v_ctx, PipelineRegistry *registry, PipelineBuilder *builder,
+    const ShaderBinary *comp, VkExtent2D depth_extent);
+
+// The depth view changes with every render graph, so it is bound after the graph compiles
+void set_depth_pyramid_source(DepthPyramid *pyramid, VkImageView depth_view);
+
+// Returns false while the reduction pipeline is still compiling, the pyramid contents are undefined then
+bool record_depth_pyramid(VkCommandBuffer command_buffer, const DepthPyramid *pyramid);
+
+// Cleanup
+void destroy_depth_pyramid(DepthPyramid *pyramid);
+
+#endif
@@ -26,10 +26,13 @@ const char* DEVICE_EXTENSIONS[] = {
 #endif
 };
 
+// The swapchain extension is always first so headless devices can skip it
+#define HEADLESS_DEVICE_EXTENSION_OFFSET 1
+
 /*
 * Context creation
 */
-VkInstance create_instance() {
+VkInstance create_instance(bool headless) {
     if (ENABLE_VALIDATION_LAYERS) {
         if (!check_validation_layer_support(VALIDATION_LAYER_COUNT, VALIDATION_LAYERS)) {
             fprintf(stderr, "validation layers requested, but not supported!\n");
@@ -37,13 +40,19 @@ VkInstance create_instance() {
         }
     }
 
+    // Feature chains and device UUIDs need at least Vulkan 1.1
+    if (get_instance_api_version() < VK_API_VERSION_1_1) {
+        fprintf(stderr, "Vulkan 1.1 or newer is required\n");
+        return NULL;
+    }
+
     VkApplicationInfo app_info;
     app_info.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
     app_info.pApplicationName = "Renderer";
     app_info.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
     app_info.pEngineName = "No Engine";
     app_info.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-    app_info.apiVersion = VK_API_VERSION_1_0;
+    app_info.apiVersion = get_instance_api_version();
     app_info.pNext = NULL;
 
     VkInstanceCreateInfo create_info;
@@ -51,8 +60,10 @@ VkInstance create_instance() {
     create_info.pApplicationInfo = &app_info;
 
     // Get extensions
+    Arena *scratch = get_scratch_arena();
+    ArenaMark mark = get_arena_mark(scratch);
     uint32_t extention_count = 0;
-    const char **extension_names = get_required_instance_extensions(&extention_count);
+    const char **extension_names = get_required_instance_extensions(scratch, headless, &extention_count);
     if (extension_names == NULL) {
         return NULL;
     }
@@ -74,18 +85,19 @@ VkInstance create_instance() {
 
     // Create instance
     VkInstance instance;
-    if (vkCreateInstance(&create_info, NULL, &instance) != VK_SUCCESS) {
+    VkResult result = vkCreateInstance(&create_info, get_host_allocator(), &instance);
+    reset_arena_to_mark(scratch, mark);
+    if (result != VK_SUCCESS) {
         fprintf(stderr, "failed to create VkInstance\n");
         return NULL;
     }
 
-    free(extension_names);
     return instance;
 }
 
 VkSurfaceKHR create_surface(VkInstance instance, GLFWwindow *window) {
     VkSurfaceKHR surface;
-    if (glfwCreateWindowSurface(instance, window, NULL, &surface) != VK_SUCCESS) {
+    if (glfwCreateWindowSurface(instance, window, get_host_allocator(), &surface) != VK_SUCCESS) {
         return NULL;
     }
     return surface;
@@ -94,44 +106,232 @@ VkSurfaceKHR create_surface(VkInstance instance, GLFWwindow *window) {
 /*
 * Device creation
 */
+// Optional extensions that later features make use of when present
+const int SCORED_DEVICE_EXTENSION_COUNT = 5;
+const char *SCORED_DEVICE_EXTENSIONS[] = {
+    "VK_KHR_timeline_semaphore",
+    "VK_EXT_descriptor_indexing",
+    "VK_KHR_draw_indirect_count",
+    "VK_EXT_memory_budget",
+    "VK_KHR_dynamic_rendering"
+};
+
+static bool has_device_extension(VkExtensionProperties *extensions, uint32_t extension_count, const char *name) {
+    for (uint32_t i = 0; i < extension_count; ++i) {
+        if (strcmp(extensions[i].extensionName, name) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+DeviceScore score_physical_device(VkPhysicalDevice physical_device) {
+    DeviceScore score;
+
+    // Device type dominates, a discrete GPU always beats an integrated one
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physical_device, &properties);
+    switch (properties.deviceType) {
+        case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU: score.type = 10000; break;
+        case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU: score.type = 5000; break;
+        case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU: score.type = 2000; break;
+        case VK_PHYSICAL_DEVICE_TYPE_CPU: score.type = 500; break;
+        default: score.type = 0; break;
+    }
+
+    // 100 points per GiB of device local memory, capped at 32 GiB
+    VkPhysicalDeviceMemoryProperties memory_properties;
+    vkGetPhysicalDeviceMemoryProperties(physical_device, &memory_properties);
+    VkDeviceSize device_local = 0;
+    for (uint32_t i = 0; i < memory_properties.memoryHeapCount; ++i) {
+        if (memory_properties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) {
+            device_local += memory_properties.memoryHeaps[i].size;
+        }
+    }
+    VkDeviceSize device_local_gib = device_local / (1024ull * 1024 * 1024);
+    score.memory = (int)(device_local_gib > 32 ? 32 : device_local_gib) * 100;
+
+    VkPhysicalDeviceLimits *limits = &properties.limits;
+    score.limits = (int)(limits->maxImageDimension2D / 256)
+        + (int)(limits->maxComputeSharedMemorySize / 1024)
+        + (int)(limits->maxPerStageDescriptorSampledImages > 1024 ? 64 : limits->maxPerStageDescriptorSampledImages / 16)
+        + (int)limits->maxSamplerAnisotropy;
+
+    Arena *scratch = get_scratch_arena();
+    ArenaMark mark = get_arena_mark(scratch);
+    uint32_t extension_count = 0;
+    vkEnumerateDeviceExtensionProperties(physical_device, NULL, &extension_count, NULL);
+    VkExtensionProperties *extensions = arena_alloc(scratch, sizeof(VkExtensionProperties) * extension_count);
+    score.extensions = 0;
+    if (extensions != NULL) {
+        vkEnumerateDeviceExtensionProperties(physical_device, NULL, &extension_count, extensions);
+        for (int i = 0; i < SCORED_DEVICE_EXTENSION_COUNT; ++i) {
+            if (has_device_extension(extensions, extension_count, SCORED_DEVICE_EXTENSIONS[i])) {
+                score.extensions += 100;
+            }
+        }
+    }
+    reset_arena_to_mark(scratch, mark);
+
+    score.total = score.type + score.memory + score.limits + score.extensions;
+    return score;
+}
+
+static char to_lower(char c) {
+    return (c >= 'A' && c <= 'Z') ? (char)(c - 'A' + 'a') : c;
+}
+
+static bool contains_ignore_case(const char *haystack, const char *needle) {
+    size_t needle_length = strlen(needle);
+    for (; *haystack != '\0'; ++haystack) {
+        size_t i = 0;
+        while (i < needle_length && haystack[i] != '\0' && to_lower(haystack[i]) == to_lower(needle[i])) {
+            ++i;
+        }
+        if (i == needle_length) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Accepts 32 hex digits with or without dashes
+static bool parse_device_uuid(const char *text, uint8_t uuid[VK_UUID_SIZE]) {
+    uint32_t digits = 0;
+    for (; *text != '\0'; ++text) {
+        if (*text == '-') { continue; }
+
+        char c = to_lower(*text);
+        int value;
+        if (c >= '0' && c <= '9') {
+            value = c - '0';
+        } else if (c >= 'a' && c <= 'f') {
+            value = c - 'a' + 10;
+        } else {
+            return false;
+        }
+
+        if (digits >= VK_UUID_SIZE * 2) { return false; }
+        uuid[digits / 2] = (uint8_t)((digits % 2 == 0) ? value << 4 : uuid[digits / 2] | value);
+        ++digits;
+    }
+    return digits == VK_UUID_SIZE * 2;
+}
+
+static bool is_index_string(const char *text) {
+    if (*text == '\0') { return false; }
+    for (; *text != '\0'; ++text) {
+        if (*text < '0' || *text > '9') { return false; }
+    }
+    return true;
+}
+
+// VRENDER_DEVICE selects a device by enumeration index, UUID or part of its name
+static bool matches_device_override(VkPhysicalDevice physical_device, uint32_t index, const char *override) {
+    if (is_index_string(override)) {
+        return (uint32_t)strtoul(override, NULL, 10) == index;
+    }
+
+    uint8_t uuid[VK_UUID_SIZE];
+    if (parse_device_uuid(override, uuid)) {
+        VkPhysicalDeviceIDProperties id_properties;
+        id_properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ID_PROPERTIES;
+        id_properties.pNext = NULL;
+
+        VkPhysicalDeviceProperties2 properties;
+        properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+        properties.pNext = &id_properties;
+        vkGetPhysicalDeviceProperties2(physical_device, &properties);
+        return memcmp(id_properties.deviceUUID, uuid, VK_UUID_SIZE) == 0;
+    }
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physical_device, &properties);
+    return contains_ignore_case(properties.deviceName, override);
+}
+
 VkPhysicalDevice get_physical_device(VkInstance instance, VkSurfaceKHR surface) {
     // Get all available physical devices
     uint32_t physical_device_count = 0;
     vkEnumeratePhysicalDevices(instance, &physical_device_count, NULL);
     if (physical_device_count == 0) { return VK_NULL_HANDLE; }
 
-    VkPhysicalDevice *physical_devices = malloc(sizeof(VkPhysicalDevice) * physical_device_count);
+    Arena *scratch = get_scratch_arena();
+    ArenaMark mark = get_arena_mark(scratch);
+    VkPhysicalDevice *physical_devices = arena_alloc(scratch, sizeof(VkPhysicalDevice) * physical_device_count);
     if (physical_devices == NULL) { return VK_NULL_HANDLE; }
     vkEnumeratePhysicalDevices(instance, &physical_device_count, physical_devices);
 
-    // Choose a physical device
+    const char *override = getenv(PHYSICAL_DEVICE_ENV);
+    if (override != NULL && *override == '\0') {
+        override = NULL;
+    }
+
+    // Rank every suitable device, headless contexts pass a null surface
     VkPhysicalDevice physical_device = VK_NULL_HANDLE;
-    for (int i = 0; i < physical_device_count; ++i) {
-        if (is_physical_device_suitable(physical_devices[i], surface)) {
+    VkPhysicalDevice forced_device = VK_NULL_HANDLE;
+    int best_score = -1;
+    for (uint32_t i = 0; i < physical_device_count; ++i) {
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(physical_devices[i], &properties);
+
+        if (!is_physical_device_suitable(physical_devices[i], surface)) {
+            printf("[DEVICE] %u: %s (unsuitable)\n", i, properties.deviceName);
+            continue;
+        }
+
+        DeviceScore score = score_physical_device(physical_devices[i]);
+        printf("[DEVICE] %u: %s score %d (type %d, memory %d, limits %d, extensions %d)\n", i, properties.deviceName,
+            score.total, score.type, score.memory, score.limits, score.extensions);
+
+        if (override != NULL && forced_device == VK_NULL_HANDLE && matches_device_override(physical_devices[i], i, override)) {
+            forced_device = physical_devices[i];
+        }
+        if (score.total > best_score) {
+            best_score = score.total;
             physical_device = physical_devices[i];
-            break;
         }
     }
 
-    free(physical_devices);
+    if (override != NULL) {
+        if (forced_device != VK_NULL_HANDLE) {
+            physical_device = forced_device;
+        } else {
+            fprintf(stderr, "%s=%s matched no suitable device, using the best ranked one\n", PHYSICAL_DEVICE_ENV, override);
+        }
+    }
+
+    if (physical_device != VK_NULL_HANDLE) {
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(physical_device, &properties);
+        printf("[DEVICE] Selected %s%s\n", properties.deviceName, physical_device == forced_device ? " (forced)" : "");
+    }
+
+    reset_arena_to_mark(scratch, mark);
     return physical_device;
 }
 
 bool is_physical_device_suitable(VkPhysicalDevice physical_device, VkSurfaceKHR surface) {
+    uint32_t required_extension_count = 0;
+    const char **required_extensions = get_device_extensions(surface, &required_extension_count);
+
     // Check if required device extensions are within device extension properties
     uint32_t available_extension_count;
     vkEnumerateDeviceExtensionProperties(physical_device, NULL, &available_extension_count, NULL);
 
-    VkExtensionProperties *available_extensions = malloc(sizeof(VkExtensionProperties) * available_extension_count);
+    Arena *scratch = get_scratch_arena();
+    ArenaMark mark = get_arena_mark(scratch);
+    VkExtensionProperties *available_extensions = arena_alloc(scratch, sizeof(VkExtensionProperties) * available_extension_count);
+    if (available_extensions == NULL) { return false; }
     vkEnumerateDeviceExtensionProperties(physical_device, NULL, &available_extension_count, available_extensions);
 
     bool is_suitable = true;
-    for (int i = 0; i < DEVICE_EXTENSION_COUNT; ++i) {
+    for (int i = 0; i < required_extension_count; ++i) {
         bool found = false;
 
         // Check if the required extension is in the list of available extensions
         for (int j = 0; j < available_extension_count; ++j) {
-            if (strcmp(DEVICE_EXTENSIONS[i], available_extensions[j].extensionName) == 0) {
+            if (strcmp(required_extensions[i], available_extensions[j].extensionName) == 0) {
                 found = true;
                 break;
             }
@@ -145,25 +345,39 @@ bool is_physical_device_suitable(VkPhysicalDevice physical_device, VkSurfaceKHR
         }
     }
 
-    SwapChainSupportDetails *details = query_swapchain_support_details(physical_device, surface);
-    if (details == NULL) { return false; }
+    if (is_suitable && !has_required_device_features(physical_device)) {
+        fprintf(stderr, "device lacks required features\n");
+        is_suitable = false;
+    }
 
-    bool supports_swap_chain = details->format_count > 0 && details->present_mode_count > 0;
+    // Headless devices render to offscreen images, no swapchain needed
+    bool supports_swap_chain = true;
+    if (surface != VK_NULL_HANDLE) {
+        SwapChainSupportDetails *details = query_swapchain_support_details(scratch, physical_device, surface);
+        supports_swap_chain = details != NULL && details->format_count > 0 && details->present_mode_count > 0;
+    }
 
-    destroy_swapchain_support_details(details);
-    free(available_extensions);
+    reset_arena_to_mark(scratch, mark);
     return is_suitable && supports_swap_chain;
 }
 
-VkDevice create_logical_device(VkPhysicalDevice physical_device, VkQueueFamilyProperties *family_properties, uint32_t family_count) {
+VkDevice create_logical_device(VkPhysicalDevice physical_device, VkSurfaceKHR surface, VkQueueFamilyProperties *family_properties, uint32_t family_count, DeviceFeatures *enabled_features) {
+    // Only requested features are enabled, the chain replaces pEnabledFeatures
+    if (!select_device_features(physical_device, surface != VK_NULL_HANDLE, enabled_features)) {
+        fprintf(stderr, "failed to select device features\n");
+        return NULL;
+    }
+
     // Begin filling device struct
     VkDeviceCreateInfo create_info;
     create_info.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
-    create_info.pNext = NULL;
+    create_info.pNext = &enabled_features->core;
     create_info.flags = 0;
 
     // Device queue families
-    VkDeviceQueueCreateInfo *queue_create_infos = create_queue_family_create_infos(family_properties, family_count);
+    Arena *scratch = get_scratch_arena();
+    ArenaMark mark = get_arena_mark(scratch);
+    VkDeviceQueueCreateInfo *queue_create_infos = create_queue_family_create_infos(scratch, family_properties, family_count);
     if (queue_create_infos == NULL) {
         fprintf(stderr, "failed to create device queue create infos\n");
         return NULL;
@@ -179,67 +393,110 @@ VkDevice create_logical_device(VkPhysicalDevice physical_device, VkQueueFamilyPr
         create_info.ppEnabledLayerNames = VALIDATION_LAYERS;
     }
 
-    // Extensions
-    create_info.enabledExtensionCount = DEVICE_EXTENSION_COUNT;
-    create_info.ppEnabledExtensionNames = DEVICE_EXTENSIONS;
+    // Extensions, present pacing ones only when their features were selected
+    uint32_t required_extension_count = 0;
+    const char **required_extensions = get_device_extensions(surface, &required_extension_count);
+    const char **extensions = arena_alloc(scratch, sizeof(const char *) * (required_extension_count + 2));
+    if (extensions == NULL) { return NULL; }
+
+    uint32_t extension_count = required_extension_count;
+    memcpy(extensions, required_extensions, sizeof(const char *) * required_extension_count);
+    if (enabled_features->present_extensions) {
+        extensions[extension_count++] = VK_KHR_PRESENT_ID_EXTENSION_NAME;
+        extensions[extension_count++] = VK_KHR_PRESENT_WAIT_EXTENSION_NAME;
+    }
+    create_info.ppEnabledExtensionNames = extensions;
+    create_info.enabledExtensionCount = extension_count;
 
-    // Physical device features
-    VkPhysicalDeviceFeatures device_features;
-    vkGetPhysicalDeviceFeatures(physical_device, &device_features);
-    create_info.pEnabledFeatures = &device_features;
+    create_info.pEnabledFeatures = NULL;
 
     VkDevice logical_device;
-    if(vkCreateDevice(physical_device, &create_info, NULL, &logical_device) != VK_SUCCESS) {
+    VkResult result = vkCreateDevice(physical_device, &create_info, get_host_allocator(), &logical_device);
+    reset_arena_to_mark(scratch, mark);
+    if (result != VK_SUCCESS) {
         return NULL;
     }
 
-    free(queue_create_infos);
     return logical_device;
 }
 
+const char **get_device_extensions(VkSurfaceKHR surface, uint32_t *extension_count) {
+    if (surface == VK_NULL_HANDLE) {
+        *extension_count = DEVICE_EXTENSION_COUNT - HEADLESS_DEVICE_EXTENSION_OFFSET;
+        return &DEVICE_EXTENSIONS[HEADLESS_DEVICE_EXTENSION_OFFSET];
+    }
+
+    *extension_count = DEVICE_EXTENSION_COUNT;
+    return DEVICE_EXTENSIONS;
+}
+
+/*
+* Memory
+*/
+uint32_t find_memory_type(VkPhysicalDevice physical_device, uint32_t type_filter, VkMemoryPropertyFlags properties) {
+    VkPhysicalDeviceMemoryProperties memory_properties;
+    vkGetPhysicalDeviceMemoryProperties(physical_device, &memory_properties);
+
+    for (uint32_t i = 0; i < memory_properties.memoryTypeCount; ++i) {
+        if ((type_filter & (1 << i))
+            && (memory_properties.memoryTypes[i].propertyFlags & properties) == properties) {
+            return i;
+        }
+    }
+
+    return UINT32_MAX;
+}
+
 /*
 * Instance extension helpers
 */
-VkExtensionProperties *get_available_instance_extensions(uint32_t *extension_count) {
+VkExtensionProperties *get_available_instance_extensions(Arena *scratch, uint32_t *extension_count) {
     vkEnumerateInstanceExtensionProperties(NULL, extension_count, NULL);
-    VkExtensionProperties *properties = malloc(sizeof(VkExtensionProperties) * (*extension_count));
+    VkExtensionProperties *properties = arena_alloc(scratch, sizeof(VkExtensionProperties) * (*extension_count));
     if (properties == NULL) {
         fprintf(stderr, "failed to alloc extension properties\n");
+        return NULL;
     }
 
     vkEnumerateInstanceExtensionProperties(NULL, extension_count, properties);
     return properties;
 }
 
-const char **get_required_instance_extensions(uint32_t *extension_count) {
+const char **get_required_instance_extensions(Arena *scratch, bool headless, uint32_t *extension_count) {
+    // Headless instances have no window system, so skip the surface extensions
     uint32_t glfw_extension_count = 0;
-    const char **glfw_extensions = glfwGetRequiredInstanceExtensions(&glfw_extension_count);
-    if (glfw_extensions == NULL) {
-        fprintf(stderr, "failed to retrieve GLFW extensions\n");
-        return NULL;
+    const char **glfw_extensions = NULL;
+    if (!headless) {
+        glfw_extensions = glfwGetRequiredInstanceExtensions(&glfw_extension_count);
+        if (glfw_extensions == NULL) {
+            fprintf(stderr, "failed to retrieve GLFW extensions\n");
+            return NULL;
+        }
     }
 
     // Calculate total extension count
     // +1 for VK_KHR_PORTABILITY_ENUMERATION_EXTENSION_NAME
-    uint32_t total_extension_count = glfw_extension_count + 2;
+    uint32_t total_extension_count = glfw_extension_count + 1;
     if (ENABLE_VALIDATION_LAYERS) {
         ++total_extension_count;
     }
 
-    const char **extensions = malloc(total_extension_count * sizeof(char*));
+    const char **extensions = arena_alloc(scratch, total_extension_count * sizeof(char*));
     if (extensions == NULL) {
         fprintf(stderr, "Failed to allocate memory for extensions array\n");
         return NULL;
     }
 
-    memcpy(extensions, glfw_extensions, glfw_extension_count * sizeof(char*));
+    if (glfw_extension_count > 0) {
+        memcpy(extensions, glfw_extensions, glfw_extension_count * sizeof(char*));
+    }
 
     // Add additional extensions required by vulkan spec
+    // Vulkan 1.1 is required, so vkGetPhysicalDeviceProperties2 and friends are core
     extensions[glfw_extension_count] = VK_KHR_PORTABILITY_ENUMERATION_EXTENSION_NAME;
-    extensions[glfw_extension_count + 1] = "VK_KHR_get_physical_device_properties2";
     // Add validation layer extension if enabled
     if (ENABLE_VALIDATION_LAYERS) {
-        extensions[glfw_extension_count + 2] = VK_EXT_DEBUG_UTILS_EXTENSION_NAME;
+        extensions[glfw_extension_count + 1] = VK_EXT_DEBUG_UTILS_EXTENSION_NAME;
     }
 
     *extension_count = total_extension_count;
@@ -249,14 +506,25 @@ const char **get_required_instance_extensions(uint32_t *extension_count) {
 /*
 * Queue families
 */
-VkQueueFamilyProperties *get_queue_family_properties(VkPhysicalDevice physical_device, uint32_t *family_count) {
+VkQueueFamilyProperties *get_queue_family_properties(Arena *scratch, VkPhysicalDevice physical_device, uint32_t *family_count) {
     vkGetPhysicalDeviceQueueFamilyProperties(physical_device, family_count, NULL);
-    VkQueueFamilyProperties *family_properties = malloc(sizeof(VkQueueFamilyProperties) * (*family_count));
+    VkQueueFamilyProperties *family_properties = arena_alloc(scratch, sizeof(VkQueueFamilyProperties) * (*family_count));
     if (family_properties == NULL) { return NULL; }
     vkGetPhysicalDeviceQueueFamilyProperties(physical_device, family_count, family_properties);
     return family_properties;
 }
 
+// First family with the wanted flags and none of the excluded ones
+int16_t find_dedicated_queue_family(VkQueueFamilyProperties *family_properties, uint32_t family_count, VkQueueFlags wanted, VkQueueFlags excluded, int16_t fallback) {
+    for (uint32_t i = 0; i < family_count; ++i) {
+        VkQueueFlags flags = family_properties[i].queueFlags;
+        if (family_properties[i].queueCount > 0 && (flags & wanted) == wanted && !(flags & excluded)) {
+            return (int16_t)i;
+        }
+    }
+    return fallback;
+}
+
 QueueFamilyIndices *get_unique_queue_family_indices(VkPhysicalDevice physical_device, VkSurfaceKHR surface, VkQueueFamilyProperties *family_properties, uint32_t family_count) {
     QueueFamilyIndices *indices = malloc(sizeof(QueueFamilyIndices));
     if (indices == NULL) { return NULL; }
@@ -273,6 +541,14 @@ QueueFamilyIndices *get_unique_queue_family_indices(VkPhysicalDevice physical_de
             indices->graphics_index = i;
         }
 
+        // Headless contexts never present
+        if (surface == VK_NULL_HANDLE) {
+            if (indices->graphics_index >= 0) {
+                break;
+            }
+            continue;
+        }
+
         // Check if index supports surface
         VkBool32 present_support = false;
         vkGetPhysicalDeviceSurfaceSupportKHR(physical_device, i, surface, &present_support);
@@ -286,19 +562,30 @@ QueueFamilyIndices *get_unique_queue_family_indices(VkPhysicalDevice physical_de
         }
     }
 
-    if (indices->graphics_index < 0 || indices->present_index < 0) {
+    bool needs_present = surface != VK_NULL_HANDLE;
+    if (indices->graphics_index < 0 || (needs_present && indices->present_index < 0)) {
         free(indices);
         return NULL;
     }
+
+    // Async queues prefer families without graphics, otherwise share the graphics queue
+    indices->compute_index = find_dedicated_queue_family(family_properties, family_count,
+        VK_QUEUE_COMPUTE_BIT, VK_QUEUE_GRAPHICS_BIT, indices->graphics_index);
+    indices->transfer_index = find_dedicated_queue_family(family_properties, family_count,
+        VK_QUEUE_TRANSFER_BIT, VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT, -1);
+    if (indices->transfer_index < 0) {
+        indices->transfer_index = find_dedicated_queue_family(family_properties, family_count,
+            VK_QUEUE_TRANSFER_BIT, VK_QUEUE_GRAPHICS_BIT, indices->graphics_index);
+    }
     return indices;
 }
 
-VkDeviceQueueCreateInfo *create_queue_family_create_infos(VkQueueFamilyProperties *family_properties, uint32_t family_count) {
-    VkDeviceQueueCreateInfo *queue_create_infos = malloc(sizeof(VkDeviceQueueCreateInfo) * family_count);
+VkDeviceQueueCreateInfo *create_queue_family_create_infos(Arena *scratch, VkQueueFamilyProperties *family_properties, uint32_t family_count) {
+    VkDeviceQueueCreateInfo *queue_create_infos = arena_alloc(scratch, sizeof(VkDeviceQueueCreateInfo) * family_count);
     if (queue_create_infos == NULL) { return NULL; }
 
-    // Create queue create infos
-    float priority = 1.0f;
+    // Create queue create infos, the priority must outlive vkCreateDevice
+    static const float priority = 1.0f;
     for (int i = 0; i < family_count; ++i) {
 
         VkDeviceQueueCreateInfo queue_create_info;
@@ -309,11 +596,7 @@ VkDeviceQueueCreateInfo *create_queue_family_create_infos(VkQueueFamilyPropertie
         queue_create_info.queueCount = 1;
         queue_create_info.pQueuePriorities = &priority;
 
-        // TODO: For the future can use multiple queues per family
-        // for now use 1 queue, priority = 1.0f
-        // queue_create_info.queueCount = family_properties[i].queueCount;
-        // queue_create_info.pQueuePriorities = &(queue_priorities[family_start_index]);
-
+        // One queue per family covers the graphics, compute and transfer queues
         queue_create_infos[i] = queue_create_info;
     }
 
@@ -324,33 +607,42 @@ VkDeviceQueueCreateInfo *create_queue_family_create_infos(VkQueueFamilyPropertie
 * Debugging
 */
 void print_instance_extensions() {
+    Arena *scratch = get_scratch_arena();
+    ArenaMark mark = get_arena_mark(scratch);
+
     uint32_t required_count = 0;
-    const char **required_extensions = get_required_instance_extensions(&required_count);
+    const char **required_extensions = get_required_instance_extensions(scratch, false, &required_count);
+    if (required_extensions == NULL) { return; }
     printf("Required extenstions: \n");
     for (int i = 0; i < required_count; ++i) {
         printf("\t- %s\n", required_extensions[i]);
     }
 
     uint32_t available_count = 0;
-    VkExtensionProperties *available_extensions = get_available_instance_extensions(&available_count);
+    VkExtensionProperties *available_extensions = get_available_instance_extensions(scratch, &available_count);
+    if (available_extensions == NULL) { return; }
     printf("Available instance extenstions: \n");
     for (int i = 0; i < available_count; ++i) {
         printf("\t- %s\n", available_extensions[i].extensionName);
     }
 
-    free(required_extensions);
-    free(available_extensions);
+    reset_arena_to_mark(scratch, mark);
 }
 
 void print_physical_device_extensions(VkPhysicalDevice physical_device) {
     uint32_t available_extension_count;
     vkEnumerateDeviceExtensionProperties(physical_device, NULL, &available_extension_count, NULL);
 
-    VkExtensionProperties *available_extensions = malloc(sizeof(VkExtensionProperties) * available_extension_count);
+    Arena *scratch = get_scratch_arena();
+    ArenaMark mark = get_arena_mark(scratch);
+    VkExtensionProperties *available_extensions = arena_alloc(scratch, sizeof(VkExtensionProperties) * available_extension_count);
+    if (available_extensions == NULL) { return; }
     vkEnumerateDeviceExtensionProperties(physical_device, NULL, &available_extension_count, available_extensions);
 
     printf("Available physical device extenstions: \n");
     for (int i = 0; i < available_extension_count; ++i) {
         printf("\t- %s\n", available_extensions[i].extensionName);
     }
+
+    reset_arena_to_mark(scratch, mark);
 }
\ No newline at end of file
@@ -12,6 +12,9 @@
 #include <stdlib.h>
 #include <stdio.h>
 
+// Forces a physical device by index, UUID or name
+#define PHYSICAL_DEVICE_ENV "VRENDER_DEVICE"
+
 // Layers
 extern const bool ENABLE_VALIDATION_LAYERS;
 extern const char *VALIDATION_LAYERS[];
@@ -19,23 +22,37 @@ extern const char *VALIDATION_LAYERS[];
 // Extensions
 extern const char *DEVICE_EXTENSIONS[];
 
+typedef struct {
+    int type;
+    int memory;
+    int limits;
+    int extensions;
+    int total;
+} DeviceScore;
+
 // Context creation
-VkInstance create_instance();
+VkInstance create_instance(bool headless);
 VkSurfaceKHR create_surface(VkInstance instance, GLFWwindow *window);
 
 // Device
 VkPhysicalDevice get_physical_device(VkInstance instance, VkSurfaceKHR surface);
+DeviceScore score_physical_device(VkPhysicalDevice physical_device);
 bool is_physical_device_suitable(VkPhysicalDevice physical_device, VkSurfaceKHR surface);
-VkDevice create_logical_device(VkPhysicalDevice physical_device, VkQueueFamilyProperties *family_properties, uint32_t family_count);
+VkDevice create_logical_device(VkPhysicalDevice physical_device, VkSurfaceKHR surface, VkQueueFamilyProperties *family_properties, uint32_t family_count, DeviceFeatures *enabled_features);
+const char **get_device_extensions(VkSurfaceKHR surface, uint32_t *extension_count);
+
+// Memory
+uint32_t find_memory_type(VkPhysicalDevice physical_device, uint32_t type_filter, VkMemoryPropertyFlags properties);
 
 // Instance extension helpers
-VkExtensionProperties *get_available_instance_extensions(uint32_t *extension_count);
-const char **get_required_instance_extensions(uint32_t *extension_count);
+VkExtensionProperties *get_available_instance_extensions(Arena *scratch, uint32_t *extension_count);
+const char **get_required_instance_extensions(Arena *scratch, bool headless, uint32_t *extension_count);
 
 // Queue families
-VkQueueFamilyProperties *get_queue_family_properties(VkPhysicalDevice physical_device, uint32_t *family_count);
+VkQueueFamilyProperties *get_queue_family_properties(Arena *scratch, VkPhysicalDevice physical_device, uint32_t *family_count);
+int16_t find_dedicated_queue_family(VkQueueFamilyProperties *family_properties, uint32_t family_count, VkQueueFlags wanted, VkQueueFlags excluded, int16_t fallback);
 QueueFamilyIndices *get_unique_queue_family_indices(VkPhysicalDevice physical_device, VkSurfaceKHR surface, VkQueueFamilyProperties *family_properties, uint32_t family_count);
-VkDeviceQueueCreateInfo *create_queue_family_create_infos(VkQueueFamilyProperties *family_properties, uint32_t family_count);
+VkDeviceQueueCreateInfo *create_queue_family_create_infos(Arena *scratch, VkQueueFamilyProperties *family_properties, uint32_t family_count);
 
 // Cleanup
 void destroy_vulkan_context(VulkanContext *device);
@@ -0,0 +1,173 @@
+#include "device_features.h"
+
+/*
+* Requests
+*/
+// Only what a subsystem checks or relies on, everything else stays disabled, including robustBufferAccess
+#define REQUEST(chain, member, required) { DEVICE_FEATURE(chain, member), #member, required }
+const DeviceFeatureRequest DEVICE_FEATURE_REQUESTS[] = {
+    // Indirect drawing, the GPU culler picks its draw path from these
+    REQUEST(core.features, multiDrawIndirect, false),
+    REQUEST(vulkan12, drawIndirectCount, false),
+
+    // Synchronization, timeline deletion points in the deletion queue
+    REQUEST(vulkan12, timelineSemaphore, false),
+
+    // Presentation, frame pacing in the present policy
+    REQUEST(present_id, presentId, false),
+    REQUEST(present_wait, presentWait, false)
+};
+const uint32_t DEVICE_FEATURE_REQUEST_COUNT = sizeof(DEVICE_FEATURE_REQUESTS) / sizeof(DEVICE_FEATURE_REQUESTS[0]);
+#undef REQUEST
+
+/*
+* Chain setup
+*/
+uint32_t get_instance_api_version(void) {
+    uint32_t api_version = VK_API_VERSION_1_0;
+    if (vkEnumerateInstanceVersion(&api_version) != VK_SUCCESS) {
+        return VK_API_VERSION_1_0;
+    }
+    return api_version < MAX_VULKAN_API_VERSION ? api_version : MAX_VULKAN_API_VERSION;
+}
+
+static void link_device_features(DeviceFeatures *features) {
+    features->core.pNext = NULL;
+    features->vulkan12.pNext = NULL;
+    features->vulkan13.pNext = NULL;
+
+    void **next = &features->core.pNext;
+    uint32_t api_version = features->api_version;
+    if (api_version >= VK_API_VERSION_1_2) {
+        *next = &features->vulkan11;
+        features->vulkan11.pNext = &features->vulkan12;
+        next = &features->vulkan12.pNext;
+    }
+    if (api_version >= VK_API_VERSION_1_3) {
+        *next = &features->vulkan13;
+        next = &features->vulkan13.pNext;
+    }
+    if (features->present_extensions) {
+        *next = &features->present_id;
+        features->present_id.pNext = &features->present_wait;
+    }
+}
+
+// Only structs the device version and extensions know about are linked into the chain
+void init_device_features(DeviceFeatures *features, uint32_t api_version, bool present_extensions) {
+    memset(features, 0, sizeof(DeviceFeatures));
+    features->api_version = api_version;
+    features->present_extensions = present_extensions;
+
+    features->core.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    features->vulkan11.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_1_FEATURES;
+    features->vulkan12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+    features->vulkan13.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES;
+    features->present_id.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR;
+    features->present_wait.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR;
+    link_device_features(features);
+}
+
+/*
+* Negotiation
+*/
+static VkBool32 *get_feature(DeviceFeatures *features, size_t offset) {
+    return (VkBool32 *)((uint8_t *)features + offset);
+}
+
+static bool is_feature_in_chain(const DeviceFeatures *features, size_t offset) {
+    if (offset >= offsetof(DeviceFeatures, present_id)) {
+        return features->present_extensions;
+    }
+    if (offset >= offsetof(DeviceFeatures, vulkan13)) {
+        return features->api_version >= VK_API_VERSION_1_3;
+    }
+    if (offset >= offsetof(DeviceFeatures, vulkan11)) {
+        return features->api_version >= VK_API_VERSION_1_2;
+    }
+    return true;
+}
+
+static uint32_t get_device_api_version(VkPhysicalDevice physical_device) {
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physical_device, &properties);
+
+    uint32_t instance_version = get_instance_api_version();
+    return properties.apiVersion < instance_version ? properties.apiVersion : instance_version;
+}
+
+// Both extensions are needed together, present wait waits on ids attached by present id
+static bool has_present_extensions(VkPhysicalDevice physical_device) {
+    Arena *scratch = get_scratch_arena();
+    ArenaMark mark = get_arena_mark(scratch);
+
+    uint32_t extension_count = 0;
+    vkEnumerateDeviceExtensionProperties(physical_device, NULL, &extension_count, NULL);
+    VkExtensionProperties *extensions = arena_alloc(scratch, sizeof(VkExtensionProperties) * extension_count);
+    if (extensions == NULL) { return false; }
+    vkEnumerateDeviceExtensionProperties(physical_device, NULL, &extension_count, extensions);
+
+    uint32_t found = 0;
+    for (uint32_t i = 0; i < extension_count; ++i) {
+        if (strcmp(extensions[i].extensionName, VK_KHR_PRESENT_ID_EXTENSION_NAME) == 0
+            || strcmp(extensions[i].extensionName, VK_KHR_PRESENT_WAIT_EXTENSION_NAME) == 0) {
+            ++found;
+        }
+    }
+
+    reset_arena_to_mark(scratch, mark);
+    return found == 2;
+}
+
+// Presentation features are only queried for devices that will create a swapchain
+void query_device_features(VkPhysicalDevice physical_device, bool presenting, DeviceFeatures *supported) {
+    bool present_extensions = presenting && has_present_extensions(physical_device);
+    init_device_features(supported, get_device_api_version(physical_device), present_extensions);
+    vkGetPhysicalDeviceFeatures2(physical_device, &supported->core);
+}
+
+bool has_required_device_features(VkPhysicalDevice physical_device) {
+    DeviceFeatures supported;
+    query_device_features(physical_device, false, &supported);
+
+    for (uint32_t i = 0; i < DEVICE_FEATURE_REQUEST_COUNT; ++i) {
+        const DeviceFeatureRequest *request = &DEVICE_FEATURE_REQUESTS[i];
+        if (request->required && !is_device_feature_enabled(&supported, request->offset)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Enables the intersection of requested and supported features
+bool select_device_features(VkPhysicalDevice physical_device, bool presenting, DeviceFeatures *enabled) {
+    DeviceFeatures supported;
+    query_device_features(physical_device, presenting, &supported);
+    init_device_features(enabled, supported.api_version, supported.present_extensions);
+
+    for (uint32_t i = 0; i < DEVICE_FEATURE_REQUEST_COUNT; ++i) {
+        const DeviceFeatureRequest *request = &DEVICE_FEATURE_REQUESTS[i];
+        if (is_device_feature_enabled(&supported, request->offset)) {
+            *get_feature(enabled, request->offset) = VK_TRUE;
+            continue;
+        }
+
+        if (request->required) {
+            fprintf(stderr, "required device feature %s not supported\n", request->name);
+            return false;
+        }
+        printf("[FEATURES] Optional feature %s unavailable\n", request->name);
+    }
+
+    // The present extensions are only worth enabling together, otherwise drop them from the chain
+    if (enabled->present_extensions && (enabled->present_id.presentId != VK_TRUE || enabled->present_wait.presentWait != VK_TRUE)) {
+        enabled->present_extensions = false;
+        link_device_features(enabled);
+    }
+    return true;
+}
+
+bool is_device_feature_enabled(const DeviceFeatures *features, size_t offset) {
+    if (!is_feature_in_chain(features, offset)) { return false; }
+    return *get_feature((DeviceFeatures *)features, offset) == VK_TRUE;
+}
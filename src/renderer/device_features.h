@@ -0,0 +1,49 @@
+#ifndef DEVICE_FEATURES_H
+#define DEVICE_FEATURES_H
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "arena.h"
+
+// Newest API version the renderer knows how to use
+#define MAX_VULKAN_API_VERSION VK_API_VERSION_1_3
+
+// Feature chain passed to vkGetPhysicalDeviceFeatures2 and vkCreateDevice, do not copy once linked
+typedef struct {
+    uint32_t api_version;
+    bool present_extensions; // VK_KHR_present_id and VK_KHR_present_wait, device must also present
+    VkPhysicalDeviceFeatures2 core;
+    VkPhysicalDeviceVulkan11Features vulkan11;
+    VkPhysicalDeviceVulkan12Features vulkan12;
+    VkPhysicalDeviceVulkan13Features vulkan13;
+    VkPhysicalDevicePresentIdFeaturesKHR present_id;
+    VkPhysicalDevicePresentWaitFeaturesKHR present_wait;
+} DeviceFeatures;
+
+// Identifies one VkBool32 inside DeviceFeatures
+#define DEVICE_FEATURE(chain, member) offsetof(DeviceFeatures, chain.member)
+
+typedef struct {
+    size_t offset;
+    const char *name;
+    bool required;
+} DeviceFeatureRequest;
+
+// Chain setup
+uint32_t get_instance_api_version(void);
+void init_device_features(DeviceFeatures *features, uint32_t api_version, bool present_extensions);
+
+// Negotiation
+void query_device_features(VkPhysicalDevice physical_device, bool presenting, DeviceFeatures *supported);
+bool has_required_device_features(VkPhysicalDevice physical_device);
+bool select_device_features(VkPhysicalDevice physical_device, bool presenting, DeviceFeatures *enabled);
+bool is_device_feature_enabled(const DeviceFeatures *features, size_t offset);
+
+#endif
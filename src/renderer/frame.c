@@ -0,0 +1,298 @@
+#include "frame.h"
+
+/*
+* Frame context creation
+*/
+FrameContext *create_frame_context(VulkanContext *v_ctx, uint32_t frames_in_flight) {
+    if (frames_in_flight < MIN_FRAMES_IN_FLIGHT || frames_in_flight > MAX_FRAMES_IN_FLIGHT) {
+        fprintf(stderr, "frames in flight must be between %d and %d\n", MIN_FRAMES_IN_FLIGHT, MAX_FRAMES_IN_FLIGHT);
+        return NULL;
+    }
+
+    FrameContext *frame_ctx = malloc(sizeof(FrameContext));
+    if (frame_ctx == NULL) { return NULL; }
+
+    frame_ctx->frames_in_flight = frames_in_flight;
+    frame_ctx->frame_index = 0;
+    frame_ctx->frame_number = 0;
+    frame_ctx->image_index = 0;
+    frame_ctx->blocked_ns = 0;
+    frame_ctx->swapchain_out_of_date = false;
+    frame_ctx->swapchain_first_frame = 0;
+    frame_ctx->deletion_queue = create_deletion_queue(v_ctx->device, v_ctx->allocator);
+    if (frame_ctx->deletion_queue == NULL) { return NULL; }
+
+    for (int i = 0; i < frames_in_flight; ++i) {
+        if (!create_frame_slot(v_ctx, &frame_ctx->frames[i])) {
+            fprintf(stderr, "failed to create frame slot [%d]\n", i);
+            return NULL;
+        }
+    }
+
+    return frame_ctx;
+}
+
+bool create_frame_slot(VulkanContext *v_ctx, FrameSlot *slot) {
+    slot->wait_count = 0;
+    slot->submitted_frame = 0;
+
+    // Transient pool, the whole pool is reset once per frame instead of per buffer
+    VkCommandPoolCreateInfo pool_create_info;
+    pool_create_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    pool_create_info.pNext = NULL;
+    pool_create_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+    pool_create_info.queueFamilyIndex = v_ctx->indices->graphics_index;
+    if (vkCreateCommandPool(v_ctx->device, &pool_create_info, get_host_allocator(), &slot->command_pool) != VK_SUCCESS) {
+        fprintf(stderr, "failed to create frame command pool\n");
+        return false;
+    }
+
+    VkCommandBufferAllocateInfo alloc_info;
+    alloc_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    alloc_info.pNext = NULL;
+    alloc_info.commandPool = slot->command_pool;
+    alloc_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    alloc_info.commandBufferCount = 1;
+    if (vkAllocateCommandBuffers(v_ctx->device, &alloc_info, &slot->command_buffer) != VK_SUCCESS) {
+        fprintf(stderr, "failed to allocate frame command buffer\n");
+        return false;
+    }
+
+    VkSemaphoreCreateInfo semaphore_create_info;
+    semaphore_create_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    semaphore_create_info.pNext = NULL;
+    semaphore_create_info.flags = 0;
+    if (vkCreateSemaphore(v_ctx->device, &semaphore_create_info, get_host_allocator(), &slot->image_available) != VK_SUCCESS) {
+        fprintf(stderr, "failed to create frame semaphore\n");
+        return false;
+    }
+
+    // Start signaled so the first wait on each slot returns immediately
+    VkFenceCreateInfo fence_create_info;
+    fence_create_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    fence_create_info.pNext = NULL;
+    fence_create_info.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+    if (vkCreateFence(v_ctx->device, &fence_create_info, get_host_allocator(), &slot->in_flight) != VK_SUCCESS) {
+        fprintf(stderr, "failed to create frame fence\n");
+        return false;
+    }
+
+    return true;
+}
+
+/*
+* Frame loop
+*/
+FrameSlot *get_current_frame_slot(FrameContext *frame_ctx) {
+    return &frame_ctx->frames[frame_ctx->frame_index];
+}
+
+// Waits are consumed by the next end_frame of the current slot
+bool add_frame_wait(FrameContext *frame_ctx, VkSemaphore semaphore, VkPipelineStageFlags stage_mask) {
+    FrameSlot *slot = get_current_frame_slot(frame_ctx);
+    if (slot->wait_count >= MAX_FRAME_WAITS) {
+        fprintf(stderr, "too many frame waits\n");
+        return false;
+    }
+
+    slot->waits[slot->wait_count].semaphore = semaphore;
+    slot->waits[slot->wait_count].stage_mask = stage_mask;
+    ++slot->wait_count;
+    return true;
+}
+
+/*
+* Deferred destruction
+*/
+// Resources retired now may still be used by the frame being recorded
+DeletionPoint get_frame_deletion_point(FrameContext *frame_ctx) {
+    DeletionPoint point;
+    point.frame = frame_ctx->frame_number;
+    point.timeline = VK_NULL_HANDLE;
+    point.timeline_value = 0;
+    return point;
+}
+
+// Each slot only holds its latest frame, so the oldest unsignaled slot bounds what has completed
+uint64_t get_completed_frames(VkDevice device, FrameContext *frame_ctx) {
+    uint64_t completed = frame_ctx->frame_number;
+    for (uint32_t i = 0; i < frame_ctx->frames_in_flight; ++i) {
+        FrameSlot *slot = &frame_ctx->frames[i];
+        if (slot->submitted_frame < completed && vkGetFenceStatus(device, slot->in_flight) != VK_SUCCESS) {
+            completed = slot->submitted_frame;
+        }
+    }
+    return completed;
+}
+
+static void destroy_retired_swapchain(VkDevice device, void *user_data) {
+    destroy_swapchain_context(device, user_data);
+}
+
+// Anything built on the swapchain views must be retired before this, it is destroyed in queue order
+bool retire_swapchain(FrameContext *frame_ctx, SwapchainContext *swapchain_ctx) {
+    DeletionPoint point = get_frame_deletion_point(frame_ctx);
+
+    // Next frame is the first present on the replacement
+    frame_ctx->swapchain_first_frame = frame_ctx->frame_number;
+    return retire_with_callback(frame_ctx->deletion_queue, destroy_retired_swapchain, swapchain_ctx, point);
+}
+
+/*
+* Present pacing
+*/
+// Frame N presents id N + 1, keeps at most max_queued_presents images waiting for scanout
+static void wait_for_queued_presents(VulkanContext *v_ctx, FrameContext *frame_ctx) {
+    uint32_t max_queued = v_ctx->present_policy->max_queued_presents;
+    if (v_ctx->wait_for_present == NULL || max_queued == 0) { return; }
+    if (frame_ctx->frame_number < frame_ctx->swapchain_first_frame + max_queued) { return; }
+
+    uint64_t present_id = frame_ctx->frame_number + 1 - max_queued;
+    VkResult result = v_ctx->wait_for_present(v_ctx->device, v_ctx->swapchain_ctx->swapchain, present_id, PRESENT_WAIT_TIMEOUT_NS);
+    if (result == VK_ERROR_OUT_OF_DATE_KHR) {
+        frame_ctx->swapchain_out_of_date = true;
+    }
+}
+
+VkCommandBuffer begin_frame(VulkanContext *v_ctx, FrameContext *frame_ctx) {
+    FrameSlot *slot = get_current_frame_slot(frame_ctx);
+    uint64_t wait_start = get_trace_time_ns();
+
+    // Only blocks when the GPU is a full ring behind the CPU
+    vkWaitForFences(v_ctx->device, 1, &slot->in_flight, VK_TRUE, UINT64_MAX);
+    if (frame_ctx->deletion_queue->count > 0) {
+        collect_deletion_queue(frame_ctx->deletion_queue, get_completed_frames(v_ctx->device, frame_ctx));
+    }
+
+    if (v_ctx->headless) {
+        frame_ctx->image_index = frame_ctx->frame_number % v_ctx->offscreen_ctx->image_count;
+    } else {
+        wait_for_queued_presents(v_ctx, frame_ctx);
+
+        // Out of date leaves the fence signaled and the semaphore unused, the caller recreates and retries
+        VkResult result = vkAcquireNextImageKHR(v_ctx->device, v_ctx->swapchain_ctx->swapchain, UINT64_MAX,
+            slot->image_available, VK_NULL_HANDLE, &frame_ctx->image_index);
+        if (result == VK_ERROR_OUT_OF_DATE_KHR) {
+            frame_ctx->swapchain_out_of_date = true;
+            frame_ctx->blocked_ns = get_trace_time_ns() - wait_start;
+            return NULL;
+        }
+        if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) {
+            fprintf(stderr, "failed to acquire swapchain image\n");
+            return NULL;
+        }
+
+        // Suboptimal images can still be presented, recreate after this frame
+        if (result == VK_SUBOPTIMAL_KHR) {
+            frame_ctx->swapchain_out_of_date = true;
+        }
+    }
+    frame_ctx->blocked_ns = get_trace_time_ns() - wait_start;
+
+    vkResetCommandPool(v_ctx->device, slot->command_pool, 0);
+
+    VkCommandBufferBeginInfo begin_info;
+    begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    begin_info.pNext = NULL;
+    begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    begin_info.pInheritanceInfo = NULL;
+    if (vkBeginCommandBuffer(slot->command_buffer, &begin_info) != VK_SUCCESS) {
+        fprintf(stderr, "failed to begin frame command buffer\n");
+        return NULL;
+    }
+
+    return slot->command_buffer;
+}
+
+bool end_frame(VulkanContext *v_ctx, FrameContext *frame_ctx) {
+    FrameSlot *slot = get_current_frame_slot(frame_ctx);
+
+    if (vkEndCommandBuffer(slot->command_buffer) != VK_SUCCESS) {
+        fprintf(stderr, "failed to end frame command buffer\n");
+        return false;
+    }
+
+    // Headless frames have nothing to acquire or present, the present waits on the acquired image's semaphore
+    VkSemaphore render_finished = v_ctx->headless ? VK_NULL_HANDLE : v_ctx->swapchain_ctx->render_finished[frame_ctx->image_index];
+    QueueSubmitDesc submit_desc;
+    submit_desc.command_buffers = &slot->command_buffer;
+    submit_desc.command_buffer_count = 1;
+    submit_desc.waits = slot->waits;
+    submit_desc.wait_count = slot->wait_count;
+    submit_desc.signals = NULL;
+    submit_desc.signal_count = 0;
+    submit_desc.fence = slot->in_flight;
+    if (!v_ctx->headless) {
+        if (!add_frame_wait(frame_ctx, slot->image_available, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT)) {
+            slot->wait_count = 0;
+            return false;
+        }
+        submit_desc.wait_count = slot->wait_count;
+        submit_desc.signals = &render_finished;
+        submit_desc.signal_count = 1;
+    }
+
+    // Reset as late as possible, any earlier failure leaves the fence signaled for the next wait on this slot
+    vkResetFences(v_ctx->device, 1, &slot->in_flight);
+    bool submitted = submit_to_queue(v_ctx, QUEUE_GRAPHICS, &submit_desc);
+    slot->wait_count = 0;
+    if (!submitted) {
+        fprintf(stderr, "failed to submit frame command buffer\n");
+        return false;
+    }
+    slot->submitted_frame = frame_ctx->frame_number;
+
+    bool success = true;
+    if (!v_ctx->headless) {
+        VkPresentInfoKHR present_info;
+        present_info.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+        present_info.pNext = NULL;
+        present_info.waitSemaphoreCount = 1;
+        present_info.pWaitSemaphores = &render_finished;
+        present_info.swapchainCount = 1;
+        present_info.pSwapchains = &v_ctx->swapchain_ctx->swapchain;
+        present_info.pImageIndices = &frame_ctx->image_index;
+        present_info.pResults = NULL;
+
+        VkPresentIdKHR present_id;
+        uint64_t present_id_value = frame_ctx->frame_number + 1;
+        if (v_ctx->wait_for_present != NULL) {
+            present_id.sType = VK_STRUCTURE_TYPE_PRESENT_ID_KHR;
+            present_id.pNext = NULL;
+            present_id.swapchainCount = 1;
+            present_id.pPresentIds = &present_id_value;
+            present_info.pNext = &present_id;
+        }
+
+        VkResult result = vkQueuePresentKHR(v_ctx->present_queue, &present_info);
+        if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR) {
+            frame_ctx->swapchain_out_of_date = true;
+        } else if (result != VK_SUCCESS) {
+            fprintf(stderr, "failed to present swapchain image\n");
+            success = false;
+        }
+    }
+
+    // Advance the ring, the CPU moves on while the GPU executes this frame
+    frame_ctx->frame_index = (frame_ctx->frame_index + 1) % frame_ctx->frames_in_flight;
+    ++frame_ctx->frame_number;
+    return success;
+}
+
+/*
+* Cleanup
+*/
+void destroy_frame_slot(VkDevice device, FrameSlot *slot) {
+    vkDestroyFence(device, slot->in_flight, get_host_allocator());
+    vkDestroySemaphore(device, slot->image_available, get_host_allocator());
+    vkDestroyCommandPool(device, slot->command_pool, get_host_allocator());
+}
+
+// Expects the device to be idle, retired resources are freed without checking fences
+void destroy_frame_context(VkDevice device, FrameContext *frame_ctx) {
+    destroy_deletion_queue(frame_ctx->deletion_queue);
+    for (int i = 0; i < frame_ctx->frames_in_flight; ++i) {
+        destroy_frame_slot(device, &frame_ctx->frames[i]);
+    }
+    free(frame_ctx);
+}
@@ -0,0 +1,66 @@
+#ifndef FRAME_H
+#define FRAME_H
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include "vulkan_context.h"
+#include "queue.h"
+#include "deletion_queue.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Number of frames the CPU may record ahead of the GPU
+#define MIN_FRAMES_IN_FLIGHT 2
+#define MAX_FRAMES_IN_FLIGHT 3
+
+// Semaphores from other queues the frame submission waits on, e.g. finished uploads
+#define MAX_FRAME_WAITS 4
+
+// Upper bound on a present wait, a missed vblank must not stall the loop indefinitely
+#define PRESENT_WAIT_TIMEOUT_NS 100000000ull
+
+// Per frame resources, reset and reused every time the slot comes around
+typedef struct {
+    VkCommandPool command_pool;
+    VkCommandBuffer command_buffer;
+    VkSemaphore image_available;
+    VkFence in_flight;
+    uint64_t submitted_frame; // last frame the fence was submitted with
+    uint32_t wait_count;
+    QueueWait waits[MAX_FRAME_WAITS];
+} FrameSlot;
+
+typedef struct {
+    uint32_t frames_in_flight;
+    uint32_t frame_index;
+    uint64_t frame_number;
+    uint32_t image_index;
+    uint64_t blocked_ns; // time begin_frame spent waiting on fences, presents and acquire
+    FrameSlot frames[MAX_FRAMES_IN_FLIGHT];
+    bool swapchain_out_of_date;
+    uint64_t swapchain_first_frame; // present ids restart with every swapchain
+    DeletionQueue *deletion_queue; // drained in begin_frame as frame fences signal
+} FrameContext;
+
+// Frame context creation
+FrameContext *create_frame_context(VulkanContext *v_ctx, uint32_t frames_in_flight);
+bool create_frame_slot(VulkanContext *v_ctx, FrameSlot *slot);
+
+// Frame loop
+VkCommandBuffer begin_frame(VulkanContext *v_ctx, FrameContext *frame_ctx);
+bool end_frame(VulkanContext *v_ctx, FrameContext *frame_ctx);
+FrameSlot *get_current_frame_slot(FrameContext *frame_ctx);
+bool add_frame_wait(FrameContext *frame_ctx, VkSemaphore semaphore, VkPipelineStageFlags stage_mask);
+
+// Deferred destruction, retired resources are freed once the frames that used them complete
+DeletionPoint get_frame_deletion_point(FrameContext *frame_ctx);
+uint64_t get_completed_frames(VkDevice device, FrameContext *frame_ctx);
+bool retire_swapchain(FrameContext *frame_ctx, SwapchainContext *swapchain_ctx);
+
+// Cleanup
+void destroy_frame_slot(VkDevice device, FrameSlot *slot);
+void destroy_frame_context(VkDevice device, FrameContext *frame_ctx);
+
+#endif
@@ -0,0 +1,187 @@
+#include "frame_governor.h"
+
+const char *GOVERNOR_MODE_NAMES[GOVERNOR_MODE_COUNT] = {
+    "uncapped",
+    "fps",
+    "idle",
+    "vsync"
+};
+
+/*
+* Governor creation
+*/
+FrameGovernor *create_frame_governor(GovernorMode mode, double target_fps, bool present_paced) {
+    FrameGovernor *governor = calloc(1, sizeof(FrameGovernor));
+    if (governor == NULL) {
+        fprintf(stderr, "failed to alloc frame governor\n");
+        return NULL;
+    }
+
+    if (target_fps <= 0.0) {
+        target_fps = GOVERNOR_FALLBACK_FPS;
+    }
+
+    governor->mode = mode;
+    governor->target_fps = target_fps;
+    governor->frame_interval_ns = (uint64_t)(1e9 / target_fps);
+    governor->present_paced = present_paced;
+    governor->dirty = true;
+    governor->next_frame_ns = get_trace_time_ns();
+    governor->last_report_ns = governor->next_frame_ns;
+
+    printf("[GOVERNOR] %s mode, %.1f fps target%s\n", GOVERNOR_MODE_NAMES[mode], target_fps,
+        mode == GOVERNOR_VSYNC && present_paced ? ", paced by presentation" : "");
+    return governor;
+}
+
+bool parse_governor_mode(const char *name, GovernorMode *mode) {
+    for (uint32_t i = 0; i < GOVERNOR_MODE_COUNT; ++i) {
+        if (strcmp(name, GOVERNOR_MODE_NAMES[i]) == 0) {
+            *mode = (GovernorMode)i;
+            return true;
+        }
+    }
+
+    fprintf(stderr, "unknown governor mode: %s\n", name);
+    return false;
+}
+
+// Monitor the window is on when fullscreen, otherwise the primary monitor
+double get_monitor_refresh_rate(GLFWwindow *window) {
+    GLFWmonitor *monitor = glfwGetWindowMonitor(window);
+    if (monitor == NULL) {
+        monitor = glfwGetPrimaryMonitor();
+    }
+    if (monitor == NULL) { return GOVERNOR_FALLBACK_FPS; }
+
+    const GLFWvidmode *mode = glfwGetVideoMode(monitor);
+    if (mode == NULL || mode->refreshRate <= 0) { return GOVERNOR_FALLBACK_FPS; }
+    return (double)mode->refreshRate;
+}
+
+/*
+* Application loop
+*/
+// Sleeps in the event wait so input still wakes the loop, then spins the last stretch
+static void wait_until(uint64_t deadline_ns) {
+    uint64_t now = get_trace_time_ns();
+    while (now + GOVERNOR_SPIN_THRESHOLD_NS < deadline_ns) {
+        glfwWaitEventsTimeout((double)(deadline_ns - now - GOVERNOR_SPIN_THRESHOLD_NS) / 1e9);
+        now = get_trace_time_ns();
+    }
+
+    while (now < deadline_ns) {
+        now = get_trace_time_ns();
+    }
+    glfwPollEvents();
+}
+
+// Returns false when this iteration should not render, the caller just loops again
+bool wait_for_next_frame(FrameGovernor *governor) {
+    uint64_t wait_start = get_trace_time_ns();
+
+    bool render = true;
+    switch (governor->mode) {
+        case GOVERNOR_FPS_CAP:
+            wait_until(governor->next_frame_ns);
+            break;
+        case GOVERNOR_IDLE:
+            // Events or the periodic refresh wake the loop, nothing changed means nothing to draw
+            glfwPollEvents();
+            if (!governor->dirty) {
+                glfwWaitEventsTimeout(GOVERNOR_IDLE_TIMEOUT_SECONDS);
+                render = governor->dirty || get_trace_time_ns() >= governor->next_frame_ns;
+            }
+            break;
+        case GOVERNOR_VSYNC:
+            // FIFO presentation blocks at vblank, otherwise pace to the refresh rate ourselves
+            if (governor->present_paced) {
+                glfwPollEvents();
+            } else {
+                wait_until(governor->next_frame_ns);
+            }
+            break;
+        default:
+            glfwPollEvents();
+            break;
+    }
+
+    uint64_t now = get_trace_time_ns();
+    governor->frame_wait_ns += now - wait_start;
+    if (!render) { return false; }
+
+    // Deadlines advance from the previous one so the average rate holds, unless we fell a frame behind
+    if (governor->mode == GOVERNOR_IDLE) {
+        governor->next_frame_ns = now + (uint64_t)(GOVERNOR_IDLE_TIMEOUT_SECONDS * 1e9);
+    } else {
+        governor->next_frame_ns += governor->frame_interval_ns;
+        if (governor->next_frame_ns < now) {
+            governor->next_frame_ns = now + governor->frame_interval_ns;
+        }
+    }
+
+    governor->dirty = false;
+    governor->frame_start_ns = now;
+    return true;
+}
+
+static void add_governor_sample(GovernorStats *stats, uint64_t work_ns, uint64_t wait_ns) {
+    ++stats->frames;
+    stats->work_ns += work_ns;
+    stats->wait_ns += wait_ns;
+    if (work_ns > stats->max_work_ns) {
+        stats->max_work_ns = work_ns;
+    }
+    if (wait_ns > stats->max_wait_ns) {
+        stats->max_wait_ns = wait_ns;
+    }
+}
+
+// Blocked time covers fence, acquire and present waits inside the frame, it counts as waiting
+void end_governed_frame(FrameGovernor *governor, uint64_t blocked_ns) {
+    uint64_t now = get_trace_time_ns();
+    uint64_t frame_ns = now - governor->frame_start_ns;
+    if (blocked_ns > frame_ns) {
+        blocked_ns = frame_ns;
+    }
+
+    uint64_t work_ns = frame_ns - blocked_ns;
+    uint64_t wait_ns = governor->frame_wait_ns + blocked_ns;
+    governor->frame_wait_ns = 0;
+    add_governor_sample(&governor->interval, work_ns, wait_ns);
+    add_governor_sample(&governor->total, work_ns, wait_ns);
+
+    if (now - governor->last_report_ns >= GOVERNOR_REPORT_INTERVAL_NS) {
+        print_frame_governor_stats("interval", &governor->interval);
+        memset(&governor->interval, 0, sizeof(GovernorStats));
+        governor->last_report_ns = now;
+    }
+}
+
+// Input and window callbacks call this so idle mode redraws on the next iteration
+void mark_governor_dirty(FrameGovernor *governor) {
+    governor->dirty = true;
+}
+
+/*
+* Statistics
+*/
+void print_frame_governor_stats(const char *label, const GovernorStats *stats) {
+    if (stats->frames == 0) { return; }
+
+    double frames = (double)stats->frames;
+    double work_ms = stats->work_ns / 1e6 / frames;
+    double wait_ms = stats->wait_ns / 1e6 / frames;
+    double busy = stats->work_ns + stats->wait_ns > 0
+        ? 100.0 * stats->work_ns / (double)(stats->work_ns + stats->wait_ns) : 0.0;
+    printf("[GOVERNOR] %s: %llu frames, cpu work %.3f ms avg (%.3f max), wait %.3f ms avg (%.3f max), %.1f%% busy\n",
+        label, (unsigned long long)stats->frames, work_ms, stats->max_work_ns / 1e6, wait_ms, stats->max_wait_ns / 1e6, busy);
+}
+
+/*
+* Cleanup
+*/
+void destroy_frame_governor(FrameGovernor *governor) {
+    print_frame_governor_stats("total", &governor->total);
+    free(governor);
+}
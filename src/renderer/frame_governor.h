@@ -0,0 +1,71 @@
+#ifndef FRAME_GOVERNOR_H
+#define FRAME_GOVERNOR_H
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "trace.h"
+
+// Last stretch before a deadline is spun, sleeping that close overshoots on most schedulers
+#define GOVERNOR_SPIN_THRESHOLD_NS 1000000ull
+
+// Idle mode still redraws this often so async work such as pipeline builds shows up
+#define GOVERNOR_IDLE_TIMEOUT_SECONDS 0.25
+
+#define GOVERNOR_REPORT_INTERVAL_NS 5000000000ull
+#define GOVERNOR_FALLBACK_FPS 60.0
+
+typedef enum {
+    GOVERNOR_UNCAPPED,
+    GOVERNOR_FPS_CAP,
+    GOVERNOR_IDLE,
+    GOVERNOR_VSYNC,
+    GOVERNOR_MODE_COUNT
+} GovernorMode;
+
+typedef struct {
+    uint64_t frames;
+    uint64_t work_ns;
+    uint64_t wait_ns;
+    uint64_t max_work_ns;
+    uint64_t max_wait_ns;
+} GovernorStats;
+
+// Decides when the application loop renders, and sleeps in between instead of spinning
+typedef struct {
+    GovernorMode mode;
+    double target_fps;
+    uint64_t frame_interval_ns;
+    bool present_paced; // presentation already blocks at vblank, no extra wait needed
+    bool dirty;
+    uint64_t next_frame_ns;
+    uint64_t frame_start_ns;
+    uint64_t frame_wait_ns;
+    uint64_t last_report_ns;
+    GovernorStats interval;
+    GovernorStats total;
+} FrameGovernor;
+
+// Governor creation
+FrameGovernor *create_frame_governor(GovernorMode mode, double target_fps, bool present_paced);
+bool parse_governor_mode(const char *name, GovernorMode *mode);
+double get_monitor_refresh_rate(GLFWwindow *window);
+
+// Application loop
+bool wait_for_next_frame(FrameGovernor *governor);
+void end_governed_frame(FrameGovernor *governor, uint64_t blocked_ns);
+void mark_governor_dirty(FrameGovernor *governor);
+
+// Statistics
+void print_frame_governor_stats(const char *label, const GovernorStats *stats);
+
+// Cleanup
+void destroy_frame_governor(FrameGovernor *governor);
+
+#endif
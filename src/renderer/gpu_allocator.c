@@ -0,0 +1,402 @@
+#include "gpu_allocator.h"
+
+/*
+* Allocator creation
+*/
+GpuAllocator *create_gpu_allocator(VkDevice device, VkPhysicalDevice physical_device) {
+    GpuAllocator *allocator = calloc(1, sizeof(GpuAllocator));
+    if (allocator == NULL) {
+        fprintf(stderr, "failed to alloc GpuAllocator\n");
+        return NULL;
+    }
+
+    allocator->device = device;
+    vkGetPhysicalDeviceMemoryProperties(physical_device, &allocator->memory_properties);
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physical_device, &properties);
+    allocator->non_coherent_atom_size = properties.limits.nonCoherentAtomSize;
+
+    allocator->max_order = 0;
+    while ((GPU_MIN_ALLOCATION_SIZE << allocator->max_order) < GPU_BLOCK_SIZE) {
+        ++allocator->max_order;
+    }
+
+    for (uint32_t i = 0; i < allocator->memory_properties.memoryHeapCount; ++i) {
+        allocator->heap_stats[i].heap_size = allocator->memory_properties.memoryHeaps[i].size;
+    }
+
+    return allocator;
+}
+
+/*
+* Memory types
+*/
+static uint32_t count_bits(uint32_t value) {
+    uint32_t count = 0;
+    for (; value != 0; value &= value - 1) {
+        ++count;
+    }
+    return count;
+}
+
+uint32_t find_gpu_memory_type(GpuAllocator *allocator, uint32_t type_filter, GpuMemoryUsage usage) {
+    VkMemoryPropertyFlags required = 0;
+    VkMemoryPropertyFlags preferred = 0;
+    VkMemoryPropertyFlags avoided = 0;
+    switch (usage) {
+        case GPU_MEMORY_GPU_ONLY:
+            required = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+            avoided = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+            break;
+        case GPU_MEMORY_CPU_TO_GPU:
+            // Write combined upload memory, reads from the CPU are slow
+            required = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+            avoided = VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+            break;
+        case GPU_MEMORY_GPU_TO_CPU:
+            required = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+            preferred = VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+            break;
+    }
+
+    uint32_t best_type = UINT32_MAX;
+    int best_score = 0;
+    for (uint32_t i = 0; i < allocator->memory_properties.memoryTypeCount; ++i) {
+        VkMemoryPropertyFlags flags = allocator->memory_properties.memoryTypes[i].propertyFlags;
+        if (!(type_filter & (1u << i)) || (flags & required) != required) {
+            continue;
+        }
+
+        int score = 1 + 2 * (int)count_bits(flags & preferred) - (int)count_bits(flags & avoided);
+        if (best_type == UINT32_MAX || score > best_score) {
+            best_type = i;
+            best_score = score;
+        }
+    }
+
+    return best_type;
+}
+
+static bool is_host_visible(GpuAllocator *allocator, uint32_t memory_type) {
+    return allocator->memory_properties.memoryTypes[memory_type].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+}
+
+static GpuHeapStats *get_heap_stats(GpuAllocator *allocator, uint32_t memory_type) {
+    return &allocator->heap_stats[allocator->memory_properties.memoryTypes[memory_type].heapIndex];
+}
+
+// Host visible memory stays mapped for its whole lifetime
+static bool allocate_device_memory(GpuAllocator *allocator, VkDeviceSize size, uint32_t memory_type, VkDeviceMemory *memory, void **mapped) {
+    VkMemoryAllocateInfo alloc_info;
+    alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    alloc_info.pNext = NULL;
+    alloc_info.allocationSize = size;
+    alloc_info.memoryTypeIndex = memory_type;
+
+    if (vkAllocateMemory(allocator->device, &alloc_info, get_host_allocator(), memory) != VK_SUCCESS) {
+        fprintf(stderr, "failed to allocate %llu bytes of device memory\n", (unsigned long long)size);
+        return false;
+    }
+
+    *mapped = NULL;
+    if (is_host_visible(allocator, memory_type)
+        && vkMapMemory(allocator->device, *memory, 0, VK_WHOLE_SIZE, 0, mapped) != VK_SUCCESS) {
+        fprintf(stderr, "failed to map device memory\n");
+        vkFreeMemory(allocator->device, *memory, get_host_allocator());
+        return false;
+    }
+
+    GpuHeapStats *stats = get_heap_stats(allocator, memory_type);
+    stats->block_bytes += size;
+    ++stats->block_count;
+    return true;
+}
+
+static void free_device_memory(GpuAllocator *allocator, VkDeviceSize size, uint32_t memory_type, VkDeviceMemory memory) {
+    // Freeing implicitly unmaps
+    vkFreeMemory(allocator->device, memory, get_host_allocator());
+
+    GpuHeapStats *stats = get_heap_stats(allocator, memory_type);
+    stats->block_bytes -= size;
+    --stats->block_count;
+}
+
+/*
+* Buddy blocks
+*/
+static GpuMemoryBlock *create_memory_block(GpuAllocator *allocator, uint32_t memory_type) {
+    GpuMemoryBlock *block = malloc(sizeof(GpuMemoryBlock));
+    if (block == NULL) { return NULL; }
+
+    // Complete binary tree, the root covers the block and leaves cover GPU_MIN_ALLOCATION_SIZE
+    uint32_t node_count = (2u << allocator->max_order) - 1;
+    block->tree = malloc(node_count);
+    if (block->tree == NULL) {
+        free(block);
+        return NULL;
+    }
+
+    uint32_t first = 0;
+    for (uint32_t depth = 0; depth <= allocator->max_order; ++depth) {
+        uint32_t width = 1u << depth;
+        memset(&block->tree[first], (int)(allocator->max_order - depth + 1), width);
+        first += width;
+    }
+
+    if (!allocate_device_memory(allocator, GPU_BLOCK_SIZE, memory_type, &block->memory, &block->mapped)) {
+        free(block->tree);
+        free(block);
+        return NULL;
+    }
+
+    block->used = 0;
+    block->next = NULL;
+    return block;
+}
+
+static void update_buddy_parents(uint8_t *tree, uint32_t index, uint32_t order) {
+    while (index > 0) {
+        index = (index - 1) / 2;
+        ++order;
+
+        // Two whole children merge back into one free node of the parent's order
+        uint8_t left = tree[index * 2 + 1];
+        uint8_t right = tree[index * 2 + 2];
+        if (left == order && right == order) {
+            tree[index] = (uint8_t)(order + 1);
+        } else {
+            tree[index] = left > right ? left : right;
+        }
+    }
+}
+
+static bool allocate_from_block(GpuAllocator *allocator, GpuMemoryBlock *block, uint32_t order, VkDeviceSize *offset) {
+    uint8_t needed = (uint8_t)(order + 1);
+    if (block->tree[0] < needed) { return false; }
+
+    // Descend into the tighter fitting child to keep large ranges whole
+    uint32_t index = 0;
+    for (uint32_t node_order = allocator->max_order; node_order > order; --node_order) {
+        uint32_t left = index * 2 + 1;
+        uint32_t right = left + 1;
+        if (block->tree[left] >= needed && (block->tree[right] < needed || block->tree[left] <= block->tree[right])) {
+            index = left;
+        } else {
+            index = right;
+        }
+    }
+
+    block->tree[index] = 0;
+    update_buddy_parents(block->tree, index, order);
+
+    uint32_t depth = allocator->max_order - order;
+    *offset = (VkDeviceSize)(index - ((1u << depth) - 1)) * (GPU_MIN_ALLOCATION_SIZE << order);
+    block->used += GPU_MIN_ALLOCATION_SIZE << order;
+    return true;
+}
+
+static void free_from_block(GpuAllocator *allocator, GpuMemoryBlock *block, VkDeviceSize offset, uint32_t order) {
+    uint32_t depth = allocator->max_order - order;
+    uint32_t index = ((1u << depth) - 1) + (uint32_t)(offset / (GPU_MIN_ALLOCATION_SIZE << order));
+
+    block->tree[index] = (uint8_t)(order + 1);
+    update_buddy_parents(block->tree, index, order);
+    block->used -= GPU_MIN_ALLOCATION_SIZE << order;
+}
+
+static void destroy_memory_block(GpuAllocator *allocator, GpuMemoryBlock *block, uint32_t memory_type) {
+    free_device_memory(allocator, GPU_BLOCK_SIZE, memory_type, block->memory);
+    free(block->tree);
+    free(block);
+}
+
+/*
+* Allocation
+*/
+static bool allocate_dedicated(GpuAllocator *allocator, VkDeviceSize size, uint32_t memory_type, GpuAllocation *allocation) {
+    if (!allocate_device_memory(allocator, size, memory_type, &allocation->memory, &allocation->mapped)) {
+        return false;
+    }
+
+    allocation->offset = 0;
+    allocation->size = size;
+    allocation->order = 0;
+    allocation->block = NULL;
+    return true;
+}
+
+bool allocate_gpu_memory(GpuAllocator *allocator, const VkMemoryRequirements *requirements, GpuMemoryUsage usage, GpuResourceKind kind, GpuAllocation *allocation) {
+    uint32_t memory_type = find_gpu_memory_type(allocator, requirements->memoryTypeBits, usage);
+    if (memory_type == UINT32_MAX) {
+        fprintf(stderr, "failed to find memory type for usage %d\n", usage);
+        return false;
+    }
+    allocation->memory_type = memory_type;
+
+    GpuHeapStats *stats = get_heap_stats(allocator, memory_type);
+    VkDeviceSize size = requirements->size > requirements->alignment ? requirements->size : requirements->alignment;
+    if (size > GPU_DEDICATED_THRESHOLD) {
+        if (!allocate_dedicated(allocator, requirements->size, memory_type, allocation)) { return false; }
+
+        stats->allocated_bytes += allocation->size;
+        ++stats->allocation_count;
+        return true;
+    }
+
+    // Buddy ranges are naturally aligned to their own size
+    uint32_t order = 0;
+    while ((GPU_MIN_ALLOCATION_SIZE << order) < size) {
+        ++order;
+    }
+
+    GpuMemoryBlock **blocks = &allocator->blocks[memory_type][kind];
+    GpuMemoryBlock *block = *blocks;
+    VkDeviceSize offset = 0;
+    while (block != NULL && !allocate_from_block(allocator, block, order, &offset)) {
+        block = block->next;
+    }
+
+    if (block == NULL) {
+        block = create_memory_block(allocator, memory_type);
+        if (block == NULL) { return false; }
+
+        block->next = *blocks;
+        *blocks = block;
+        allocate_from_block(allocator, block, order, &offset);
+    }
+
+    allocation->memory = block->memory;
+    allocation->offset = offset;
+    allocation->size = GPU_MIN_ALLOCATION_SIZE << order;
+    allocation->mapped = block->mapped != NULL ? (uint8_t *)block->mapped + offset : NULL;
+    allocation->order = order;
+    allocation->block = block;
+
+    stats->allocated_bytes += allocation->size;
+    ++stats->allocation_count;
+    return true;
+}
+
+bool allocate_buffer_memory(GpuAllocator *allocator, VkBuffer buffer, GpuMemoryUsage usage, GpuAllocation *allocation) {
+    VkMemoryRequirements requirements;
+    vkGetBufferMemoryRequirements(allocator->device, buffer, &requirements);
+    if (!allocate_gpu_memory(allocator, &requirements, usage, GPU_RESOURCE_LINEAR, allocation)) { return false; }
+
+    if (vkBindBufferMemory(allocator->device, buffer, allocation->memory, allocation->offset) != VK_SUCCESS) {
+        fprintf(stderr, "failed to bind buffer memory\n");
+        free_gpu_memory(allocator, allocation);
+        return false;
+    }
+
+    return true;
+}
+
+// Images are assumed to use VK_IMAGE_TILING_OPTIMAL
+bool allocate_image_memory(GpuAllocator *allocator, VkImage image, GpuMemoryUsage usage, GpuAllocation *allocation) {
+    VkMemoryRequirements requirements;
+    vkGetImageMemoryRequirements(allocator->device, image, &requirements);
+    if (!allocate_gpu_memory(allocator, &requirements, usage, GPU_RESOURCE_OPTIMAL, allocation)) { return false; }
+
+    if (vkBindImageMemory(allocator->device, image, allocation->memory, allocation->offset) != VK_SUCCESS) {
+        fprintf(stderr, "failed to bind image memory\n");
+        free_gpu_memory(allocator, allocation);
+        return false;
+    }
+
+    return true;
+}
+
+void free_gpu_memory(GpuAllocator *allocator, GpuAllocation *allocation) {
+    if (allocation->memory == VK_NULL_HANDLE) { return; }
+
+    GpuHeapStats *stats = get_heap_stats(allocator, allocation->memory_type);
+    stats->allocated_bytes -= allocation->size;
+    --stats->allocation_count;
+
+    // Empty blocks are kept around for reuse until the allocator is destroyed
+    if (allocation->block != NULL) {
+        free_from_block(allocator, allocation->block, allocation->offset, allocation->order);
+    } else {
+        free_device_memory(allocator, allocation->size, allocation->memory_type, allocation->memory);
+    }
+
+    allocation->memory = VK_NULL_HANDLE;
+    allocation->mapped = NULL;
+    allocation->block = NULL;
+}
+
+/*
+* Host access
+*/
+static bool get_mapped_range(GpuAllocator *allocator, const GpuAllocation *allocation, VkMappedMemoryRange *range) {
+    VkMemoryPropertyFlags flags = allocator->memory_properties.memoryTypes[allocation->memory_type].propertyFlags;
+    if (allocation->mapped == NULL || (flags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)) { return false; }
+
+    range->sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+    range->pNext = NULL;
+    range->memory = allocation->memory;
+    if (allocation->block == NULL) {
+        range->offset = 0;
+        range->size = VK_WHOLE_SIZE;
+        return true;
+    }
+
+    // Buddy ranges are at least GPU_MIN_ALLOCATION_SIZE aligned, round to the atom anyway
+    VkDeviceSize atom = allocator->non_coherent_atom_size;
+    VkDeviceSize end = allocation->offset + allocation->size;
+    range->offset = allocation->offset / atom * atom;
+    range->size = (end + atom - 1) / atom * atom - range->offset;
+    if (range->offset + range->size > GPU_BLOCK_SIZE) {
+        range->size = VK_WHOLE_SIZE;
+    }
+    return true;
+}
+
+void flush_gpu_allocation(GpuAllocator *allocator, const GpuAllocation *allocation) {
+    VkMappedMemoryRange range;
+    if (get_mapped_range(allocator, allocation, &range)) {
+        vkFlushMappedMemoryRanges(allocator->device, 1, &range);
+    }
+}
+
+void invalidate_gpu_allocation(GpuAllocator *allocator, const GpuAllocation *allocation) {
+    VkMappedMemoryRange range;
+    if (get_mapped_range(allocator, allocation, &range)) {
+        vkInvalidateMappedMemoryRanges(allocator->device, 1, &range);
+    }
+}
+
+/*
+* Statistics
+*/
+void print_gpu_allocator_stats(GpuAllocator *allocator) {
+    for (uint32_t i = 0; i < allocator->memory_properties.memoryHeapCount; ++i) {
+        GpuHeapStats *stats = &allocator->heap_stats[i];
+        bool device_local = allocator->memory_properties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT;
+        printf("[MEMORY] heap %u (%s): %u blocks %.1f MiB, %u allocations %.1f MiB, heap size %.1f MiB\n",
+            i, device_local ? "device" : "host", stats->block_count, stats->block_bytes / (1024.0 * 1024.0),
+            stats->allocation_count, stats->allocated_bytes / (1024.0 * 1024.0), stats->heap_size / (1024.0 * 1024.0));
+    }
+}
+
+/*
+* Cleanup
+*/
+void destroy_gpu_allocator(GpuAllocator *allocator) {
+    for (uint32_t type = 0; type < allocator->memory_properties.memoryTypeCount; ++type) {
+        for (uint32_t kind = 0; kind < GPU_RESOURCE_KIND_COUNT; ++kind) {
+            GpuMemoryBlock *block = allocator->blocks[type][kind];
+            while (block != NULL) {
+                GpuMemoryBlock *next = block->next;
+                if (block->used > 0) {
+                    fprintf(stderr, "gpu allocator destroyed with %llu bytes still allocated\n", (unsigned long long)block->used);
+                }
+                destroy_memory_block(allocator, block, type);
+                block = next;
+            }
+        }
+    }
+
+    free(allocator);
+}
@@ -0,0 +1,93 @@
+#ifndef GPU_ALLOCATOR_H
+#define GPU_ALLOCATOR_H
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "host_allocator.h"
+
+#define GPU_BLOCK_SIZE (64ull * 1024 * 1024)
+#define GPU_MIN_ALLOCATION_SIZE 1024ull
+
+// Requests above this size get their own VkDeviceMemory
+#define GPU_DEDICATED_THRESHOLD (GPU_BLOCK_SIZE / 2)
+
+typedef enum {
+    GPU_MEMORY_GPU_ONLY,
+    GPU_MEMORY_CPU_TO_GPU,
+    GPU_MEMORY_GPU_TO_CPU
+} GpuMemoryUsage;
+
+// Linear and optimal resources never share a block, which satisfies bufferImageGranularity
+typedef enum {
+    GPU_RESOURCE_LINEAR,
+    GPU_RESOURCE_OPTIMAL,
+    GPU_RESOURCE_KIND_COUNT
+} GpuResourceKind;
+
+// Buddy tree over one VkDeviceMemory, each node stores the largest free order below it plus one
+typedef struct GpuMemoryBlock {
+    VkDeviceMemory memory;
+    void *mapped;
+    uint8_t *tree;
+    VkDeviceSize used;
+    struct GpuMemoryBlock *next;
+} GpuMemoryBlock;
+
+typedef struct {
+    VkDeviceMemory memory;
+    VkDeviceSize offset;
+    VkDeviceSize size;
+    void *mapped;
+    uint32_t memory_type;
+    uint32_t order;
+    GpuMemoryBlock *block; // NULL for dedicated allocations
+} GpuAllocation;
+
+typedef struct {
+    VkDeviceSize heap_size;
+    VkDeviceSize block_bytes;
+    VkDeviceSize allocated_bytes;
+    uint32_t block_count;
+    uint32_t allocation_count;
+} GpuHeapStats;
+
+// Not thread safe, allocate from the thread that owns the device
+typedef struct {
+    VkDevice device;
+    VkPhysicalDeviceMemoryProperties memory_properties;
+    VkDeviceSize non_coherent_atom_size;
+    uint32_t max_order;
+    GpuMemoryBlock *blocks[VK_MAX_MEMORY_TYPES][GPU_RESOURCE_KIND_COUNT];
+    GpuHeapStats heap_stats[VK_MAX_MEMORY_HEAPS];
+} GpuAllocator;
+
+// Allocator creation
+GpuAllocator *create_gpu_allocator(VkDevice device, VkPhysicalDevice physical_device);
+
+// Memory types
+uint32_t find_gpu_memory_type(GpuAllocator *allocator, uint32_t type_filter, GpuMemoryUsage usage);
+
+// Allocation
+bool allocate_gpu_memory(GpuAllocator *allocator, const VkMemoryRequirements *requirements, GpuMemoryUsage usage, GpuResourceKind kind, GpuAllocation *allocation);
+bool allocate_buffer_memory(GpuAllocator *allocator, VkBuffer buffer, GpuMemoryUsage usage, GpuAllocation *allocation);
+bool allocate_image_memory(GpuAllocator *allocator, VkImage image, GpuMemoryUsage usage, GpuAllocation *allocation);
+void free_gpu_memory(GpuAllocator *allocator, GpuAllocation *allocation);
+
+// Host access, only needed for memory types without HOST_COHERENT
+void flush_gpu_allocation(GpuAllocator *allocator, const GpuAllocation *allocation);
+void invalidate_gpu_allocation(GpuAllocator *allocator, const GpuAllocation *allocation);
+
+// Statistics
+void print_gpu_allocator_stats(GpuAllocator *allocator);
+
+// Cleanup
+void destroy_gpu_allocator(GpuAllocator *allocator);
+
+#endif
@@ -0,0 +1,319 @@
+#include "gpu_culling.h"
+
+#include <math.h>
+
+#define CULL_BUFFER_BINDING_COUNT 4
+#define CULL_PYRAMID_BINDING 4
+
+/*
+* Draw records
+*/
+// Meshlets give the finest granularity, meshes cooked without them fall back to submesh bounds
+static GpuDrawRecord *build_draw_records(const Mesh *mesh, uint32_t *record_count) {
+    *record_count = mesh->meshlet_count > 0 ? mesh->meshlet_count : mesh->submesh_count;
+    GpuDrawRecord *records = calloc(*record_count, sizeof(GpuDrawRecord));
+    if (records == NULL) { return NULL; }
+
+    for (uint32_t i = 0; i < mesh->meshlet_count; ++i) {
+        const MeshFileMeshlet *meshlet = &mesh->meshlets[i];
+        memcpy(records[i].sphere, meshlet->center, sizeof(meshlet->center));
+        records[i].sphere[3] = meshlet->radius;
+        records[i].first_index = meshlet->first_index;
+        records[i].index_count = meshlet->index_count;
+        records[i].vertex_offset = (int32_t)meshlet->first_vertex;
+    }
+
+    for (uint32_t i = 0; mesh->meshlet_count == 0 && i < mesh->submesh_count; ++i) {
+        const MeshFileSubmesh *submesh = &mesh->submeshes[i];
+        float radius_sq = 0.0f;
+        for (int axis = 0; axis < 3; ++axis) {
+            float half = (submesh->bounds_max[axis] - submesh->bounds_min[axis]) * 0.5f;
+            records[i].sphere[axis] = submesh->bounds_min[axis] + half;
+            radius_sq += half * half;
+        }
+        records[i].sphere[3] = sqrtf(radius_sq);
+        records[i].first_index = submesh->first_index;
+        records[i].index_count = submesh->index_count;
+        records[i].vertex_offset = (int32_t)submesh->first_vertex;
+    }
+    return records;
+}
+
+/*
+* Culler creation
+*/
+// A GPU count needs the feature and a limit that covers every record, multi draw is chunked by the same limit
+static CullDrawPath select_draw_path(VulkanContext *v_ctx, uint32_t record_count, uint32_t *max_draw_count) {
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(v_ctx->physical_device, &properties);
+    *max_draw_count = properties.limits.maxDrawIndirectCount > 0 ? properties.limits.maxDrawIndirectCount : 1;
+
+    if (is_device_feature_enabled(&v_ctx->features, DEVICE_FEATURE(vulkan12, drawIndirectCount))
+        && record_count <= *max_draw_count) {
+        return CULL_DRAW_INDIRECT_COUNT;
+    }
+    if (is_device_feature_enabled(&v_ctx->features, DEVICE_FEATURE(core.features, multiDrawIndirect))) {
+        return CULL_DRAW_MULTI_INDIRECT;
+    }
+
+    *max_draw_count = 1;
+    return CULL_DRAW_SINGLE_INDIRECT;
+}
+
+static bool create_cull_frame(VulkanContext *v_ctx, uint32_t record_count, GpuCullFrame *frame) {
+    return create_mesh_buffer(v_ctx, CULL_PHASE_COUNT * record_count * sizeof(VkDrawIndexedIndirectCommand),
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+            GPU_MEMORY_GPU_ONLY, &frame->command_buffer, &frame->command_allocation)
+        && create_mesh_buffer(v_ctx, CULL_PHASE_COUNT * sizeof(uint32_t),
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            GPU_MEMORY_GPU_ONLY, &frame->count_buffer, &frame->count_allocation);
+}
+
+static bool create_cull_descriptor_sets(VulkanContext *v_ctx, GpuCuller *culler, VkDescriptorSetLayout set_layout) {
+    VkDescriptorPoolSize pool_sizes[2];
+    pool_sizes[0].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    pool_sizes[0].descriptorCount = CULL_BUFFER_BINDING_COUNT * culler->frame_count;
+    pool_sizes[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    pool_sizes[1].descriptorCount = culler->frame_count;
+
+    VkDescriptorPoolCreateInfo pool_create_info;
+    pool_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    pool_create_info.pNext = NULL;
+    pool_create_info.flags = 0;
+    pool_create_info.maxSets = culler->frame_count;
+    pool_create_info.poolSizeCount = 2;
+    pool_create_info.pPoolSizes = pool_sizes;
+    if (vkCreateDescriptorPool(v_ctx->device, &pool_create_info, get_host_allocator(), &culler->descriptor_pool) != VK_SUCCESS) {
+        fprintf(stderr, "failed to create cull descriptor pool\n");
+        return false;
+    }
+
+    for (uint32_t i = 0; i < culler->frame_count; ++i) {
+        GpuCullFrame *frame = &culler->frames[i];
+        VkDescriptorSetAllocateInfo alloc_info;
+        alloc_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        alloc_info.pNext = NULL;
+        alloc_info.descriptorPool = culler->descriptor_pool;
+        alloc_info.descriptorSetCount = 1;
+        alloc_info.pSetLayouts = &set_layout;
+        if (vkAllocateDescriptorSets(v_ctx->device, &alloc_info, &frame->descriptor_set) != VK_SUCCESS) {
+            fprintf(stderr, "failed to allocate cull descriptor set\n");
+            return false;
+        }
+
+        // Bindings follow the shader, records, commands, counts and visibility, the pyramid is written per frame
+        VkDescriptorBufferInfo buffer_infos[CULL_BUFFER_BINDING_COUNT] = {
+            { culler->record_buffer, 0, VK_WHOLE_SIZE },
+            { frame->command_buffer, 0, VK_WHOLE_SIZE },
+            { frame->count_buffer, 0, VK_WHOLE_SIZE },
+            { culler->visibility_buffer, 0, VK_WHOLE_SIZE }
+        };
+
+        VkWriteDescriptorSet writes[CULL_BUFFER_BINDING_COUNT];
+        for (uint32_t b = 0; b < CULL_BUFFER_BINDING_COUNT; ++b) {
+            writes[b].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            writes[b].pNext = NULL;
+            writes[b].dstSet = frame->descriptor_set;
+            writes[b].dstBinding = b;
+            writes[b].dstArrayElement = 0;
+            writes[b].descriptorCount = 1;
+            writes[b].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            writes[b].pImageInfo = NULL;
+            writes[b].pBufferInfo = &buffer_infos[b];
+            writes[b].pTexelBufferView = NULL;
+        }
+        vkUpdateDescriptorSets(v_ctx->device, CULL_BUFFER_BINDING_COUNT, writes, 0, NULL);
+    }
+    return true;
+}
+
+static bool queue_cull_pipeline(GpuCuller *culler, PipelineRegistry *registry, PipelineBuilder *builder,
+    const ShaderBinary *comp, VkDescriptorSetLayout *set_layout) {
+    ShaderReflection reflection;
+    if (!reflect_shader(comp, &reflection)) { return false; }
+
+    culler->pipeline_layout = create_reflected_pipeline_layout(registry, &reflection, 1);
+    *set_layout = get_reflected_set_layout(registry, &reflection, 1, 0);
+    if (culler->pipeline_layout == VK_NULL_HANDLE || *set_layout == VK_NULL_HANDLE) {
+        fprintf(stderr, "failed to create cull pipeline layout\n");
+        return false;
+    }
+
+    ComputePipelineDesc desc;
+    init_compute_pipeline_desc(&desc, culler->pipeline_layout, comp);
+    set_specialization_constant(&desc.specialization, CULL_COMPACT_CONSTANT_ID, culler->draw_path == CULL_DRAW_INDIRECT_COUNT);
+    if (!validate_specialization(&reflection, &desc.specialization)) { return false; }
+
+    culler->pipeline = request_compute_pipeline(registry, builder, &desc);
+    return culler->pipeline != NULL;
+}
+
+GpuCuller *create_gpu_culler(VulkanContext *v_ctx, PipelineRegistry *registry, PipelineBuilder *builder,
+    const ShaderBinary *comp, const Mesh *mesh, uint32_t frame_count) {
+    GpuCuller *culler = calloc(1, sizeof(GpuCuller));
+    if (culler == NULL) { return NULL; }
+
+    GpuDrawRecord *records = build_draw_records(mesh, &culler->record_count);
+    if (records == NULL) {
+        free(culler);
+        return NULL;
+    }
+    culler->frame_count = frame_count;
+    culler->draw_path = select_draw_path(v_ctx, culler->record_count, &culler->max_draw_count);
+    culler->constants.record_count = culler->record_count;
+
+    bool created = create_mesh_buffer(v_ctx, culler->record_count * sizeof(GpuDrawRecord),
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        GPU_MEMORY_GPU_ONLY, &culler->record_buffer, &culler->record_allocation);
+    created = created && upload_mesh_data(v_ctx, culler->record_buffer, records, culler->record_count * sizeof(GpuDrawRecord));
+    free(records);
+
+    // Nothing counts as visible before the first late phase, so the first frame draws everything there
+    uint32_t *visibility = calloc(culler->record_count, sizeof(uint32_t));
+    created = created && visibility != NULL && create_mesh_buffer(v_ctx, culler->record_count * sizeof(uint32_t),
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        GPU_MEMORY_GPU_ONLY, &culler->visibility_buffer, &culler->visibility_allocation);
+    created = created && upload_mesh_data(v_ctx, culler->visibility_buffer, visibility, culler->record_count * sizeof(uint32_t));
+    free(visibility);
+    for (uint32_t i = 0; created && i < frame_count; ++i) {
+        created = create_cull_frame(v_ctx, culler->record_count, &culler->frames[i]);
+    }
+
+    VkDescriptorSetLayout set_layout = VK_NULL_HANDLE;
+    created = created && queue_cull_pipeline(culler, registry, builder, comp, &set_layout);
+    created = created && create_cull_descriptor_sets(v_ctx, culler, set_layout);
+    if (!created) {
+        fprintf(stderr, "failed to create gpu culler\n");
+        destroy_gpu_culler(v_ctx, culler);
+        return NULL;
+    }
+
+    printf("[CULL] %u %s, %s\n", culler->record_count, mesh->meshlet_count > 0 ? "meshlets" : "submeshes",
+        get_cull_draw_path_name(culler->draw_path));
+    return culler;
+}
+
+void set_cull_transform(GpuCuller *culler, const float clip_from_model[16]) {
+    memcpy(culler->constants.clip_from_model, clip_from_model, sizeof(culler->constants.clip_from_model));
+}
+
+void set_cull_depth_pyramid(GpuCuller *culler, VkImageView view, VkSampler sampler) {
+    culler->pyramid_view = view;
+    culler->pyramid_sampler = sampler;
+    ++culler->pyramid_generation;
+}
+
+// Only safe once the frame's fence has signaled, earlier submissions may still read the old pyramid
+void update_cull_frame(VkDevice device, GpuCuller *culler, uint32_t frame_index) {
+    GpuCullFrame *frame = &culler->frames[frame_index];
+    if (frame->pyramid_generation == culler->pyramid_generation) { return; }
+
+    VkDescriptorImageInfo image_info = { culler->pyramid_sampler, culler->pyramid_view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+    VkWriteDescriptorSet write;
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.pNext = NULL;
+    write.dstSet = frame->descriptor_set;
+    write.dstBinding = CULL_PYRAMID_BINDING;
+    write.dstArrayElement = 0;
+    write.descriptorCount = 1;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    write.pImageInfo = &image_info;
+    write.pBufferInfo = NULL;
+    write.pTexelBufferView = NULL;
+    vkUpdateDescriptorSets(device, 1, &write, 0, NULL);
+    frame->pyramid_generation = culler->pyramid_generation;
+}
+
+/*
+* Recording
+*/
+void record_cull_reset(VkCommandBuffer command_buffer, const GpuCuller *culler, uint32_t frame_index) {
+    vkCmdFillBuffer(command_buffer, culler->frames[frame_index].count_buffer, 0, CULL_PHASE_COUNT * sizeof(uint32_t), 0);
+}
+
+// The early phase decides for the whole frame, culled stays unset while the pipeline is still compiling
+// and the frame then draws every range on the CPU. The late phase skips the occlusion test without a pyramid
+void record_cull_dispatch(VkCommandBuffer command_buffer, GpuCuller *culler, uint32_t frame_index, CullPhase phase, bool occlusion) {
+    VkPipeline pipeline = get_ready_pipeline(culler->pipeline, VK_NULL_HANDLE);
+    if (phase == CULL_PHASE_EARLY) {
+        culler->culled = pipeline != VK_NULL_HANDLE;
+    }
+    if (!culler->culled) { return; }
+
+    // Visibility was last written by the previous frame's late phase, which the graph does not see
+    if (phase == CULL_PHASE_EARLY) {
+        VkMemoryBarrier barrier;
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.pNext = NULL;
+        barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            0, 1, &barrier, 0, NULL, 0, NULL);
+    }
+
+    culler->constants.phase = phase;
+    culler->constants.occlusion = occlusion;
+    vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+    vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, culler->pipeline_layout, 0, 1,
+        &culler->frames[frame_index].descriptor_set, 0, NULL);
+    vkCmdPushConstants(command_buffer, culler->pipeline_layout, VK_SHADER_STAGE_COMPUTE_BIT, 0,
+        sizeof(CullConstants), &culler->constants);
+    vkCmdDispatch(command_buffer, (culler->record_count + CULL_WORKGROUP_SIZE - 1) / CULL_WORKGROUP_SIZE, 1, 1);
+}
+
+// Expects the mesh and a pipeline to be bound, the indirect commands carry everything else
+void record_cull_draws(VkCommandBuffer command_buffer, const GpuCuller *culler, uint32_t frame_index, CullPhase phase) {
+    const GpuCullFrame *frame = &culler->frames[frame_index];
+    uint32_t stride = sizeof(VkDrawIndexedIndirectCommand);
+    VkDeviceSize phase_offset = (VkDeviceSize)phase * culler->record_count * stride;
+    if (culler->draw_path == CULL_DRAW_INDIRECT_COUNT) {
+        vkCmdDrawIndexedIndirectCount(command_buffer, frame->command_buffer, phase_offset, frame->count_buffer,
+            phase * sizeof(uint32_t), culler->record_count, stride);
+        return;
+    }
+
+    for (uint32_t first = 0; first < culler->record_count; first += culler->max_draw_count) {
+        uint32_t count = culler->record_count - first < culler->max_draw_count ? culler->record_count - first : culler->max_draw_count;
+        vkCmdDrawIndexedIndirect(command_buffer, frame->command_buffer, phase_offset + (VkDeviceSize)first * stride, count, stride);
+    }
+}
+
+const char *get_cull_draw_path_name(CullDrawPath path) {
+    switch (path) {
+    case CULL_DRAW_INDIRECT_COUNT: return "indirect count";
+    case CULL_DRAW_MULTI_INDIRECT: return "multi draw indirect";
+    default: return "single draw indirect";
+    }
+}
+
+/*
+* Cleanup
+*/
+// The pipeline and layouts belong to the registry
+void destroy_gpu_culler(VulkanContext *v_ctx, GpuCuller *culler) {
+    if (culler->descriptor_pool != VK_NULL_HANDLE) {
+        vkDestroyDescriptorPool(v_ctx->device, culler->descriptor_pool, get_host_allocator());
+    }
+
+    for (uint32_t i = 0; i < culler->frame_count; ++i) {
+        GpuCullFrame *frame = &culler->frames[i];
+        if (frame->command_buffer != VK_NULL_HANDLE) {
+            vkDestroyBuffer(v_ctx->device, frame->command_buffer, get_host_allocator());
+            free_gpu_memory(v_ctx->allocator, &frame->command_allocation);
+        }
+        if (frame->count_buffer != VK_NULL_HANDLE) {
+            vkDestroyBuffer(v_ctx->device, frame->count_buffer, get_host_allocator());
+            free_gpu_memory(v_ctx->allocator, &frame->count_allocation);
+        }
+    }
+
+    if (culler->record_buffer != VK_NULL_HANDLE) {
+        vkDestroyBuffer(v_ctx->device, culler->record_buffer, get_host_allocator());
+        free_gpu_memory(v_ctx->allocator, &culler->record_allocation);
+    }
+    if (culler->visibility_buffer != VK_NULL_HANDLE) {
+        vkDestroyBuffer(v_ctx->device, culler->visibility_buffer, get_host_allocator());
+        free_gpu_memory(v_ctx->allocator, &culler->visibility_allocation);
+    }
+    free(culler);
+}
@@ -0,0 +1,106 @@
+#ifndef GPU_CULLING_H
+#define GPU_CULLING_H
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "vulkan_context.h"
+#include "frame.h"
+#include "mesh.h"
+#include "pipeline.h"
+#include "pipeline_builder.h"
+#include "pipeline_registry.h"
+#include "spirv_reflect.h"
+
+// Matches the cull shader's local size and specialization constant
+#define CULL_WORKGROUP_SIZE 64
+#define CULL_COMPACT_CONSTANT_ID 0
+
+// One culled object, a meshlet or a whole submesh when the mesh has none, laid out as in the shader
+typedef struct {
+    float sphere[4]; // model space center and radius
+    uint32_t first_index;
+    uint32_t index_count;
+    int32_t vertex_offset;
+    uint32_t padding;
+} GpuDrawRecord;
+
+// The early phase draws what was visible last frame, the late phase tests the rest against the depth pyramid
+typedef enum {
+    CULL_PHASE_EARLY,
+    CULL_PHASE_LATE,
+    CULL_PHASE_COUNT
+} CullPhase;
+
+// Matches the cull shader's push constant block
+typedef struct {
+    float clip_from_model[16];
+    uint32_t record_count;
+    uint32_t phase;
+    uint32_t occlusion; // the pyramid was built this frame
+} CullConstants;
+
+// How the surviving draws reach the rasterizer, picked from the device's indirect features
+typedef enum {
+    CULL_DRAW_INDIRECT_COUNT, // one vkCmdDrawIndexedIndirectCount over the compacted commands
+    CULL_DRAW_MULTI_INDIRECT, // every slot written, culled ones with no instances
+    CULL_DRAW_SINGLE_INDIRECT // as above, one vkCmdDrawIndexedIndirect per slot
+} CullDrawPath;
+
+// Written by the cull passes of one frame in flight and consumed by its draws, each phase has its own half
+typedef struct {
+    VkBuffer command_buffer;
+    GpuAllocation command_allocation;
+    VkBuffer count_buffer;
+    GpuAllocation count_allocation;
+    VkDescriptorSet descriptor_set;
+    uint32_t pyramid_generation; // the depth pyramid the set points at
+} GpuCullFrame;
+
+typedef struct {
+    uint32_t record_count;
+    VkBuffer record_buffer; // static, uploaded once
+    GpuAllocation record_allocation;
+    VkBuffer visibility_buffer; // one flag per record, written by the late phase for the next frame
+    GpuAllocation visibility_allocation;
+    VkImageView pyramid_view;
+    VkSampler pyramid_sampler;
+    uint32_t pyramid_generation;
+    uint32_t frame_count;
+    GpuCullFrame frames[MAX_FRAMES_IN_FLIGHT];
+    VkDescriptorPool descriptor_pool;
+    VkPipelineLayout pipeline_layout;
+    PipelineFuture *pipeline;
+    CullDrawPath draw_path;
+    uint32_t max_draw_count; // per indirect draw call
+    CullConstants constants;
+    bool culled; // the current frame's commands came from the cull passes
+} GpuCuller;
+
+// Culler creation, the cull pipeline compiles on the builder and frames draw on the CPU until it is ready
+GpuCuller *create_gpu_culler(VulkanContext *v_ctx, PipelineRegistry *registry, PipelineBuilder *builder,
+    const ShaderBinary *comp, const Mesh *mesh, uint32_t frame_count);
+
+// Column major model to clip matrix, Vulkan clip space with 0..w depth, frustum planes are taken from its rows
+void set_cull_transform(GpuCuller *culler, const float clip_from_model[16]);
+
+// The pyramid changes with the render targets, each frame's set picks it up in update_cull_frame once the frame is free
+void set_cull_depth_pyramid(GpuCuller *culler, VkImageView view, VkSampler sampler);
+void update_cull_frame(VkDevice device, GpuCuller *culler, uint32_t frame_index);
+
+// Recording, the count reset goes in a transfer pass ahead of the early dispatch
+void record_cull_reset(VkCommandBuffer command_buffer, const GpuCuller *culler, uint32_t frame_index);
+void record_cull_dispatch(VkCommandBuffer command_buffer, GpuCuller *culler, uint32_t frame_index, CullPhase phase, bool occlusion);
+void record_cull_draws(VkCommandBuffer command_buffer, const GpuCuller *culler, uint32_t frame_index, CullPhase phase);
+const char *get_cull_draw_path_name(CullDrawPath path);
+
+// Cleanup
+void destroy_gpu_culler(VulkanContext *v_ctx, GpuCuller *culler);
+
+#endif
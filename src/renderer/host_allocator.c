@@ -0,0 +1,138 @@
+#include "host_allocator.h"
+
+// Stored just in front of every pointer handed to the driver
+typedef struct {
+    size_t size;
+    uint32_t scope;
+    uint32_t offset;
+} HostAllocationHeader;
+
+#define HOST_HEADER_SIZE 16
+_Static_assert(sizeof(HostAllocationHeader) <= HOST_HEADER_SIZE, "host allocation header too large");
+
+static HostAllocationStats host_stats[HOST_ALLOCATION_SCOPE_COUNT];
+
+static const char *SCOPE_NAMES[HOST_ALLOCATION_SCOPE_COUNT] = {
+    "command", "object", "cache", "device", "instance"
+};
+
+/*
+* Tracking
+*/
+static void track_allocation(uint32_t scope, size_t size) {
+    HostAllocationStats *stats = &host_stats[scope];
+    atomic_fetch_add(&stats->allocation_count, 1);
+    atomic_fetch_add(&stats->live_allocations, 1);
+    size_t live = atomic_fetch_add(&stats->live_bytes, size) + size;
+
+    size_t peak = atomic_load(&stats->peak_bytes);
+    while (live > peak && !atomic_compare_exchange_weak(&stats->peak_bytes, &peak, live)) {
+    }
+}
+
+static void track_free(uint32_t scope, size_t size) {
+    HostAllocationStats *stats = &host_stats[scope];
+    atomic_fetch_sub(&stats->live_allocations, 1);
+    atomic_fetch_sub(&stats->live_bytes, size);
+}
+
+static HostAllocationHeader *get_header(void *memory) {
+    return (HostAllocationHeader *)((uint8_t *)memory - HOST_HEADER_SIZE);
+}
+
+/*
+* Callbacks
+*/
+static VKAPI_ATTR void *VKAPI_CALL host_allocation(void *user_data, size_t size, size_t alignment, VkSystemAllocationScope scope) {
+    (void)user_data;
+    if (size == 0) { return NULL; }
+    if (alignment < HOST_HEADER_SIZE) {
+        alignment = HOST_HEADER_SIZE;
+    }
+
+    uint8_t *raw = malloc(size + alignment + HOST_HEADER_SIZE);
+    if (raw == NULL) { return NULL; }
+
+    uintptr_t aligned = ((uintptr_t)raw + HOST_HEADER_SIZE + alignment - 1) & ~(uintptr_t)(alignment - 1);
+    uint8_t *memory = (uint8_t *)aligned;
+
+    HostAllocationHeader *header = get_header(memory);
+    header->size = size;
+    header->scope = (uint32_t)scope < HOST_ALLOCATION_SCOPE_COUNT ? (uint32_t)scope : 0;
+    header->offset = (uint32_t)(memory - raw);
+
+    track_allocation(header->scope, size);
+    return memory;
+}
+
+static VKAPI_ATTR void VKAPI_CALL host_free(void *user_data, void *memory) {
+    (void)user_data;
+    if (memory == NULL) { return; }
+
+    HostAllocationHeader *header = get_header(memory);
+    track_free(header->scope, header->size);
+    free((uint8_t *)memory - header->offset);
+}
+
+static VKAPI_ATTR void *VKAPI_CALL host_reallocation(void *user_data, void *original, size_t size, size_t alignment, VkSystemAllocationScope scope) {
+    if (original == NULL) {
+        return host_allocation(user_data, size, alignment, scope);
+    }
+    if (size == 0) {
+        host_free(user_data, original);
+        return NULL;
+    }
+
+    // Alignment must be preserved, so always move to a fresh allocation
+    void *memory = host_allocation(user_data, size, alignment, scope);
+    if (memory == NULL) { return NULL; }
+
+    size_t original_size = get_header(original)->size;
+    memcpy(memory, original, original_size < size ? original_size : size);
+    host_free(user_data, original);
+    return memory;
+}
+
+// Driver allocations we only get told about, they are not ours to free
+static VKAPI_ATTR void VKAPI_CALL host_internal_allocation(void *user_data, size_t size, VkInternalAllocationType type, VkSystemAllocationScope scope) {
+    (void)user_data;
+    (void)type;
+    if ((uint32_t)scope < HOST_ALLOCATION_SCOPE_COUNT) {
+        atomic_fetch_add(&host_stats[scope].internal_bytes, size);
+    }
+}
+
+static VKAPI_ATTR void VKAPI_CALL host_internal_free(void *user_data, size_t size, VkInternalAllocationType type, VkSystemAllocationScope scope) {
+    (void)user_data;
+    (void)type;
+    if ((uint32_t)scope < HOST_ALLOCATION_SCOPE_COUNT) {
+        atomic_fetch_sub(&host_stats[scope].internal_bytes, size);
+    }
+}
+
+static const VkAllocationCallbacks HOST_ALLOCATOR = {
+    .pUserData = NULL,
+    .pfnAllocation = host_allocation,
+    .pfnReallocation = host_reallocation,
+    .pfnFree = host_free,
+    .pfnInternalAllocation = host_internal_allocation,
+    .pfnInternalFree = host_internal_free
+};
+
+const VkAllocationCallbacks *get_host_allocator(void) {
+    return &HOST_ALLOCATOR;
+}
+
+/*
+* Statistics
+*/
+void print_host_allocator_stats(void) {
+    printf("[HOST MEMORY] scope      allocs      live   live KiB   peak KiB  internal KiB\n");
+    for (uint32_t i = 0; i < HOST_ALLOCATION_SCOPE_COUNT; ++i) {
+        HostAllocationStats *stats = &host_stats[i];
+        printf("[HOST MEMORY] %-8s %8zu  %8zu  %9.1f  %9.1f  %12.1f\n", SCOPE_NAMES[i],
+            atomic_load(&stats->allocation_count), atomic_load(&stats->live_allocations),
+            atomic_load(&stats->live_bytes) / 1024.0, atomic_load(&stats->peak_bytes) / 1024.0,
+            atomic_load(&stats->internal_bytes) / 1024.0);
+    }
+}
@@ -0,0 +1,33 @@
+#ifndef HOST_ALLOCATOR_H
+#define HOST_ALLOCATOR_H
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// One entry per VkSystemAllocationScope
+#define HOST_ALLOCATION_SCOPE_COUNT 5
+
+// Updated from any driver thread
+typedef struct {
+    atomic_size_t allocation_count;
+    atomic_size_t live_allocations;
+    atomic_size_t live_bytes;
+    atomic_size_t peak_bytes;
+    atomic_size_t internal_bytes;
+} HostAllocationStats;
+
+// Callbacks passed to every Vulkan create and destroy call
+const VkAllocationCallbacks *get_host_allocator(void);
+
+// Statistics
+void print_host_allocator_stats(void);
+
+#endif
@@ -0,0 +1,100 @@
+// mmap and fstat are POSIX, not C17
+#define _POSIX_C_SOURCE 200809L
+
+#include "mapped_file.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/*
+* Mapping
+*/
+#ifdef _WIN32
+MappedFile *map_file(const char *path) {
+    MappedFile *file = malloc(sizeof(MappedFile));
+    if (file == NULL) { return NULL; }
+
+    file->file_handle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file->file_handle == INVALID_HANDLE_VALUE) {
+        fprintf(stderr, "failed to open file: %s\n", path);
+        free(file);
+        return NULL;
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file->file_handle, &size) || size.QuadPart == 0) {
+        fprintf(stderr, "failed to stat file: %s\n", path);
+        CloseHandle(file->file_handle);
+        free(file);
+        return NULL;
+    }
+    file->size = (size_t)size.QuadPart;
+
+    file->mapping_handle = CreateFileMappingA(file->file_handle, NULL, PAGE_READONLY, 0, 0, NULL);
+    file->data = file->mapping_handle != NULL ? MapViewOfFile(file->mapping_handle, FILE_MAP_READ, 0, 0, 0) : NULL;
+    if (file->data == NULL) {
+        fprintf(stderr, "failed to map file: %s\n", path);
+        if (file->mapping_handle != NULL) {
+            CloseHandle(file->mapping_handle);
+        }
+        CloseHandle(file->file_handle);
+        free(file);
+        return NULL;
+    }
+
+    return file;
+}
+#else
+MappedFile *map_file(const char *path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "failed to open file: %s\n", path);
+        return NULL;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0) {
+        fprintf(stderr, "failed to stat file: %s\n", path);
+        close(fd);
+        return NULL;
+    }
+
+    // The mapping keeps the file referenced, the descriptor is not needed after this
+    void *data = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        fprintf(stderr, "failed to map file: %s\n", path);
+        return NULL;
+    }
+
+    MappedFile *file = malloc(sizeof(MappedFile));
+    if (file == NULL) {
+        munmap(data, (size_t)info.st_size);
+        return NULL;
+    }
+
+    file->data = data;
+    file->size = (size_t)info.st_size;
+    return file;
+}
+#endif
+
+/*
+* Cleanup
+*/
+void unmap_file(MappedFile *file) {
+#ifdef _WIN32
+    UnmapViewOfFile(file->data);
+    CloseHandle(file->mapping_handle);
+    CloseHandle(file->file_handle);
+#else
+    munmap((void *)file->data, file->size);
+#endif
+    free(file);
+}
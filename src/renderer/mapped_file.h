@@ -0,0 +1,25 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Read only view of a whole file, valid until unmapped
+typedef struct {
+    const void *data;
+    size_t size;
+#ifdef _WIN32
+    void *file_handle;
+    void *mapping_handle;
+#endif
+} MappedFile;
+
+// Mapping
+MappedFile *map_file(const char *path);
+
+// Cleanup
+void unmap_file(MappedFile *file);
+
+#endif
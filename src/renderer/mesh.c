@@ -0,0 +1,374 @@
+#include "mesh.h"
+
+typedef struct {
+    VkBuffer buffer;
+    GpuAllocation allocation;
+    VkCommandBuffer command_buffer;
+    VkFence fence;
+    bool pending;
+} MeshUploadSlot;
+
+typedef struct {
+    uint32_t location;
+    VkFormat format;
+    uint32_t offset;
+} MeshAttribute;
+
+#define MESH_ATTRIBUTE_COUNT 3
+
+static const MeshAttribute FLOAT_ATTRIBUTES[MESH_ATTRIBUTE_COUNT] = {
+    { MESH_LOCATION_POSITION, VK_FORMAT_R32G32B32_SFLOAT, offsetof(MeshVertex, position) },
+    { MESH_LOCATION_NORMAL, VK_FORMAT_R32G32B32_SFLOAT, offsetof(MeshVertex, normal) },
+    { MESH_LOCATION_UV, VK_FORMAT_R32G32_SFLOAT, offsetof(MeshVertex, uv) }
+};
+
+// Every format here has mandatory vertex buffer support, no feature query needed
+static const MeshAttribute QUANTIZED_ATTRIBUTES[MESH_ATTRIBUTE_COUNT] = {
+    { MESH_LOCATION_POSITION, VK_FORMAT_R16G16B16A16_SNORM, offsetof(MeshQuantizedVertex, position) },
+    { MESH_LOCATION_NORMAL, VK_FORMAT_R16G16_SNORM, offsetof(MeshQuantizedVertex, normal) },
+    { MESH_LOCATION_UV, VK_FORMAT_R16G16_UNORM, offsetof(MeshQuantizedVertex, uv) }
+};
+
+static uint32_t get_vertex_stride(uint32_t vertex_format) {
+    switch (vertex_format) {
+    case MESH_VERTEX_FORMAT_FLOAT: return sizeof(MeshVertex);
+    case MESH_VERTEX_FORMAT_QUANTIZED: return sizeof(MeshQuantizedVertex);
+    default: return 0;
+    }
+}
+
+/*
+* Validation
+*/
+// Written so neither the sum nor the difference can wrap, offsets come straight from the file
+static bool is_range_in_file(uint64_t offset, uint64_t bytes, size_t file_size) {
+    return offset <= file_size && bytes <= file_size - offset;
+}
+
+// Headers and tables are checked once so drawing can trust every range, index values are left to the GPU
+static bool validate_mesh_file(const MappedFile *file) {
+    const MeshFileHeader *header = file->data;
+    if (file->size < sizeof(MeshFileHeader)
+        || header->magic != MESH_FILE_MAGIC
+        || header->version != MESH_FILE_VERSION
+        || get_vertex_stride(header->vertex_format) == 0
+        || header->vertex_stride != get_vertex_stride(header->vertex_format)
+        || (header->index_size != MESH_INDEX_SIZE_16 && header->index_size != MESH_INDEX_SIZE_32)) {
+        return false;
+    }
+
+    // Ends are only compared once their range is known to be inside the file, so they cannot have wrapped
+    uint64_t table_bytes = (uint64_t)header->submesh_count * sizeof(MeshFileSubmesh);
+    uint64_t meshlet_bytes = (uint64_t)header->meshlet_count * sizeof(MeshFileMeshlet);
+    uint64_t table_end = header->submesh_offset + table_bytes;
+    uint64_t meshlet_end = header->meshlet_offset + meshlet_bytes;
+    uint64_t vertex_end = header->vertex_offset + header->vertex_bytes;
+    bool valid = header->submesh_offset >= sizeof(MeshFileHeader)
+        && header->submesh_offset % sizeof(uint32_t) == 0
+        && is_range_in_file(header->submesh_offset, table_bytes, file->size)
+        && header->meshlet_offset >= table_end
+        && header->meshlet_offset % sizeof(uint32_t) == 0
+        && is_range_in_file(header->meshlet_offset, meshlet_bytes, file->size)
+        && header->vertex_offset >= meshlet_end
+        && header->vertex_bytes == (uint64_t)header->vertex_count * header->vertex_stride
+        && is_range_in_file(header->vertex_offset, header->vertex_bytes, file->size)
+        && header->index_offset >= vertex_end
+        && (header->index_offset - header->vertex_offset) % header->index_size == 0
+        && header->index_bytes == (uint64_t)header->index_count * header->index_size
+        && is_range_in_file(header->index_offset, header->index_bytes, file->size);
+
+    const MeshFileSubmesh *submeshes = (const MeshFileSubmesh *)((const uint8_t *)file->data + header->submesh_offset);
+    for (uint32_t i = 0; valid && i < header->submesh_count; ++i) {
+        valid = (uint64_t)submeshes[i].first_index + submeshes[i].index_count <= header->index_count
+            && (uint64_t)submeshes[i].first_vertex + submeshes[i].vertex_count <= header->vertex_count
+            && (uint64_t)submeshes[i].first_meshlet + submeshes[i].meshlet_count <= header->meshlet_count;
+    }
+
+    // Meshlets are drawn as plain index ranges, so they have to stay inside their submesh
+    const MeshFileMeshlet *meshlets = (const MeshFileMeshlet *)((const uint8_t *)file->data + header->meshlet_offset);
+    for (uint32_t i = 0; valid && i < header->meshlet_count; ++i) {
+        const MeshFileSubmesh *submesh = meshlets[i].submesh < header->submesh_count ? &submeshes[meshlets[i].submesh] : NULL;
+        valid = submesh != NULL
+            && meshlets[i].first_vertex == submesh->first_vertex
+            && meshlets[i].first_index >= submesh->first_index
+            && (uint64_t)meshlets[i].first_index + meshlets[i].index_count <= (uint64_t)submesh->first_index + submesh->index_count;
+    }
+    return valid;
+}
+
+/*
+* Upload
+*/
+// Concurrent when the transfer queue is its own family, the graphics queue reads without an ownership transfer
+bool create_mesh_buffer(VulkanContext *v_ctx, VkDeviceSize size, VkBufferUsageFlags usage, GpuMemoryUsage memory_usage,
+    VkBuffer *buffer, GpuAllocation *allocation) {
+    uint32_t families[2] = { get_queue_family(v_ctx, QUEUE_GRAPHICS), get_queue_family(v_ctx, QUEUE_TRANSFER) };
+    bool concurrent = memory_usage == GPU_MEMORY_GPU_ONLY && is_queue_dedicated(v_ctx, QUEUE_TRANSFER);
+
+    VkBufferCreateInfo create_info;
+    create_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    create_info.pNext = NULL;
+    create_info.flags = 0;
+    create_info.size = size;
+    create_info.usage = usage;
+    create_info.sharingMode = concurrent ? VK_SHARING_MODE_CONCURRENT : VK_SHARING_MODE_EXCLUSIVE;
+    create_info.queueFamilyIndexCount = concurrent ? 2 : 0;
+    create_info.pQueueFamilyIndices = concurrent ? families : NULL;
+    if (vkCreateBuffer(v_ctx->device, &create_info, get_host_allocator(), buffer) != VK_SUCCESS) {
+        fprintf(stderr, "failed to create mesh buffer\n");
+        return false;
+    }
+
+    if (!allocate_buffer_memory(v_ctx->allocator, *buffer, memory_usage, allocation)) {
+        fprintf(stderr, "failed to allocate mesh buffer memory\n");
+        vkDestroyBuffer(v_ctx->device, *buffer, get_host_allocator());
+        *buffer = VK_NULL_HANDLE;
+        return false;
+    }
+    return true;
+}
+
+static bool create_upload_slot(VulkanContext *v_ctx, VkCommandPool command_pool, VkDeviceSize size, MeshUploadSlot *slot) {
+    slot->pending = false;
+    if (!create_mesh_buffer(v_ctx, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, GPU_MEMORY_CPU_TO_GPU, &slot->buffer, &slot->allocation)) {
+        return false;
+    }
+
+    VkCommandBufferAllocateInfo alloc_info;
+    alloc_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    alloc_info.pNext = NULL;
+    alloc_info.commandPool = command_pool;
+    alloc_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    alloc_info.commandBufferCount = 1;
+
+    VkFenceCreateInfo fence_create_info;
+    fence_create_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    fence_create_info.pNext = NULL;
+    fence_create_info.flags = 0;
+    if (vkAllocateCommandBuffers(v_ctx->device, &alloc_info, &slot->command_buffer) != VK_SUCCESS
+        || vkCreateFence(v_ctx->device, &fence_create_info, get_host_allocator(), &slot->fence) != VK_SUCCESS) {
+        fprintf(stderr, "failed to create mesh upload slot\n");
+        return false;
+    }
+    return true;
+}
+
+static bool wait_upload_slot(VulkanContext *v_ctx, MeshUploadSlot *slot) {
+    if (!slot->pending) { return true; }
+
+    slot->pending = false;
+    if (vkWaitForFences(v_ctx->device, 1, &slot->fence, VK_TRUE, UINT64_MAX) != VK_SUCCESS) {
+        fprintf(stderr, "failed to wait for mesh upload\n");
+        return false;
+    }
+    vkResetFences(v_ctx->device, 1, &slot->fence);
+    return true;
+}
+
+// The mapping is copied straight into staging, one memcpy per chunk and no parsing
+bool upload_mesh_data(VulkanContext *v_ctx, VkBuffer buffer, const void *data, VkDeviceSize size) {
+    VkCommandPool command_pool = create_queue_command_pool(v_ctx, QUEUE_TRANSFER,
+        VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT);
+    if (command_pool == VK_NULL_HANDLE) { return false; }
+
+    VkDeviceSize chunk_size = size < MESH_UPLOAD_CHUNK_SIZE ? size : MESH_UPLOAD_CHUNK_SIZE;
+    MeshUploadSlot slots[MESH_UPLOAD_SLOTS];
+    memset(slots, 0, sizeof(slots));
+
+    bool success = true;
+    for (uint32_t i = 0; success && i < MESH_UPLOAD_SLOTS; ++i) {
+        success = create_upload_slot(v_ctx, command_pool, chunk_size, &slots[i]);
+    }
+
+    uint32_t chunk = 0;
+    for (VkDeviceSize offset = 0; success && offset < size; offset += chunk_size, ++chunk) {
+        MeshUploadSlot *slot = &slots[chunk % MESH_UPLOAD_SLOTS];
+        if (!wait_upload_slot(v_ctx, slot)) {
+            success = false;
+            break;
+        }
+
+        VkDeviceSize copy_size = size - offset < chunk_size ? size - offset : chunk_size;
+        memcpy(slot->allocation.mapped, (const uint8_t *)data + offset, (size_t)copy_size);
+        flush_gpu_allocation(v_ctx->allocator, &slot->allocation);
+
+        VkCommandBufferBeginInfo begin_info;
+        begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        begin_info.pNext = NULL;
+        begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        begin_info.pInheritanceInfo = NULL;
+
+        VkBufferCopy region;
+        region.srcOffset = 0;
+        region.dstOffset = offset;
+        region.size = copy_size;
+
+        vkBeginCommandBuffer(slot->command_buffer, &begin_info);
+        vkCmdCopyBuffer(slot->command_buffer, slot->buffer, buffer, 1, &region);
+        vkEndCommandBuffer(slot->command_buffer);
+
+        QueueSubmitDesc submit_desc;
+        submit_desc.command_buffers = &slot->command_buffer;
+        submit_desc.command_buffer_count = 1;
+        submit_desc.waits = NULL;
+        submit_desc.wait_count = 0;
+        submit_desc.signals = NULL;
+        submit_desc.signal_count = 0;
+        submit_desc.fence = slot->fence;
+        success = submit_to_queue(v_ctx, QUEUE_TRANSFER, &submit_desc);
+        slot->pending = success;
+    }
+
+    // Every copy has finished before the mesh is handed to the frame loop
+    for (uint32_t i = 0; i < MESH_UPLOAD_SLOTS; ++i) {
+        success = wait_upload_slot(v_ctx, &slots[i]) && success;
+        if (slots[i].fence != VK_NULL_HANDLE) {
+            vkDestroyFence(v_ctx->device, slots[i].fence, get_host_allocator());
+        }
+        if (slots[i].buffer != VK_NULL_HANDLE) {
+            vkDestroyBuffer(v_ctx->device, slots[i].buffer, get_host_allocator());
+            free_gpu_memory(v_ctx->allocator, &slots[i].allocation);
+        }
+    }
+    vkDestroyCommandPool(v_ctx->device, command_pool, get_host_allocator());
+    return success;
+}
+
+/*
+* Mesh loading
+*/
+Mesh *load_mesh(VulkanContext *v_ctx, const char *path) {
+    uint64_t start = get_trace_time_ns();
+    MappedFile *file = map_file(path);
+    if (file == NULL) { return NULL; }
+
+    if (!validate_mesh_file(file)) {
+        fprintf(stderr, "invalid mesh file: %s\n", path);
+        unmap_file(file);
+        return NULL;
+    }
+
+    const MeshFileHeader *header = file->data;
+    Mesh *mesh = calloc(1, sizeof(Mesh));
+    if (mesh == NULL) {
+        unmap_file(file);
+        return NULL;
+    }
+
+    // The submesh and meshlet tables are the only parts kept on the CPU
+    mesh->submeshes = malloc(header->submesh_count * sizeof(MeshFileSubmesh));
+    mesh->meshlets = header->meshlet_count > 0 ? malloc(header->meshlet_count * sizeof(MeshFileMeshlet)) : NULL;
+    if (mesh->submeshes == NULL || (header->meshlet_count > 0 && mesh->meshlets == NULL)) {
+        free(mesh->submeshes);
+        free(mesh->meshlets);
+        free(mesh);
+        unmap_file(file);
+        return NULL;
+    }
+    memcpy(mesh->submeshes, (const uint8_t *)file->data + header->submesh_offset, header->submesh_count * sizeof(MeshFileSubmesh));
+    if (header->meshlet_count > 0) {
+        memcpy(mesh->meshlets, (const uint8_t *)file->data + header->meshlet_offset, header->meshlet_count * sizeof(MeshFileMeshlet));
+    }
+    mesh->submesh_count = header->submesh_count;
+    mesh->meshlet_count = header->meshlet_count;
+    mesh->vertex_format = header->vertex_format;
+    mesh->vertex_stride = header->vertex_stride;
+    mesh->vertex_count = header->vertex_count;
+    mesh->index_count = header->index_count;
+    mesh->index_type = header->index_size == MESH_INDEX_SIZE_16 ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+    mesh->vertex_offset = 0;
+    mesh->index_offset = header->index_offset - header->vertex_offset;
+    memcpy(mesh->bounds_min, header->bounds_min, sizeof(mesh->bounds_min));
+    memcpy(mesh->bounds_max, header->bounds_max, sizeof(mesh->bounds_max));
+    memcpy(mesh->position_scale, header->position_scale, sizeof(mesh->position_scale));
+    memcpy(mesh->position_offset, header->position_offset, sizeof(mesh->position_offset));
+    memcpy(mesh->uv_scale, header->uv_scale, sizeof(mesh->uv_scale));
+    memcpy(mesh->uv_offset, header->uv_offset, sizeof(mesh->uv_offset));
+
+    // Both streams and the padding between them go up as one range
+    VkDeviceSize size = mesh->index_offset + header->index_bytes;
+    bool loaded = create_mesh_buffer(v_ctx, size,
+        VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        GPU_MEMORY_GPU_ONLY, &mesh->buffer, &mesh->allocation);
+    loaded = loaded && upload_mesh_data(v_ctx, mesh->buffer, (const uint8_t *)file->data + header->vertex_offset, size);
+    unmap_file(file);
+    if (!loaded) {
+        destroy_mesh(v_ctx, mesh);
+        fprintf(stderr, "failed to load mesh: %s\n", path);
+        return NULL;
+    }
+
+    printf("[MESH] %s: %u vertices (%u bytes each), %u indices, %u submeshes, %u meshlets, %.2f MiB in %.2f ms\n", path,
+        mesh->vertex_count, mesh->vertex_stride, mesh->index_count, mesh->submesh_count, mesh->meshlet_count,
+        size / (1024.0 * 1024.0), (get_trace_time_ns() - start) / 1e6);
+    return mesh;
+}
+
+const char *get_mesh_path() {
+    const char *path = getenv(MESH_PATH_ENV);
+    if (path != NULL && path[0] != '\0') {
+        return path;
+    }
+    return MESH_FILE;
+}
+
+/*
+* Pipeline state
+*/
+bool build_mesh_vertex_input(const Mesh *mesh, const ShaderReflection *vertex_reflection, VertexInputDesc *vertex_input) {
+    const MeshAttribute *attributes = mesh->vertex_format == MESH_VERTEX_FORMAT_QUANTIZED ? QUANTIZED_ATTRIBUTES : FLOAT_ATTRIBUTES;
+    vertex_input->binding_count = 1;
+    vertex_input->bindings[0].binding = 0;
+    vertex_input->bindings[0].stride = mesh->vertex_stride;
+    vertex_input->bindings[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+    vertex_input->attribute_count = 0;
+
+    for (uint32_t i = 0; i < vertex_reflection->vertex_input_count; ++i) {
+        uint32_t location = vertex_reflection->vertex_inputs[i].location;
+        const MeshAttribute *attribute = NULL;
+        for (uint32_t j = 0; j < MESH_ATTRIBUTE_COUNT; ++j) {
+            if (attributes[j].location == location) {
+                attribute = &attributes[j];
+                break;
+            }
+        }
+
+        if (attribute == NULL) {
+            fprintf(stderr, "mesh has no vertex attribute for location %u\n", location);
+            return false;
+        }
+
+        VkVertexInputAttributeDescription *description = &vertex_input->attributes[vertex_input->attribute_count++];
+        description->location = location;
+        description->binding = 0;
+        description->format = attribute->format;
+        description->offset = attribute->offset;
+    }
+    return true;
+}
+
+/*
+* Drawing
+*/
+void bind_mesh(VkCommandBuffer command_buffer, const Mesh *mesh) {
+    vkCmdBindVertexBuffers(command_buffer, 0, 1, &mesh->buffer, &mesh->vertex_offset);
+    vkCmdBindIndexBuffer(command_buffer, mesh->buffer, mesh->index_offset, mesh->index_type);
+}
+
+void draw_submesh(VkCommandBuffer command_buffer, const Mesh *mesh, uint32_t submesh) {
+    const MeshFileSubmesh *range = &mesh->submeshes[submesh];
+    vkCmdDrawIndexed(command_buffer, range->index_count, 1, range->first_index, (int32_t)range->first_vertex, 0);
+}
+
+/*
+* Cleanup
+*/
+void destroy_mesh(VulkanContext *v_ctx, Mesh *mesh) {
+    if (mesh->buffer != VK_NULL_HANDLE) {
+        vkDestroyBuffer(v_ctx->device, mesh->buffer, get_host_allocator());
+        free_gpu_memory(v_ctx->allocator, &mesh->allocation);
+    }
+    free(mesh->submeshes);
+    free(mesh->meshlets);
+    free(mesh);
+}
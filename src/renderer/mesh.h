@@ -0,0 +1,77 @@
+#ifndef MESH_H
+#define MESH_H
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "config.h"
+#include "vulkan_context.h"
+#include "queue.h"
+#include "mapped_file.h"
+#include "mesh_format.h"
+#include "pipeline.h"
+#include "spirv_reflect.h"
+#include "trace.h"
+
+#define MESH_PATH_ENV "VRENDER_MESH"
+
+// Vertex shader interface every mesh pipeline follows
+#define MESH_LOCATION_POSITION 0
+#define MESH_LOCATION_NORMAL 1
+#define MESH_LOCATION_UV 2
+#define MESH_VERTEX_FORMAT_CONSTANT_ID 0
+
+// Staging is double buffered, one chunk is copied from the mapping while the other uploads
+#define MESH_UPLOAD_CHUNK_SIZE (16ull * 1024 * 1024)
+#define MESH_UPLOAD_SLOTS 2
+
+// Vertex and index streams share one device local buffer, laid out as in the file
+typedef struct {
+    VkBuffer buffer;
+    GpuAllocation allocation;
+    VkDeviceSize vertex_offset;
+    VkDeviceSize index_offset;
+    VkIndexType index_type;
+    MeshVertexFormat vertex_format;
+    uint32_t vertex_stride;
+    uint32_t vertex_count;
+    uint32_t index_count;
+    uint32_t submesh_count;
+    MeshFileSubmesh *submeshes;
+    uint32_t meshlet_count;
+    MeshFileMeshlet *meshlets; // empty unless cooked with --meshlets
+    float bounds_min[3];
+    float bounds_max[3];
+    float position_scale[3];
+    float position_offset[3];
+    float uv_scale[2];
+    float uv_offset[2];
+} Mesh;
+
+// Mesh loading
+Mesh *load_mesh(VulkanContext *v_ctx, const char *path);
+const char *get_mesh_path();
+
+// Upload, also used for other static geometry data such as culling records
+bool create_mesh_buffer(VulkanContext *v_ctx, VkDeviceSize size, VkBufferUsageFlags usage, GpuMemoryUsage memory_usage,
+    VkBuffer *buffer, GpuAllocation *allocation);
+bool upload_mesh_data(VulkanContext *v_ctx, VkBuffer buffer, const void *data, VkDeviceSize size);
+
+// Pipeline state, attributes follow the mesh's vertex format and only what the shader reads is fetched
+bool build_mesh_vertex_input(const Mesh *mesh, const ShaderReflection *vertex_reflection, VertexInputDesc *vertex_input);
+
+// Drawing
+void bind_mesh(VkCommandBuffer command_buffer, const Mesh *mesh);
+void draw_submesh(VkCommandBuffer command_buffer, const Mesh *mesh, uint32_t submesh);
+
+// Cleanup
+void destroy_mesh(VulkanContext *v_ctx, Mesh *mesh);
+
+#endif
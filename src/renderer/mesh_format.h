@@ -0,0 +1,95 @@
+#ifndef MESH_FORMAT_H
+#define MESH_FORMAT_H
+
+// On disk layout shared by the runtime and the cooking tool, no Vulkan types
+
+#include <stdint.h>
+
+#define MESH_FILE_MAGIC 0x48534D56 // "VMSH"
+#define MESH_FILE_VERSION 3
+#define MESH_FILE_ALIGNMENT 64
+
+#define MESH_INDEX_SIZE_16 2
+#define MESH_INDEX_SIZE_32 4
+
+// Sized for mesh shader style clusters, with 64 vertices a meshlet's local indices fit in a byte
+#define MESHLET_MAX_VERTICES 64
+#define MESHLET_MAX_TRIANGLES 124
+
+// Values match the vertex shader's format specialization constant
+typedef enum {
+    MESH_VERTEX_FORMAT_FLOAT = 0,
+    MESH_VERTEX_FORMAT_QUANTIZED = 1
+} MeshVertexFormat;
+
+// Interleaved, matches the vertex shader inputs in location order
+typedef struct {
+    float position[3];
+    float normal[3];
+    float uv[2];
+} MeshVertex;
+
+// Half the size of MeshVertex, decoded by the vertex fetch and the header's dequantization transform
+typedef struct {
+    int16_t position[4]; // SNORM16 within the mesh bounds, w is padding
+    int16_t normal[2]; // SNORM16 octahedral
+    uint16_t uv[2]; // UNORM16 within the uv bounds
+} MeshQuantizedVertex;
+
+// Submesh indices are relative to first_vertex, which keeps 16 bit indices usable for large meshes
+typedef struct {
+    uint32_t first_index;
+    uint32_t index_count;
+    uint32_t first_vertex;
+    uint32_t vertex_count;
+    float bounds_min[3];
+    float bounds_max[3];
+    uint32_t first_meshlet;
+    uint32_t meshlet_count; // 0 when the mesh was cooked without meshlets
+} MeshFileSubmesh;
+
+// A contiguous run of a submesh's triangles with bounds for cluster culling, drawn as a plain indexed range
+typedef struct {
+    uint32_t first_index;
+    uint32_t index_count;
+    uint32_t first_vertex; // same as the owning submesh
+    uint32_t vertex_count; // unique vertices referenced, at most MESHLET_MAX_VERTICES
+    float center[3];
+    float radius;
+    // Every triangle faces away from any eye where dot(normalize(apex - eye), axis) >= cutoff
+    float cone_axis[3];
+    float cone_cutoff;
+    float cone_apex[3];
+    uint32_t submesh;
+} MeshFileMeshlet;
+
+// [header][submesh table][meshlet table][aligned vertex stream][aligned index stream], streams are uploaded as one range
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t vertex_format;
+    uint32_t vertex_stride;
+    uint32_t vertex_count;
+    uint32_t index_count;
+    uint32_t index_size;
+    uint32_t submesh_count;
+    uint32_t meshlet_count;
+    uint32_t padding;
+    float bounds_min[3];
+    float bounds_max[3];
+
+    // decoded = stored * scale + offset, identity for float vertices
+    float position_scale[3];
+    float position_offset[3];
+    float uv_scale[2];
+    float uv_offset[2];
+
+    uint64_t submesh_offset;
+    uint64_t meshlet_offset;
+    uint64_t vertex_offset;
+    uint64_t vertex_bytes;
+    uint64_t index_offset;
+    uint64_t index_bytes;
+} MeshFileHeader;
+
+#endif
@@ -0,0 +1,112 @@
+#include "offscreen.h"
+
+/*
+* Offscreen creation
+*/
+OffscreenContext *create_offscreen_context(VulkanContext *v_ctx, VkExtent2D extent, uint32_t image_count, VkFormat format) {
+    OffscreenContext *offscreen_ctx = malloc(sizeof(OffscreenContext));
+    if (offscreen_ctx == NULL) { return NULL; }
+
+    offscreen_ctx->image_count = image_count;
+    offscreen_ctx->extent = extent;
+    offscreen_ctx->image_format = format;
+    offscreen_ctx->images = calloc(image_count, sizeof(VkImage));
+    offscreen_ctx->allocations = calloc(image_count, sizeof(GpuAllocation));
+    if (offscreen_ctx->images == NULL || offscreen_ctx->allocations == NULL) {
+        fprintf(stderr, "failed to alloc offscreen image arrays\n");
+        return NULL;
+    }
+
+    for (int i = 0; i < image_count; ++i) {
+        VkImageCreateInfo create_info;
+        create_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        create_info.pNext = NULL;
+        create_info.flags = 0;
+        create_info.imageType = VK_IMAGE_TYPE_2D;
+        create_info.format = format;
+        create_info.extent.width = extent.width;
+        create_info.extent.height = extent.height;
+        create_info.extent.depth = 1;
+        create_info.mipLevels = 1;
+        create_info.arrayLayers = 1;
+        create_info.samples = VK_SAMPLE_COUNT_1_BIT;
+        create_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+
+        // Transfer source so results can be read back or copied out
+        create_info.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+        create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        create_info.queueFamilyIndexCount = 0;
+        create_info.pQueueFamilyIndices = NULL;
+        create_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+        if (vkCreateImage(v_ctx->device, &create_info, get_host_allocator(), &offscreen_ctx->images[i]) != VK_SUCCESS) {
+            fprintf(stderr, "failed to create offscreen image [%d]\n", i);
+            return NULL;
+        }
+
+        if (!allocate_image_memory(v_ctx->allocator, offscreen_ctx->images[i], GPU_MEMORY_GPU_ONLY, &offscreen_ctx->allocations[i])) {
+            fprintf(stderr, "failed to allocate offscreen image memory [%d]\n", i);
+            return NULL;
+        }
+    }
+
+    offscreen_ctx->image_views = create_offscreen_image_views(v_ctx->device, offscreen_ctx);
+    if (offscreen_ctx->image_views == NULL) { return NULL; }
+
+    return offscreen_ctx;
+}
+
+/*
+* Image views
+*/
+VkImageView *create_offscreen_image_views(VkDevice device, OffscreenContext *offscreen_ctx) {
+    VkImageView *image_views = malloc(sizeof(VkImageView) * offscreen_ctx->image_count);
+    if (image_views == NULL) { return NULL; }
+
+    for (int i = 0; i < offscreen_ctx->image_count; ++i) {
+        VkImageViewCreateInfo create_info;
+        create_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        create_info.pNext = NULL;
+        create_info.image = offscreen_ctx->images[i];
+        create_info.flags = 0;
+
+        create_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        create_info.format = offscreen_ctx->image_format;
+
+        // Components
+        create_info.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
+        create_info.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
+        create_info.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
+        create_info.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
+
+        // Subresource range
+        create_info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        create_info.subresourceRange.baseMipLevel = 0;
+        create_info.subresourceRange.levelCount = 1;
+        create_info.subresourceRange.baseArrayLayer = 0;
+        create_info.subresourceRange.layerCount = 1;
+
+        if (vkCreateImageView(device, &create_info, get_host_allocator(), &image_views[i]) != VK_SUCCESS) {
+            fprintf(stderr, "failed to create offscreen image view [%d]\n", i);
+            return NULL;
+        }
+    }
+
+    return image_views;
+}
+
+/*
+* Cleanup
+*/
+void destroy_offscreen_context(VkDevice device, GpuAllocator *allocator, OffscreenContext *offscreen_ctx) {
+    for (int i = 0; i < offscreen_ctx->image_count; ++i) {
+        vkDestroyImageView(device, offscreen_ctx->image_views[i], get_host_allocator());
+        vkDestroyImage(device, offscreen_ctx->images[i], get_host_allocator());
+        free_gpu_memory(allocator, &offscreen_ctx->allocations[i]);
+    }
+
+    free(offscreen_ctx->image_views);
+    free(offscreen_ctx->allocations);
+    free(offscreen_ctx->images);
+    free(offscreen_ctx);
+}
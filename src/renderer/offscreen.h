@@ -0,0 +1,21 @@
+#ifndef OFFSCREEN_H
+#define OFFSCREEN_H
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include "vulkan_context.h"
+#include "device.h"
+
+#define DEFAULT_OFFSCREEN_FORMAT VK_FORMAT_R8G8B8A8_UNORM
+
+// Offscreen creation
+OffscreenContext *create_offscreen_context(VulkanContext *v_ctx, VkExtent2D extent, uint32_t image_count, VkFormat format);
+
+// Image views
+VkImageView *create_offscreen_image_views(VkDevice device, OffscreenContext *offscreen_ctx);
+
+// Cleanup
+void destroy_offscreen_context(VkDevice device, GpuAllocator *allocator, OffscreenContext *offscreen_ctx);
+
+#endif
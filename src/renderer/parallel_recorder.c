@@ -0,0 +1,245 @@
+#include "parallel_recorder.h"
+
+/*
+* Recorder creation
+*/
+static bool create_record_pool(VkDevice device, uint32_t queue_family, RecordPool *pool) {
+    pool->command_buffers = NULL;
+    pool->command_buffer_count = 0;
+    pool->used_count = 0;
+
+    // Transient, buffers are never freed or reset on their own
+    VkCommandPoolCreateInfo create_info;
+    create_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    create_info.pNext = NULL;
+    create_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+    create_info.queueFamilyIndex = queue_family;
+    if (vkCreateCommandPool(device, &create_info, get_host_allocator(), &pool->command_pool) != VK_SUCCESS) {
+        fprintf(stderr, "failed to create recording command pool\n");
+        pool->command_pool = VK_NULL_HANDLE;
+        return false;
+    }
+    return true;
+}
+
+ParallelRecorder *create_parallel_recorder(VkDevice device, uint32_t queue_family, ThreadPool *thread_pool, uint32_t frames_in_flight) {
+    ParallelRecorder *recorder = calloc(1, sizeof(ParallelRecorder));
+    if (recorder == NULL) {
+        fprintf(stderr, "failed to alloc ParallelRecorder\n");
+        return NULL;
+    }
+
+    // Initialized first so every failure below can go through destroy_parallel_recorder
+    pthread_mutex_init(&recorder->mutex, NULL);
+    pthread_cond_init(&recorder->jobs_done, NULL);
+    recorder->device = device;
+    recorder->thread_pool = thread_pool;
+    recorder->frames_in_flight = frames_in_flight;
+    recorder->thread_count = thread_pool->thread_count + 1;
+    recorder->pools = calloc(frames_in_flight * recorder->thread_count, sizeof(RecordPool));
+    recorder->jobs = calloc(recorder->thread_count, sizeof(RecordJob));
+    recorder->secondaries = calloc(recorder->thread_count, sizeof(VkCommandBuffer));
+    if (recorder->pools == NULL || recorder->jobs == NULL || recorder->secondaries == NULL) {
+        fprintf(stderr, "failed to alloc recording pools\n");
+        destroy_parallel_recorder(recorder);
+        return NULL;
+    }
+
+    // Pools after a failed one are still zeroed, destroying a null pool is a no-op
+    for (uint32_t i = 0; i < frames_in_flight * recorder->thread_count; ++i) {
+        if (!create_record_pool(device, queue_family, &recorder->pools[i])) {
+            destroy_parallel_recorder(recorder);
+            return NULL;
+        }
+    }
+    for (uint32_t i = 0; i < recorder->thread_count; ++i) {
+        recorder->jobs[i].claimed = true;
+    }
+    return recorder;
+}
+
+/*
+* Recording
+*/
+// The frame's fence must have signaled, every secondary from that frame is reset at once
+bool reset_parallel_recorder(ParallelRecorder *recorder, uint32_t frame_index) {
+    recorder->frame_index = frame_index;
+    for (uint32_t i = 0; i < recorder->thread_count; ++i) {
+        RecordPool *pool = &recorder->pools[frame_index * recorder->thread_count + i];
+        if (vkResetCommandPool(recorder->device, pool->command_pool, 0) != VK_SUCCESS) {
+            fprintf(stderr, "failed to reset recording command pool\n");
+            return false;
+        }
+        pool->used_count = 0;
+    }
+    return true;
+}
+
+// Buffers are kept across frames, the pool only grows when a frame records more secondaries than any before
+static VkCommandBuffer acquire_secondary(ParallelRecorder *recorder, RecordPool *pool) {
+    if (pool->used_count == pool->command_buffer_count) {
+        uint32_t capacity = pool->command_buffer_count == 0 ? PARALLEL_RECORD_INITIAL_BUFFERS : pool->command_buffer_count * 2;
+        VkCommandBuffer *command_buffers = realloc(pool->command_buffers, sizeof(VkCommandBuffer) * capacity);
+        if (command_buffers == NULL) { return VK_NULL_HANDLE; }
+        pool->command_buffers = command_buffers;
+
+        VkCommandBufferAllocateInfo alloc_info;
+        alloc_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        alloc_info.pNext = NULL;
+        alloc_info.commandPool = pool->command_pool;
+        alloc_info.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+        alloc_info.commandBufferCount = capacity - pool->command_buffer_count;
+        if (vkAllocateCommandBuffers(recorder->device, &alloc_info, &pool->command_buffers[pool->command_buffer_count]) != VK_SUCCESS) {
+            fprintf(stderr, "failed to allocate secondary command buffers\n");
+            return VK_NULL_HANDLE;
+        }
+        pool->command_buffer_count = capacity;
+    }
+
+    return pool->command_buffers[pool->used_count++];
+}
+
+static bool record_secondary(RecordJob *job) {
+    VkCommandBufferBeginInfo begin_info;
+    begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    begin_info.pNext = NULL;
+    begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    if (job->inheritance->renderPass != VK_NULL_HANDLE) {
+        begin_info.flags |= VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+    }
+    begin_info.pInheritanceInfo = job->inheritance;
+    if (vkBeginCommandBuffer(job->command_buffer, &begin_info) != VK_SUCCESS) {
+        fprintf(stderr, "failed to begin secondary command buffer\n");
+        return false;
+    }
+
+    job->func(job->command_buffer, job->first, job->count, job->user_data);
+
+    if (vkEndCommandBuffer(job->command_buffer) != VK_SUCCESS) {
+        fprintf(stderr, "failed to end secondary command buffer\n");
+        return false;
+    }
+    return true;
+}
+
+// Every job is claimed by the time a recording returns, so stale queue entries find nothing to do
+static bool claim_record_job(ParallelRecorder *recorder, RecordJob *job, bool worker) {
+    pthread_mutex_lock(&recorder->mutex);
+    bool claimed = !job->claimed;
+    job->claimed = true;
+    if (claimed && worker) {
+        ++recorder->running_count;
+    }
+    pthread_mutex_unlock(&recorder->mutex);
+    return claimed;
+}
+
+// The recording thread may already have taken this chunk, or a later recording may own the slot by now
+static void record_secondary_job(void *arg) {
+    RecordJob *job = arg;
+    ParallelRecorder *recorder = job->recorder;
+    if (!claim_record_job(recorder, job, true)) { return; }
+    bool recorded = record_secondary(job);
+
+    pthread_mutex_lock(&recorder->mutex);
+    recorder->failed |= !recorded;
+    if (--recorder->running_count == 0) {
+        pthread_cond_signal(&recorder->jobs_done);
+    }
+    pthread_mutex_unlock(&recorder->mutex);
+}
+
+// Splits items into contiguous chunks, the calling thread records the first while workers take the rest
+bool record_parallel_commands(ParallelRecorder *recorder, VkCommandBuffer primary, const VkCommandBufferInheritanceInfo *inheritance,
+    uint32_t item_count, RecordFunc func, void *user_data) {
+    uint32_t chunk_count = (item_count + PARALLEL_RECORD_MIN_BATCH - 1) / PARALLEL_RECORD_MIN_BATCH;
+    if (chunk_count > recorder->thread_count) {
+        chunk_count = recorder->thread_count;
+    }
+    if (chunk_count == 0) {
+        chunk_count = 1;
+    }
+
+    uint32_t first = 0;
+    for (uint32_t i = 0; i < chunk_count; ++i) {
+        RecordPool *pool = &recorder->pools[recorder->frame_index * recorder->thread_count + i];
+        RecordJob *job = &recorder->jobs[i];
+        job->recorder = recorder;
+        job->command_buffer = acquire_secondary(recorder, pool);
+        job->inheritance = inheritance;
+        job->func = func;
+        job->user_data = user_data;
+        job->first = first;
+        job->count = item_count / chunk_count + (i < item_count % chunk_count ? 1 : 0);
+        first += job->count;
+        if (job->command_buffer == VK_NULL_HANDLE) { return false; }
+        recorder->secondaries[i] = job->command_buffer;
+    }
+
+    // Jobs are only released once fully written, stale workers may claim them as soon as they are
+    pthread_mutex_lock(&recorder->mutex);
+    recorder->failed = false;
+    for (uint32_t i = 1; i < chunk_count; ++i) {
+        recorder->jobs[i].claimed = false;
+    }
+    pthread_mutex_unlock(&recorder->mutex);
+
+    // Whatever does not make it onto the queue is taken back below
+    for (uint32_t i = 1; i < chunk_count; ++i) {
+        if (!submit_job(recorder->thread_pool, record_secondary_job, &recorder->jobs[i])) { break; }
+    }
+    bool recorded = record_secondary(&recorder->jobs[0]);
+
+    // Chunks no worker has started, e.g. queued behind pipeline compiles, are recorded here rather than waited for
+    for (uint32_t i = 1; i < chunk_count; ++i) {
+        if (claim_record_job(recorder, &recorder->jobs[i], false)) {
+            recorded = record_secondary(&recorder->jobs[i]) && recorded;
+        }
+    }
+
+    pthread_mutex_lock(&recorder->mutex);
+    while (recorder->running_count > 0) {
+        pthread_cond_wait(&recorder->jobs_done, &recorder->mutex);
+    }
+    recorded = recorded && !recorder->failed;
+    pthread_mutex_unlock(&recorder->mutex);
+    if (!recorded) { return false; }
+
+    // Chunks are executed in item order, the output matches recording on one thread
+    vkCmdExecuteCommands(primary, chunk_count, recorder->secondaries);
+    recorder->recorded_items += item_count;
+    recorder->secondary_count += chunk_count;
+    ++recorder->recording_count;
+    return true;
+}
+
+/*
+* Statistics
+*/
+void print_parallel_recorder_stats(ParallelRecorder *recorder) {
+    if (recorder->recording_count == 0) { return; }
+
+    printf("[RECORD] %llu items in %llu secondaries over %llu recordings, %u recording threads\n",
+        (unsigned long long)recorder->recorded_items, (unsigned long long)recorder->secondary_count,
+        (unsigned long long)recorder->recording_count, recorder->thread_count);
+}
+
+/*
+* Cleanup
+*/
+// Destroying a pool frees its command buffers, the device must be idle
+void destroy_parallel_recorder(ParallelRecorder *recorder) {
+    // Taken back chunks can leave entries on the shared queue that still point at the jobs
+    wait_thread_pool(recorder->thread_pool);
+    for (uint32_t i = 0; recorder->pools != NULL && i < recorder->frames_in_flight * recorder->thread_count; ++i) {
+        vkDestroyCommandPool(recorder->device, recorder->pools[i].command_pool, get_host_allocator());
+        free(recorder->pools[i].command_buffers);
+    }
+
+    pthread_mutex_destroy(&recorder->mutex);
+    pthread_cond_destroy(&recorder->jobs_done);
+    free(recorder->jobs);
+    free(recorder->secondaries);
+    free(recorder->pools);
+    free(recorder);
+}
@@ -0,0 +1,82 @@
+#ifndef PARALLEL_RECORDER_H
+#define PARALLEL_RECORDER_H
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "host_allocator.h"
+#include "thread_pool.h"
+
+// Below this many items per secondary the hand off costs more than the recording
+#define PARALLEL_RECORD_MIN_BATCH 256
+
+#define PARALLEL_RECORD_INITIAL_BUFFERS 4
+
+// Records items [first, first + count) into a secondary, dynamic state is not inherited and must be set again
+typedef void (*RecordFunc)(VkCommandBuffer command_buffer, uint32_t first, uint32_t count, void *user_data);
+
+// One pool per recording thread per frame in flight, reset wholesale when its frame comes around
+typedef struct {
+    VkCommandPool command_pool;
+    VkCommandBuffer *command_buffers;
+    uint32_t command_buffer_count;
+    uint32_t used_count;
+} RecordPool;
+
+struct ParallelRecorder;
+
+typedef struct {
+    struct ParallelRecorder *recorder;
+    VkCommandBuffer command_buffer;
+    const VkCommandBufferInheritanceInfo *inheritance;
+    RecordFunc func;
+    void *user_data;
+    uint32_t first;
+    uint32_t count;
+    bool claimed; // taken by a worker or the recording thread, guarded by the recorder's mutex
+} RecordJob;
+
+// Chunk i of every recording always lands in pool i, so pools are never shared between threads
+typedef struct ParallelRecorder {
+    VkDevice device;
+    ThreadPool *thread_pool;
+    uint32_t frames_in_flight;
+    uint32_t thread_count; // workers plus the recording thread
+    uint32_t frame_index;
+    RecordPool *pools; // frames_in_flight * thread_count
+    RecordJob *jobs;
+    VkCommandBuffer *secondaries;
+
+    // The thread pool is shared with pipeline builds, so chunks still queued behind them are taken back
+    // by the recording thread and only chunks a worker has started are waited for
+    pthread_mutex_t mutex;
+    pthread_cond_t jobs_done;
+    uint32_t running_count;
+    bool failed;
+
+    uint64_t recorded_items;
+    uint64_t secondary_count;
+    uint64_t recording_count;
+} ParallelRecorder;
+
+// Recorder creation
+ParallelRecorder *create_parallel_recorder(VkDevice device, uint32_t queue_family, ThreadPool *thread_pool, uint32_t frames_in_flight);
+
+// Recording
+bool reset_parallel_recorder(ParallelRecorder *recorder, uint32_t frame_index);
+bool record_parallel_commands(ParallelRecorder *recorder, VkCommandBuffer primary, const VkCommandBufferInheritanceInfo *inheritance,
+    uint32_t item_count, RecordFunc func, void *user_data);
+
+// Statistics
+void print_parallel_recorder_stats(ParallelRecorder *recorder);
+
+// Cleanup
+void destroy_parallel_recorder(ParallelRecorder *recorder);
+
+#endif
@@ -1,7 +1,5 @@
 #include "pipeline.h"
 
-#define FNAME_MAX 1024
-
 const int DYNAMIC_STATES_COUNT = 2;
 const VkDynamicState DYNAMIC_STATES[] = {
     VK_DYNAMIC_STATE_VIEWPORT,
@@ -11,178 +9,226 @@ const VkDynamicState DYNAMIC_STATES[] = {
 /*
 * Pipeline creation
 */
-VkPipeline create_graphics_pipeline(VkDevice device, SwapchainContext *swapchain_ctx, const char *fname_vert, const char *fname_frag) {
-    VkShaderModule vertex_module = create_shader_module(device, fname_vert);
-    if (vertex_module == NULL) {
+void init_graphics_pipeline_desc(GraphicsPipelineDesc *desc, VkRenderPass render_pass, VkPipelineLayout pipeline_layout, const ShaderBinary *vert, const ShaderBinary *frag) {
+    desc->vert = *vert;
+    desc->frag = *frag;
+    desc->vert_specialization.constant_count = 0;
+    desc->frag_specialization.constant_count = 0;
+    desc->render_pass = render_pass;
+    desc->pipeline_layout = pipeline_layout;
+    desc->subpass = 0;
+    desc->vertex_input.binding_count = 0;
+    desc->vertex_input.attribute_count = 0;
+    desc->topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+    desc->polygon_mode = VK_POLYGON_MODE_FILL;
+    desc->cull_mode = VK_CULL_MODE_BACK_BIT;
+    desc->front_face = VK_FRONT_FACE_CLOCKWISE;
+    desc->samples = VK_SAMPLE_COUNT_1_BIT;
+    desc->blend_enable = VK_FALSE;
+    desc->depth_test_enable = VK_FALSE;
+    desc->depth_write_enable = VK_FALSE;
+    desc->depth_compare_op = VK_COMPARE_OP_LESS;
+}
+
+static const VkSpecializationInfo *fill_specialization_info(const SpecializationDesc *desc, VkSpecializationMapEntry *map_entries, VkSpecializationInfo *info) {
+    if (desc->constant_count == 0) { return NULL; }
+
+    // Values are tightly packed, entry i reads word i of the desc
+    for (uint32_t i = 0; i < desc->constant_count; ++i) {
+        map_entries[i].constantID = desc->constant_ids[i];
+        map_entries[i].offset = i * sizeof(uint32_t);
+        map_entries[i].size = sizeof(uint32_t);
+    }
+
+    info->mapEntryCount = desc->constant_count;
+    info->pMapEntries = map_entries;
+    info->dataSize = desc->constant_count * sizeof(uint32_t);
+    info->pData = desc->values;
+    return info;
+}
+
+bool fill_graphics_pipeline_create_info(VkDevice device, const GraphicsPipelineDesc *desc, GraphicsPipelineState *state, VkGraphicsPipelineCreateInfo *create_info) {
+    state->vertex_module = create_shader_module(device, &desc->vert);
+    if (state->vertex_module == NULL) {
         fprintf(stderr, "failed to create vertex module\n");
-        return NULL;
+        return false;
     }
 
-    VkShaderModule frag_module = create_shader_module(device, fname_frag);
-    if (frag_module == NULL) {
+    state->frag_module = create_shader_module(device, &desc->frag);
+    if (state->frag_module == NULL) {
         fprintf(stderr, "failed to create fragment module\n");
-        return NULL;
+        vkDestroyShaderModule(device, state->vertex_module, get_host_allocator());
+        return false;
     }
 
-    VkPipelineShaderStageCreateInfo vert_create_info;
-    vert_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-    vert_create_info.pNext = NULL;
-    vert_create_info.flags = 0;
-    vert_create_info.module = vertex_module;
-    vert_create_info.stage = VK_SHADER_STAGE_VERTEX_BIT;
-    vert_create_info.pName = "main";
-    vert_create_info.pSpecializationInfo = NULL;
-
-    VkPipelineShaderStageCreateInfo frag_create_info;
-    frag_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-    frag_create_info.pNext = NULL;
-    frag_create_info.flags = 0;
-    frag_create_info.module = frag_module;
-    frag_create_info.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
-    frag_create_info.pName = "main";
-    frag_create_info.pSpecializationInfo = NULL;
-
-    VkPipelineShaderStageCreateInfo shader_stages[] = {
-        vert_create_info,
-        frag_create_info
-    };
+    VkPipelineShaderStageCreateInfo *vert_create_info = &state->shader_stages[0];
+    vert_create_info->sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    vert_create_info->pNext = NULL;
+    vert_create_info->flags = 0;
+    vert_create_info->module = state->vertex_module;
+    vert_create_info->stage = VK_SHADER_STAGE_VERTEX_BIT;
+    vert_create_info->pName = "main";
+    vert_create_info->pSpecializationInfo = fill_specialization_info(&desc->vert_specialization,
+        state->vert_map_entries, &state->vert_specialization_info);
+
+    VkPipelineShaderStageCreateInfo *frag_create_info = &state->shader_stages[1];
+    frag_create_info->sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    frag_create_info->pNext = NULL;
+    frag_create_info->flags = 0;
+    frag_create_info->module = state->frag_module;
+    frag_create_info->stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+    frag_create_info->pName = "main";
+    frag_create_info->pSpecializationInfo = fill_specialization_info(&desc->frag_specialization,
+        state->frag_map_entries, &state->frag_specialization_info);
 
     // Dynamic state creation
-    VkPipelineDynamicStateCreateInfo dynamics_create_info;
-    dynamics_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
-    dynamics_create_info.dynamicStateCount = DYNAMIC_STATES_COUNT;
-    dynamics_create_info.pDynamicStates = DYNAMIC_STATES;
+    VkPipelineDynamicStateCreateInfo *dynamics_create_info = &state->dynamics_create_info;
+    dynamics_create_info->sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+    dynamics_create_info->pNext = NULL;
+    dynamics_create_info->flags = 0;
+    dynamics_create_info->dynamicStateCount = DYNAMIC_STATES_COUNT;
+    dynamics_create_info->pDynamicStates = DYNAMIC_STATES;
 
     // Vertex input
-    VkPipelineVertexInputStateCreateInfo vertex_input_create_info;
-    vertex_input_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-    vertex_input_create_info.pNext = NULL;
-    vertex_input_create_info.flags = 0;
-    vertex_input_create_info.vertexBindingDescriptionCount = 0;
-    vertex_input_create_info.pVertexAttributeDescriptions = NULL;
-    vertex_input_create_info.vertexAttributeDescriptionCount = 0;
-    vertex_input_create_info.pVertexBindingDescriptions = NULL;
+    VkPipelineVertexInputStateCreateInfo *vertex_input_create_info = &state->vertex_input_create_info;
+    vertex_input_create_info->sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+    vertex_input_create_info->pNext = NULL;
+    vertex_input_create_info->flags = 0;
+    vertex_input_create_info->vertexBindingDescriptionCount = desc->vertex_input.binding_count;
+    vertex_input_create_info->pVertexBindingDescriptions = desc->vertex_input.bindings;
+    vertex_input_create_info->vertexAttributeDescriptionCount = desc->vertex_input.attribute_count;
+    vertex_input_create_info->pVertexAttributeDescriptions = desc->vertex_input.attributes;
 
     // Input assembly
-    VkPipelineInputAssemblyStateCreateInfo input_assembly_create_info;
-    input_assembly_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-    input_assembly_create_info.pNext = NULL;
-    input_assembly_create_info.flags = 0;
-    input_assembly_create_info.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
-    input_assembly_create_info.primitiveRestartEnable = VK_FALSE;
-
-    // Viewport state creation
-    VkViewport viewport;
-    viewport.x = 0.0f;
-    viewport.y = 0.0f;
-    viewport.width = swapchain_ctx->extent.width;
-    viewport.height = swapchain_ctx->extent.height;
-    viewport.minDepth = 0.0f;
-    viewport.maxDepth = 1.0f;
-
-    VkRect2D scissor;
-    scissor.offset = (VkOffset2D){0, 0};
-    scissor.extent = swapchain_ctx->extent;
-
-    VkPipelineViewportStateCreateInfo viewport_create_info;
-    viewport_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
-    viewport_create_info.pNext = NULL;
-    viewport_create_info.flags = 0;
-    viewport_create_info.viewportCount = 1;
-    viewport_create_info.pViewports = &viewport;
-    viewport_create_info.scissorCount = 1;
-    viewport_create_info.pScissors = &scissor;
+    VkPipelineInputAssemblyStateCreateInfo *input_assembly_create_info = &state->input_assembly_create_info;
+    input_assembly_create_info->sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+    input_assembly_create_info->pNext = NULL;
+    input_assembly_create_info->flags = 0;
+    input_assembly_create_info->topology = desc->topology;
+    input_assembly_create_info->primitiveRestartEnable = VK_FALSE;
+
+    // Viewport and scissor are dynamic, only the counts are baked in
+    VkPipelineViewportStateCreateInfo *viewport_create_info = &state->viewport_create_info;
+    viewport_create_info->sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+    viewport_create_info->pNext = NULL;
+    viewport_create_info->flags = 0;
+    viewport_create_info->viewportCount = 1;
+    viewport_create_info->pViewports = NULL;
+    viewport_create_info->scissorCount = 1;
+    viewport_create_info->pScissors = NULL;
 
     // Rasterization
-    VkPipelineRasterizationStateCreateInfo rasterizer_create_info;
-    rasterizer_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
-    rasterizer_create_info.pNext = NULL;
-    rasterizer_create_info.flags = 0;
-    rasterizer_create_info.rasterizerDiscardEnable = VK_FALSE;
+    VkPipelineRasterizationStateCreateInfo *rasterizer_create_info = &state->rasterizer_create_info;
+    rasterizer_create_info->sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+    rasterizer_create_info->pNext = NULL;
+    rasterizer_create_info->flags = 0;
+    rasterizer_create_info->rasterizerDiscardEnable = VK_FALSE;
 
     // Triangles
-    rasterizer_create_info.polygonMode = VK_POLYGON_MODE_FILL;
-    rasterizer_create_info.cullMode = VK_CULL_MODE_BACK_BIT;
-    rasterizer_create_info.frontFace = VK_FRONT_FACE_CLOCKWISE;
+    rasterizer_create_info->polygonMode = desc->polygon_mode;
+    rasterizer_create_info->cullMode = desc->cull_mode;
+    rasterizer_create_info->frontFace = desc->front_face;
 
     // Depth
-    rasterizer_create_info.depthClampEnable = VK_FALSE;
-    rasterizer_create_info.depthBiasEnable = VK_FALSE;
-    rasterizer_create_info.depthBiasConstantFactor = 0.0f;
-    rasterizer_create_info.depthBiasClamp = 0.0f;
-    rasterizer_create_info.depthBiasSlopeFactor = 0.0f;
+    rasterizer_create_info->depthClampEnable = VK_FALSE;
+    rasterizer_create_info->depthBiasEnable = VK_FALSE;
+    rasterizer_create_info->depthBiasConstantFactor = 0.0f;
+    rasterizer_create_info->depthBiasClamp = 0.0f;
+    rasterizer_create_info->depthBiasSlopeFactor = 0.0f;
 
-    rasterizer_create_info.lineWidth = 1.0f;
+    rasterizer_create_info->lineWidth = 1.0f;
 
     // Anti-aliasing
-    VkPipelineMultisampleStateCreateInfo multiple_sample_create_info;
-    multiple_sample_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
-    multiple_sample_create_info.pNext = NULL;
-    multiple_sample_create_info.flags = 0;
-    multiple_sample_create_info.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
-    multiple_sample_create_info.sampleShadingEnable = VK_FALSE;
-    multiple_sample_create_info.minSampleShading = 1.0f;
-    multiple_sample_create_info.pSampleMask = NULL;
-    multiple_sample_create_info.alphaToCoverageEnable = VK_FALSE;
-    multiple_sample_create_info.alphaToOneEnable = VK_FALSE;
-
-    VkPipelineColorBlendAttachmentState color_blend_attacthment;
-    color_blend_attacthment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT |
+    VkPipelineMultisampleStateCreateInfo *multiple_sample_create_info = &state->multiple_sample_create_info;
+    multiple_sample_create_info->sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+    multiple_sample_create_info->pNext = NULL;
+    multiple_sample_create_info->flags = 0;
+    multiple_sample_create_info->rasterizationSamples = desc->samples;
+    multiple_sample_create_info->sampleShadingEnable = VK_FALSE;
+    multiple_sample_create_info->minSampleShading = 1.0f;
+    multiple_sample_create_info->pSampleMask = NULL;
+    multiple_sample_create_info->alphaToCoverageEnable = VK_FALSE;
+    multiple_sample_create_info->alphaToOneEnable = VK_FALSE;
+
+    // Ignored by render passes without a depth attachment
+    VkPipelineDepthStencilStateCreateInfo *depth_stencil_create_info = &state->depth_stencil_create_info;
+    memset(depth_stencil_create_info, 0, sizeof(VkPipelineDepthStencilStateCreateInfo));
+    depth_stencil_create_info->sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+    depth_stencil_create_info->depthTestEnable = desc->depth_test_enable;
+    depth_stencil_create_info->depthWriteEnable = desc->depth_write_enable;
+    depth_stencil_create_info->depthCompareOp = desc->depth_compare_op;
+    depth_stencil_create_info->depthBoundsTestEnable = VK_FALSE;
+    depth_stencil_create_info->stencilTestEnable = VK_FALSE;
+    depth_stencil_create_info->minDepthBounds = 0.0f;
+    depth_stencil_create_info->maxDepthBounds = 1.0f;
+
+    VkPipelineColorBlendAttachmentState *color_blend_attacthment = &state->color_blend_attachment;
+    color_blend_attacthment->colorWriteMask = VK_COLOR_COMPONENT_R_BIT |
         VK_COLOR_COMPONENT_G_BIT |
         VK_COLOR_COMPONENT_B_BIT |
         VK_COLOR_COMPONENT_A_BIT;
-    color_blend_attacthment.blendEnable = VK_FALSE;
-    color_blend_attacthment.srcColorBlendFactor = VK_BLEND_FACTOR_ONE;
-    color_blend_attacthment.dstColorBlendFactor = VK_BLEND_FACTOR_ZERO;
-    color_blend_attacthment.colorBlendOp = VK_BLEND_OP_ADD;
-    color_blend_attacthment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
-    color_blend_attacthment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
-    color_blend_attacthment.alphaBlendOp = VK_BLEND_OP_ADD;
-
-    VkPipelineColorBlendStateCreateInfo color_blend_create_info;
-    color_blend_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
-    color_blend_create_info.pNext = NULL;
-    color_blend_create_info.flags = 0;
-    color_blend_create_info.logicOpEnable = VK_FALSE;
-    color_blend_create_info.logicOp = VK_LOGIC_OP_COPY;
-    color_blend_create_info.attachmentCount = 1;
-    color_blend_create_info.pAttachments = &color_blend_attacthment;
-    color_blend_create_info.blendConstants[0] = 0.0f;
-    color_blend_create_info.blendConstants[1] = 0.0f;
-    color_blend_create_info.blendConstants[2] = 0.0f;
-    color_blend_create_info.blendConstants[3] = 0.0f;
+    color_blend_attacthment->blendEnable = desc->blend_enable;
+    color_blend_attacthment->srcColorBlendFactor = desc->blend_enable ? VK_BLEND_FACTOR_SRC_ALPHA : VK_BLEND_FACTOR_ONE;
+    color_blend_attacthment->dstColorBlendFactor = desc->blend_enable ? VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA : VK_BLEND_FACTOR_ZERO;
+    color_blend_attacthment->colorBlendOp = VK_BLEND_OP_ADD;
+    color_blend_attacthment->srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+    color_blend_attacthment->dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+    color_blend_attacthment->alphaBlendOp = VK_BLEND_OP_ADD;
+
+    VkPipelineColorBlendStateCreateInfo *color_blend_create_info = &state->color_blend_create_info;
+    color_blend_create_info->sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+    color_blend_create_info->pNext = NULL;
+    color_blend_create_info->flags = 0;
+    color_blend_create_info->logicOpEnable = VK_FALSE;
+    color_blend_create_info->logicOp = VK_LOGIC_OP_COPY;
+    color_blend_create_info->attachmentCount = 1;
+    color_blend_create_info->pAttachments = color_blend_attacthment;
+    color_blend_create_info->blendConstants[0] = 0.0f;
+    color_blend_create_info->blendConstants[1] = 0.0f;
+    color_blend_create_info->blendConstants[2] = 0.0f;
+    color_blend_create_info->blendConstants[3] = 0.0f;
 
     // Pipeline creation
-    VkPipelineLayoutCreateInfo pipeline_layout_create_info;
-    pipeline_layout_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-    pipeline_layout_create_info.pNext = NULL;
-    pipeline_layout_create_info.flags = 0;
-    pipeline_layout_create_info.setLayoutCount = 0;
-    pipeline_layout_create_info.pSetLayouts = NULL;
-    pipeline_layout_create_info.pushConstantRangeCount = 0;
-    pipeline_layout_create_info.pPushConstantRanges = NULL;
+    create_info->sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+    create_info->pNext = NULL;
+    create_info->flags = 0;
+    create_info->stageCount = 2;
+    create_info->pStages = state->shader_stages;
+    create_info->pVertexInputState = vertex_input_create_info;
+    create_info->pInputAssemblyState = input_assembly_create_info;
+    create_info->pTessellationState = NULL;
+    create_info->pViewportState = viewport_create_info;
+    create_info->pRasterizationState = rasterizer_create_info;
+    create_info->pMultisampleState = multiple_sample_create_info;
+    create_info->pDepthStencilState = depth_stencil_create_info;
+    create_info->pColorBlendState = color_blend_create_info;
+    create_info->pDynamicState = dynamics_create_info;
+    create_info->layout = desc->pipeline_layout;
+    create_info->renderPass = desc->render_pass;
+    create_info->subpass = desc->subpass;
+    create_info->basePipelineHandle = VK_NULL_HANDLE;
+    create_info->basePipelineIndex = -1;
+
+    return true;
+}
 
-    VkPipelineLayout pipeline_layout;
-    if (vkCreatePipelineLayout(device, &pipeline_layout_create_info, NULL, &pipeline_layout) != VK_SUCCESS) {
-        fprintf(stderr, "failed to create pipeline layout\n");
-        return NULL;
-    }
+void destroy_graphics_pipeline_state(VkDevice device, GraphicsPipelineState *state) {
+    // Modules are only needed until the pipeline has been created
+    vkDestroyShaderModule(device, state->vertex_module, get_host_allocator());
+    vkDestroyShaderModule(device, state->frag_module, get_host_allocator());
+}
 
+VkPipeline create_graphics_pipeline(VkDevice device, VkPipelineCache pipeline_cache, const GraphicsPipelineDesc *desc) {
+    GraphicsPipelineState state;
     VkGraphicsPipelineCreateInfo create_info;
-    create_info.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-    create_info.stageCount = 2;
-    create_info.pStages = shader_stages;
-    create_info.pVertexInputState = &vert_create_info;
-    create_info.pInputAssemblyState = &input_assembly_create_info;
-    create_info.pViewportState = &viewport_create_info;
-    create_info.pRasterizationState = &rasterizer_create_info;
-    create_info.pMultisampleState = &multiple_sample_create_info;
-    create_info.pDepthStencilState = NULL;
-    create_info.pColorBlendState = &color_blend_create_info;
-    create_info.pDynamicState = &DYNAMIC_STATES;
+    if (!fill_graphics_pipeline_create_info(device, desc, &state, &create_info)) {
+        return NULL;
+    }
 
     VkPipeline graphics_pipeline;
-    if (vkCreateGraphicsPipelines(device, NULL, 1, &create_info, NULL, &graphics_pipeline) != VK_SUCCESS) {
+    VkResult result = vkCreateGraphicsPipelines(device, pipeline_cache, 1, &create_info, get_host_allocator(), &graphics_pipeline);
+    destroy_graphics_pipeline_state(device, &state);
+    if (result != VK_SUCCESS) {
         fprintf(stderr, "failed to create graphics pipeline(s)\n");
         return NULL;
     }
@@ -190,44 +236,211 @@ VkPipeline create_graphics_pipeline(VkDevice device, SwapchainContext *swapchain
     return graphics_pipeline;
 }
 
+void init_compute_pipeline_desc(ComputePipelineDesc *desc, VkPipelineLayout pipeline_layout, const ShaderBinary *comp) {
+    desc->comp = *comp;
+    desc->specialization.constant_count = 0;
+    desc->pipeline_layout = pipeline_layout;
+}
+
+bool fill_compute_pipeline_create_info(VkDevice device, const ComputePipelineDesc *desc, ComputePipelineState *state, VkComputePipelineCreateInfo *create_info) {
+    state->module = create_shader_module(device, &desc->comp);
+    if (state->module == NULL) {
+        fprintf(stderr, "failed to create compute module\n");
+        return false;
+    }
+
+    create_info->sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    create_info->pNext = NULL;
+    create_info->flags = 0;
+    create_info->stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    create_info->stage.pNext = NULL;
+    create_info->stage.flags = 0;
+    create_info->stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    create_info->stage.module = state->module;
+    create_info->stage.pName = "main";
+    create_info->stage.pSpecializationInfo = fill_specialization_info(&desc->specialization,
+        state->map_entries, &state->specialization_info);
+    create_info->layout = desc->pipeline_layout;
+    create_info->basePipelineHandle = VK_NULL_HANDLE;
+    create_info->basePipelineIndex = -1;
+
+    return true;
+}
+
+void destroy_compute_pipeline_state(VkDevice device, ComputePipelineState *state) {
+    vkDestroyShaderModule(device, state->module, get_host_allocator());
+}
+
+VkPipeline create_compute_pipeline(VkDevice device, VkPipelineCache pipeline_cache, const ComputePipelineDesc *desc) {
+    ComputePipelineState state;
+    VkComputePipelineCreateInfo create_info;
+    if (!fill_compute_pipeline_create_info(device, desc, &state, &create_info)) {
+        return NULL;
+    }
+
+    VkPipeline compute_pipeline;
+    VkResult result = vkCreateComputePipelines(device, pipeline_cache, 1, &create_info, get_host_allocator(), &compute_pipeline);
+    destroy_compute_pipeline_state(device, &state);
+    if (result != VK_SUCCESS) {
+        fprintf(stderr, "failed to create compute pipeline(s)\n");
+        return NULL;
+    }
+
+    return compute_pipeline;
+}
+
+VkPipelineLayout create_pipeline_layout(VkDevice device, const PipelineLayoutDesc *desc) {
+    VkPipelineLayoutCreateInfo create_info;
+    create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    create_info.pNext = NULL;
+    create_info.flags = 0;
+    create_info.setLayoutCount = desc->set_layout_count;
+    create_info.pSetLayouts = desc->set_layouts;
+    create_info.pushConstantRangeCount = desc->push_constant_range_count;
+    create_info.pPushConstantRanges = desc->push_constant_ranges;
+
+    VkPipelineLayout pipeline_layout;
+    if (vkCreatePipelineLayout(device, &create_info, get_host_allocator(), &pipeline_layout) != VK_SUCCESS) {
+        fprintf(stderr, "failed to create pipeline layout\n");
+        return NULL;
+    }
+
+    return pipeline_layout;
+}
+
+VkDescriptorSetLayout create_descriptor_set_layout(VkDevice device, const DescriptorSetLayoutDesc *desc) {
+    VkDescriptorSetLayoutCreateInfo create_info;
+    create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    create_info.pNext = NULL;
+    create_info.flags = 0;
+    create_info.bindingCount = desc->binding_count;
+    create_info.pBindings = desc->bindings;
+
+    VkDescriptorSetLayout set_layout;
+    if (vkCreateDescriptorSetLayout(device, &create_info, get_host_allocator(), &set_layout) != VK_SUCCESS) {
+        fprintf(stderr, "failed to create descriptor set layout\n");
+        return NULL;
+    }
+
+    return set_layout;
+}
+
+/*
+* Specialization
+*/
+bool set_specialization_constant(SpecializationDesc *desc, uint32_t constant_id, uint32_t value) {
+    // Kept sorted so equal constant sets encode to the same registry key
+    uint32_t index = 0;
+    while (index < desc->constant_count && desc->constant_ids[index] < constant_id) {
+        ++index;
+    }
+
+    if (index < desc->constant_count && desc->constant_ids[index] == constant_id) {
+        desc->values[index] = value;
+        return true;
+    }
+
+    if (desc->constant_count >= MAX_SPECIALIZATION_CONSTANTS) {
+        fprintf(stderr, "too many specialization constants\n");
+        return false;
+    }
+
+    for (uint32_t i = desc->constant_count; i > index; --i) {
+        desc->constant_ids[i] = desc->constant_ids[i - 1];
+        desc->values[i] = desc->values[i - 1];
+    }
+
+    desc->constant_ids[index] = constant_id;
+    desc->values[index] = value;
+    ++desc->constant_count;
+    return true;
+}
+
+bool set_specialization_constant_float(SpecializationDesc *desc, uint32_t constant_id, float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return set_specialization_constant(desc, constant_id, bits);
+}
 
 /*
 * Render pass
 */
-VkRenderPass create_render_pass(VkDevice device, SwapchainContext *swapchain_ctx) {
-    VkAttachmentDescription color_attachment;
-    color_attachment.flags = 0;
-    color_attachment.format = swapchain_ctx->image_format;
-    color_attachment.samples = VK_SAMPLE_COUNT_1_BIT;
-    color_attachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-    color_attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-    color_attachment.stencilStoreOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-    color_attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-    color_attachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    color_attachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+VkRenderPass create_render_pass(VkDevice device, const RenderPassDesc *desc) {
+    bool has_depth = desc->depth_format != VK_FORMAT_UNDEFINED;
+    VkAttachmentDescription attachments[2];
+
+    VkAttachmentDescription *color_attachment = &attachments[0];
+    color_attachment->flags = 0;
+    color_attachment->format = desc->color_format;
+    color_attachment->samples = VK_SAMPLE_COUNT_1_BIT;
+    color_attachment->loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    color_attachment->storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+    color_attachment->stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    color_attachment->stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    color_attachment->initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    color_attachment->finalLayout = desc->final_layout;
+
+    // Depth goes after the colors, the same order the render graph uses
+    VkAttachmentDescription *depth_attachment = &attachments[1];
+    depth_attachment->flags = 0;
+    depth_attachment->format = desc->depth_format;
+    depth_attachment->samples = VK_SAMPLE_COUNT_1_BIT;
+    depth_attachment->loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    depth_attachment->storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    depth_attachment->stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    depth_attachment->stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    depth_attachment->initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    depth_attachment->finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
 
     VkAttachmentReference color_attachment_ref;
-    color_attachment_ref.layout = 0;
-    color_attachment_ref.attachment = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    color_attachment_ref.attachment = 0;
+    color_attachment_ref.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+    VkAttachmentReference depth_attachment_ref;
+    depth_attachment_ref.attachment = 1;
+    depth_attachment_ref.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
 
     VkSubpassDescription subpass;
     subpass.flags = 0;
     subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    subpass.inputAttachmentCount = 0;
+    subpass.pInputAttachments = NULL;
     subpass.colorAttachmentCount = 1;
-    subpass.pColorAttachments = &color_attachment;
+    subpass.pColorAttachments = &color_attachment_ref;
+    subpass.pResolveAttachments = NULL;
+    subpass.pDepthStencilAttachment = has_depth ? &depth_attachment_ref : NULL;
+    subpass.preserveAttachmentCount = 0;
+    subpass.pPreserveAttachments = NULL;
+
+    // Wait for the previous frame's writes (or the acquire) before clearing
+    VkSubpassDependency dependency;
+    dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
+    dependency.dstSubpass = 0;
+    dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    dependency.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    dependency.dependencyFlags = 0;
+    if (has_depth) {
+        dependency.srcStageMask |= VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+        dependency.srcAccessMask |= VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+        dependency.dstStageMask |= VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+        dependency.dstAccessMask |= VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    }
 
     VkRenderPassCreateInfo create_info;
     create_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+    create_info.pNext = NULL;
     create_info.flags = 0;
-    create_info.attachmentCount = 1;
-    create_info.pAttachments = &color_attachment;
+    create_info.attachmentCount = has_depth ? 2 : 1;
+    create_info.pAttachments = attachments;
     create_info.subpassCount = 1;
     create_info.pSubpasses = &subpass;
-    create_info.dependencyCount = 0;
-    create_info.pDependencies = NULL;
+    create_info.dependencyCount = 1;
+    create_info.pDependencies = &dependency;
 
     VkRenderPass renderpass;
-    if (vkCreateRenderPass(device, &create_info, NULL, &renderpass) != VK_SUCCESS) {
+    if (vkCreateRenderPass(device, &create_info, get_host_allocator(), &renderpass) != VK_SUCCESS) {
         return NULL;
     }
 
@@ -237,57 +450,21 @@ VkRenderPass create_render_pass(VkDevice device, SwapchainContext *swapchain_ctx
 /*
 * Shader creation
 */
-VkShaderModule create_shader_module(VkDevice device, const char *fname) {
+VkShaderModule create_shader_module(VkDevice device, const ShaderBinary *binary) {
     VkShaderModuleCreateInfo create_info;
     create_info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
     create_info.pNext = NULL;
     create_info.flags = 0;
 
-    // Create file path
-    char f_path[FNAME_MAX] = {0};
-    strcpy(f_path, SHADER_BIN_DIR);
-    strcat(f_path, fname);
-
-    size_t shader_code_size = 0;
-    uint32_t *shader_code = read_file(f_path, &shader_code_size);
-    if (shader_code == NULL) { return NULL; }
-    create_info.codeSize = shader_code_size;
-    create_info.pCode = shader_code;
+    // Code points straight into the mapped shader pack, no copy
+    create_info.codeSize = binary->size;
+    create_info.pCode = binary->code;
 
     VkShaderModule shader_module;
-    if (vkCreateShaderModule(device, &create_info, NULL, &shader_module) != VK_SUCCESS) {
+    if (vkCreateShaderModule(device, &create_info, get_host_allocator(), &shader_module) != VK_SUCCESS) {
+        fprintf(stderr, "failed to create shader module: %s\n", binary->name);
         return NULL;
     }
 
-    free(shader_code);
     return shader_module;
 }
-
-uint32_t *read_file(const char *fname, size_t *bytes_read) {
-    FILE *fp = fopen(fname, "r");
-    if (fp == NULL) {
-        fprintf(stderr, "failed to open file: %s\n", fname);
-        return NULL;
-    }
-
-    fseek(fp, 0, SEEK_END);
-    size_t fsize = ftell(fp);
-    fseek(fp, 0, SEEK_SET);
-
-    uint32_t *buffer = malloc(fsize);
-    if (buffer == NULL) {
-        fclose(fp);
-        return NULL;
-    }
-
-    *bytes_read = fread(buffer, 1, fsize, fp);
-    fclose(fp);
-
-    if (*bytes_read != fsize) {
-        fprintf(stderr, "failed to read file: %s\n", fname);
-        free(buffer);
-        return NULL;
-    }
-
-    return buffer;
-}
\ No newline at end of file
@@ -3,24 +3,131 @@
 
 #include "vulkan_context.h"
 
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
 #include "config.h"
+#include "shader_pack.h"
+
+#define MAX_DESCRIPTOR_SETS 4
+#define MAX_DESCRIPTOR_BINDINGS 16
+#define MAX_PUSH_CONSTANT_RANGES 4
+#define MAX_VERTEX_BINDINGS 4
+#define MAX_VERTEX_ATTRIBUTES 16
+#define MAX_SPECIALIZATION_CONSTANTS 16
 
 extern const int DYNAMIC_STATES_COUNT;
 extern const VkDynamicState DYNAMIC_STATES[];
 
+typedef struct {
+    uint32_t binding_count;
+    VkVertexInputBindingDescription bindings[MAX_VERTEX_BINDINGS];
+    uint32_t attribute_count;
+    VkVertexInputAttributeDescription attributes[MAX_VERTEX_ATTRIBUTES];
+} VertexInputDesc;
+
+// 32-bit constant values baked into one shader stage, sorted by constant id
+typedef struct {
+    uint32_t constant_count;
+    uint32_t constant_ids[MAX_SPECIALIZATION_CONSTANTS];
+    uint32_t values[MAX_SPECIALIZATION_CONSTANTS];
+} SpecializationDesc;
+
+// Fixed function state and shaders for one graphics pipeline
+typedef struct {
+    ShaderBinary vert;
+    ShaderBinary frag;
+    SpecializationDesc vert_specialization;
+    SpecializationDesc frag_specialization;
+    VkRenderPass render_pass;
+    VkPipelineLayout pipeline_layout;
+    uint32_t subpass;
+    VertexInputDesc vertex_input;
+    VkPrimitiveTopology topology;
+    VkPolygonMode polygon_mode;
+    VkCullModeFlags cull_mode;
+    VkFrontFace front_face;
+    VkSampleCountFlagBits samples;
+    VkBool32 blend_enable;
+    VkBool32 depth_test_enable;
+    VkBool32 depth_write_enable;
+    VkCompareOp depth_compare_op;
+} GraphicsPipelineDesc;
+
+// Shader and layout for one compute pipeline
+typedef struct {
+    ShaderBinary comp;
+    SpecializationDesc specialization;
+    VkPipelineLayout pipeline_layout;
+} ComputePipelineDesc;
+
+typedef struct {
+    uint32_t binding_count;
+    VkDescriptorSetLayoutBinding bindings[MAX_DESCRIPTOR_BINDINGS];
+} DescriptorSetLayoutDesc;
+
+typedef struct {
+    uint32_t set_layout_count;
+    VkDescriptorSetLayout set_layouts[MAX_DESCRIPTOR_SETS];
+    uint32_t push_constant_range_count;
+    VkPushConstantRange push_constant_ranges[MAX_PUSH_CONSTANT_RANGES];
+} PipelineLayoutDesc;
+
+typedef struct {
+    VkFormat color_format;
+    VkFormat depth_format; // VK_FORMAT_UNDEFINED for color only
+    VkImageLayout final_layout;
+} RenderPassDesc;
+
+// Storage referenced by a filled VkGraphicsPipelineCreateInfo, must outlive the create call
+typedef struct {
+    VkShaderModule vertex_module;
+    VkShaderModule frag_module;
+    VkPipelineShaderStageCreateInfo shader_stages[2];
+    VkSpecializationMapEntry vert_map_entries[MAX_SPECIALIZATION_CONSTANTS];
+    VkSpecializationMapEntry frag_map_entries[MAX_SPECIALIZATION_CONSTANTS];
+    VkSpecializationInfo vert_specialization_info;
+    VkSpecializationInfo frag_specialization_info;
+    VkPipelineDynamicStateCreateInfo dynamics_create_info;
+    VkPipelineVertexInputStateCreateInfo vertex_input_create_info;
+    VkPipelineInputAssemblyStateCreateInfo input_assembly_create_info;
+    VkPipelineViewportStateCreateInfo viewport_create_info;
+    VkPipelineRasterizationStateCreateInfo rasterizer_create_info;
+    VkPipelineMultisampleStateCreateInfo multiple_sample_create_info;
+    VkPipelineDepthStencilStateCreateInfo depth_stencil_create_info;
+    VkPipelineColorBlendAttachmentState color_blend_attachment;
+    VkPipelineColorBlendStateCreateInfo color_blend_create_info;
+} GraphicsPipelineState;
+
+// Storage referenced by a filled VkComputePipelineCreateInfo, must outlive the create call
+typedef struct {
+    VkShaderModule module;
+    VkSpecializationMapEntry map_entries[MAX_SPECIALIZATION_CONSTANTS];
+    VkSpecializationInfo specialization_info;
+} ComputePipelineState;
+
 // Pipeline creation
-VkPipelineLayout create_graphics_pipeline(VkDevice device, SwapchainContext *swapchain_ctx, const char *fname_vert, const char *fname_frag);
-VkPipelineLayout create_pipeline_layout(VkDevice device, SwapchainContext *swapchain_ctx);
+void init_graphics_pipeline_desc(GraphicsPipelineDesc *desc, VkRenderPass render_pass, VkPipelineLayout pipeline_layout, const ShaderBinary *vert, const ShaderBinary *frag);
+bool fill_graphics_pipeline_create_info(VkDevice device, const GraphicsPipelineDesc *desc, GraphicsPipelineState *state, VkGraphicsPipelineCreateInfo *create_info);
+void destroy_graphics_pipeline_state(VkDevice device, GraphicsPipelineState *state);
+VkPipeline create_graphics_pipeline(VkDevice device, VkPipelineCache pipeline_cache, const GraphicsPipelineDesc *desc);
+void init_compute_pipeline_desc(ComputePipelineDesc *desc, VkPipelineLayout pipeline_layout, const ShaderBinary *comp);
+bool fill_compute_pipeline_create_info(VkDevice device, const ComputePipelineDesc *desc, ComputePipelineState *state, VkComputePipelineCreateInfo *create_info);
+void destroy_compute_pipeline_state(VkDevice device, ComputePipelineState *state);
+VkPipeline create_compute_pipeline(VkDevice device, VkPipelineCache pipeline_cache, const ComputePipelineDesc *desc);
+VkPipelineLayout create_pipeline_layout(VkDevice device, const PipelineLayoutDesc *desc);
+VkDescriptorSetLayout create_descriptor_set_layout(VkDevice device, const DescriptorSetLayoutDesc *desc);
+
+// Specialization
+bool set_specialization_constant(SpecializationDesc *desc, uint32_t constant_id, uint32_t value);
+bool set_specialization_constant_float(SpecializationDesc *desc, uint32_t constant_id, float value);
 
 // Render pass
-VkRenderPass create_render_pass(VkDevice device);
+VkRenderPass create_render_pass(VkDevice device, const RenderPassDesc *desc);
 
 // Shaders
-VkShaderModule create_shader_module(VkDevice device, const char *fname);
-uint32_t *read_file(const char *fname, size_t *bytes_read);
+VkShaderModule create_shader_module(VkDevice device, const ShaderBinary *binary);
 
 #endif
\ No newline at end of file
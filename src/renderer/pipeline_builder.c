@@ -0,0 +1,218 @@
+#include "pipeline_builder.h"
+
+// One job compiles a contiguous slice of the request
+typedef struct {
+    PipelineBuilder *builder;
+    GraphicsPipelineDesc descs[PIPELINE_BATCH_SIZE];
+    PipelineFuture *futures[PIPELINE_BATCH_SIZE];
+    uint32_t count;
+} PipelineBatchJob;
+
+typedef struct {
+    PipelineBuilder *builder;
+    ComputePipelineDesc descs[PIPELINE_BATCH_SIZE];
+    PipelineFuture *futures[PIPELINE_BATCH_SIZE];
+    uint32_t count;
+} ComputePipelineBatchJob;
+
+/*
+* Builder creation
+*/
+PipelineBuilder *create_pipeline_builder(VkDevice device, VkPipelineCache pipeline_cache, ThreadPool *pool) {
+    PipelineBuilder *builder = malloc(sizeof(PipelineBuilder));
+    if (builder == NULL) { return NULL; }
+
+    builder->device = device;
+    builder->pipeline_cache = pipeline_cache;
+    builder->pool = pool;
+    return builder;
+}
+
+/*
+* Async builds
+*/
+static void build_pipeline_batch(void *arg) {
+    PipelineBatchJob *job = arg;
+    VkDevice device = job->builder->device;
+    begin_trace_scope("build_pipeline_batch");
+
+    GraphicsPipelineState states[PIPELINE_BATCH_SIZE];
+    VkGraphicsPipelineCreateInfo create_infos[PIPELINE_BATCH_SIZE];
+    PipelineFuture *futures[PIPELINE_BATCH_SIZE];
+    VkPipeline pipelines[PIPELINE_BATCH_SIZE];
+
+    // Descs whose shaders fail to load are dropped from the batch
+    uint32_t batch_count = 0;
+    for (uint32_t i = 0; i < job->count; ++i) {
+        if (!fill_graphics_pipeline_create_info(device, &job->descs[i], &states[batch_count], &create_infos[batch_count])) {
+            atomic_store(&job->futures[i]->status, PIPELINE_FAILED);
+            continue;
+        }
+        futures[batch_count] = job->futures[i];
+        pipelines[batch_count] = VK_NULL_HANDLE;
+        ++batch_count;
+    }
+
+    // The pipeline cache is internally synchronized, so workers share it
+    if (batch_count > 0) {
+        begin_trace_scope("vkCreateGraphicsPipelines");
+        VkResult result = vkCreateGraphicsPipelines(device, job->builder->pipeline_cache,
+            batch_count, create_infos, get_host_allocator(), pipelines);
+        end_trace_scope();
+        if (result != VK_SUCCESS) {
+            fprintf(stderr, "failed to create graphics pipeline batch\n");
+        }
+    }
+
+    // Failed entries in a batch come back as null handles
+    for (uint32_t i = 0; i < batch_count; ++i) {
+        destroy_graphics_pipeline_state(device, &states[i]);
+        futures[i]->pipeline = pipelines[i];
+        atomic_store(&futures[i]->status, pipelines[i] != VK_NULL_HANDLE ? PIPELINE_READY : PIPELINE_FAILED);
+    }
+
+    free(job);
+    end_trace_scope();
+}
+
+static void build_compute_pipeline_batch(void *arg) {
+    ComputePipelineBatchJob *job = arg;
+    VkDevice device = job->builder->device;
+    begin_trace_scope("build_compute_pipeline_batch");
+
+    ComputePipelineState states[PIPELINE_BATCH_SIZE];
+    VkComputePipelineCreateInfo create_infos[PIPELINE_BATCH_SIZE];
+    PipelineFuture *futures[PIPELINE_BATCH_SIZE];
+    VkPipeline pipelines[PIPELINE_BATCH_SIZE];
+
+    uint32_t batch_count = 0;
+    for (uint32_t i = 0; i < job->count; ++i) {
+        if (!fill_compute_pipeline_create_info(device, &job->descs[i], &states[batch_count], &create_infos[batch_count])) {
+            atomic_store(&job->futures[i]->status, PIPELINE_FAILED);
+            continue;
+        }
+        futures[batch_count] = job->futures[i];
+        pipelines[batch_count] = VK_NULL_HANDLE;
+        ++batch_count;
+    }
+
+    if (batch_count > 0) {
+        begin_trace_scope("vkCreateComputePipelines");
+        VkResult result = vkCreateComputePipelines(device, job->builder->pipeline_cache,
+            batch_count, create_infos, get_host_allocator(), pipelines);
+        end_trace_scope();
+        if (result != VK_SUCCESS) {
+            fprintf(stderr, "failed to create compute pipeline batch\n");
+        }
+    }
+
+    for (uint32_t i = 0; i < batch_count; ++i) {
+        destroy_compute_pipeline_state(device, &states[i]);
+        futures[i]->pipeline = pipelines[i];
+        atomic_store(&futures[i]->status, pipelines[i] != VK_NULL_HANDLE ? PIPELINE_READY : PIPELINE_FAILED);
+    }
+
+    free(job);
+    end_trace_scope();
+}
+
+static uint32_t begin_pipeline_batches(PipelineBuilder *builder, PipelineFuture *futures, uint32_t count) {
+    for (uint32_t i = 0; i < count; ++i) {
+        futures[i].pipeline = VK_NULL_HANDLE;
+        atomic_init(&futures[i].status, PIPELINE_PENDING);
+    }
+
+    // Spread the work over every worker, batching only what is left over
+    uint32_t thread_count = builder->pool->thread_count;
+    uint32_t batch_size = (count + thread_count - 1) / thread_count;
+    if (batch_size > PIPELINE_BATCH_SIZE) {
+        batch_size = PIPELINE_BATCH_SIZE;
+    }
+    return batch_size;
+}
+
+// Nothing will ever complete the futures that were not queued, so waiters see them fail instead
+static void fail_pipeline_batches(PipelineFuture *futures, uint32_t first, uint32_t count) {
+    for (uint32_t i = first; i < count; ++i) {
+        atomic_store(&futures[i].status, PIPELINE_FAILED);
+    }
+}
+
+bool build_graphics_pipelines_async(PipelineBuilder *builder, const GraphicsPipelineDesc *descs, PipelineFuture *futures, uint32_t count) {
+    uint32_t batch_size = begin_pipeline_batches(builder, futures, count);
+    for (uint32_t first = 0; first < count; first += batch_size) {
+        PipelineBatchJob *job = malloc(sizeof(PipelineBatchJob));
+        if (job == NULL) {
+            fail_pipeline_batches(futures, first, count);
+            return false;
+        }
+
+        job->builder = builder;
+        job->count = count - first < batch_size ? count - first : batch_size;
+        for (uint32_t i = 0; i < job->count; ++i) {
+            job->descs[i] = descs[first + i];
+            job->futures[i] = &futures[first + i];
+        }
+
+        if (!submit_job(builder->pool, build_pipeline_batch, job)) {
+            free(job);
+            fail_pipeline_batches(futures, first, count);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool build_compute_pipelines_async(PipelineBuilder *builder, const ComputePipelineDesc *descs, PipelineFuture *futures, uint32_t count) {
+    uint32_t batch_size = begin_pipeline_batches(builder, futures, count);
+    for (uint32_t first = 0; first < count; first += batch_size) {
+        ComputePipelineBatchJob *job = malloc(sizeof(ComputePipelineBatchJob));
+        if (job == NULL) {
+            fail_pipeline_batches(futures, first, count);
+            return false;
+        }
+
+        job->builder = builder;
+        job->count = count - first < batch_size ? count - first : batch_size;
+        for (uint32_t i = 0; i < job->count; ++i) {
+            job->descs[i] = descs[first + i];
+            job->futures[i] = &futures[first + i];
+        }
+
+        if (!submit_job(builder->pool, build_compute_pipeline_batch, job)) {
+            free(job);
+            fail_pipeline_batches(futures, first, count);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void wait_pipeline_builder(PipelineBuilder *builder) {
+    wait_thread_pool(builder->pool);
+}
+
+/*
+* Futures
+*/
+PipelineStatus get_pipeline_status(PipelineFuture *future) {
+    return atomic_load(&future->status);
+}
+
+VkPipeline get_ready_pipeline(PipelineFuture *future, VkPipeline fallback) {
+    if (atomic_load(&future->status) == PIPELINE_READY) {
+        return future->pipeline;
+    }
+    return fallback;
+}
+
+/*
+* Cleanup
+*/
+void destroy_pipeline_builder(PipelineBuilder *builder) {
+    // In flight jobs still reference the builder
+    wait_pipeline_builder(builder);
+    free(builder);
+}
@@ -0,0 +1,52 @@
+#ifndef PIPELINE_BUILDER_H
+#define PIPELINE_BUILDER_H
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "pipeline.h"
+#include "thread_pool.h"
+#include "trace.h"
+
+// Upper bound on create infos handed to one vkCreate*Pipelines call
+#define PIPELINE_BATCH_SIZE 16
+
+typedef enum {
+    PIPELINE_PENDING = 0,
+    PIPELINE_READY,
+    PIPELINE_FAILED
+} PipelineStatus;
+
+// Written by a worker, polled by the frame loop
+typedef struct {
+    atomic_int status;
+    VkPipeline pipeline;
+} PipelineFuture;
+
+typedef struct {
+    VkDevice device;
+    VkPipelineCache pipeline_cache;
+    ThreadPool *pool;
+} PipelineBuilder;
+
+// Builder creation
+PipelineBuilder *create_pipeline_builder(VkDevice device, VkPipelineCache pipeline_cache, ThreadPool *pool);
+
+// Async builds, workers write into the futures so the array must outlive every queued job. On failure the
+// futures that were never queued are marked failed, earlier batches may still be compiling
+bool build_graphics_pipelines_async(PipelineBuilder *builder, const GraphicsPipelineDesc *descs, PipelineFuture *futures, uint32_t count);
+bool build_compute_pipelines_async(PipelineBuilder *builder, const ComputePipelineDesc *descs, PipelineFuture *futures, uint32_t count);
+void wait_pipeline_builder(PipelineBuilder *builder);
+
+// Futures
+PipelineStatus get_pipeline_status(PipelineFuture *future);
+VkPipeline get_ready_pipeline(PipelineFuture *future, VkPipeline fallback);
+
+// Cleanup
+void destroy_pipeline_builder(PipelineBuilder *builder);
+
+#endif
@@ -0,0 +1,225 @@
+// fileno and fsync are POSIX, not C17
+#define _POSIX_C_SOURCE 200809L
+
+#include "pipeline_cache.h"
+
+#ifdef _WIN32
+#include <io.h>
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#define FNV_OFFSET_BASIS 0xcbf29ce484222325ULL
+#define FNV_PRIME 0x100000001b3ULL
+#define TMP_SUFFIX ".tmp"
+
+/*
+* Pipeline cache creation
+*/
+static uint8_t *read_cache_file(const char *path, size_t *file_size) {
+    FILE *fp = fopen(path, "rb");
+    if (fp == NULL) { return NULL; }
+
+    fseek(fp, 0, SEEK_END);
+    long fsize = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    if (fsize <= 0) {
+        fclose(fp);
+        return NULL;
+    }
+
+    uint8_t *buffer = malloc(fsize);
+    if (buffer == NULL) {
+        fclose(fp);
+        return NULL;
+    }
+
+    *file_size = fread(buffer, 1, fsize, fp);
+    fclose(fp);
+
+    if (*file_size != (size_t)fsize) {
+        free(buffer);
+        return NULL;
+    }
+    return buffer;
+}
+
+VkPipelineCache create_pipeline_cache(VkDevice device, VkPhysicalDevice physical_device, const char *path) {
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physical_device, &properties);
+
+    VkPipelineCacheCreateInfo create_info;
+    create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    create_info.pNext = NULL;
+    create_info.flags = 0;
+    create_info.initialDataSize = 0;
+    create_info.pInitialData = NULL;
+
+    // A missing or stale file is not an error, the cache just starts cold
+    size_t file_size = 0;
+    uint8_t *file_data = read_cache_file(path, &file_size);
+    if (file_data != NULL) {
+        if (is_pipeline_cache_valid(file_data, file_size, &properties)) {
+            create_info.initialDataSize = file_size - sizeof(PipelineCacheFileHeader);
+            create_info.pInitialData = file_data + sizeof(PipelineCacheFileHeader);
+            printf("[SUCCESS] Loaded pipeline cache: %s (%zu bytes)\n", path, create_info.initialDataSize);
+        } else {
+            fprintf(stderr, "discarding stale pipeline cache: %s\n", path);
+        }
+    }
+
+    VkPipelineCache cache;
+    VkResult result = vkCreatePipelineCache(device, &create_info, get_host_allocator(), &cache);
+
+    // Retry cold if the driver still rejects the blob
+    if (result != VK_SUCCESS && create_info.pInitialData != NULL) {
+        create_info.initialDataSize = 0;
+        create_info.pInitialData = NULL;
+        result = vkCreatePipelineCache(device, &create_info, get_host_allocator(), &cache);
+    }
+
+    free(file_data);
+    if (result != VK_SUCCESS) {
+        fprintf(stderr, "failed to create pipeline cache\n");
+        return VK_NULL_HANDLE;
+    }
+    return cache;
+}
+
+const char *get_pipeline_cache_path() {
+    const char *path = getenv(PIPELINE_CACHE_PATH_ENV);
+    if (path != NULL && path[0] != '\0') {
+        return path;
+    }
+    return PIPELINE_CACHE_FILE;
+}
+
+/*
+* Validation
+*/
+bool is_pipeline_cache_valid(const uint8_t *file_data, size_t file_size, VkPhysicalDeviceProperties *properties) {
+    if (file_size < sizeof(PipelineCacheFileHeader) + sizeof(VkPipelineCacheHeaderVersionOne)) {
+        return false;
+    }
+
+    PipelineCacheFileHeader header;
+    memcpy(&header, file_data, sizeof(header));
+    if (header.magic != PIPELINE_CACHE_MAGIC || header.version != PIPELINE_CACHE_VERSION) {
+        return false;
+    }
+
+    // Any driver or device change invalidates the whole cache
+    if (header.vendor_id != properties->vendorID
+        || header.device_id != properties->deviceID
+        || header.driver_version != properties->driverVersion
+        || memcmp(header.cache_uuid, properties->pipelineCacheUUID, VK_UUID_SIZE) != 0) {
+        return false;
+    }
+
+    const uint8_t *data = file_data + sizeof(PipelineCacheFileHeader);
+    size_t data_size = file_size - sizeof(PipelineCacheFileHeader);
+    if (header.data_size != data_size || header.data_hash != hash_pipeline_cache_data(data, data_size)) {
+        return false;
+    }
+
+    // Cross check the driver's own header as well
+    VkPipelineCacheHeaderVersionOne driver_header;
+    memcpy(&driver_header, data, sizeof(driver_header));
+    return driver_header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+        && driver_header.vendorID == properties->vendorID
+        && driver_header.deviceID == properties->deviceID
+        && memcmp(driver_header.pipelineCacheUUID, properties->pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
+
+uint64_t hash_pipeline_cache_data(const uint8_t *data, size_t size) {
+    uint64_t hash = FNV_OFFSET_BASIS;
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= data[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+/*
+* Serialization
+*/
+bool save_pipeline_cache(VkDevice device, VkPhysicalDevice physical_device, VkPipelineCache cache, const char *path) {
+    size_t data_size = 0;
+    if (vkGetPipelineCacheData(device, cache, &data_size, NULL) != VK_SUCCESS || data_size == 0) {
+        return false;
+    }
+
+    uint8_t *data = malloc(data_size);
+    if (data == NULL) { return false; }
+
+    if (vkGetPipelineCacheData(device, cache, &data_size, data) != VK_SUCCESS) {
+        free(data);
+        return false;
+    }
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physical_device, &properties);
+
+    // Zeroed so the padding after the uuid is written out deterministically
+    PipelineCacheFileHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = PIPELINE_CACHE_MAGIC;
+    header.version = PIPELINE_CACHE_VERSION;
+    header.vendor_id = properties.vendorID;
+    header.device_id = properties.deviceID;
+    header.driver_version = properties.driverVersion;
+    memcpy(header.cache_uuid, properties.pipelineCacheUUID, VK_UUID_SIZE);
+    header.data_size = data_size;
+    header.data_hash = hash_pipeline_cache_data(data, data_size);
+
+    // Write beside the target then rename, a crash never leaves a torn cache
+    size_t path_length = strlen(path);
+    char *tmp_path = malloc(path_length + sizeof(TMP_SUFFIX));
+    if (tmp_path == NULL) {
+        free(data);
+        return false;
+    }
+    memcpy(tmp_path, path, path_length);
+    memcpy(tmp_path + path_length, TMP_SUFFIX, sizeof(TMP_SUFFIX));
+
+    FILE *fp = fopen(tmp_path, "wb");
+    if (fp == NULL) {
+        fprintf(stderr, "failed to open pipeline cache for writing: %s\n", tmp_path);
+        free(tmp_path);
+        free(data);
+        return false;
+    }
+
+    bool written = fwrite(&header, sizeof(header), 1, fp) == 1
+        && fwrite(data, 1, data_size, fp) == data_size
+        && fflush(fp) == 0;
+#ifdef _WIN32
+    written = written && _commit(_fileno(fp)) == 0;
+#else
+    written = written && fsync(fileno(fp)) == 0;
+#endif
+    fclose(fp);
+    free(data);
+
+    if (!written) {
+        fprintf(stderr, "failed to write pipeline cache: %s\n", tmp_path);
+        remove(tmp_path);
+        free(tmp_path);
+        return false;
+    }
+
+    // rename() refuses to replace an existing file on windows, MoveFileEx swaps it in one step
+#ifdef _WIN32
+    bool renamed = MoveFileExA(tmp_path, path, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+    bool renamed = rename(tmp_path, path) == 0;
+#endif
+    if (!renamed) {
+        fprintf(stderr, "failed to replace pipeline cache: %s\n", path);
+        remove(tmp_path);
+    }
+
+    free(tmp_path);
+    return renamed;
+}
@@ -0,0 +1,43 @@
+#ifndef PIPELINE_CACHE_H
+#define PIPELINE_CACHE_H
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "config.h"
+#include "host_allocator.h"
+
+#define PIPELINE_CACHE_MAGIC 0x43505256 // "VRPC"
+#define PIPELINE_CACHE_VERSION 1
+#define PIPELINE_CACHE_PATH_ENV "VRENDER_PIPELINE_CACHE"
+
+// Prepended to the driver blob, the driver header alone has no driver version
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t vendor_id;
+    uint32_t device_id;
+    uint32_t driver_version;
+    uint8_t cache_uuid[VK_UUID_SIZE];
+    uint64_t data_size;
+    uint64_t data_hash;
+} PipelineCacheFileHeader;
+
+// Pipeline cache creation
+VkPipelineCache create_pipeline_cache(VkDevice device, VkPhysicalDevice physical_device, const char *path);
+const char *get_pipeline_cache_path();
+
+// Validation
+bool is_pipeline_cache_valid(const uint8_t *file_data, size_t file_size, VkPhysicalDeviceProperties *properties);
+uint64_t hash_pipeline_cache_data(const uint8_t *data, size_t size);
+
+// Serialization
+bool save_pipeline_cache(VkDevice device, VkPhysicalDevice physical_device, VkPipelineCache cache, const char *path);
+
+#endif
@@ -0,0 +1,490 @@
+#include "pipeline_registry.h"
+
+#define FNV_OFFSET_BASIS 0xcbf29ce484222325ULL
+#define FNV_PRIME 0x100000001b3ULL
+#define REGISTRY_MAX_LOAD_PERCENT 70
+
+/*
+* Keys
+*/
+static bool key_push(RegistryKey *key, const void *data, size_t size) {
+    if (key->size + size > key->capacity) {
+        size_t capacity = key->capacity > 0 ? key->capacity * 2 : 64;
+        while (capacity < key->size + size) {
+            capacity *= 2;
+        }
+
+        uint8_t *grown = realloc(key->data, capacity);
+        if (grown == NULL) {
+            key->failed = true;
+            return false;
+        }
+        key->data = grown;
+        key->capacity = capacity;
+    }
+
+    memcpy(key->data + key->size, data, size);
+    key->size += size;
+    return true;
+}
+
+static void key_push_u32(RegistryKey *key, uint32_t value) {
+    key_push(key, &value, sizeof(value));
+}
+
+static void key_push_u64(RegistryKey *key, uint64_t value) {
+    key_push(key, &value, sizeof(value));
+}
+
+// Length prefixed so "ab"+"c" and "a"+"bc" encode differently
+static void key_push_string(RegistryKey *key, const char *value) {
+    uint32_t length = value != NULL ? (uint32_t)strlen(value) : 0;
+    key_push_u32(key, length);
+    key_push(key, value, length);
+}
+
+// Handles are already deduplicated, so their identity stands in for their state
+#define key_push_handle(key, handle) key_push_u64(key, (uint64_t)(uintptr_t)(handle))
+
+static void free_key(RegistryKey *key) {
+    free(key->data);
+    key->data = NULL;
+    key->size = 0;
+    key->capacity = 0;
+    key->failed = false;
+}
+
+/*
+* Hashing
+*/
+uint64_t hash_registry_key(const RegistryKey *key) {
+    uint64_t hash = FNV_OFFSET_BASIS;
+    for (size_t i = 0; i < key->size; ++i) {
+        hash ^= key->data[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+static void encode_specialization_desc(RegistryKey *key, const SpecializationDesc *desc) {
+    key_push_u32(key, desc->constant_count);
+    for (uint32_t i = 0; i < desc->constant_count; ++i) {
+        key_push_u32(key, desc->constant_ids[i]);
+        key_push_u32(key, desc->values[i]);
+    }
+}
+
+// Fields are encoded one by one, struct padding never reaches the hash
+void encode_graphics_pipeline_desc(RegistryKey *key, const GraphicsPipelineDesc *desc) {
+    key_push_string(key, desc->vert.name);
+    key_push_string(key, desc->frag.name);
+    encode_specialization_desc(key, &desc->vert_specialization);
+    encode_specialization_desc(key, &desc->frag_specialization);
+    key_push_handle(key, desc->render_pass);
+    key_push_handle(key, desc->pipeline_layout);
+    key_push_u32(key, desc->subpass);
+
+    key_push_u32(key, desc->vertex_input.binding_count);
+    for (uint32_t i = 0; i < desc->vertex_input.binding_count; ++i) {
+        key_push_u32(key, desc->vertex_input.bindings[i].binding);
+        key_push_u32(key, desc->vertex_input.bindings[i].stride);
+        key_push_u32(key, desc->vertex_input.bindings[i].inputRate);
+    }
+
+    key_push_u32(key, desc->vertex_input.attribute_count);
+    for (uint32_t i = 0; i < desc->vertex_input.attribute_count; ++i) {
+        key_push_u32(key, desc->vertex_input.attributes[i].location);
+        key_push_u32(key, desc->vertex_input.attributes[i].binding);
+        key_push_u32(key, desc->vertex_input.attributes[i].format);
+        key_push_u32(key, desc->vertex_input.attributes[i].offset);
+    }
+
+    key_push_u32(key, desc->topology);
+    key_push_u32(key, desc->polygon_mode);
+    key_push_u32(key, desc->cull_mode);
+    key_push_u32(key, desc->front_face);
+    key_push_u32(key, desc->samples);
+    key_push_u32(key, desc->blend_enable);
+    key_push_u32(key, desc->depth_test_enable);
+    key_push_u32(key, desc->depth_write_enable);
+    key_push_u32(key, desc->depth_compare_op);
+}
+
+void encode_compute_pipeline_desc(RegistryKey *key, const ComputePipelineDesc *desc) {
+    key_push_string(key, desc->comp.name);
+    encode_specialization_desc(key, &desc->specialization);
+    key_push_handle(key, desc->pipeline_layout);
+}
+
+void encode_pipeline_layout_desc(RegistryKey *key, const PipelineLayoutDesc *desc) {
+    key_push_u32(key, desc->set_layout_count);
+    for (uint32_t i = 0; i < desc->set_layout_count; ++i) {
+        key_push_handle(key, desc->set_layouts[i]);
+    }
+
+    key_push_u32(key, desc->push_constant_range_count);
+    for (uint32_t i = 0; i < desc->push_constant_range_count; ++i) {
+        key_push_u32(key, desc->push_constant_ranges[i].stageFlags);
+        key_push_u32(key, desc->push_constant_ranges[i].offset);
+        key_push_u32(key, desc->push_constant_ranges[i].size);
+    }
+}
+
+void encode_descriptor_set_layout_desc(RegistryKey *key, const DescriptorSetLayoutDesc *desc) {
+    // Bindings are encoded in binding order so declaration order does not matter
+    const VkDescriptorSetLayoutBinding *sorted[MAX_DESCRIPTOR_BINDINGS];
+    for (uint32_t i = 0; i < desc->binding_count; ++i) {
+        sorted[i] = &desc->bindings[i];
+        for (uint32_t j = i; j > 0 && sorted[j - 1]->binding > sorted[j]->binding; --j) {
+            const VkDescriptorSetLayoutBinding *tmp = sorted[j];
+            sorted[j] = sorted[j - 1];
+            sorted[j - 1] = tmp;
+        }
+    }
+
+    key_push_u32(key, desc->binding_count);
+    for (uint32_t i = 0; i < desc->binding_count; ++i) {
+        key_push_u32(key, sorted[i]->binding);
+        key_push_u32(key, sorted[i]->descriptorType);
+        key_push_u32(key, sorted[i]->descriptorCount);
+        key_push_u32(key, sorted[i]->stageFlags);
+        key_push_handle(key, sorted[i]->pImmutableSamplers);
+    }
+}
+
+void encode_render_pass_desc(RegistryKey *key, const RenderPassDesc *desc) {
+    key_push_u32(key, desc->color_format);
+    key_push_u32(key, desc->depth_format);
+    key_push_u32(key, desc->final_layout);
+}
+
+/*
+* Tables
+*/
+static bool init_table(RegistryTable *table) {
+    table->entries = calloc(REGISTRY_INITIAL_CAPACITY, sizeof(RegistryEntry));
+    if (table->entries == NULL) { return false; }
+
+    table->capacity = REGISTRY_INITIAL_CAPACITY;
+    table->count = 0;
+    table->hits = 0;
+    table->misses = 0;
+    return true;
+}
+
+static RegistryEntry *probe_table(RegistryEntry *entries, uint32_t capacity, uint64_t hash, const RegistryKey *key) {
+    uint32_t mask = capacity - 1;
+    for (uint32_t i = (uint32_t)hash & mask; ; i = (i + 1) & mask) {
+        RegistryEntry *entry = &entries[i];
+        if (!entry->occupied) {
+            return entry;
+        }
+        if (entry->hash == hash && key != NULL && entry->key.size == key->size
+            && memcmp(entry->key.data, key->data, key->size) == 0) {
+            return entry;
+        }
+    }
+}
+
+static bool grow_table(RegistryTable *table) {
+    uint32_t capacity = table->capacity * 2;
+    RegistryEntry *entries = calloc(capacity, sizeof(RegistryEntry));
+    if (entries == NULL) { return false; }
+
+    // Keys are unique, so reinsertion only needs a free slot
+    for (uint32_t i = 0; i < table->capacity; ++i) {
+        if (table->entries[i].occupied) {
+            *probe_table(entries, capacity, table->entries[i].hash, NULL) = table->entries[i];
+        }
+    }
+
+    free(table->entries);
+    table->entries = entries;
+    table->capacity = capacity;
+    return true;
+}
+
+// Returns the matching entry, or a fresh unoccupied one that takes ownership of the key
+static RegistryEntry *find_or_insert(RegistryTable *table, RegistryKey *key) {
+    if (key->failed) {
+        fprintf(stderr, "failed to alloc registry key\n");
+        free_key(key);
+        return NULL;
+    }
+    if ((table->count + 1) * 100 > table->capacity * REGISTRY_MAX_LOAD_PERCENT) {
+        if (!grow_table(table)) {
+            free_key(key);
+            return NULL;
+        }
+    }
+
+    uint64_t hash = hash_registry_key(key);
+    RegistryEntry *entry = probe_table(table->entries, table->capacity, hash, key);
+    if (entry->occupied) {
+        ++table->hits;
+        free_key(key);
+        return entry;
+    }
+
+    ++table->misses;
+    entry->hash = hash;
+    entry->key = *key;
+    return entry;
+}
+
+static void commit_entry(RegistryTable *table, RegistryEntry *entry) {
+    entry->occupied = true;
+    ++table->count;
+}
+
+static void discard_entry(RegistryEntry *entry) {
+    free_key(&entry->key);
+}
+
+/*
+* Registry creation
+*/
+PipelineRegistry *create_pipeline_registry(VkDevice device, VkPipelineCache pipeline_cache) {
+    PipelineRegistry *registry = malloc(sizeof(PipelineRegistry));
+    if (registry == NULL) { return NULL; }
+
+    registry->device = device;
+    registry->pipeline_cache = pipeline_cache;
+    if (!init_table(&registry->pipelines) || !init_table(&registry->compute_pipelines) || !init_table(&registry->pipeline_layouts)
+        || !init_table(&registry->set_layouts) || !init_table(&registry->render_passes)) {
+        fprintf(stderr, "failed to alloc pipeline registry tables\n");
+        return NULL;
+    }
+
+    return registry;
+}
+
+/*
+* Lookups
+*/
+static PipelineFuture *lookup_graphics_pipeline(PipelineRegistry *registry, PipelineBuilder *builder, const GraphicsPipelineDesc *desc) {
+    RegistryKey key = {0};
+    encode_graphics_pipeline_desc(&key, desc);
+
+    RegistryEntry *entry = find_or_insert(&registry->pipelines, &key);
+    if (entry == NULL) { return NULL; }
+    if (entry->occupied && get_pipeline_status(entry->handle.pipeline) != PIPELINE_FAILED) {
+        return entry->handle.pipeline;
+    }
+
+    // A failed build is evicted by rebuilding into its future, holders of the old result pick up the new one
+    bool rebuild = entry->occupied;
+    PipelineFuture *future = rebuild ? entry->handle.pipeline : malloc(sizeof(PipelineFuture));
+    if (future == NULL) {
+        discard_entry(entry);
+        return NULL;
+    }
+
+    if (builder != NULL) {
+        if (!build_graphics_pipelines_async(builder, desc, future, 1)) {
+            if (!rebuild) {
+                free(future);
+                discard_entry(entry);
+            }
+            return NULL;
+        }
+    } else {
+        future->pipeline = create_graphics_pipeline(registry->device, registry->pipeline_cache, desc);
+        atomic_init(&future->status, future->pipeline != VK_NULL_HANDLE ? PIPELINE_READY : PIPELINE_FAILED);
+    }
+
+    if (!rebuild) {
+        entry->handle.pipeline = future;
+        commit_entry(&registry->pipelines, entry);
+    }
+    return future;
+}
+
+PipelineFuture *get_graphics_pipeline(PipelineRegistry *registry, const GraphicsPipelineDesc *desc) {
+    return lookup_graphics_pipeline(registry, NULL, desc);
+}
+
+PipelineFuture *request_graphics_pipeline(PipelineRegistry *registry, PipelineBuilder *builder, const GraphicsPipelineDesc *desc) {
+    return lookup_graphics_pipeline(registry, builder, desc);
+}
+
+static PipelineFuture *lookup_compute_pipeline(PipelineRegistry *registry, PipelineBuilder *builder, const ComputePipelineDesc *desc) {
+    RegistryKey key = {0};
+    encode_compute_pipeline_desc(&key, desc);
+
+    RegistryEntry *entry = find_or_insert(&registry->compute_pipelines, &key);
+    if (entry == NULL) { return NULL; }
+    if (entry->occupied && get_pipeline_status(entry->handle.pipeline) != PIPELINE_FAILED) {
+        return entry->handle.pipeline;
+    }
+
+    bool rebuild = entry->occupied;
+    PipelineFuture *future = rebuild ? entry->handle.pipeline : malloc(sizeof(PipelineFuture));
+    if (future == NULL) {
+        discard_entry(entry);
+        return NULL;
+    }
+
+    if (builder != NULL) {
+        if (!build_compute_pipelines_async(builder, desc, future, 1)) {
+            if (!rebuild) {
+                free(future);
+                discard_entry(entry);
+            }
+            return NULL;
+        }
+    } else {
+        future->pipeline = create_compute_pipeline(registry->device, registry->pipeline_cache, desc);
+        atomic_init(&future->status, future->pipeline != VK_NULL_HANDLE ? PIPELINE_READY : PIPELINE_FAILED);
+    }
+
+    if (!rebuild) {
+        entry->handle.pipeline = future;
+        commit_entry(&registry->compute_pipelines, entry);
+    }
+    return future;
+}
+
+PipelineFuture *get_compute_pipeline(PipelineRegistry *registry, const ComputePipelineDesc *desc) {
+    return lookup_compute_pipeline(registry, NULL, desc);
+}
+
+PipelineFuture *request_compute_pipeline(PipelineRegistry *registry, PipelineBuilder *builder, const ComputePipelineDesc *desc) {
+    return lookup_compute_pipeline(registry, builder, desc);
+}
+
+VkPipelineLayout get_pipeline_layout(PipelineRegistry *registry, const PipelineLayoutDesc *desc) {
+    RegistryKey key = {0};
+    encode_pipeline_layout_desc(&key, desc);
+
+    RegistryEntry *entry = find_or_insert(&registry->pipeline_layouts, &key);
+    if (entry == NULL) { return VK_NULL_HANDLE; }
+    if (entry->occupied) {
+        return entry->handle.pipeline_layout;
+    }
+
+    entry->handle.pipeline_layout = create_pipeline_layout(registry->device, desc);
+    if (entry->handle.pipeline_layout == VK_NULL_HANDLE) {
+        discard_entry(entry);
+        return VK_NULL_HANDLE;
+    }
+
+    commit_entry(&registry->pipeline_layouts, entry);
+    return entry->handle.pipeline_layout;
+}
+
+VkDescriptorSetLayout get_descriptor_set_layout(PipelineRegistry *registry, const DescriptorSetLayoutDesc *desc) {
+    RegistryKey key = {0};
+    encode_descriptor_set_layout_desc(&key, desc);
+
+    RegistryEntry *entry = find_or_insert(&registry->set_layouts, &key);
+    if (entry == NULL) { return VK_NULL_HANDLE; }
+    if (entry->occupied) {
+        return entry->handle.set_layout;
+    }
+
+    entry->handle.set_layout = create_descriptor_set_layout(registry->device, desc);
+    if (entry->handle.set_layout == VK_NULL_HANDLE) {
+        discard_entry(entry);
+        return VK_NULL_HANDLE;
+    }
+
+    commit_entry(&registry->set_layouts, entry);
+    return entry->handle.set_layout;
+}
+
+VkRenderPass get_render_pass(PipelineRegistry *registry, const RenderPassDesc *desc) {
+    RegistryKey key = {0};
+    encode_render_pass_desc(&key, desc);
+
+    RegistryEntry *entry = find_or_insert(&registry->render_passes, &key);
+    if (entry == NULL) { return VK_NULL_HANDLE; }
+    if (entry->occupied) {
+        return entry->handle.render_pass;
+    }
+
+    entry->handle.render_pass = create_render_pass(registry->device, desc);
+    if (entry->handle.render_pass == VK_NULL_HANDLE) {
+        discard_entry(entry);
+        return VK_NULL_HANDLE;
+    }
+
+    commit_entry(&registry->render_passes, entry);
+    return entry->handle.render_pass;
+}
+
+/*
+* Debugging
+*/
+static void print_table_stats(const char *name, RegistryTable *table) {
+    printf("\t- %-22s %4u objects, %5u hits, %4u misses\n", name, table->count, table->hits, table->misses);
+}
+
+void print_pipeline_registry_stats(PipelineRegistry *registry) {
+    printf("Pipeline registry: \n");
+    print_table_stats("pipelines", &registry->pipelines);
+    print_table_stats("compute pipelines", &registry->compute_pipelines);
+    print_table_stats("pipeline layouts", &registry->pipeline_layouts);
+    print_table_stats("descriptor set layouts", &registry->set_layouts);
+    print_table_stats("render passes", &registry->render_passes);
+}
+
+/*
+* Cleanup
+*/
+static void destroy_table(RegistryTable *table) {
+    for (uint32_t i = 0; i < table->capacity; ++i) {
+        if (table->entries[i].occupied) {
+            free_key(&table->entries[i].key);
+        }
+    }
+    free(table->entries);
+}
+
+static void destroy_pipeline_futures(VkDevice device, RegistryTable *table) {
+    for (uint32_t i = 0; i < table->capacity; ++i) {
+        RegistryEntry *entry = &table->entries[i];
+        if (!entry->occupied) { continue; }
+
+        if (get_pipeline_status(entry->handle.pipeline) == PIPELINE_READY) {
+            vkDestroyPipeline(device, entry->handle.pipeline->pipeline, get_host_allocator());
+        }
+        free(entry->handle.pipeline);
+    }
+}
+
+// Any pipeline builder feeding this registry must be idle first
+void destroy_pipeline_registry(PipelineRegistry *registry) {
+    VkDevice device = registry->device;
+    destroy_pipeline_futures(device, &registry->pipelines);
+    destroy_pipeline_futures(device, &registry->compute_pipelines);
+
+    // Layouts after the pipelines that use them
+    for (uint32_t i = 0; i < registry->pipeline_layouts.capacity; ++i) {
+        RegistryEntry *entry = &registry->pipeline_layouts.entries[i];
+        if (entry->occupied) {
+            vkDestroyPipelineLayout(device, entry->handle.pipeline_layout, get_host_allocator());
+        }
+    }
+
+    for (uint32_t i = 0; i < registry->set_layouts.capacity; ++i) {
+        RegistryEntry *entry = &registry->set_layouts.entries[i];
+        if (entry->occupied) {
+            vkDestroyDescriptorSetLayout(device, entry->handle.set_layout, get_host_allocator());
+        }
+    }
+
+    for (uint32_t i = 0; i < registry->render_passes.capacity; ++i) {
+        RegistryEntry *entry = &registry->render_passes.entries[i];
+        if (entry->occupied) {
+            vkDestroyRenderPass(device, entry->handle.render_pass, get_host_allocator());
+        }
+    }
+
+    destroy_table(&registry->pipelines);
+    destroy_table(&registry->compute_pipelines);
+    destroy_table(&registry->pipeline_layouts);
+    destroy_table(&registry->set_layouts);
+    destroy_table(&registry->render_passes);
+    free(registry);
+}
@@ -0,0 +1,83 @@
+#ifndef PIPELINE_REGISTRY_H
+#define PIPELINE_REGISTRY_H
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "pipeline.h"
+#include "pipeline_builder.h"
+
+#define REGISTRY_INITIAL_CAPACITY 64
+
+typedef union {
+    PipelineFuture *pipeline;
+    VkPipelineLayout pipeline_layout;
+    VkDescriptorSetLayout set_layout;
+    VkRenderPass render_pass;
+} RegistryHandle;
+
+// Canonical byte encoding of a description, compared on hash collisions
+typedef struct {
+    uint8_t *data;
+    size_t size;
+    size_t capacity;
+    bool failed; // a push ran out of memory, the encoding is incomplete and must not be looked up
+} RegistryKey;
+
+typedef struct {
+    uint64_t hash;
+    RegistryKey key;
+    RegistryHandle handle;
+    bool occupied;
+} RegistryEntry;
+
+// Open addressing table with linear probing, capacity is a power of two
+typedef struct {
+    RegistryEntry *entries;
+    uint32_t capacity;
+    uint32_t count;
+    uint32_t hits;
+    uint32_t misses;
+} RegistryTable;
+
+// Deduplicates pipeline objects by state, not thread safe
+typedef struct {
+    VkDevice device;
+    VkPipelineCache pipeline_cache;
+    RegistryTable pipelines;
+    RegistryTable compute_pipelines;
+    RegistryTable pipeline_layouts;
+    RegistryTable set_layouts;
+    RegistryTable render_passes;
+} PipelineRegistry;
+
+// Registry creation
+PipelineRegistry *create_pipeline_registry(VkDevice device, VkPipelineCache pipeline_cache);
+
+// Lookups, identical state returns the existing object
+PipelineFuture *get_graphics_pipeline(PipelineRegistry *registry, const GraphicsPipelineDesc *desc);
+PipelineFuture *request_graphics_pipeline(PipelineRegistry *registry, PipelineBuilder *builder, const GraphicsPipelineDesc *desc);
+PipelineFuture *get_compute_pipeline(PipelineRegistry *registry, const ComputePipelineDesc *desc);
+PipelineFuture *request_compute_pipeline(PipelineRegistry *registry, PipelineBuilder *builder, const ComputePipelineDesc *desc);
+VkPipelineLayout get_pipeline_layout(PipelineRegistry *registry, const PipelineLayoutDesc *desc);
+VkDescriptorSetLayout get_descriptor_set_layout(PipelineRegistry *registry, const DescriptorSetLayoutDesc *desc);
+VkRenderPass get_render_pass(PipelineRegistry *registry, const RenderPassDesc *desc);
+
+// Hashing
+uint64_t hash_registry_key(const RegistryKey *key);
+void encode_graphics_pipeline_desc(RegistryKey *key, const GraphicsPipelineDesc *desc);
+void encode_compute_pipeline_desc(RegistryKey *key, const ComputePipelineDesc *desc);
+void encode_pipeline_layout_desc(RegistryKey *key, const PipelineLayoutDesc *desc);
+void encode_descriptor_set_layout_desc(RegistryKey *key, const DescriptorSetLayoutDesc *desc);
+void encode_render_pass_desc(RegistryKey *key, const RenderPassDesc *desc);
+
+// Debugging
+void print_pipeline_registry_stats(PipelineRegistry *registry);
+
+// Cleanup
+void destroy_pipeline_registry(PipelineRegistry *registry);
+
+#endif
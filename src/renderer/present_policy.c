@@ -0,0 +1,92 @@
+#include "present_policy.h"
+
+/*
+* Profiles
+*/
+const PresentPolicy PRESENT_POLICIES[PRESENT_POLICY_COUNT] = {
+    // Newest image wins, the CPU never waits on vblank so there is no present wait pacing
+    {
+        PRESENT_POLICY_LOW_LATENCY, "low-latency",
+        2, { VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_IMMEDIATE_KHR },
+        DOUBLE_BUFFERING, 0, 2, 0
+    },
+    // Deep queue keeps the GPU busy through frame time spikes
+    {
+        PRESENT_POLICY_THROUGHPUT, "throughput",
+        1, { VK_PRESENT_MODE_FIFO_KHR },
+        TRIPLE_BUFFERING, 1, 3, 0
+    },
+    // Vsync with a shallow queue, the CPU sleeps on present instead of running ahead
+    {
+        PRESENT_POLICY_POWER_SAVE, "power-save",
+        1, { VK_PRESENT_MODE_FIFO_KHR },
+        DOUBLE_BUFFERING, 0, 2, 1
+    }
+};
+
+const PresentPolicy *get_present_policy(PresentPolicyProfile profile) {
+    if (profile >= PRESENT_POLICY_COUNT) { return NULL; }
+    return &PRESENT_POLICIES[profile];
+}
+
+bool parse_present_policy_profile(const char *name, PresentPolicyProfile *profile) {
+    for (uint32_t i = 0; i < PRESENT_POLICY_COUNT; ++i) {
+        if (strcmp(name, PRESENT_POLICIES[i].name) == 0) {
+            *profile = PRESENT_POLICIES[i].profile;
+            return true;
+        }
+    }
+
+    fprintf(stderr, "unknown present policy: %s\n", name);
+    return false;
+}
+
+// Interactive runs favour latency, batch runs have nothing to present and favour throughput
+PresentPolicyProfile get_default_present_policy_profile(bool headless) {
+    PresentPolicyProfile profile = headless ? PRESENT_POLICY_THROUGHPUT : PRESENT_POLICY_LOW_LATENCY;
+
+    const char *name = getenv(PRESENT_POLICY_ENV);
+    if (name != NULL && name[0] != '\0') {
+        parse_present_policy_profile(name, &profile);
+    }
+    return profile;
+}
+
+/*
+* Swapchain parameters
+*/
+VkPresentModeKHR select_policy_present_mode(const PresentPolicy *policy, const VkPresentModeKHR *present_modes, uint32_t present_mode_count) {
+    for (uint32_t i = 0; i < policy->present_mode_count; ++i) {
+        for (uint32_t j = 0; j < present_mode_count; ++j) {
+            if (present_modes[j] == policy->present_modes[i]) {
+                return present_modes[j];
+            }
+        }
+    }
+
+    // The only mode every surface is required to support
+    return VK_PRESENT_MODE_FIFO_KHR;
+}
+
+uint32_t select_policy_image_count(const PresentPolicy *policy, const VkSurfaceCapabilitiesKHR *capabilities) {
+    uint32_t image_count = policy->image_count;
+    if (image_count < capabilities->minImageCount + policy->extra_images) {
+        image_count = capabilities->minImageCount + policy->extra_images;
+    }
+
+    // Zero means no upper limit
+    if (capabilities->maxImageCount > 0 && image_count > capabilities->maxImageCount) {
+        image_count = capabilities->maxImageCount;
+    }
+    return image_count;
+}
+
+const char *get_present_mode_name(VkPresentModeKHR present_mode) {
+    switch (present_mode) {
+        case VK_PRESENT_MODE_IMMEDIATE_KHR: return "IMMEDIATE";
+        case VK_PRESENT_MODE_MAILBOX_KHR: return "MAILBOX";
+        case VK_PRESENT_MODE_FIFO_KHR: return "FIFO";
+        case VK_PRESENT_MODE_FIFO_RELAXED_KHR: return "FIFO_RELAXED";
+        default: return "UNKNOWN";
+    }
+}
@@ -0,0 +1,50 @@
+#ifndef PRESENT_POLICY_H
+#define PRESENT_POLICY_H
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Overrides the default profile, same names as --present-policy
+#define PRESENT_POLICY_ENV "VRENDER_PRESENT_POLICY"
+#define MAX_PRESENT_MODE_PREFERENCES 3
+
+// Number of images we will buffer in the swapchain
+#define DOUBLE_BUFFERING 2
+#define TRIPLE_BUFFERING 3
+
+typedef enum {
+    PRESENT_POLICY_LOW_LATENCY,
+    PRESENT_POLICY_THROUGHPUT,
+    PRESENT_POLICY_POWER_SAVE,
+    PRESENT_POLICY_COUNT
+} PresentPolicyProfile;
+
+// Trades latency against throughput and power, FIFO is always the final present mode fallback
+typedef struct {
+    PresentPolicyProfile profile;
+    const char *name;
+    uint32_t present_mode_count;
+    VkPresentModeKHR present_modes[MAX_PRESENT_MODE_PREFERENCES];
+    uint32_t image_count;         // desired swapchain images, clamped to the surface limits
+    uint32_t extra_images;        // minimum images on top of minImageCount
+    uint32_t frames_in_flight;
+    uint32_t max_queued_presents; // paced with VK_KHR_present_wait when available, 0 disables pacing
+} PresentPolicy;
+
+// Profiles
+const PresentPolicy *get_present_policy(PresentPolicyProfile profile);
+bool parse_present_policy_profile(const char *name, PresentPolicyProfile *profile);
+PresentPolicyProfile get_default_present_policy_profile(bool headless);
+
+// Swapchain parameters
+VkPresentModeKHR select_policy_present_mode(const PresentPolicy *policy, const VkPresentModeKHR *present_modes, uint32_t present_mode_count);
+uint32_t select_policy_image_count(const PresentPolicy *policy, const VkSurfaceCapabilitiesKHR *capabilities);
+const char *get_present_mode_name(VkPresentModeKHR present_mode);
+
+#endif
@@ -0,0 +1,166 @@
+#include "queue.h"
+
+/*
+* Queues
+*/
+VkQueue get_queue(VulkanContext *v_ctx, QueueType type) {
+    switch (type) {
+        case QUEUE_COMPUTE: return v_ctx->compute_queue;
+        case QUEUE_TRANSFER: return v_ctx->transfer_queue;
+        default: return v_ctx->graphics_queue;
+    }
+}
+
+uint32_t get_queue_family(VulkanContext *v_ctx, QueueType type) {
+    switch (type) {
+        case QUEUE_COMPUTE: return v_ctx->indices->compute_index;
+        case QUEUE_TRANSFER: return v_ctx->indices->transfer_index;
+        default: return v_ctx->indices->graphics_index;
+    }
+}
+
+// False when the type falls back to the graphics family
+bool is_queue_dedicated(VulkanContext *v_ctx, QueueType type) {
+    return type == QUEUE_GRAPHICS || get_queue_family(v_ctx, type) != (uint32_t)v_ctx->indices->graphics_index;
+}
+
+VkCommandPool create_queue_command_pool(VulkanContext *v_ctx, QueueType type, VkCommandPoolCreateFlags flags) {
+    VkCommandPoolCreateInfo create_info;
+    create_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    create_info.pNext = NULL;
+    create_info.flags = flags;
+    create_info.queueFamilyIndex = get_queue_family(v_ctx, type);
+
+    VkCommandPool command_pool;
+    if (vkCreateCommandPool(v_ctx->device, &create_info, get_host_allocator(), &command_pool) != VK_SUCCESS) {
+        fprintf(stderr, "failed to create queue command pool\n");
+        return VK_NULL_HANDLE;
+    }
+
+    return command_pool;
+}
+
+/*
+* Submission
+*/
+bool submit_to_queue(VulkanContext *v_ctx, QueueType type, const QueueSubmitDesc *desc) {
+    if (desc->wait_count > MAX_QUEUE_WAITS) {
+        fprintf(stderr, "too many queue waits\n");
+        return false;
+    }
+
+    VkSemaphore wait_semaphores[MAX_QUEUE_WAITS];
+    VkPipelineStageFlags wait_stages[MAX_QUEUE_WAITS];
+    for (uint32_t i = 0; i < desc->wait_count; ++i) {
+        wait_semaphores[i] = desc->waits[i].semaphore;
+        wait_stages[i] = desc->waits[i].stage_mask;
+    }
+
+    VkSubmitInfo submit_info;
+    submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submit_info.pNext = NULL;
+    submit_info.waitSemaphoreCount = desc->wait_count;
+    submit_info.pWaitSemaphores = desc->wait_count > 0 ? wait_semaphores : NULL;
+    submit_info.pWaitDstStageMask = desc->wait_count > 0 ? wait_stages : NULL;
+    submit_info.commandBufferCount = desc->command_buffer_count;
+    submit_info.pCommandBuffers = desc->command_buffers;
+    submit_info.signalSemaphoreCount = desc->signal_count;
+    submit_info.pSignalSemaphores = desc->signals;
+
+    if (vkQueueSubmit(get_queue(v_ctx, type), 1, &submit_info, desc->fence) != VK_SUCCESS) {
+        fprintf(stderr, "failed to submit to queue %d\n", type);
+        return false;
+    }
+
+    return true;
+}
+
+/*
+* Ownership transfers
+*/
+// Same family transfers need no release, the acquire becomes an ordinary barrier
+static bool is_same_family(VulkanContext *v_ctx, const QueueTransfer *transfer) {
+    return get_queue_family(v_ctx, transfer->src_queue) == get_queue_family(v_ctx, transfer->dst_queue);
+}
+
+static void get_transfer_families(VulkanContext *v_ctx, const QueueTransfer *transfer, uint32_t *src_family, uint32_t *dst_family) {
+    *src_family = VK_QUEUE_FAMILY_IGNORED;
+    *dst_family = VK_QUEUE_FAMILY_IGNORED;
+    if (!is_same_family(v_ctx, transfer)) {
+        *src_family = get_queue_family(v_ctx, transfer->src_queue);
+        *dst_family = get_queue_family(v_ctx, transfer->dst_queue);
+    }
+}
+
+static void record_buffer_barrier(VkCommandBuffer command_buffer, VulkanContext *v_ctx, const QueueTransfer *transfer, VkBuffer buffer,
+    VkPipelineStageFlags src_stage, VkAccessFlags src_access, VkPipelineStageFlags dst_stage, VkAccessFlags dst_access) {
+    VkBufferMemoryBarrier barrier;
+    barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    barrier.pNext = NULL;
+    barrier.srcAccessMask = src_access;
+    barrier.dstAccessMask = dst_access;
+    get_transfer_families(v_ctx, transfer, &barrier.srcQueueFamilyIndex, &barrier.dstQueueFamilyIndex);
+    barrier.buffer = buffer;
+    barrier.offset = 0;
+    barrier.size = VK_WHOLE_SIZE;
+
+    vkCmdPipelineBarrier(command_buffer, src_stage, dst_stage, 0, 0, NULL, 1, &barrier, 0, NULL);
+}
+
+static void record_image_barrier(VkCommandBuffer command_buffer, VulkanContext *v_ctx, const QueueTransfer *transfer, VkImage image,
+    VkImageSubresourceRange range, VkImageLayout old_layout, VkImageLayout new_layout,
+    VkPipelineStageFlags src_stage, VkAccessFlags src_access, VkPipelineStageFlags dst_stage, VkAccessFlags dst_access) {
+    VkImageMemoryBarrier barrier;
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.pNext = NULL;
+    barrier.srcAccessMask = src_access;
+    barrier.dstAccessMask = dst_access;
+    barrier.oldLayout = old_layout;
+    barrier.newLayout = new_layout;
+    get_transfer_families(v_ctx, transfer, &barrier.srcQueueFamilyIndex, &barrier.dstQueueFamilyIndex);
+    barrier.image = image;
+    barrier.subresourceRange = range;
+
+    vkCmdPipelineBarrier(command_buffer, src_stage, dst_stage, 0, 0, NULL, 0, NULL, 1, &barrier);
+}
+
+void record_buffer_release(VkCommandBuffer command_buffer, VulkanContext *v_ctx, const QueueTransfer *transfer, VkBuffer buffer) {
+    if (is_same_family(v_ctx, transfer)) { return; }
+
+    // Destination access is ignored by the releasing queue
+    record_buffer_barrier(command_buffer, v_ctx, transfer, buffer,
+        transfer->src_stage, transfer->src_access, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0);
+}
+
+void record_buffer_acquire(VkCommandBuffer command_buffer, VulkanContext *v_ctx, const QueueTransfer *transfer, VkBuffer buffer) {
+    if (is_same_family(v_ctx, transfer)) {
+        record_buffer_barrier(command_buffer, v_ctx, transfer, buffer,
+            transfer->src_stage, transfer->src_access, transfer->dst_stage, transfer->dst_access);
+        return;
+    }
+
+    // The semaphore between the submissions orders this after the release
+    record_buffer_barrier(command_buffer, v_ctx, transfer, buffer,
+        VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0, transfer->dst_stage, transfer->dst_access);
+}
+
+// Both halves must specify the same layout transition, it executes once
+void record_image_release(VkCommandBuffer command_buffer, VulkanContext *v_ctx, const QueueTransfer *transfer, VkImage image,
+    VkImageSubresourceRange range, VkImageLayout old_layout, VkImageLayout new_layout) {
+    if (is_same_family(v_ctx, transfer)) { return; }
+
+    record_image_barrier(command_buffer, v_ctx, transfer, image, range, old_layout, new_layout,
+        transfer->src_stage, transfer->src_access, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0);
+}
+
+void record_image_acquire(VkCommandBuffer command_buffer, VulkanContext *v_ctx, const QueueTransfer *transfer, VkImage image,
+    VkImageSubresourceRange range, VkImageLayout old_layout, VkImageLayout new_layout) {
+    if (is_same_family(v_ctx, transfer)) {
+        record_image_barrier(command_buffer, v_ctx, transfer, image, range, old_layout, new_layout,
+            transfer->src_stage, transfer->src_access, transfer->dst_stage, transfer->dst_access);
+        return;
+    }
+
+    record_image_barrier(command_buffer, v_ctx, transfer, image, range, old_layout, new_layout,
+        VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0, transfer->dst_stage, transfer->dst_access);
+}
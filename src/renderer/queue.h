@@ -0,0 +1,63 @@
+#ifndef QUEUE_H
+#define QUEUE_H
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include "vulkan_context.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define MAX_QUEUE_WAITS 8
+
+typedef enum {
+    QUEUE_GRAPHICS,
+    QUEUE_COMPUTE,
+    QUEUE_TRANSFER
+} QueueType;
+
+typedef struct {
+    VkSemaphore semaphore;
+    VkPipelineStageFlags stage_mask;
+} QueueWait;
+
+// One batch of command buffers plus the semaphores ordering it against other queues
+typedef struct {
+    const VkCommandBuffer *command_buffers;
+    uint32_t command_buffer_count;
+    const QueueWait *waits;
+    uint32_t wait_count;
+    const VkSemaphore *signals;
+    uint32_t signal_count;
+    VkFence fence;
+} QueueSubmitDesc;
+
+// Both halves of a queue family ownership transfer, src is the releasing queue
+typedef struct {
+    QueueType src_queue;
+    QueueType dst_queue;
+    VkPipelineStageFlags src_stage;
+    VkAccessFlags src_access;
+    VkPipelineStageFlags dst_stage;
+    VkAccessFlags dst_access;
+} QueueTransfer;
+
+// Queues
+VkQueue get_queue(VulkanContext *v_ctx, QueueType type);
+uint32_t get_queue_family(VulkanContext *v_ctx, QueueType type);
+bool is_queue_dedicated(VulkanContext *v_ctx, QueueType type);
+VkCommandPool create_queue_command_pool(VulkanContext *v_ctx, QueueType type, VkCommandPoolCreateFlags flags);
+
+// Submission
+bool submit_to_queue(VulkanContext *v_ctx, QueueType type, const QueueSubmitDesc *desc);
+
+// Ownership transfers, record the release on the src queue and the acquire on the dst queue
+void record_buffer_release(VkCommandBuffer command_buffer, VulkanContext *v_ctx, const QueueTransfer *transfer, VkBuffer buffer);
+void record_buffer_acquire(VkCommandBuffer command_buffer, VulkanContext *v_ctx, const QueueTransfer *transfer, VkBuffer buffer);
+void record_image_release(VkCommandBuffer command_buffer, VulkanContext *v_ctx, const QueueTransfer *transfer, VkImage image,
+    VkImageSubresourceRange range, VkImageLayout old_layout, VkImageLayout new_layout);
+void record_image_acquire(VkCommandBuffer command_buffer, VulkanContext *v_ctx, const QueueTransfer *transfer, VkImage image,
+    VkImageSubresourceRange range, VkImageLayout old_layout, VkImageLayout new_layout);
+
+#endif
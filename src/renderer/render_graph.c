@@ -0,0 +1,1039 @@
+#include "render_graph.h"
+
+// Synchronization a single resource use implies
+typedef struct {
+    VkPipelineStageFlags stage;
+    VkAccessFlags access;
+    VkImageLayout layout;
+    bool write;
+    VkImageUsageFlags image_usage;
+    VkBufferUsageFlags buffer_usage;
+} GraphAccessInfo;
+
+// Hazard tracking for one resource while barriers are generated
+typedef struct {
+    VkImageLayout layout;
+    VkPipelineStageFlags write_stage;
+    VkAccessFlags write_access;
+    VkPipelineStageFlags read_stages;
+    VkPipelineStageFlags visible_stages;
+    VkAccessFlags visible_access;
+    uint32_t first_barrier;
+} GraphResourceState;
+
+#define SHADER_STAGES (VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT)
+#define DEPTH_STAGES (VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT)
+
+/*
+* Graph creation
+*/
+RenderGraph *create_render_graph(VkDevice device, GpuAllocator *allocator) {
+    RenderGraph *graph = calloc(1, sizeof(RenderGraph));
+    if (graph == NULL) {
+        fprintf(stderr, "failed to alloc RenderGraph\n");
+        return NULL;
+    }
+
+    graph->device = device;
+    graph->allocator = allocator;
+    return graph;
+}
+
+/*
+* Resources
+*/
+static bool is_depth_format(VkFormat format) {
+    switch (format) {
+        case VK_FORMAT_D16_UNORM:
+        case VK_FORMAT_X8_D24_UNORM_PACK32:
+        case VK_FORMAT_D32_SFLOAT:
+        case VK_FORMAT_D16_UNORM_S8_UINT:
+        case VK_FORMAT_D24_UNORM_S8_UINT:
+        case VK_FORMAT_D32_SFLOAT_S8_UINT:
+            return true;
+        default:
+            return false;
+    }
+}
+
+static bool has_stencil(VkFormat format) {
+    return format == VK_FORMAT_D16_UNORM_S8_UINT || format == VK_FORMAT_D24_UNORM_S8_UINT || format == VK_FORMAT_D32_SFLOAT_S8_UINT;
+}
+
+static VkImageAspectFlags get_format_aspect(VkFormat format) {
+    if (!is_depth_format(format)) { return VK_IMAGE_ASPECT_COLOR_BIT; }
+    return has_stencil(format) ? VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT : VK_IMAGE_ASPECT_DEPTH_BIT;
+}
+
+static RenderGraphResource *add_graph_resource(RenderGraph *graph, const char *name, GraphResourceType type) {
+    if (graph->compiled) {
+        fprintf(stderr, "render graph already compiled, cannot add %s\n", name);
+        return NULL;
+    }
+    if (graph->resource_count >= MAX_GRAPH_RESOURCES) {
+        fprintf(stderr, "too many render graph resources\n");
+        return NULL;
+    }
+
+    RenderGraphResource *resource = &graph->resources[graph->resource_count++];
+    memset(resource, 0, sizeof(RenderGraphResource));
+    resource->name = name;
+    resource->type = type;
+    resource->first_pass = GRAPH_RESOURCE_NONE;
+    resource->last_pass = GRAPH_RESOURCE_NONE;
+    resource->alias_predecessor = GRAPH_RESOURCE_NONE;
+    return resource;
+}
+
+uint32_t import_graph_image(RenderGraph *graph, const char *name, const GraphImageImport *import) {
+    RenderGraphResource *resource = add_graph_resource(graph, name, GRAPH_RESOURCE_IMAGE);
+    if (resource == NULL) { return GRAPH_RESOURCE_NONE; }
+
+    resource->imported = true;
+    resource->image_desc.format = import->format;
+    resource->image_desc.extent = import->extent;
+    resource->image_desc.samples = VK_SAMPLE_COUNT_1_BIT;
+    resource->aspect = get_format_aspect(import->format);
+    resource->image = import->image;
+    resource->view = import->view;
+    resource->initial_layout = import->initial_layout;
+    resource->initial_stage = import->initial_stage;
+    resource->final_layout = import->final_layout;
+    return graph->resource_count - 1;
+}
+
+uint32_t import_graph_buffer(RenderGraph *graph, const char *name, VkBuffer buffer, VkDeviceSize size) {
+    RenderGraphResource *resource = add_graph_resource(graph, name, GRAPH_RESOURCE_BUFFER);
+    if (resource == NULL) { return GRAPH_RESOURCE_NONE; }
+
+    resource->imported = true;
+    resource->buffer = buffer;
+    resource->size = size;
+    resource->initial_stage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+    return graph->resource_count - 1;
+}
+
+// Transient resources are created at compile time, usage comes from the passes that touch them
+uint32_t create_graph_image(RenderGraph *graph, const char *name, const GraphImageDesc *desc) {
+    RenderGraphResource *resource = add_graph_resource(graph, name, GRAPH_RESOURCE_IMAGE);
+    if (resource == NULL) { return GRAPH_RESOURCE_NONE; }
+
+    resource->image_desc = *desc;
+    if (resource->image_desc.samples == 0) {
+        resource->image_desc.samples = VK_SAMPLE_COUNT_1_BIT;
+    }
+    resource->aspect = get_format_aspect(desc->format);
+    resource->initial_layout = VK_IMAGE_LAYOUT_UNDEFINED;
+    return graph->resource_count - 1;
+}
+
+uint32_t create_graph_buffer(RenderGraph *graph, const char *name, VkDeviceSize size) {
+    RenderGraphResource *resource = add_graph_resource(graph, name, GRAPH_RESOURCE_BUFFER);
+    if (resource == NULL) { return GRAPH_RESOURCE_NONE; }
+
+    resource->size = size;
+    return graph->resource_count - 1;
+}
+
+void set_graph_image(RenderGraph *graph, uint32_t resource, VkImage image, VkImageView view) {
+    graph->resources[resource].image = image;
+    graph->resources[resource].view = view;
+}
+
+void set_graph_buffer(RenderGraph *graph, uint32_t resource, VkBuffer buffer) {
+    graph->resources[resource].buffer = buffer;
+}
+
+VkImageView get_graph_image_view(RenderGraph *graph, uint32_t resource) {
+    return graph->resources[resource].view;
+}
+
+VkBuffer get_graph_buffer(RenderGraph *graph, uint32_t resource) {
+    return graph->resources[resource].buffer;
+}
+
+/*
+* Passes
+*/
+uint32_t add_graph_pass(RenderGraph *graph, const char *name, GraphPassType type, GraphPassCallback callback, void *user_data) {
+    if (graph->compiled || graph->pass_count >= MAX_GRAPH_PASSES) {
+        fprintf(stderr, "failed to add render graph pass %s\n", name);
+        return GRAPH_RESOURCE_NONE;
+    }
+
+    RenderGraphPass *pass = &graph->passes[graph->pass_count++];
+    memset(pass, 0, sizeof(RenderGraphPass));
+    pass->name = name;
+    pass->type = type;
+    pass->callback = callback;
+    pass->user_data = user_data;
+    pass->contents = VK_SUBPASS_CONTENTS_INLINE;
+    return graph->pass_count - 1;
+}
+
+// A resource is used at most once per pass, one layout per resource per pass
+bool use_graph_resource(RenderGraph *graph, uint32_t pass_index, uint32_t resource, GraphAccess access) {
+    if (pass_index >= graph->pass_count || resource >= graph->resource_count) { return false; }
+
+    RenderGraphPass *pass = &graph->passes[pass_index];
+    for (uint32_t i = 0; i < pass->use_count; ++i) {
+        if (pass->uses[i].resource == resource) {
+            fprintf(stderr, "pass %s uses %s twice\n", pass->name, graph->resources[resource].name);
+            return false;
+        }
+    }
+    if (pass->use_count >= MAX_PASS_RESOURCES) {
+        fprintf(stderr, "too many resources in pass %s\n", pass->name);
+        return false;
+    }
+
+    GraphResourceUse *use = &pass->uses[pass->use_count++];
+    memset(use, 0, sizeof(GraphResourceUse));
+    use->resource = resource;
+    use->access = access;
+    return true;
+}
+
+// Cleared attachments do not depend on earlier contents, which also lets earlier writers be culled
+bool clear_graph_attachment(RenderGraph *graph, uint32_t pass_index, uint32_t resource, VkClearValue clear_value) {
+    RenderGraphPass *pass = &graph->passes[pass_index];
+    for (uint32_t i = 0; i < pass->use_count; ++i) {
+        GraphResourceUse *use = &pass->uses[i];
+        if (use->resource == resource
+            && (use->access == GRAPH_ACCESS_COLOR_ATTACHMENT || use->access == GRAPH_ACCESS_DEPTH_ATTACHMENT)) {
+            use->clear = true;
+            use->clear_value = clear_value;
+            return true;
+        }
+    }
+
+    fprintf(stderr, "pass %s does not write %s as an attachment\n", pass->name, graph->resources[resource].name);
+    return false;
+}
+
+// Passes whose results leave the graph some other way, e.g. readbacks, are never culled
+void set_graph_pass_side_effects(RenderGraph *graph, uint32_t pass_index) {
+    graph->passes[pass_index].side_effects = true;
+}
+
+// The callback records into secondaries, e.g. on worker threads, and executes them from the pass
+void set_graph_pass_secondary(RenderGraph *graph, uint32_t pass_index) {
+    graph->passes[pass_index].contents = VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS;
+}
+
+/*
+* Compilation
+*/
+static GraphAccessInfo get_access_info(GraphAccess access, GraphPassType pass_type) {
+    VkPipelineStageFlags shader_stages = pass_type == GRAPH_PASS_COMPUTE ? VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT : SHADER_STAGES;
+
+    GraphAccessInfo info;
+    memset(&info, 0, sizeof(GraphAccessInfo));
+    switch (access) {
+        case GRAPH_ACCESS_COLOR_ATTACHMENT:
+            info.stage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+            info.access = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+            info.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+            info.write = true;
+            info.image_usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+            break;
+        case GRAPH_ACCESS_DEPTH_ATTACHMENT:
+            info.stage = DEPTH_STAGES;
+            info.access = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+            info.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+            info.write = true;
+            info.image_usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+            break;
+        case GRAPH_ACCESS_DEPTH_READ:
+            info.stage = DEPTH_STAGES;
+            info.access = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT;
+            info.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+            info.image_usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+            break;
+        case GRAPH_ACCESS_SAMPLED:
+            info.stage = shader_stages;
+            info.access = VK_ACCESS_SHADER_READ_BIT;
+            info.layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+            info.image_usage = VK_IMAGE_USAGE_SAMPLED_BIT;
+            info.buffer_usage = VK_BUFFER_USAGE_UNIFORM_TEXEL_BUFFER_BIT;
+            break;
+        case GRAPH_ACCESS_STORAGE_READ:
+            info.stage = shader_stages;
+            info.access = VK_ACCESS_SHADER_READ_BIT;
+            info.layout = VK_IMAGE_LAYOUT_GENERAL;
+            info.image_usage = VK_IMAGE_USAGE_STORAGE_BIT;
+            info.buffer_usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+            break;
+        case GRAPH_ACCESS_STORAGE_WRITE:
+            info.stage = shader_stages;
+            info.access = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+            info.layout = VK_IMAGE_LAYOUT_GENERAL;
+            info.write = true;
+            info.image_usage = VK_IMAGE_USAGE_STORAGE_BIT;
+            info.buffer_usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+            break;
+        case GRAPH_ACCESS_TRANSFER_SRC:
+            info.stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+            info.access = VK_ACCESS_TRANSFER_READ_BIT;
+            info.layout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+            info.image_usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+            info.buffer_usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+            break;
+        case GRAPH_ACCESS_TRANSFER_DST:
+            info.stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+            info.access = VK_ACCESS_TRANSFER_WRITE_BIT;
+            info.layout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+            info.write = true;
+            info.image_usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+            info.buffer_usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+            break;
+        case GRAPH_ACCESS_INDIRECT:
+            info.stage = VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT;
+            info.access = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+            info.buffer_usage = VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT;
+            break;
+        case GRAPH_ACCESS_VERTEX:
+            info.stage = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT;
+            info.access = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT;
+            info.buffer_usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+            break;
+        case GRAPH_ACCESS_INDEX:
+            info.stage = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT;
+            info.access = VK_ACCESS_INDEX_READ_BIT;
+            info.buffer_usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
+            break;
+        case GRAPH_ACCESS_UNIFORM:
+            info.stage = shader_stages;
+            info.access = VK_ACCESS_UNIFORM_READ_BIT;
+            info.buffer_usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+            break;
+        default:
+            break;
+    }
+    return info;
+}
+
+static bool is_attachment_access(GraphAccess access) {
+    return access == GRAPH_ACCESS_COLOR_ATTACHMENT || access == GRAPH_ACCESS_DEPTH_ATTACHMENT || access == GRAPH_ACCESS_DEPTH_READ;
+}
+
+// Walks backwards from imported resources, a pass lives if something downstream needs what it writes
+static void cull_graph_passes(RenderGraph *graph) {
+    bool needed[MAX_GRAPH_RESOURCES];
+    for (uint32_t i = 0; i < graph->resource_count; ++i) {
+        needed[i] = graph->resources[i].imported;
+    }
+
+    for (uint32_t p = graph->pass_count; p-- > 0;) {
+        RenderGraphPass *pass = &graph->passes[p];
+        pass->live = pass->side_effects;
+        for (uint32_t i = 0; i < pass->use_count; ++i) {
+            GraphResourceUse *use = &pass->uses[i];
+            if (get_access_info(use->access, pass->type).write && needed[use->resource]) {
+                pass->live = true;
+            }
+        }
+        if (!pass->live) { continue; }
+
+        // Cleared attachments end the dependency chain, everything else reads what came before
+        for (uint32_t i = 0; i < pass->use_count; ++i) {
+            GraphResourceUse *use = &pass->uses[i];
+            needed[use->resource] = !use->clear;
+        }
+    }
+}
+
+// Lifetimes and usage flags only count live passes
+static void gather_resource_usage(RenderGraph *graph) {
+    for (uint32_t p = 0; p < graph->pass_count; ++p) {
+        RenderGraphPass *pass = &graph->passes[p];
+        if (!pass->live) { continue; }
+
+        for (uint32_t i = 0; i < pass->use_count; ++i) {
+            RenderGraphResource *resource = &graph->resources[pass->uses[i].resource];
+            GraphAccessInfo info = get_access_info(pass->uses[i].access, pass->type);
+            resource->image_usage |= info.image_usage;
+            resource->buffer_usage |= info.buffer_usage;
+            if (resource->first_pass == GRAPH_RESOURCE_NONE) {
+                resource->first_pass = p;
+            }
+            resource->last_pass = p;
+        }
+    }
+}
+
+// Contents only survive into a pass if something earlier wrote them, and only leave it if something later reads them
+static void select_attachment_ops(RenderGraph *graph) {
+    bool has_contents[MAX_GRAPH_RESOURCES];
+    for (uint32_t i = 0; i < graph->resource_count; ++i) {
+        RenderGraphResource *resource = &graph->resources[i];
+        has_contents[i] = resource->imported && resource->initial_layout != VK_IMAGE_LAYOUT_UNDEFINED;
+    }
+
+    for (uint32_t p = 0; p < graph->pass_count; ++p) {
+        RenderGraphPass *pass = &graph->passes[p];
+        if (!pass->live) { continue; }
+
+        for (uint32_t i = 0; i < pass->use_count; ++i) {
+            GraphResourceUse *use = &pass->uses[i];
+            RenderGraphResource *resource = &graph->resources[use->resource];
+
+            if (use->clear) {
+                use->load_op = VK_ATTACHMENT_LOAD_OP_CLEAR;
+            } else if (has_contents[use->resource]) {
+                use->load_op = VK_ATTACHMENT_LOAD_OP_LOAD;
+            } else {
+                use->load_op = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+            }
+
+            bool read_later = resource->imported || resource->last_pass > p;
+            use->store_op = read_later ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+            if (get_access_info(use->access, pass->type).write) {
+                has_contents[use->resource] = true;
+            }
+        }
+    }
+}
+
+static bool is_lifetime_overlapping(const RenderGraphResource *a, const RenderGraphResource *b) {
+    return a->first_pass <= b->last_pass && b->first_pass <= a->last_pass;
+}
+
+static bool is_memory_overlapping(const RenderGraphResource *a, const RenderGraphResource *b) {
+    return a->memory_offset < b->memory_offset + b->requirements.size
+        && b->memory_offset < a->memory_offset + a->requirements.size;
+}
+
+// First fit by descending size, resources whose lifetimes never overlap may share the same bytes
+static VkDeviceSize place_transient_resources(RenderGraph *graph, uint32_t *indices, uint32_t count, VkMemoryRequirements *combined) {
+    for (uint32_t i = 1; i < count; ++i) {
+        uint32_t index = indices[i];
+        uint32_t j = i;
+        while (j > 0 && graph->resources[indices[j - 1]].requirements.size < graph->resources[index].requirements.size) {
+            indices[j] = indices[j - 1];
+            --j;
+        }
+        indices[j] = index;
+    }
+
+    combined->size = 0;
+    combined->alignment = 1;
+    combined->memoryTypeBits = UINT32_MAX;
+    for (uint32_t i = 0; i < count; ++i) {
+        RenderGraphResource *resource = &graph->resources[indices[i]];
+        VkDeviceSize alignment = resource->requirements.alignment;
+
+        // Candidate offsets are the start of the heap and the end of every conflicting placement
+        VkDeviceSize best = UINT64_MAX;
+        for (uint32_t c = 0; c <= i; ++c) {
+            VkDeviceSize candidate = 0;
+            if (c < i) {
+                RenderGraphResource *placed = &graph->resources[indices[c]];
+                if (!is_lifetime_overlapping(resource, placed)) { continue; }
+                candidate = placed->memory_offset + placed->requirements.size;
+            }
+            candidate = (candidate + alignment - 1) & ~(alignment - 1);
+            if (candidate >= best) { continue; }
+
+            bool fits = true;
+            resource->memory_offset = candidate;
+            for (uint32_t k = 0; k < i && fits; ++k) {
+                RenderGraphResource *placed = &graph->resources[indices[k]];
+                fits = !is_lifetime_overlapping(resource, placed) || !is_memory_overlapping(resource, placed);
+            }
+            if (fits) {
+                best = candidate;
+            }
+        }
+
+        resource->memory_offset = best;
+        if (best + resource->requirements.size > combined->size) {
+            combined->size = best + resource->requirements.size;
+        }
+        if (alignment > combined->alignment) {
+            combined->alignment = alignment;
+        }
+        combined->memoryTypeBits &= resource->requirements.memoryTypeBits;
+        graph->transient_bytes += resource->requirements.size;
+    }
+
+    // The previous occupant of a resource's bytes, its last use must finish before the first write
+    for (uint32_t i = 0; i < count; ++i) {
+        RenderGraphResource *resource = &graph->resources[indices[i]];
+        uint32_t latest_before = GRAPH_RESOURCE_NONE;
+        uint32_t latest_overall = indices[i];
+        for (uint32_t k = 0; k < count; ++k) {
+            RenderGraphResource *other = &graph->resources[indices[k]];
+            if (k == i || !is_memory_overlapping(resource, other)) { continue; }
+
+            if (other->last_pass < resource->first_pass
+                && (latest_before == GRAPH_RESOURCE_NONE || other->last_pass > graph->resources[latest_before].last_pass)) {
+                latest_before = indices[k];
+            }
+            if (other->last_pass > graph->resources[latest_overall].last_pass) {
+                latest_overall = indices[k];
+            }
+        }
+
+        // Without one in this frame the previous frame's last occupant wrote these bytes
+        resource->alias_predecessor = latest_before != GRAPH_RESOURCE_NONE ? latest_before : latest_overall;
+    }
+
+    return combined->size;
+}
+
+static bool create_transient_resource(RenderGraph *graph, RenderGraphResource *resource) {
+    if (resource->type == GRAPH_RESOURCE_BUFFER) {
+        VkBufferCreateInfo create_info;
+        create_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        create_info.pNext = NULL;
+        create_info.flags = 0;
+        create_info.size = resource->size;
+        create_info.usage = resource->buffer_usage;
+        create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        create_info.queueFamilyIndexCount = 0;
+        create_info.pQueueFamilyIndices = NULL;
+        if (vkCreateBuffer(graph->device, &create_info, get_host_allocator(), &resource->buffer) != VK_SUCCESS) {
+            fprintf(stderr, "failed to create transient buffer %s\n", resource->name);
+            return false;
+        }
+        vkGetBufferMemoryRequirements(graph->device, resource->buffer, &resource->requirements);
+        return true;
+    }
+
+    VkImageCreateInfo create_info;
+    create_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    create_info.pNext = NULL;
+    create_info.flags = 0;
+    create_info.imageType = VK_IMAGE_TYPE_2D;
+    create_info.format = resource->image_desc.format;
+    create_info.extent.width = resource->image_desc.extent.width;
+    create_info.extent.height = resource->image_desc.extent.height;
+    create_info.extent.depth = 1;
+    create_info.mipLevels = 1;
+    create_info.arrayLayers = 1;
+    create_info.samples = resource->image_desc.samples;
+    create_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+    create_info.usage = resource->image_usage;
+    create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    create_info.queueFamilyIndexCount = 0;
+    create_info.pQueueFamilyIndices = NULL;
+    create_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    if (vkCreateImage(graph->device, &create_info, get_host_allocator(), &resource->image) != VK_SUCCESS) {
+        fprintf(stderr, "failed to create transient image %s\n", resource->name);
+        return false;
+    }
+    vkGetImageMemoryRequirements(graph->device, resource->image, &resource->requirements);
+    return true;
+}
+
+static bool create_transient_view(RenderGraph *graph, RenderGraphResource *resource) {
+    VkImageViewCreateInfo create_info;
+    create_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    create_info.pNext = NULL;
+    create_info.flags = 0;
+    create_info.image = resource->image;
+    create_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    create_info.format = resource->image_desc.format;
+    create_info.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
+    create_info.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
+    create_info.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
+    create_info.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
+    create_info.subresourceRange.aspectMask = resource->aspect;
+    create_info.subresourceRange.baseMipLevel = 0;
+    create_info.subresourceRange.levelCount = 1;
+    create_info.subresourceRange.baseArrayLayer = 0;
+    create_info.subresourceRange.layerCount = 1;
+    if (vkCreateImageView(graph->device, &create_info, get_host_allocator(), &resource->view) != VK_SUCCESS) {
+        fprintf(stderr, "failed to create transient image view %s\n", resource->name);
+        return false;
+    }
+    return true;
+}
+
+// Images and buffers get separate heaps, which keeps bufferImageGranularity out of the packing
+static bool allocate_transient_heap(RenderGraph *graph, GraphResourceType type, GpuAllocation *allocation) {
+    uint32_t indices[MAX_GRAPH_RESOURCES];
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < graph->resource_count; ++i) {
+        RenderGraphResource *resource = &graph->resources[i];
+        if (resource->type != type || resource->imported || resource->first_pass == GRAPH_RESOURCE_NONE) { continue; }
+
+        if (!create_transient_resource(graph, resource)) { return false; }
+        indices[count++] = i;
+    }
+    if (count == 0) { return true; }
+
+    VkMemoryRequirements combined;
+    place_transient_resources(graph, indices, count, &combined);
+    if (combined.memoryTypeBits == 0) {
+        fprintf(stderr, "transient resources share no memory type\n");
+        return false;
+    }
+
+    GpuResourceKind kind = type == GRAPH_RESOURCE_IMAGE ? GPU_RESOURCE_OPTIMAL : GPU_RESOURCE_LINEAR;
+    if (!allocate_gpu_memory(graph->allocator, &combined, GPU_MEMORY_GPU_ONLY, kind, allocation)) {
+        fprintf(stderr, "failed to allocate transient memory\n");
+        return false;
+    }
+    graph->aliased_bytes += combined.size;
+
+    for (uint32_t i = 0; i < count; ++i) {
+        RenderGraphResource *resource = &graph->resources[indices[i]];
+        VkDeviceSize offset = allocation->offset + resource->memory_offset;
+        if (type == GRAPH_RESOURCE_BUFFER) {
+            vkBindBufferMemory(graph->device, resource->buffer, allocation->memory, offset);
+        } else {
+            vkBindImageMemory(graph->device, resource->image, allocation->memory, offset);
+            if (!create_transient_view(graph, resource)) { return false; }
+        }
+    }
+    return true;
+}
+
+static GraphBarrier *push_graph_barrier(RenderGraph *graph, uint32_t resource) {
+    GraphBarrier *barrier = &graph->barriers[graph->barrier_count++];
+    memset(barrier, 0, sizeof(GraphBarrier));
+    barrier->resource = resource;
+    return barrier;
+}
+
+static void init_resource_state(const RenderGraphResource *resource, GraphResourceState *state) {
+    memset(state, 0, sizeof(GraphResourceState));
+    state->layout = resource->imported ? resource->initial_layout : VK_IMAGE_LAYOUT_UNDEFINED;
+    state->write_stage = resource->imported ? resource->initial_stage : 0;
+    state->first_barrier = GRAPH_RESOURCE_NONE;
+}
+
+// Emits a barrier only for layout changes, read after write and write after anything
+static void generate_use_barrier(RenderGraph *graph, RenderGraphPass *pass, GraphResourceUse *use, GraphResourceState *state) {
+    RenderGraphResource *resource = &graph->resources[use->resource];
+    GraphAccessInfo info = get_access_info(use->access, pass->type);
+    bool is_image = resource->type == GRAPH_RESOURCE_IMAGE;
+
+    // Attachments that do not load their contents can discard them in the transition
+    VkImageLayout old_layout = state->layout;
+    if (is_attachment_access(use->access) && use->load_op != VK_ATTACHMENT_LOAD_OP_LOAD) {
+        old_layout = VK_IMAGE_LAYOUT_UNDEFINED;
+    }
+
+    bool first_use = state->first_barrier == GRAPH_RESOURCE_NONE;
+    bool transient_first_use = first_use && !resource->imported;
+    bool layout_change = is_image && old_layout != info.layout;
+    bool hazard;
+    if (info.write) {
+        hazard = (state->write_stage | state->read_stages) != 0;
+    } else {
+        hazard = state->write_access != 0
+            && ((info.stage & ~state->visible_stages) != 0 || (info.access & ~state->visible_access) != 0);
+    }
+
+    if (layout_change || hazard || transient_first_use) {
+        GraphBarrier *barrier = push_graph_barrier(graph, use->resource);
+        barrier->src_stage = state->write_stage | (info.write || layout_change ? state->read_stages : 0);
+        barrier->src_access = state->write_access;
+        barrier->dst_stage = info.stage;
+        barrier->dst_access = info.access;
+        barrier->old_layout = is_image ? old_layout : VK_IMAGE_LAYOUT_UNDEFINED;
+        barrier->new_layout = is_image ? info.layout : VK_IMAGE_LAYOUT_UNDEFINED;
+        ++pass->barrier_count;
+
+        if (first_use) {
+            state->first_barrier = graph->barrier_count - 1;
+        }
+        state->visible_stages = info.stage;
+        state->visible_access = info.access;
+    } else if (first_use) {
+        state->first_barrier = graph->barrier_count;
+    }
+
+    state->layout = info.layout;
+    if (info.write) {
+        state->write_stage = info.stage;
+        state->write_access = info.access & (VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT
+            | VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT);
+        state->read_stages = 0;
+        state->visible_stages = info.stage;
+        state->visible_access = info.access;
+    } else {
+        state->read_stages |= info.stage;
+    }
+}
+
+static bool generate_graph_barriers(RenderGraph *graph) {
+    GraphResourceState states[MAX_GRAPH_RESOURCES];
+    for (uint32_t i = 0; i < graph->resource_count; ++i) {
+        init_resource_state(&graph->resources[i], &states[i]);
+    }
+
+    for (uint32_t p = 0; p < graph->pass_count; ++p) {
+        RenderGraphPass *pass = &graph->passes[p];
+        pass->barrier_start = graph->barrier_count;
+        pass->barrier_count = 0;
+        if (!pass->live) { continue; }
+
+        for (uint32_t i = 0; i < pass->use_count; ++i) {
+            generate_use_barrier(graph, pass, &pass->uses[i], &states[pass->uses[i].resource]);
+        }
+    }
+
+    // The first write into aliased bytes waits on whatever last used them, in this frame or the previous one
+    for (uint32_t i = 0; i < graph->resource_count; ++i) {
+        RenderGraphResource *resource = &graph->resources[i];
+        if (resource->imported || resource->alias_predecessor == GRAPH_RESOURCE_NONE) { continue; }
+        if (states[i].first_barrier >= graph->barrier_count) { continue; }
+
+        GraphResourceState *predecessor = &states[resource->alias_predecessor];
+        GraphBarrier *barrier = &graph->barriers[states[i].first_barrier];
+        barrier->src_stage |= predecessor->write_stage | predecessor->read_stages;
+        barrier->src_access |= predecessor->write_access;
+    }
+
+    // Imported images leave in the layout their owner expects
+    graph->final_barrier_start = graph->barrier_count;
+    for (uint32_t i = 0; i < graph->resource_count; ++i) {
+        RenderGraphResource *resource = &graph->resources[i];
+        GraphResourceState *state = &states[i];
+        if (!resource->imported || resource->type != GRAPH_RESOURCE_IMAGE || resource->first_pass == GRAPH_RESOURCE_NONE) { continue; }
+        if (resource->final_layout == VK_IMAGE_LAYOUT_UNDEFINED || resource->final_layout == state->layout) { continue; }
+
+        // Presentation is ordered by the semaphore, anything else may be read by any later command
+        bool present = resource->final_layout == VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+        GraphBarrier *barrier = push_graph_barrier(graph, i);
+        barrier->src_stage = state->write_stage | state->read_stages;
+        barrier->src_access = state->write_access;
+        barrier->dst_stage = present ? VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT : VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+        barrier->dst_access = present ? 0 : VK_ACCESS_MEMORY_READ_BIT;
+        barrier->old_layout = state->layout;
+        barrier->new_layout = resource->final_layout;
+    }
+    graph->final_barrier_count = graph->barrier_count - graph->final_barrier_start;
+    return true;
+}
+
+// One single-subpass render pass per graphics pass, barriers outside it do every layout transition
+static bool create_graph_render_pass(RenderGraph *graph, RenderGraphPass *pass) {
+    VkAttachmentDescription attachments[MAX_PASS_ATTACHMENTS];
+    VkAttachmentReference color_refs[MAX_PASS_ATTACHMENTS];
+    VkAttachmentReference depth_ref;
+    uint32_t color_count = 0;
+    bool has_depth = false;
+
+    // Colors first, depth last, framebuffers follow the same order
+    pass->attachment_count = 0;
+    for (uint32_t depth_pass = 0; depth_pass < 2; ++depth_pass) {
+        for (uint32_t i = 0; i < pass->use_count; ++i) {
+            GraphResourceUse *use = &pass->uses[i];
+            if (!is_attachment_access(use->access)) { continue; }
+
+            bool is_depth = use->access != GRAPH_ACCESS_COLOR_ATTACHMENT;
+            if (is_depth != (depth_pass == 1)) { continue; }
+            if (pass->attachment_count >= MAX_PASS_ATTACHMENTS || (is_depth && has_depth)) {
+                fprintf(stderr, "too many attachments in pass %s\n", pass->name);
+                return false;
+            }
+
+            RenderGraphResource *resource = &graph->resources[use->resource];
+            GraphAccessInfo info = get_access_info(use->access, pass->type);
+            uint32_t index = pass->attachment_count++;
+
+            VkAttachmentDescription *attachment = &attachments[index];
+            attachment->flags = 0;
+            attachment->format = resource->image_desc.format;
+            attachment->samples = resource->image_desc.samples;
+            attachment->loadOp = use->load_op;
+            attachment->storeOp = use->store_op;
+            attachment->stencilLoadOp = has_stencil(resource->image_desc.format) ? use->load_op : VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+            attachment->stencilStoreOp = has_stencil(resource->image_desc.format) ? use->store_op : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+            attachment->initialLayout = info.layout;
+            attachment->finalLayout = info.layout;
+
+            pass->attachment_uses[index] = i;
+            pass->clear_values[index] = use->clear_value;
+            pass->extent = resource->image_desc.extent;
+            if (is_depth) {
+                depth_ref.attachment = index;
+                depth_ref.layout = info.layout;
+                has_depth = true;
+            } else {
+                color_refs[color_count].attachment = index;
+                color_refs[color_count].layout = info.layout;
+                ++color_count;
+            }
+        }
+    }
+    if (pass->attachment_count == 0) { return true; }
+
+    VkSubpassDescription subpass;
+    subpass.flags = 0;
+    subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    subpass.inputAttachmentCount = 0;
+    subpass.pInputAttachments = NULL;
+    subpass.colorAttachmentCount = color_count;
+    subpass.pColorAttachments = color_refs;
+    subpass.pResolveAttachments = NULL;
+    subpass.pDepthStencilAttachment = has_depth ? &depth_ref : NULL;
+    subpass.preserveAttachmentCount = 0;
+    subpass.pPreserveAttachments = NULL;
+
+    VkRenderPassCreateInfo create_info;
+    create_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+    create_info.pNext = NULL;
+    create_info.flags = 0;
+    create_info.attachmentCount = pass->attachment_count;
+    create_info.pAttachments = attachments;
+    create_info.subpassCount = 1;
+    create_info.pSubpasses = &subpass;
+    create_info.dependencyCount = 0;
+    create_info.pDependencies = NULL;
+    if (vkCreateRenderPass(graph->device, &create_info, get_host_allocator(), &pass->render_pass) != VK_SUCCESS) {
+        fprintf(stderr, "failed to create render pass for %s\n", pass->name);
+        return false;
+    }
+    return true;
+}
+
+bool compile_render_graph(RenderGraph *graph) {
+    if (graph->compiled) { return true; }
+
+    cull_graph_passes(graph);
+    gather_resource_usage(graph);
+    select_attachment_ops(graph);
+
+    if (!allocate_transient_heap(graph, GRAPH_RESOURCE_IMAGE, &graph->image_memory)
+        || !allocate_transient_heap(graph, GRAPH_RESOURCE_BUFFER, &graph->buffer_memory)) {
+        return false;
+    }
+
+    if (!generate_graph_barriers(graph)) { return false; }
+
+    for (uint32_t p = 0; p < graph->pass_count; ++p) {
+        RenderGraphPass *pass = &graph->passes[p];
+        if (!pass->live || pass->type != GRAPH_PASS_GRAPHICS) { continue; }
+        if (!create_graph_render_pass(graph, pass)) { return false; }
+    }
+
+    graph->compiled = true;
+    return true;
+}
+
+/*
+* Execution
+*/
+static void record_graph_barriers(RenderGraph *graph, VkCommandBuffer command_buffer, uint32_t start, uint32_t count) {
+    if (count == 0) { return; }
+
+    VkImageMemoryBarrier image_barriers[MAX_PASS_RESOURCES + MAX_GRAPH_RESOURCES];
+    VkBufferMemoryBarrier buffer_barriers[MAX_PASS_RESOURCES + MAX_GRAPH_RESOURCES];
+    uint32_t image_count = 0;
+    uint32_t buffer_count = 0;
+    VkPipelineStageFlags src_stage = 0;
+    VkPipelineStageFlags dst_stage = 0;
+
+    for (uint32_t i = start; i < start + count; ++i) {
+        GraphBarrier *barrier = &graph->barriers[i];
+        RenderGraphResource *resource = &graph->resources[barrier->resource];
+        src_stage |= barrier->src_stage;
+        dst_stage |= barrier->dst_stage;
+
+        if (resource->type == GRAPH_RESOURCE_BUFFER) {
+            VkBufferMemoryBarrier *buffer_barrier = &buffer_barriers[buffer_count++];
+            buffer_barrier->sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+            buffer_barrier->pNext = NULL;
+            buffer_barrier->srcAccessMask = barrier->src_access;
+            buffer_barrier->dstAccessMask = barrier->dst_access;
+            buffer_barrier->srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            buffer_barrier->dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            buffer_barrier->buffer = resource->buffer;
+            buffer_barrier->offset = 0;
+            buffer_barrier->size = VK_WHOLE_SIZE;
+            continue;
+        }
+
+        VkImageMemoryBarrier *image_barrier = &image_barriers[image_count++];
+        image_barrier->sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        image_barrier->pNext = NULL;
+        image_barrier->srcAccessMask = barrier->src_access;
+        image_barrier->dstAccessMask = barrier->dst_access;
+        image_barrier->oldLayout = barrier->old_layout;
+        image_barrier->newLayout = barrier->new_layout;
+        image_barrier->srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        image_barrier->dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        image_barrier->image = resource->image;
+        image_barrier->subresourceRange.aspectMask = resource->aspect;
+        image_barrier->subresourceRange.baseMipLevel = 0;
+        image_barrier->subresourceRange.levelCount = VK_REMAINING_MIP_LEVELS;
+        image_barrier->subresourceRange.baseArrayLayer = 0;
+        image_barrier->subresourceRange.layerCount = VK_REMAINING_ARRAY_LAYERS;
+    }
+
+    // Nothing to wait on yet, e.g. the first use of a fresh transient
+    if (src_stage == 0) {
+        src_stage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+    }
+
+    vkCmdPipelineBarrier(command_buffer, src_stage, dst_stage, 0, 0, NULL,
+        buffer_count, buffer_barriers, image_count, image_barriers);
+}
+
+static VkFramebuffer get_graph_framebuffer(RenderGraph *graph, RenderGraphPass *pass) {
+    VkImageView views[MAX_PASS_ATTACHMENTS];
+    for (uint32_t i = 0; i < pass->attachment_count; ++i) {
+        views[i] = graph->resources[pass->uses[pass->attachment_uses[i]].resource].view;
+    }
+
+    for (uint32_t i = 0; i < pass->framebuffer_count; ++i) {
+        if (memcmp(pass->framebuffers[i].views, views, sizeof(VkImageView) * pass->attachment_count) == 0) {
+            return pass->framebuffers[i].framebuffer;
+        }
+    }
+
+    // Framebuffers may still be in flight, so the cache only grows until the graph is destroyed
+    if (pass->framebuffer_count >= MAX_GRAPH_FRAMEBUFFERS) {
+        fprintf(stderr, "too many framebuffers for pass %s\n", pass->name);
+        return VK_NULL_HANDLE;
+    }
+
+    VkFramebufferCreateInfo create_info;
+    create_info.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+    create_info.pNext = NULL;
+    create_info.flags = 0;
+    create_info.renderPass = pass->render_pass;
+    create_info.attachmentCount = pass->attachment_count;
+    create_info.pAttachments = views;
+    create_info.width = pass->extent.width;
+    create_info.height = pass->extent.height;
+    create_info.layers = 1;
+
+    GraphFramebuffer *cached = &pass->framebuffers[pass->framebuffer_count];
+    if (vkCreateFramebuffer(graph->device, &create_info, get_host_allocator(), &cached->framebuffer) != VK_SUCCESS) {
+        fprintf(stderr, "failed to create framebuffer for pass %s\n", pass->name);
+        return VK_NULL_HANDLE;
+    }
+    memcpy(cached->views, views, sizeof(VkImageView) * pass->attachment_count);
+    ++pass->framebuffer_count;
+    return cached->framebuffer;
+}
+
+bool execute_render_graph(RenderGraph *graph, VkCommandBuffer command_buffer) {
+    if (!graph->compiled) {
+        fprintf(stderr, "render graph executed before compiling\n");
+        return false;
+    }
+
+    for (uint32_t p = 0; p < graph->pass_count; ++p) {
+        RenderGraphPass *pass = &graph->passes[p];
+        if (!pass->live) { continue; }
+
+        record_graph_barriers(graph, command_buffer, pass->barrier_start, pass->barrier_count);
+        if (pass->render_pass == VK_NULL_HANDLE) {
+            if (!pass->callback(command_buffer, pass, pass->user_data)) { return false; }
+            continue;
+        }
+
+        pass->framebuffer = get_graph_framebuffer(graph, pass);
+        if (pass->framebuffer == VK_NULL_HANDLE) { return false; }
+
+        VkRenderPassBeginInfo begin_info;
+        begin_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+        begin_info.pNext = NULL;
+        begin_info.renderPass = pass->render_pass;
+        begin_info.framebuffer = pass->framebuffer;
+        begin_info.renderArea.offset = (VkOffset2D){0, 0};
+        begin_info.renderArea.extent = pass->extent;
+        begin_info.clearValueCount = pass->attachment_count;
+        begin_info.pClearValues = pass->clear_values;
+
+        vkCmdBeginRenderPass(command_buffer, &begin_info, pass->contents);
+        bool recorded = pass->callback(command_buffer, pass, pass->user_data);
+        vkCmdEndRenderPass(command_buffer);
+        if (!recorded) { return false; }
+    }
+
+    record_graph_barriers(graph, command_buffer, graph->final_barrier_start, graph->final_barrier_count);
+    return true;
+}
+
+VkRenderPass get_graph_pass_render_pass(RenderGraph *graph, uint32_t pass) {
+    return graph->passes[pass].render_pass;
+}
+
+// Secondaries recorded for a pass continue its render pass and framebuffer
+void get_graph_pass_inheritance(const RenderGraphPass *pass, VkCommandBufferInheritanceInfo *inheritance) {
+    inheritance->sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+    inheritance->pNext = NULL;
+    inheritance->renderPass = pass->render_pass;
+    inheritance->subpass = 0;
+    inheritance->framebuffer = pass->framebuffer;
+    inheritance->occlusionQueryEnable = VK_FALSE;
+    inheritance->queryFlags = 0;
+    inheritance->pipelineStatistics = 0;
+}
+
+static const char *get_load_op_name(VkAttachmentLoadOp load_op) {
+    switch (load_op) {
+        case VK_ATTACHMENT_LOAD_OP_LOAD: return "load";
+        case VK_ATTACHMENT_LOAD_OP_CLEAR: return "clear";
+        default: return "dont_care";
+    }
+}
+
+void print_render_graph(RenderGraph *graph) {
+    for (uint32_t p = 0; p < graph->pass_count; ++p) {
+        RenderGraphPass *pass = &graph->passes[p];
+        if (!pass->live) {
+            printf("[GRAPH] %s culled\n", pass->name);
+            continue;
+        }
+
+        printf("[GRAPH] %s: %u barriers", pass->name, pass->barrier_count);
+        for (uint32_t i = 0; i < pass->attachment_count; ++i) {
+            GraphResourceUse *use = &pass->uses[pass->attachment_uses[i]];
+            printf(", %s %s/%s", graph->resources[use->resource].name, get_load_op_name(use->load_op),
+                use->store_op == VK_ATTACHMENT_STORE_OP_STORE ? "store" : "dont_care");
+        }
+        printf("\n");
+    }
+
+    printf("[GRAPH] transient memory %.2f MiB aliased into %.2f MiB, %u final barriers\n",
+        graph->transient_bytes / (1024.0 * 1024.0), graph->aliased_bytes / (1024.0 * 1024.0), graph->final_barrier_count);
+}
+
+/*
+* Cleanup
+*/
+void destroy_render_graph(RenderGraph *graph) {
+    VkDevice device = graph->device;
+    for (uint32_t p = 0; p < graph->pass_count; ++p) {
+        RenderGraphPass *pass = &graph->passes[p];
+        for (uint32_t i = 0; i < pass->framebuffer_count; ++i) {
+            vkDestroyFramebuffer(device, pass->framebuffers[i].framebuffer, get_host_allocator());
+        }
+        if (pass->render_pass != VK_NULL_HANDLE) {
+            vkDestroyRenderPass(device, pass->render_pass, get_host_allocator());
+        }
+    }
+
+    for (uint32_t i = 0; i < graph->resource_count; ++i) {
+        RenderGraphResource *resource = &graph->resources[i];
+        if (resource->imported) { continue; }
+
+        if (resource->view != VK_NULL_HANDLE) {
+            vkDestroyImageView(device, resource->view, get_host_allocator());
+        }
+        if (resource->image != VK_NULL_HANDLE) {
+            vkDestroyImage(device, resource->image, get_host_allocator());
+        }
+        if (resource->buffer != VK_NULL_HANDLE) {
+            vkDestroyBuffer(device, resource->buffer, get_host_allocator());
+        }
+    }
+
+    if (graph->image_memory.memory != VK_NULL_HANDLE) {
+        free_gpu_memory(graph->allocator, &graph->image_memory);
+    }
+    if (graph->buffer_memory.memory != VK_NULL_HANDLE) {
+        free_gpu_memory(graph->allocator, &graph->buffer_memory);
+    }
+    free(graph);
+}
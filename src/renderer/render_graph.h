@@ -0,0 +1,200 @@
+#ifndef RENDER_GRAPH_H
+#define RENDER_GRAPH_H
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "gpu_allocator.h"
+#include "host_allocator.h"
+
+#define MAX_GRAPH_PASSES 32
+#define MAX_GRAPH_RESOURCES 32
+#define MAX_PASS_RESOURCES 8
+#define MAX_PASS_ATTACHMENTS 5 // four color and one depth
+#define MAX_GRAPH_BARRIERS (MAX_GRAPH_PASSES * MAX_PASS_RESOURCES + MAX_GRAPH_RESOURCES)
+
+// Imported images change per frame, e.g. swapchain images, each distinct view set needs a framebuffer
+#define MAX_GRAPH_FRAMEBUFFERS 8
+
+#define GRAPH_RESOURCE_NONE UINT32_MAX
+
+typedef enum {
+    GRAPH_PASS_GRAPHICS,
+    GRAPH_PASS_COMPUTE,
+    GRAPH_PASS_TRANSFER
+} GraphPassType;
+
+typedef enum {
+    GRAPH_RESOURCE_IMAGE,
+    GRAPH_RESOURCE_BUFFER
+} GraphResourceType;
+
+// How a pass touches a resource, the graph derives stages, access masks and layouts from this
+typedef enum {
+    GRAPH_ACCESS_COLOR_ATTACHMENT,
+    GRAPH_ACCESS_DEPTH_ATTACHMENT,
+    GRAPH_ACCESS_DEPTH_READ,
+    GRAPH_ACCESS_SAMPLED,
+    GRAPH_ACCESS_STORAGE_READ,
+    GRAPH_ACCESS_STORAGE_WRITE,
+    GRAPH_ACCESS_TRANSFER_SRC,
+    GRAPH_ACCESS_TRANSFER_DST,
+    GRAPH_ACCESS_INDIRECT,
+    GRAPH_ACCESS_VERTEX,
+    GRAPH_ACCESS_INDEX,
+    GRAPH_ACCESS_UNIFORM,
+    GRAPH_ACCESS_COUNT
+} GraphAccess;
+
+typedef struct {
+    VkFormat format;
+    VkExtent2D extent;
+    VkSampleCountFlagBits samples;
+} GraphImageDesc;
+
+// Images owned outside the graph, the handles may be swapped every frame with set_graph_image
+typedef struct {
+    VkImage image;
+    VkImageView view;
+    VkFormat format;
+    VkExtent2D extent;
+    VkImageLayout initial_layout;
+    VkPipelineStageFlags initial_stage; // e.g. the stage the acquire semaphore is waited at
+    VkImageLayout final_layout;
+} GraphImageImport;
+
+typedef struct {
+    const char *name;
+    GraphResourceType type;
+    bool imported;
+
+    // Images
+    GraphImageDesc image_desc;
+    VkImageAspectFlags aspect;
+    VkImageUsageFlags image_usage;
+    VkImage image;
+    VkImageView view;
+    VkImageLayout initial_layout;
+    VkPipelineStageFlags initial_stage;
+    VkImageLayout final_layout;
+
+    // Buffers
+    VkDeviceSize size;
+    VkBufferUsageFlags buffer_usage;
+    VkBuffer buffer;
+
+    // Compiled, lifetime over live passes and placement in the shared transient memory
+    uint32_t first_pass;
+    uint32_t last_pass;
+    VkMemoryRequirements requirements;
+    VkDeviceSize memory_offset;
+    uint32_t alias_predecessor;
+} RenderGraphResource;
+
+typedef struct {
+    uint32_t resource;
+    GraphAccess access;
+    bool clear;
+    VkClearValue clear_value;
+    VkAttachmentLoadOp load_op;
+    VkAttachmentStoreOp store_op;
+} GraphResourceUse;
+
+typedef struct {
+    VkImageView views[MAX_PASS_ATTACHMENTS];
+    VkFramebuffer framebuffer;
+} GraphFramebuffer;
+
+struct RenderGraphPass;
+typedef bool (*GraphPassCallback)(VkCommandBuffer command_buffer, const struct RenderGraphPass *pass, void *user_data);
+
+typedef struct RenderGraphPass {
+    const char *name;
+    GraphPassType type;
+    GraphPassCallback callback;
+    void *user_data;
+    bool side_effects;
+    VkSubpassContents contents; // secondary passes may only record vkCmdExecuteCommands
+    uint32_t use_count;
+    GraphResourceUse uses[MAX_PASS_RESOURCES];
+
+    // Compiled
+    bool live;
+    VkExtent2D extent;
+    VkRenderPass render_pass;
+    VkFramebuffer framebuffer; // bound while the callback records
+    uint32_t attachment_count;
+    uint32_t attachment_uses[MAX_PASS_ATTACHMENTS];
+    VkClearValue clear_values[MAX_PASS_ATTACHMENTS];
+    uint32_t barrier_start;
+    uint32_t barrier_count;
+    uint32_t framebuffer_count;
+    GraphFramebuffer framebuffers[MAX_GRAPH_FRAMEBUFFERS];
+} RenderGraphPass;
+
+typedef struct {
+    uint32_t resource;
+    VkPipelineStageFlags src_stage;
+    VkPipelineStageFlags dst_stage;
+    VkAccessFlags src_access;
+    VkAccessFlags dst_access;
+    VkImageLayout old_layout;
+    VkImageLayout new_layout;
+} GraphBarrier;
+
+// Declared once, compiled once, executed every frame with the current imported handles
+typedef struct {
+    VkDevice device;
+    GpuAllocator *allocator;
+    bool compiled;
+    uint32_t pass_count;
+    RenderGraphPass passes[MAX_GRAPH_PASSES];
+    uint32_t resource_count;
+    RenderGraphResource resources[MAX_GRAPH_RESOURCES];
+    uint32_t barrier_count;
+    GraphBarrier barriers[MAX_GRAPH_BARRIERS];
+    uint32_t final_barrier_start;
+    uint32_t final_barrier_count;
+    GpuAllocation image_memory;
+    GpuAllocation buffer_memory;
+    VkDeviceSize transient_bytes;
+    VkDeviceSize aliased_bytes;
+} RenderGraph;
+
+// Graph creation
+RenderGraph *create_render_graph(VkDevice device, GpuAllocator *allocator);
+
+// Resources
+uint32_t import_graph_image(RenderGraph *graph, const char *name, const GraphImageImport *import);
+uint32_t import_graph_buffer(RenderGraph *graph, const char *name, VkBuffer buffer, VkDeviceSize size);
+uint32_t create_graph_image(RenderGraph *graph, const char *name, const GraphImageDesc *desc);
+uint32_t create_graph_buffer(RenderGraph *graph, const char *name, VkDeviceSize size);
+void set_graph_image(RenderGraph *graph, uint32_t resource, VkImage image, VkImageView view);
+void set_graph_buffer(RenderGraph *graph, uint32_t resource, VkBuffer buffer);
+VkImageView get_graph_image_view(RenderGraph *graph, uint32_t resource);
+VkBuffer get_graph_buffer(RenderGraph *graph, uint32_t resource);
+
+// Passes
+uint32_t add_graph_pass(RenderGraph *graph, const char *name, GraphPassType type, GraphPassCallback callback, void *user_data);
+bool use_graph_resource(RenderGraph *graph, uint32_t pass, uint32_t resource, GraphAccess access);
+bool clear_graph_attachment(RenderGraph *graph, uint32_t pass, uint32_t resource, VkClearValue clear_value);
+void set_graph_pass_side_effects(RenderGraph *graph, uint32_t pass);
+void set_graph_pass_secondary(RenderGraph *graph, uint32_t pass);
+
+// Compilation and execution
+bool compile_render_graph(RenderGraph *graph);
+bool execute_render_graph(RenderGraph *graph, VkCommandBuffer command_buffer);
+VkRenderPass get_graph_pass_render_pass(RenderGraph *graph, uint32_t pass);
+void get_graph_pass_inheritance(const RenderGraphPass *pass, VkCommandBufferInheritanceInfo *inheritance);
+void print_render_graph(RenderGraph *graph);
+
+// Cleanup
+void destroy_render_graph(RenderGraph *graph);
+
+#endif
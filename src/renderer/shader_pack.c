@@ -0,0 +1,96 @@
+#include "shader_pack.h"
+
+/*
+* Shader pack creation
+*/
+ShaderPack *open_shader_pack(const char *path) {
+    MappedFile *file = map_file(path);
+    if (file == NULL) { return NULL; }
+
+    const ShaderPackHeader *header = file->data;
+    if (file->size < sizeof(ShaderPackHeader)
+        || header->magic != SHADER_PACK_MAGIC
+        || header->version != SHADER_PACK_VERSION) {
+        fprintf(stderr, "invalid shader pack: %s\n", path);
+        unmap_file(file);
+        return NULL;
+    }
+
+    // Validate every entry once so lookups can trust offsets and names
+    size_t table_end = sizeof(ShaderPackHeader) + (size_t)header->entry_count * sizeof(ShaderPackEntry);
+    const ShaderPackEntry *entries = (const ShaderPackEntry *)(header + 1);
+    bool valid = table_end <= file->size;
+    for (uint32_t i = 0; valid && i < header->entry_count; ++i) {
+        valid = memchr(entries[i].name, '\0', SHADER_PACK_NAME_MAX) != NULL
+            && entries[i].offset >= table_end
+            && entries[i].offset <= file->size
+            && entries[i].offset % sizeof(uint32_t) == 0
+            && entries[i].size % sizeof(uint32_t) == 0
+            && entries[i].size <= file->size - entries[i].offset;
+    }
+
+    if (!valid) {
+        fprintf(stderr, "corrupt shader pack: %s\n", path);
+        unmap_file(file);
+        return NULL;
+    }
+
+    ShaderPack *pack = malloc(sizeof(ShaderPack));
+    if (pack == NULL) {
+        unmap_file(file);
+        return NULL;
+    }
+
+    pack->file = file;
+    pack->header = header;
+    pack->entries = entries;
+    return pack;
+}
+
+const char *get_shader_pack_path() {
+    const char *path = getenv(SHADER_PACK_PATH_ENV);
+    if (path != NULL && path[0] != '\0') {
+        return path;
+    }
+    return SHADER_PACK_FILE;
+}
+
+/*
+* Lookup
+*/
+bool find_shader_binary(ShaderPack *pack, const char *name, ShaderBinary *binary) {
+    uint64_t hash = hash_shader_name(name);
+
+    // Entries are sorted by (hash, name)
+    uint32_t low = 0;
+    uint32_t high = pack->header->entry_count;
+    while (low < high) {
+        uint32_t mid = low + (high - low) / 2;
+        const ShaderPackEntry *entry = &pack->entries[mid];
+
+        int order = compare_shader_pack_entries(entry->name_hash, entry->name, hash, name);
+        if (order == 0) {
+            binary->name = entry->name;
+            binary->code = (const uint32_t *)((const uint8_t *)pack->file->data + entry->offset);
+            binary->size = entry->size;
+            return true;
+        }
+
+        if (order < 0) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    fprintf(stderr, "shader not found in pack: %s\n", name);
+    return false;
+}
+
+/*
+* Cleanup
+*/
+void close_shader_pack(ShaderPack *pack) {
+    unmap_file(pack->file);
+    free(pack);
+}
@@ -0,0 +1,38 @@
+#ifndef SHADER_PACK_H
+#define SHADER_PACK_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "config.h"
+#include "mapped_file.h"
+#include "shader_pack_format.h"
+
+#define SHADER_PACK_PATH_ENV "VRENDER_SHADER_PACK"
+
+// SPIR-V words pointing straight into the mapped pack
+typedef struct {
+    const char *name;
+    const uint32_t *code;
+    size_t size;
+} ShaderBinary;
+
+typedef struct {
+    MappedFile *file;
+    const ShaderPackHeader *header;
+    const ShaderPackEntry *entries;
+} ShaderPack;
+
+// Shader pack creation
+ShaderPack *open_shader_pack(const char *path);
+const char *get_shader_pack_path();
+
+// Lookup
+bool find_shader_binary(ShaderPack *pack, const char *name, ShaderBinary *binary);
+
+// Cleanup
+void close_shader_pack(ShaderPack *pack);
+
+#endif
@@ -0,0 +1,48 @@
+#ifndef SHADER_PACK_FORMAT_H
+#define SHADER_PACK_FORMAT_H
+
+// On disk layout shared by the runtime and the packing tool, no Vulkan types
+
+#include <stdint.h>
+#include <string.h>
+
+#define SHADER_PACK_MAGIC 0x4B505356 // "VSPK"
+#define SHADER_PACK_VERSION 1
+#define SHADER_PACK_ALIGNMENT 16
+#define SHADER_PACK_NAME_MAX 64
+
+#define SHADER_PACK_FNV_OFFSET_BASIS 0xcbf29ce484222325ULL
+#define SHADER_PACK_FNV_PRIME 0x100000001b3ULL
+
+// [header][entries sorted by (name_hash, name)][aligned SPIR-V blobs]
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t entry_count;
+    uint32_t alignment;
+} ShaderPackHeader;
+
+typedef struct {
+    uint64_t name_hash;
+    char name[SHADER_PACK_NAME_MAX];
+    uint64_t offset;
+    uint64_t size;
+} ShaderPackEntry;
+
+static inline uint64_t hash_shader_name(const char *name) {
+    uint64_t hash = SHADER_PACK_FNV_OFFSET_BASIS;
+    for (const char *c = name; *c != '\0'; ++c) {
+        hash ^= (uint8_t)*c;
+        hash *= SHADER_PACK_FNV_PRIME;
+    }
+    return hash;
+}
+
+static inline int compare_shader_pack_entries(uint64_t hash_a, const char *name_a, uint64_t hash_b, const char *name_b) {
+    if (hash_a != hash_b) {
+        return hash_a < hash_b ? -1 : 1;
+    }
+    return strncmp(name_a, name_b, SHADER_PACK_NAME_MAX);
+}
+
+#endif
@@ -0,0 +1,678 @@
+#include "spirv_reflect.h"
+
+/*
+* SPIR-V constants, see the SPIR-V specification section 3
+*/
+#define SPV_MAGIC 0x07230203
+#define SPV_HEADER_WORDS 5
+
+#define SPV_OP_ENTRY_POINT 15
+#define SPV_OP_TYPE_BOOL 20
+#define SPV_OP_TYPE_INT 21
+#define SPV_OP_TYPE_FLOAT 22
+#define SPV_OP_TYPE_VECTOR 23
+#define SPV_OP_TYPE_MATRIX 24
+#define SPV_OP_TYPE_IMAGE 25
+#define SPV_OP_TYPE_SAMPLER 26
+#define SPV_OP_TYPE_SAMPLED_IMAGE 27
+#define SPV_OP_TYPE_ARRAY 28
+#define SPV_OP_TYPE_RUNTIME_ARRAY 29
+#define SPV_OP_TYPE_STRUCT 30
+#define SPV_OP_TYPE_POINTER 32
+#define SPV_OP_CONSTANT 43
+#define SPV_OP_SPEC_CONSTANT_TRUE 48
+#define SPV_OP_SPEC_CONSTANT_FALSE 49
+#define SPV_OP_SPEC_CONSTANT 50
+#define SPV_OP_VARIABLE 59
+#define SPV_OP_DECORATE 71
+#define SPV_OP_MEMBER_DECORATE 72
+#define SPV_OP_TYPE_ACCELERATION_STRUCTURE 5341
+
+#define SPV_DECORATION_SPEC_ID 1
+#define SPV_DECORATION_BLOCK 2
+#define SPV_DECORATION_BUFFER_BLOCK 3
+#define SPV_DECORATION_ARRAY_STRIDE 6
+#define SPV_DECORATION_BUILT_IN 11
+#define SPV_DECORATION_LOCATION 30
+#define SPV_DECORATION_BINDING 33
+#define SPV_DECORATION_DESCRIPTOR_SET 34
+#define SPV_DECORATION_OFFSET 35
+
+#define SPV_STORAGE_UNIFORM_CONSTANT 0
+#define SPV_STORAGE_INPUT 1
+#define SPV_STORAGE_UNIFORM 2
+#define SPV_STORAGE_PUSH_CONSTANT 9
+#define SPV_STORAGE_STORAGE_BUFFER 12
+
+#define SPV_DIM_BUFFER 5
+#define SPV_DIM_SUBPASS_DATA 6
+
+#define SPV_EXECUTION_VERTEX 0
+#define SPV_EXECUTION_TESS_CONTROL 1
+#define SPV_EXECUTION_TESS_EVALUATION 2
+#define SPV_EXECUTION_GEOMETRY 3
+#define SPV_EXECUTION_FRAGMENT 4
+#define SPV_EXECUTION_GL_COMPUTE 5
+
+#define ID_HAS_SET (1 << 0)
+#define ID_HAS_BINDING (1 << 1)
+#define ID_HAS_LOCATION (1 << 2)
+#define ID_HAS_SPEC_ID (1 << 3)
+#define ID_BUILT_IN (1 << 4)
+#define ID_BLOCK (1 << 5)
+#define ID_BUFFER_BLOCK (1 << 6)
+
+// Everything we track about one result id
+typedef struct {
+    uint32_t opcode;
+    uint32_t type_id;
+    uint32_t storage_class;
+    uint32_t width;
+    uint32_t count;
+    uint32_t is_signed;
+    uint32_t image_dim;
+    uint32_t image_sampled;
+    uint32_t value;
+
+    uint32_t flags;
+    uint32_t set;
+    uint32_t binding;
+    uint32_t location;
+    uint32_t spec_id;
+    uint32_t array_stride;
+
+    // Structs index into the shared member tables
+    uint32_t member_base;
+    uint32_t member_count;
+} SpirvId;
+
+typedef struct {
+    const uint32_t *words;
+    uint32_t word_count;
+    uint32_t bound;
+    SpirvId *ids;
+    uint32_t *member_types;
+    uint32_t *member_offsets;
+} SpirvModule;
+
+/*
+* Parsing
+*/
+static bool next_instruction(SpirvModule *module, uint32_t *cursor, uint32_t *opcode, const uint32_t **operands, uint32_t *operand_count) {
+    if (*cursor >= module->word_count) { return false; }
+
+    uint32_t word = module->words[*cursor];
+    uint32_t length = word >> 16;
+    if (length == 0 || *cursor + length > module->word_count) { return false; }
+
+    *opcode = word & 0xFFFF;
+    *operands = &module->words[*cursor + 1];
+    *operand_count = length - 1;
+    *cursor += length;
+    return true;
+}
+
+static bool is_valid_id(SpirvModule *module, uint32_t id) {
+    return id < module->bound;
+}
+
+// Pass one records every type, constant and variable definition
+static bool parse_definitions(SpirvModule *module, ShaderReflection *reflection) {
+    uint32_t member_total = 0;
+    uint32_t cursor = SPV_HEADER_WORDS;
+    uint32_t opcode, count;
+    const uint32_t *ops;
+
+    // Count struct members first so their tables can be allocated once
+    while (next_instruction(module, &cursor, &opcode, &ops, &count)) {
+        if (opcode == SPV_OP_TYPE_STRUCT && count >= 1) {
+            member_total += count - 1;
+        }
+    }
+
+    module->member_types = calloc(member_total + 1, sizeof(uint32_t));
+    module->member_offsets = calloc(member_total + 1, sizeof(uint32_t));
+    if (module->member_types == NULL || module->member_offsets == NULL) { return false; }
+
+    uint32_t member_next = 0;
+    cursor = SPV_HEADER_WORDS;
+    while (next_instruction(module, &cursor, &opcode, &ops, &count)) {
+        if (opcode == SPV_OP_ENTRY_POINT && count >= 1) {
+            switch (ops[0]) {
+                case SPV_EXECUTION_VERTEX: reflection->stage = VK_SHADER_STAGE_VERTEX_BIT; break;
+                case SPV_EXECUTION_TESS_CONTROL: reflection->stage = VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT; break;
+                case SPV_EXECUTION_TESS_EVALUATION: reflection->stage = VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT; break;
+                case SPV_EXECUTION_GEOMETRY: reflection->stage = VK_SHADER_STAGE_GEOMETRY_BIT; break;
+                case SPV_EXECUTION_FRAGMENT: reflection->stage = VK_SHADER_STAGE_FRAGMENT_BIT; break;
+                case SPV_EXECUTION_GL_COMPUTE: reflection->stage = VK_SHADER_STAGE_COMPUTE_BIT; break;
+            }
+            continue;
+        }
+
+        // Every other definition we care about has its result id first
+        uint32_t result_index = (opcode == SPV_OP_CONSTANT || opcode == SPV_OP_VARIABLE
+            || opcode == SPV_OP_SPEC_CONSTANT || opcode == SPV_OP_SPEC_CONSTANT_TRUE
+            || opcode == SPV_OP_SPEC_CONSTANT_FALSE) ? 1 : 0;
+        if (count <= result_index || !is_valid_id(module, ops[result_index])) { continue; }
+        SpirvId *id = &module->ids[ops[result_index]];
+
+        switch (opcode) {
+            case SPV_OP_TYPE_BOOL:
+            case SPV_OP_TYPE_SAMPLER:
+            case SPV_OP_TYPE_ACCELERATION_STRUCTURE:
+                id->opcode = opcode;
+                id->width = 32;
+                break;
+            case SPV_OP_TYPE_INT:
+                if (count < 3) { break; }
+                id->opcode = opcode;
+                id->width = ops[1];
+                id->is_signed = ops[2];
+                break;
+            case SPV_OP_TYPE_FLOAT:
+                if (count < 2) { break; }
+                id->opcode = opcode;
+                id->width = ops[1];
+                break;
+            case SPV_OP_TYPE_VECTOR:
+            case SPV_OP_TYPE_MATRIX:
+                if (count < 3) { break; }
+                id->opcode = opcode;
+                id->type_id = ops[1];
+                id->count = ops[2];
+                break;
+            case SPV_OP_TYPE_IMAGE:
+                if (count < 8) { break; }
+                id->opcode = opcode;
+                id->image_dim = ops[2];
+                id->image_sampled = ops[6];
+                break;
+            case SPV_OP_TYPE_SAMPLED_IMAGE:
+            case SPV_OP_TYPE_RUNTIME_ARRAY:
+                if (count < 2) { break; }
+                id->opcode = opcode;
+                id->type_id = ops[1];
+                break;
+            case SPV_OP_TYPE_ARRAY:
+                // Length is the id of a constant, resolved once constants are known
+                if (count < 3) { break; }
+                id->opcode = opcode;
+                id->type_id = ops[1];
+                id->count = ops[2];
+                break;
+            case SPV_OP_TYPE_STRUCT:
+                id->opcode = opcode;
+                id->member_base = member_next;
+                id->member_count = count - 1;
+                for (uint32_t i = 1; i < count; ++i) {
+                    module->member_types[member_next++] = ops[i];
+                }
+                break;
+            case SPV_OP_TYPE_POINTER:
+                if (count < 3) { break; }
+                id->opcode = opcode;
+                id->storage_class = ops[1];
+                id->type_id = ops[2];
+                break;
+            case SPV_OP_CONSTANT:
+            case SPV_OP_SPEC_CONSTANT:
+                if (count < 3) { break; }
+                id->opcode = opcode;
+                id->type_id = ops[0];
+                id->value = ops[2];
+                break;
+            case SPV_OP_SPEC_CONSTANT_TRUE:
+            case SPV_OP_SPEC_CONSTANT_FALSE:
+                id->opcode = opcode;
+                id->type_id = ops[0];
+                id->value = opcode == SPV_OP_SPEC_CONSTANT_TRUE;
+                break;
+            case SPV_OP_VARIABLE:
+                if (count < 3) { break; }
+                id->opcode = opcode;
+                id->type_id = ops[0];
+                id->storage_class = ops[2];
+                break;
+        }
+    }
+
+    return true;
+}
+
+// Pass two applies decorations, which SPIR-V places before the definitions
+static void parse_decorations(SpirvModule *module) {
+    uint32_t cursor = SPV_HEADER_WORDS;
+    uint32_t opcode, count;
+    const uint32_t *ops;
+
+    while (next_instruction(module, &cursor, &opcode, &ops, &count)) {
+        if (opcode == SPV_OP_DECORATE && count >= 2 && is_valid_id(module, ops[0])) {
+            SpirvId *id = &module->ids[ops[0]];
+            uint32_t literal = count >= 3 ? ops[2] : 0;
+
+            switch (ops[1]) {
+                case SPV_DECORATION_DESCRIPTOR_SET: id->set = literal; id->flags |= ID_HAS_SET; break;
+                case SPV_DECORATION_BINDING: id->binding = literal; id->flags |= ID_HAS_BINDING; break;
+                case SPV_DECORATION_LOCATION: id->location = literal; id->flags |= ID_HAS_LOCATION; break;
+                case SPV_DECORATION_SPEC_ID: id->spec_id = literal; id->flags |= ID_HAS_SPEC_ID; break;
+                case SPV_DECORATION_BUILT_IN: id->flags |= ID_BUILT_IN; break;
+                case SPV_DECORATION_BLOCK: id->flags |= ID_BLOCK; break;
+                case SPV_DECORATION_BUFFER_BLOCK: id->flags |= ID_BUFFER_BLOCK; break;
+                case SPV_DECORATION_ARRAY_STRIDE: id->array_stride = literal; break;
+            }
+        } else if (opcode == SPV_OP_MEMBER_DECORATE && count >= 4 && is_valid_id(module, ops[0])) {
+            SpirvId *id = &module->ids[ops[0]];
+            if (ops[2] == SPV_DECORATION_OFFSET && id->opcode == SPV_OP_TYPE_STRUCT && ops[1] < id->member_count) {
+                module->member_offsets[id->member_base + ops[1]] = ops[3];
+            }
+        }
+    }
+}
+
+/*
+* Types
+*/
+static uint32_t get_array_length(SpirvModule *module, SpirvId *type) {
+    if (!is_valid_id(module, type->count)) { return 1; }
+    return module->ids[type->count].value;
+}
+
+// Size under the explicit layout rules push constants use (std430)
+static uint32_t get_type_size(SpirvModule *module, uint32_t type_id, uint32_t depth) {
+    if (!is_valid_id(module, type_id) || depth > 16) { return 0; }
+    SpirvId *type = &module->ids[type_id];
+
+    switch (type->opcode) {
+        case SPV_OP_TYPE_BOOL:
+        case SPV_OP_TYPE_INT:
+        case SPV_OP_TYPE_FLOAT:
+            return type->width / 8;
+        case SPV_OP_TYPE_VECTOR:
+            return type->count * get_type_size(module, type->type_id, depth + 1);
+        case SPV_OP_TYPE_MATRIX: {
+            // Column vectors of three or four components are padded to four
+            uint32_t column_size = get_type_size(module, type->type_id, depth + 1);
+            SpirvId *column = &module->ids[type->type_id];
+            if (column->count == 3) {
+                column_size = column_size / 3 * 4;
+            }
+            return type->count * column_size;
+        }
+        case SPV_OP_TYPE_ARRAY: {
+            uint32_t stride = type->array_stride;
+            if (stride == 0) {
+                stride = get_type_size(module, type->type_id, depth + 1);
+            }
+            return get_array_length(module, type) * stride;
+        }
+        case SPV_OP_TYPE_STRUCT: {
+            uint32_t size = 0;
+            for (uint32_t i = 0; i < type->member_count; ++i) {
+                uint32_t member_end = module->member_offsets[type->member_base + i]
+                    + get_type_size(module, module->member_types[type->member_base + i], depth + 1);
+                if (member_end > size) {
+                    size = member_end;
+                }
+            }
+            return size;
+        }
+    }
+
+    return 0;
+}
+
+static VkFormat get_vertex_input_format(SpirvModule *module, uint32_t type_id) {
+    if (!is_valid_id(module, type_id)) { return VK_FORMAT_UNDEFINED; }
+    SpirvId *type = &module->ids[type_id];
+
+    uint32_t components = 1;
+    if (type->opcode == SPV_OP_TYPE_VECTOR) {
+        components = type->count;
+        if (!is_valid_id(module, type->type_id)) { return VK_FORMAT_UNDEFINED; }
+        type = &module->ids[type->type_id];
+    }
+    if (type->width != 32 || components < 1 || components > 4) {
+        return VK_FORMAT_UNDEFINED;
+    }
+
+    static const VkFormat float_formats[] = {
+        VK_FORMAT_R32_SFLOAT, VK_FORMAT_R32G32_SFLOAT, VK_FORMAT_R32G32B32_SFLOAT, VK_FORMAT_R32G32B32A32_SFLOAT
+    };
+    static const VkFormat sint_formats[] = {
+        VK_FORMAT_R32_SINT, VK_FORMAT_R32G32_SINT, VK_FORMAT_R32G32B32_SINT, VK_FORMAT_R32G32B32A32_SINT
+    };
+    static const VkFormat uint_formats[] = {
+        VK_FORMAT_R32_UINT, VK_FORMAT_R32G32_UINT, VK_FORMAT_R32G32B32_UINT, VK_FORMAT_R32G32B32A32_UINT
+    };
+
+    if (type->opcode == SPV_OP_TYPE_FLOAT) {
+        return float_formats[components - 1];
+    }
+    if (type->opcode == SPV_OP_TYPE_INT) {
+        return type->is_signed ? sint_formats[components - 1] : uint_formats[components - 1];
+    }
+    return VK_FORMAT_UNDEFINED;
+}
+
+static bool get_descriptor_type(SpirvModule *module, SpirvId *variable, uint32_t type_id, VkDescriptorType *type, uint32_t *count) {
+    *count = 1;
+
+    // Unwrap descriptor arrays
+    SpirvId *element = &module->ids[type_id];
+    if (element->opcode == SPV_OP_TYPE_ARRAY) {
+        *count = get_array_length(module, element);
+        type_id = element->type_id;
+    } else if (element->opcode == SPV_OP_TYPE_RUNTIME_ARRAY) {
+        // Unbounded arrays need descriptor indexing, reserve a single slot
+        type_id = element->type_id;
+    }
+    if (!is_valid_id(module, type_id)) { return false; }
+    element = &module->ids[type_id];
+
+    switch (variable->storage_class) {
+        case SPV_STORAGE_UNIFORM:
+            *type = (element->flags & ID_BUFFER_BLOCK) ? VK_DESCRIPTOR_TYPE_STORAGE_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+            return true;
+        case SPV_STORAGE_STORAGE_BUFFER:
+            *type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            return true;
+        case SPV_STORAGE_UNIFORM_CONSTANT:
+            break;
+        default:
+            return false;
+    }
+
+    switch (element->opcode) {
+        case SPV_OP_TYPE_SAMPLER:
+            *type = VK_DESCRIPTOR_TYPE_SAMPLER;
+            return true;
+        case SPV_OP_TYPE_SAMPLED_IMAGE:
+            *type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+            return true;
+        case SPV_OP_TYPE_ACCELERATION_STRUCTURE:
+            *type = VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR;
+            return true;
+        case SPV_OP_TYPE_IMAGE:
+            // Sampled 1 means used with a sampler, 2 means storage
+            if (element->image_dim == SPV_DIM_SUBPASS_DATA) {
+                *type = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+            } else if (element->image_dim == SPV_DIM_BUFFER) {
+                *type = element->image_sampled == 2 ? VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
+            } else {
+                *type = element->image_sampled == 2 ? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE : VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+            }
+            return true;
+    }
+
+    return false;
+}
+
+/*
+* Reflection
+*/
+static bool collect_interface(SpirvModule *module, ShaderReflection *reflection) {
+    for (uint32_t i = 0; i < module->bound; ++i) {
+        SpirvId *id = &module->ids[i];
+
+        // Specialization constants
+        if ((id->opcode == SPV_OP_SPEC_CONSTANT || id->opcode == SPV_OP_SPEC_CONSTANT_TRUE
+            || id->opcode == SPV_OP_SPEC_CONSTANT_FALSE) && (id->flags & ID_HAS_SPEC_ID)) {
+            if (reflection->spec_constant_count >= MAX_REFLECTED_SPEC_CONSTANTS) {
+                fprintf(stderr, "too many specialization constants\n");
+                return false;
+            }
+
+            ReflectedSpecConstant *constant = &reflection->spec_constants[reflection->spec_constant_count++];
+            constant->id = id->spec_id;
+            constant->size = get_type_size(module, id->type_id, 0);
+            constant->default_value = id->value;
+            continue;
+        }
+
+        if (id->opcode != SPV_OP_VARIABLE || !is_valid_id(module, id->type_id)) { continue; }
+        SpirvId *pointer = &module->ids[id->type_id];
+        if (pointer->opcode != SPV_OP_TYPE_POINTER || !is_valid_id(module, pointer->type_id)) { continue; }
+
+        // Push constants, only one block is allowed per stage
+        if (id->storage_class == SPV_STORAGE_PUSH_CONSTANT) {
+            reflection->push_constant_size = get_type_size(module, pointer->type_id, 0);
+            continue;
+        }
+
+        // Vertex inputs, built-ins such as gl_VertexIndex have no location
+        if (id->storage_class == SPV_STORAGE_INPUT) {
+            if (reflection->stage != VK_SHADER_STAGE_VERTEX_BIT
+                || (id->flags & ID_BUILT_IN) || !(id->flags & ID_HAS_LOCATION)) {
+                continue;
+            }
+            if (reflection->vertex_input_count >= MAX_REFLECTED_VERTEX_INPUTS) {
+                fprintf(stderr, "too many vertex inputs\n");
+                return false;
+            }
+
+            ReflectedVertexInput *input = &reflection->vertex_inputs[reflection->vertex_input_count++];
+            input->location = id->location;
+            input->format = get_vertex_input_format(module, pointer->type_id);
+            input->size = get_type_size(module, pointer->type_id, 0);
+            if (input->format == VK_FORMAT_UNDEFINED) {
+                fprintf(stderr, "unsupported vertex input type at location %u\n", id->location);
+                return false;
+            }
+            continue;
+        }
+
+        // Descriptors
+        if (!(id->flags & ID_HAS_BINDING)) { continue; }
+
+        VkDescriptorType type;
+        uint32_t count;
+        if (!get_descriptor_type(module, id, pointer->type_id, &type, &count)) { continue; }
+        if (reflection->binding_count >= MAX_REFLECTED_BINDINGS) {
+            fprintf(stderr, "too many descriptor bindings\n");
+            return false;
+        }
+
+        ReflectedBinding *binding = &reflection->bindings[reflection->binding_count++];
+        binding->set = (id->flags & ID_HAS_SET) ? id->set : 0;
+        binding->binding = id->binding;
+        binding->type = type;
+        binding->count = count;
+    }
+
+    return true;
+}
+
+bool reflect_shader(const ShaderBinary *binary, ShaderReflection *reflection) {
+    memset(reflection, 0, sizeof(ShaderReflection));
+
+    uint32_t word_count = (uint32_t)(binary->size / sizeof(uint32_t));
+    if (word_count < SPV_HEADER_WORDS || binary->code[0] != SPV_MAGIC) {
+        fprintf(stderr, "not a SPIR-V module: %s\n", binary->name);
+        return false;
+    }
+
+    SpirvModule module;
+    module.words = binary->code;
+    module.word_count = word_count;
+    module.bound = binary->code[3];
+    module.member_types = NULL;
+    module.member_offsets = NULL;
+    module.ids = calloc(module.bound, sizeof(SpirvId));
+    if (module.ids == NULL) { return false; }
+
+    bool success = parse_definitions(&module, reflection);
+    if (success) {
+        parse_decorations(&module);
+        success = collect_interface(&module, reflection);
+    }
+
+    free(module.member_offsets);
+    free(module.member_types);
+    free(module.ids);
+
+    if (!success) {
+        fprintf(stderr, "failed to reflect shader: %s\n", binary->name);
+    }
+    return success;
+}
+
+bool validate_specialization(const ShaderReflection *reflection, const SpecializationDesc *specialization) {
+    for (uint32_t i = 0; i < specialization->constant_count; ++i) {
+        const ReflectedSpecConstant *declared = NULL;
+        for (uint32_t j = 0; j < reflection->spec_constant_count; ++j) {
+            if (reflection->spec_constants[j].id == specialization->constant_ids[i]) {
+                declared = &reflection->spec_constants[j];
+                break;
+            }
+        }
+
+        if (declared == NULL) {
+            fprintf(stderr, "shader has no specialization constant %u\n", specialization->constant_ids[i]);
+            return false;
+        }
+        if (declared->size != sizeof(uint32_t)) {
+            fprintf(stderr, "specialization constant %u is not 32-bit\n", specialization->constant_ids[i]);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/*
+* Layouts
+*/
+// Merge bindings, a binding seen by several stages gets all of their stage bits
+static bool merge_reflected_sets(const ShaderReflection *reflections, uint32_t reflection_count,
+    DescriptorSetLayoutDesc *set_descs, uint32_t *set_count) {
+    memset(set_descs, 0, MAX_DESCRIPTOR_SETS * sizeof(DescriptorSetLayoutDesc));
+    *set_count = 0;
+
+    for (uint32_t r = 0; r < reflection_count; ++r) {
+        const ShaderReflection *reflection = &reflections[r];
+        for (uint32_t b = 0; b < reflection->binding_count; ++b) {
+            const ReflectedBinding *binding = &reflection->bindings[b];
+            if (binding->set >= MAX_DESCRIPTOR_SETS) {
+                fprintf(stderr, "descriptor set %u out of range\n", binding->set);
+                return false;
+            }
+
+            DescriptorSetLayoutDesc *set_desc = &set_descs[binding->set];
+            VkDescriptorSetLayoutBinding *merged = NULL;
+            for (uint32_t i = 0; i < set_desc->binding_count; ++i) {
+                if (set_desc->bindings[i].binding == binding->binding) {
+                    merged = &set_desc->bindings[i];
+                    break;
+                }
+            }
+
+            if (merged != NULL) {
+                if (merged->descriptorType != binding->type || merged->descriptorCount != binding->count) {
+                    fprintf(stderr, "binding mismatch at set %u binding %u\n", binding->set, binding->binding);
+                    return false;
+                }
+                merged->stageFlags |= reflection->stage;
+                continue;
+            }
+
+            if (set_desc->binding_count >= MAX_DESCRIPTOR_BINDINGS) {
+                fprintf(stderr, "too many bindings in set %u\n", binding->set);
+                return false;
+            }
+
+            merged = &set_desc->bindings[set_desc->binding_count++];
+            merged->binding = binding->binding;
+            merged->descriptorType = binding->type;
+            merged->descriptorCount = binding->count;
+            merged->stageFlags = reflection->stage;
+            merged->pImmutableSamplers = NULL;
+
+            if (binding->set + 1 > *set_count) {
+                *set_count = binding->set + 1;
+            }
+        }
+    }
+    return true;
+}
+
+VkPipelineLayout create_reflected_pipeline_layout(PipelineRegistry *registry, const ShaderReflection *reflections, uint32_t reflection_count) {
+    DescriptorSetLayoutDesc set_descs[MAX_DESCRIPTOR_SETS];
+    PipelineLayoutDesc layout_desc;
+    memset(&layout_desc, 0, sizeof(layout_desc));
+    if (!merge_reflected_sets(reflections, reflection_count, set_descs, &layout_desc.set_layout_count)) {
+        return VK_NULL_HANDLE;
+    }
+
+    uint32_t push_constant_size = 0;
+    VkShaderStageFlags push_constant_stages = 0;
+    for (uint32_t r = 0; r < reflection_count; ++r) {
+        if (reflections[r].push_constant_size > 0) {
+            push_constant_stages |= reflections[r].stage;
+            if (reflections[r].push_constant_size > push_constant_size) {
+                push_constant_size = reflections[r].push_constant_size;
+            }
+        }
+    }
+
+    // Sets below the highest used one still need a (possibly empty) layout
+    for (uint32_t i = 0; i < layout_desc.set_layout_count; ++i) {
+        layout_desc.set_layouts[i] = get_descriptor_set_layout(registry, &set_descs[i]);
+        if (layout_desc.set_layouts[i] == VK_NULL_HANDLE) { return VK_NULL_HANDLE; }
+    }
+
+    // One range covering every stage that reads push constants
+    if (push_constant_size > 0) {
+        layout_desc.push_constant_range_count = 1;
+        layout_desc.push_constant_ranges[0].stageFlags = push_constant_stages;
+        layout_desc.push_constant_ranges[0].offset = 0;
+        layout_desc.push_constant_ranges[0].size = push_constant_size;
+    }
+
+    return get_pipeline_layout(registry, &layout_desc);
+}
+
+VkDescriptorSetLayout get_reflected_set_layout(PipelineRegistry *registry, const ShaderReflection *reflections, uint32_t reflection_count, uint32_t set) {
+    DescriptorSetLayoutDesc set_descs[MAX_DESCRIPTOR_SETS];
+    uint32_t set_count;
+    if (set >= MAX_DESCRIPTOR_SETS || !merge_reflected_sets(reflections, reflection_count, set_descs, &set_count)) {
+        return VK_NULL_HANDLE;
+    }
+
+    // Same desc as the pipeline layout used, so the registry hands back the same object
+    return get_descriptor_set_layout(registry, &set_descs[set]);
+}
+
+void build_reflected_vertex_input(const ShaderReflection *vertex_reflection, VertexInputDesc *vertex_input) {
+    vertex_input->binding_count = 0;
+    vertex_input->attribute_count = 0;
+    if (vertex_reflection->vertex_input_count == 0) { return; }
+
+    // Tightly packed, interleaved in location order on binding 0
+    uint32_t order[MAX_REFLECTED_VERTEX_INPUTS];
+    for (uint32_t i = 0; i < vertex_reflection->vertex_input_count; ++i) {
+        order[i] = i;
+        for (uint32_t j = i; j > 0 && vertex_reflection->vertex_inputs[order[j - 1]].location
+            > vertex_reflection->vertex_inputs[order[j]].location; --j) {
+            uint32_t tmp = order[j];
+            order[j] = order[j - 1];
+            order[j - 1] = tmp;
+        }
+    }
+
+    uint32_t offset = 0;
+    for (uint32_t i = 0; i < vertex_reflection->vertex_input_count; ++i) {
+        const ReflectedVertexInput *input = &vertex_reflection->vertex_inputs[order[i]];
+
+        VkVertexInputAttributeDescription *attribute = &vertex_input->attributes[vertex_input->attribute_count++];
+        attribute->location = input->location;
+        attribute->binding = 0;
+        attribute->format = input->format;
+        attribute->offset = offset;
+        offset += input->size;
+    }
+
+    vertex_input->binding_count = 1;
+    vertex_input->bindings[0].binding = 0;
+    vertex_input->bindings[0].stride = offset;
+    vertex_input->bindings[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+}
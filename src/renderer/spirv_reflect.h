@@ -0,0 +1,64 @@
+#ifndef SPIRV_REFLECT_H
+#define SPIRV_REFLECT_H
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "pipeline.h"
+#include "pipeline_registry.h"
+#include "shader_pack.h"
+
+#define MAX_REFLECTED_BINDINGS 32
+#define MAX_REFLECTED_VERTEX_INPUTS MAX_VERTEX_ATTRIBUTES
+#define MAX_REFLECTED_SPEC_CONSTANTS 16
+
+typedef struct {
+    uint32_t set;
+    uint32_t binding;
+    VkDescriptorType type;
+    uint32_t count;
+} ReflectedBinding;
+
+typedef struct {
+    uint32_t location;
+    VkFormat format;
+    uint32_t size;
+} ReflectedVertexInput;
+
+typedef struct {
+    uint32_t id;
+    uint32_t size;
+    uint32_t default_value;
+} ReflectedSpecConstant;
+
+// Interface of one shader stage as declared in its SPIR-V
+typedef struct {
+    VkShaderStageFlagBits stage;
+
+    uint32_t binding_count;
+    ReflectedBinding bindings[MAX_REFLECTED_BINDINGS];
+
+    uint32_t push_constant_size;
+
+    uint32_t vertex_input_count;
+    ReflectedVertexInput vertex_inputs[MAX_REFLECTED_VERTEX_INPUTS];
+
+    uint32_t spec_constant_count;
+    ReflectedSpecConstant spec_constants[MAX_REFLECTED_SPEC_CONSTANTS];
+} ShaderReflection;
+
+// Reflection
+bool reflect_shader(const ShaderBinary *binary, ShaderReflection *reflection);
+
+// Checks every constant in a variant is declared by the shader as a 32-bit value
+bool validate_specialization(const ShaderReflection *reflection, const SpecializationDesc *specialization);
+
+// Layouts, merged across every stage of a pipeline
+VkPipelineLayout create_reflected_pipeline_layout(PipelineRegistry *registry, const ShaderReflection *reflections, uint32_t reflection_count);
+VkDescriptorSetLayout get_reflected_set_layout(PipelineRegistry *registry, const ShaderReflection *reflections, uint32_t reflection_count, uint32_t set);
+void build_reflected_vertex_input(const ShaderReflection *vertex_reflection, VertexInputDesc *vertex_input);
+
+#endif
@@ -16,17 +16,9 @@ VkSurfaceFormatKHR get_swapchain_surface_format(VkSurfaceFormatKHR *formats, uin
     return formats[0];
 }
 
-VkPresentModeKHR get_swapchain_present_mode(VkPresentModeKHR *present_modes, uint32_t present_mode_count) {
-    for (int i = 0; i < present_mode_count; ++i) {
-        if (present_modes[i] == VK_PRESENT_MODE_MAILBOX_KHR) {
-            return present_modes[i];
-        }
-    }
-    return present_modes[0];
-}
-
 VkExtent2D get_swapchain_extent(VkSurfaceCapabilitiesKHR capabilities, GLFWwindow *window) {
-    if (capabilities.currentExtent.width != INT_MAX) {
+    // UINT32_MAX means the surface size follows the swapchain, e.g. on Wayland
+    if (capabilities.currentExtent.width != UINT32_MAX) {
         return capabilities.currentExtent;
     }
 
@@ -46,15 +38,15 @@ VkExtent2D get_swapchain_extent(VkSurfaceCapabilitiesKHR capabilities, GLFWwindo
 /*
 * Swapchain support detail
 */
-SwapChainSupportDetails *query_swapchain_support_details(VkPhysicalDevice physical_device, VkSurfaceKHR surface) {
-    SwapChainSupportDetails *details = malloc(sizeof(SwapChainSupportDetails));
+SwapChainSupportDetails *query_swapchain_support_details(Arena *scratch, VkPhysicalDevice physical_device, VkSurfaceKHR surface) {
+    SwapChainSupportDetails *details = arena_alloc(scratch, sizeof(SwapChainSupportDetails));
     if (details == NULL) { return NULL; }
 
     vkGetPhysicalDeviceSurfaceCapabilitiesKHR(physical_device, surface, &details->capabilities);
 
     uint32_t format_count = 0;
     vkGetPhysicalDeviceSurfaceFormatsKHR(physical_device, surface, &format_count, NULL);
-    details->formats = malloc(sizeof(VkSurfaceFormatKHR) * format_count);
+    details->formats = arena_alloc(scratch, sizeof(VkSurfaceFormatKHR) * format_count);
     if (details->formats == NULL) { return NULL; }
 
     details->format_count = format_count;
@@ -62,7 +54,7 @@ SwapChainSupportDetails *query_swapchain_support_details(VkPhysicalDevice physic
 
     uint32_t present_mode_count = 0;
     vkGetPhysicalDeviceSurfacePresentModesKHR(physical_device, surface, &present_mode_count, NULL);
-    details->present_modes = malloc(sizeof(VkPresentModeKHR) * present_mode_count);
+    details->present_modes = arena_alloc(scratch, sizeof(VkPresentModeKHR) * present_mode_count);
     if (details->present_modes == NULL) { return NULL; }
 
     details->present_mode_count = present_mode_count;
@@ -101,7 +93,7 @@ VkImageView *create_swapchain_image_views(VkDevice device, SwapchainContext *swa
         create_info.subresourceRange.baseArrayLayer = 0;
         create_info.subresourceRange.layerCount = 1;
 
-        if (vkCreateImageView(device, &create_info, NULL, &image_views[i]) != VK_SUCCESS) {
+        if (vkCreateImageView(device, &create_info, get_host_allocator(), &image_views[i]) != VK_SUCCESS) {
             fprintf(stderr, "failed to create swapchain image view [%d]\n", i);
             return NULL;
         }
@@ -110,22 +102,36 @@ VkImageView *create_swapchain_image_views(VkDevice device, SwapchainContext *swa
     return image_views;
 }
 
+VkSemaphore *create_swapchain_semaphores(VkDevice device, uint32_t image_count) {
+    VkSemaphore *semaphores = malloc(sizeof(VkSemaphore) * image_count);
+    if (semaphores == NULL) { return NULL; }
+
+    VkSemaphoreCreateInfo create_info;
+    create_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    create_info.pNext = NULL;
+    create_info.flags = 0;
+    for (int i = 0; i < image_count; ++i) {
+        if (vkCreateSemaphore(device, &create_info, get_host_allocator(), &semaphores[i]) != VK_SUCCESS) {
+            fprintf(stderr, "failed to create swapchain semaphore [%d]\n", i);
+            return NULL;
+        }
+    }
+
+    return semaphores;
+}
+
 /*
 * Cleanup
 */
-void destroy_swapchain_support_details(SwapChainSupportDetails *details) {
-    free(details->formats);
-    free(details->present_modes);
-    free(details);
-}
-
 void destroy_swapchain_context(VkDevice device, SwapchainContext *swapchain_ctx) {
     for (int i = 0; i < swapchain_ctx->image_count; ++i) {
-        vkDestroyImageView(device, swapchain_ctx->image_views[i], NULL);
+        vkDestroyImageView(device, swapchain_ctx->image_views[i], get_host_allocator());
+        vkDestroySemaphore(device, swapchain_ctx->render_finished[i], get_host_allocator());
     }
     // Destroying swapchain destroys VkImages aquired by vkGetSwapchainImagesKHR
-    vkDestroySwapchainKHR(device, swapchain_ctx->swapchain, NULL);
+    vkDestroySwapchainKHR(device, swapchain_ctx->swapchain, get_host_allocator());
 
+    free(swapchain_ctx->render_finished);
     free(swapchain_ctx->image_views);
     free(swapchain_ctx->images);
     free(swapchain_ctx);
@@ -4,15 +4,11 @@
 #define GLFW_INCLUDE_VULKAN
 #include <GLFW/glfw3.h>
 #include <limits.h>
+#include <stdint.h>
 
 #include "vulkan_context.h"
 #include "device.h"
 
-// Number of frames we will buffer in the swapchain
-#define NO_BUFFERING 1
-#define DOUBLE_BUFFERING 2
-#define TRIPLE_BUFFERING 3
-
 typedef struct {
     VkSurfaceCapabilitiesKHR capabilities;
 
@@ -24,19 +20,21 @@ typedef struct {
 } SwapChainSupportDetails;
 
 // Swapchain creation
-SwapchainContext *create_swapchain_context(VulkanContext *v_ctx, GLFWwindow *window);
+SwapchainContext *create_swapchain_context(VulkanContext *v_ctx, GLFWwindow *window, VkSwapchainKHR old_swapchain);
 VkSurfaceFormatKHR get_swapchain_surface_format(VkSurfaceFormatKHR *formats, uint32_t format_count);
-VkPresentModeKHR get_swapchain_present_mode(VkPresentModeKHR *present_modes, uint32_t present_mode_count);
 VkExtent2D get_swapchain_extent(VkSurfaceCapabilitiesKHR capabilities, GLFWwindow *window);
 
 // Image views
 VkImageView *create_swapchain_image_views(VkDevice device, SwapchainContext *swapchain_ctx, uint32_t image_count);
 
+// Present waits, a frame's slot fence says nothing about when the presentation engine is done with them
+VkSemaphore *create_swapchain_semaphores(VkDevice device, uint32_t image_count);
+
 // Support detail
-SwapChainSupportDetails *query_swapchain_support_details(VkPhysicalDevice physical_device, VkSurfaceKHR surface);
+// Allocated from the scratch arena, released with the caller's mark
+SwapChainSupportDetails *query_swapchain_support_details(Arena *scratch, VkPhysicalDevice physical_device, VkSurfaceKHR surface);
 
 // Cleanup
-void destroy_swapchain_support_details(SwapChainSupportDetails *details);
 void destroy_swapchain_context(VkDevice device, SwapchainContext *swapchain_ctx);
 
 #endif
\ No newline at end of file
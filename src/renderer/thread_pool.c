@@ -0,0 +1,157 @@
+// sysconf is POSIX, not C17
+#define _POSIX_C_SOURCE 200809L
+
+#include "thread_pool.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+/*
+* Workers
+*/
+static void *worker_main(void *arg) {
+    ThreadPool *pool = arg;
+
+    pthread_mutex_lock(&pool->mutex);
+    while (true) {
+        while (pool->job_count == 0 && !pool->shutdown) {
+            pthread_cond_wait(&pool->job_available, &pool->mutex);
+        }
+        if (pool->job_count == 0 && pool->shutdown) {
+            break;
+        }
+
+        Job job = pool->jobs[pool->job_head];
+        pool->job_head = (pool->job_head + 1) % pool->job_capacity;
+        --pool->job_count;
+        ++pool->active_count;
+
+        pthread_mutex_unlock(&pool->mutex);
+        job.func(job.arg);
+        pthread_mutex_lock(&pool->mutex);
+
+        --pool->active_count;
+        if (pool->job_count == 0 && pool->active_count == 0) {
+            pthread_cond_broadcast(&pool->jobs_done);
+        }
+    }
+    pthread_mutex_unlock(&pool->mutex);
+
+    return NULL;
+}
+
+/*
+* Thread pool creation
+*/
+ThreadPool *create_thread_pool(uint32_t thread_count) {
+    if (thread_count == 0) {
+        thread_count = get_cpu_count();
+    }
+
+    // Zeroed with the sync objects up front so every failure below can go through destroy_thread_pool
+    ThreadPool *pool = calloc(1, sizeof(ThreadPool));
+    if (pool == NULL) { return NULL; }
+    pthread_mutex_init(&pool->mutex, NULL);
+    pthread_cond_init(&pool->job_available, NULL);
+    pthread_cond_init(&pool->jobs_done, NULL);
+
+    pool->threads = malloc(sizeof(pthread_t) * thread_count);
+    pool->jobs = malloc(sizeof(Job) * THREAD_POOL_INITIAL_CAPACITY);
+    if (pool->threads == NULL || pool->jobs == NULL) {
+        fprintf(stderr, "failed to alloc thread pool\n");
+        destroy_thread_pool(pool);
+        return NULL;
+    }
+    pool->job_capacity = THREAD_POOL_INITIAL_CAPACITY;
+
+    // Workers that did start are joined by destroy_thread_pool
+    for (uint32_t i = 0; i < thread_count; ++i) {
+        if (pthread_create(&pool->threads[i], NULL, worker_main, pool) != 0) {
+            fprintf(stderr, "failed to create worker thread [%u]\n", i);
+            destroy_thread_pool(pool);
+            return NULL;
+        }
+        ++pool->thread_count;
+    }
+    return pool;
+}
+
+uint32_t get_cpu_count() {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors > 0 ? info.dwNumberOfProcessors : 1;
+#else
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (uint32_t)count : 1;
+#endif
+}
+
+/*
+* Jobs
+*/
+bool submit_job(ThreadPool *pool, JobFunc func, void *arg) {
+    pthread_mutex_lock(&pool->mutex);
+
+    // Grow the ring, unwrapping it into the new allocation
+    if (pool->job_count == pool->job_capacity) {
+        uint32_t new_capacity = pool->job_capacity * 2;
+        Job *jobs = malloc(sizeof(Job) * new_capacity);
+        if (jobs == NULL) {
+            pthread_mutex_unlock(&pool->mutex);
+            fprintf(stderr, "failed to grow thread pool job queue\n");
+            return false;
+        }
+
+        for (uint32_t i = 0; i < pool->job_count; ++i) {
+            jobs[i] = pool->jobs[(pool->job_head + i) % pool->job_capacity];
+        }
+        free(pool->jobs);
+        pool->jobs = jobs;
+        pool->job_capacity = new_capacity;
+        pool->job_head = 0;
+    }
+
+    uint32_t tail = (pool->job_head + pool->job_count) % pool->job_capacity;
+    pool->jobs[tail].func = func;
+    pool->jobs[tail].arg = arg;
+    ++pool->job_count;
+
+    pthread_cond_signal(&pool->job_available);
+    pthread_mutex_unlock(&pool->mutex);
+    return true;
+}
+
+void wait_thread_pool(ThreadPool *pool) {
+    pthread_mutex_lock(&pool->mutex);
+    while (pool->job_count > 0 || pool->active_count > 0) {
+        pthread_cond_wait(&pool->jobs_done, &pool->mutex);
+    }
+    pthread_mutex_unlock(&pool->mutex);
+}
+
+/*
+* Cleanup
+*/
+void destroy_thread_pool(ThreadPool *pool) {
+    // Workers drain any queued jobs before exiting
+    pthread_mutex_lock(&pool->mutex);
+    pool->shutdown = true;
+    pthread_cond_broadcast(&pool->job_available);
+    pthread_mutex_unlock(&pool->mutex);
+
+    for (uint32_t i = 0; i < pool->thread_count; ++i) {
+        pthread_join(pool->threads[i], NULL);
+    }
+
+    pthread_cond_destroy(&pool->jobs_done);
+    pthread_cond_destroy(&pool->job_available);
+    pthread_mutex_destroy(&pool->mutex);
+
+    free(pool->jobs);
+    free(pool->threads);
+    free(pool);
+}
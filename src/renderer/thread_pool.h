@@ -0,0 +1,47 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define THREAD_POOL_INITIAL_CAPACITY 64
+
+typedef void (*JobFunc)(void *arg);
+
+typedef struct {
+    JobFunc func;
+    void *arg;
+} Job;
+
+// Fixed set of workers pulling from a growable ring of jobs
+typedef struct {
+    pthread_t *threads;
+    uint32_t thread_count;
+
+    pthread_mutex_t mutex;
+    pthread_cond_t job_available;
+    pthread_cond_t jobs_done;
+
+    Job *jobs;
+    uint32_t job_capacity;
+    uint32_t job_head;
+    uint32_t job_count;
+    uint32_t active_count;
+    bool shutdown;
+} ThreadPool;
+
+// Thread pool creation
+ThreadPool *create_thread_pool(uint32_t thread_count);
+uint32_t get_cpu_count();
+
+// Jobs
+bool submit_job(ThreadPool *pool, JobFunc func, void *arg);
+void wait_thread_pool(ThreadPool *pool);
+
+// Cleanup
+void destroy_thread_pool(ThreadPool *pool);
+
+#endif
@@ -0,0 +1,165 @@
+// clock_gettime is POSIX, not C17
+#define _POSIX_C_SOURCE 200809L
+
+#include "trace.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+static TraceEvent trace_events[MAX_TRACE_EVENTS];
+static atomic_uint trace_event_count = 0;
+static atomic_uint next_thread_id = 0;
+static uint64_t trace_origin_ns = 0;
+
+// Open scopes of the calling thread, indices into trace_events
+static _Thread_local uint32_t scope_stack[MAX_TRACE_DEPTH];
+static _Thread_local uint32_t scope_depth = 0;
+static _Thread_local uint32_t thread_id = UINT32_MAX;
+
+/*
+* Scopes
+*/
+uint64_t get_trace_time_ns(void) {
+#ifdef _WIN32
+    LARGE_INTEGER frequency, counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (uint64_t)((double)counter.QuadPart * 1e9 / (double)frequency.QuadPart);
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec;
+#endif
+}
+
+void begin_trace_scope(const char *name) {
+    uint64_t now = get_trace_time_ns();
+    if (thread_id == UINT32_MAX) {
+        thread_id = atomic_fetch_add(&next_thread_id, 1);
+    }
+
+    // Events past the limit or depth are dropped, the scope still balances
+    uint32_t index = UINT32_MAX;
+    if (scope_depth < MAX_TRACE_DEPTH) {
+        index = atomic_fetch_add(&trace_event_count, 1);
+        if (index < MAX_TRACE_EVENTS) {
+            TraceEvent *event = &trace_events[index];
+            event->name = name;
+            event->start_ns = now;
+            event->duration_ns = 0;
+            event->thread_id = thread_id;
+            event->depth = scope_depth;
+            event->closed = false;
+        } else {
+            index = UINT32_MAX;
+        }
+        scope_stack[scope_depth] = index;
+    }
+
+    // Timestamps in the exported trace are relative to the first scope
+    if (trace_origin_ns == 0) {
+        trace_origin_ns = now;
+    }
+    ++scope_depth;
+}
+
+void end_trace_scope(void) {
+    uint64_t now = get_trace_time_ns();
+    if (scope_depth == 0) {
+        fprintf(stderr, "end_trace_scope without a matching begin\n");
+        return;
+    }
+
+    --scope_depth;
+    if (scope_depth >= MAX_TRACE_DEPTH) { return; }
+
+    uint32_t index = scope_stack[scope_depth];
+    if (index == UINT32_MAX) { return; }
+
+    trace_events[index].duration_ns = now - trace_events[index].start_ns;
+    trace_events[index].closed = true;
+}
+
+/*
+* Output
+*/
+const char *get_trace_path(void) {
+    const char *path = getenv(TRACE_PATH_ENV);
+    if (path != NULL && path[0] != '\0') {
+        return path;
+    }
+    return NULL;
+}
+
+static uint32_t get_recorded_event_count(void) {
+    uint32_t count = atomic_load(&trace_event_count);
+    return count < MAX_TRACE_EVENTS ? count : MAX_TRACE_EVENTS;
+}
+
+// Chrome trace event format, load in chrome://tracing or ui.perfetto.dev
+bool write_trace_file(const char *path) {
+    FILE *file = fopen(path, "w");
+    if (file == NULL) {
+        fprintf(stderr, "failed to open trace file: %s\n", path);
+        return false;
+    }
+
+    fprintf(file, "{\"traceEvents\":[\n");
+    uint32_t count = get_recorded_event_count();
+    bool first = true;
+    for (uint32_t i = 0; i < count; ++i) {
+        TraceEvent *event = &trace_events[i];
+        if (!event->closed) { continue; }
+
+        fprintf(file, "%s{\"name\":\"%s\",\"cat\":\"vrender\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%u}",
+            first ? "" : ",\n", event->name, (event->start_ns - trace_origin_ns) / 1000.0,
+            event->duration_ns / 1000.0, event->thread_id);
+        first = false;
+    }
+    fprintf(file, "\n],\"displayTimeUnit\":\"ms\"}\n");
+
+    bool success = fclose(file) == 0;
+    if (success) {
+        printf("[TRACE] Wrote %u events to %s\n", count, path);
+    }
+    return success;
+}
+
+// Repeated scopes with the same name, thread and depth are folded into one row
+void print_trace_summary(void) {
+    uint32_t count = get_recorded_event_count();
+    bool *printed = calloc(count + 1, sizeof(bool));
+    if (printed == NULL) { return; }
+
+    printf("[TRACE] %-40s %6s %10s %10s %10s\n", "scope", "count", "total ms", "avg ms", "max ms");
+    for (uint32_t i = 0; i < count; ++i) {
+        TraceEvent *event = &trace_events[i];
+        if (printed[i] || !event->closed) { continue; }
+
+        uint32_t calls = 0;
+        uint64_t total_ns = 0;
+        uint64_t max_ns = 0;
+        for (uint32_t j = i; j < count; ++j) {
+            TraceEvent *other = &trace_events[j];
+            if (printed[j] || !other->closed || other->thread_id != event->thread_id
+                || other->depth != event->depth || strcmp(other->name, event->name) != 0) {
+                continue;
+            }
+
+            printed[j] = true;
+            ++calls;
+            total_ns += other->duration_ns;
+            if (other->duration_ns > max_ns) {
+                max_ns = other->duration_ns;
+            }
+        }
+
+        printf("[TRACE] %*s%-*s %6u %10.3f %10.3f %10.3f\n", (int)event->depth * 2, "", 40 - (int)event->depth * 2,
+            event->name, calls, total_ns / 1e6, total_ns / 1e6 / calls, max_ns / 1e6);
+    }
+
+    free(printed);
+}
@@ -0,0 +1,35 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TRACE_PATH_ENV "VRENDER_TRACE"
+#define MAX_TRACE_EVENTS 4096
+#define MAX_TRACE_DEPTH 32
+
+// One closed or still open scope, names must be string literals
+typedef struct {
+    const char *name;
+    uint64_t start_ns;
+    uint64_t duration_ns;
+    uint32_t thread_id;
+    uint32_t depth;
+    bool closed;
+} TraceEvent;
+
+// Scopes, nest per thread and must be closed in reverse order
+void begin_trace_scope(const char *name);
+void end_trace_scope(void);
+uint64_t get_trace_time_ns(void);
+
+// Output
+const char *get_trace_path(void);
+bool write_trace_file(const char *path);
+void print_trace_summary(void);
+
+#endif
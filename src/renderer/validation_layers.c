@@ -20,7 +20,7 @@ VkDebugUtilsMessengerEXT create_debug_messenger(VkInstance instance) {
     populate_debug_messenger_create_info(&create_info);
 
     VkDebugUtilsMessengerEXT debug_messenger = VK_NULL_HANDLE;
-    if (create_debug_utils_msg_ext(instance, &create_info, NULL, &debug_messenger) != VK_SUCCESS) {
+    if (create_debug_utils_msg_ext(instance, &create_info, get_host_allocator(), &debug_messenger) != VK_SUCCESS) {
         fprintf(stderr, "failed to set up debug messenger\n");
         return VK_NULL_HANDLE;
     }
@@ -48,7 +48,9 @@ bool check_validation_layer_support(uint32_t num_validation_layers, const char *
     uint32_t instance_layer_count;
     vkEnumerateInstanceLayerProperties(&instance_layer_count, NULL);
 
-    VkLayerProperties *available_layers = malloc(sizeof(VkLayerProperties) * instance_layer_count);
+    Arena *scratch = get_scratch_arena();
+    ArenaMark mark = get_arena_mark(scratch);
+    VkLayerProperties *available_layers = arena_alloc(scratch, sizeof(VkLayerProperties) * instance_layer_count);
     if (available_layers == NULL) {
         fprintf(stderr, "failed to allocate memory for available layers\n");
         return false;
@@ -73,7 +75,7 @@ bool check_validation_layer_support(uint32_t num_validation_layers, const char *
         }
     }
 
-    free(available_layers);
+    reset_arena_to_mark(scratch, mark);
     return supports_layers;
 }
 
@@ -103,9 +105,12 @@ void print_available_layers() {
     uint32_t instance_layer_count;
     vkEnumerateInstanceLayerProperties(&instance_layer_count, NULL);
 
-    VkLayerProperties *available_layers = malloc(sizeof(VkLayerProperties) * instance_layer_count);
+    Arena *scratch = get_scratch_arena();
+    ArenaMark mark = get_arena_mark(scratch);
+    VkLayerProperties *available_layers = arena_alloc(scratch, sizeof(VkLayerProperties) * instance_layer_count);
     if (available_layers == NULL) {
         fprintf(stderr, "failed to allocate memory for available layers\n");
+        return;
     }
 
     vkEnumerateInstanceLayerProperties(&instance_layer_count, available_layers);
@@ -114,5 +119,5 @@ void print_available_layers() {
     for (int i = 0; i < instance_layer_count; ++i) {
         printf("\t%s\n", available_layers[i].layerName);
     }
-    free(available_layers);
+    reset_arena_to_mark(scratch, mark);
 }
\ No newline at end of file
@@ -8,6 +8,9 @@
 #include <stdlib.h>
 #include <stdio.h>
 
+#include "arena.h"
+#include "host_allocator.h"
+
 VkDebugUtilsMessengerEXT create_debug_messenger(VkInstance instance);
 
 void populate_debug_messenger_create_info(VkDebugUtilsMessengerCreateInfoEXT *create_info);
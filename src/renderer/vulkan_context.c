@@ -1,29 +1,48 @@
 #include "vulkan_context.h"
 
-VulkanContext *create_vulkan_context(GLFWwindow *window) {
+/*
+* Context creation
+*/
+// Shared by windowed and headless contexts, a NULL window skips the surface
+static VulkanContext *create_base_vulkan_context(GLFWwindow *window, const PresentPolicy *present_policy) {
     VulkanContext *v_ctx = malloc(sizeof(VulkanContext));
     if (v_ctx == NULL) {
         fprintf(stderr, "failed to alloc VulkanContext\n");
         return NULL;
     }
+    v_ctx->headless = window == NULL;
+    v_ctx->surface = VK_NULL_HANDLE;
+    v_ctx->debug_messenger = VK_NULL_HANDLE;
+    v_ctx->swapchain_ctx = NULL;
+    v_ctx->offscreen_ctx = NULL;
+    v_ctx->present_policy = present_policy;
+    v_ctx->wait_for_present = NULL;
 
-    // Vulkan instance
-    v_ctx->instance = create_instance();
+    // Vulkan instance, includes loader and ICD discovery
+    begin_trace_scope("create_instance");
+    v_ctx->instance = create_instance(v_ctx->headless);
+    end_trace_scope();
     if (v_ctx->instance == NULL) {
         fprintf(stderr, "failed to create VkInstance\n");
         return NULL;
     }
 
     // Window surface
-    v_ctx->surface = create_surface(v_ctx->instance, window);
-    if (v_ctx->surface == NULL) {
-        fprintf(stderr, "failed to create VkSurface\n");
-        return NULL;
+    if (!v_ctx->headless) {
+        begin_trace_scope("create_surface");
+        v_ctx->surface = create_surface(v_ctx->instance, window);
+        end_trace_scope();
+        if (v_ctx->surface == NULL) {
+            fprintf(stderr, "failed to create VkSurface\n");
+            return NULL;
+        }
     }
 
     // Additional validation layers
     if (ENABLE_VALIDATION_LAYERS) {
+        begin_trace_scope("create_debug_messenger");
         v_ctx->debug_messenger = create_debug_messenger(v_ctx->instance);
+        end_trace_scope();
         if (v_ctx->debug_messenger == VK_NULL_HANDLE) {
             fprintf(stderr, "failed to create debug messenger\n");
             return NULL;
@@ -33,58 +52,125 @@ VulkanContext *create_vulkan_context(GLFWwindow *window) {
     }
 
     // Pick physical device
+    begin_trace_scope("select_physical_device");
     v_ctx->physical_device = get_physical_device(v_ctx->instance, v_ctx->surface);
+    end_trace_scope();
     if (v_ctx->physical_device == NULL) {
         fprintf(stderr, "failed to find physical device\n");
         return NULL;
     }
 
     // Queue families
+    begin_trace_scope("find_queue_families");
+    Arena *scratch = get_scratch_arena();
+    ArenaMark mark = get_arena_mark(scratch);
     uint32_t family_count = 0;
-    VkQueueFamilyProperties *family_properties = get_queue_family_properties(v_ctx->physical_device, &family_count);
+    VkQueueFamilyProperties *family_properties = get_queue_family_properties(scratch, v_ctx->physical_device, &family_count);
     if (family_properties == NULL || family_count == 0) {
+        end_trace_scope();
         fprintf(stderr, "failed to get queue family properties\n");
         return NULL;
     }
 
     v_ctx->indices = get_unique_queue_family_indices(v_ctx->physical_device, v_ctx->surface, family_properties, family_count);
+    end_trace_scope();
     if (v_ctx->indices == NULL) {
         fprintf(stderr, "failed to get family indices\n");
         return NULL;
     }
 
     // Device creation
-    v_ctx->device = create_logical_device(v_ctx->physical_device, family_properties, family_count);
+    begin_trace_scope("create_logical_device");
+    v_ctx->device = create_logical_device(v_ctx->physical_device, v_ctx->surface, family_properties, family_count, &v_ctx->features);
+    end_trace_scope();
     if (v_ctx->device == NULL) {
         fprintf(stderr, "failed to create logical device\n");
         return NULL;
     }
 
+    // Queues
+    vkGetDeviceQueue(v_ctx->device, v_ctx->indices->graphics_index, 0, &v_ctx->graphics_queue);
+    v_ctx->present_queue = VK_NULL_HANDLE;
+    if (!v_ctx->headless) {
+        vkGetDeviceQueue(v_ctx->device, v_ctx->indices->present_index, 0, &v_ctx->present_queue);
+    }
+    vkGetDeviceQueue(v_ctx->device, v_ctx->indices->compute_index, 0, &v_ctx->compute_queue);
+    vkGetDeviceQueue(v_ctx->device, v_ctx->indices->transfer_index, 0, &v_ctx->transfer_queue);
+    printf("[QUEUES] graphics %d, compute %d, transfer %d\n", v_ctx->indices->graphics_index,
+        v_ctx->indices->compute_index, v_ctx->indices->transfer_index);
+
+    // Present pacing is optional, the policy falls back to fences alone
+    if (v_ctx->features.present_extensions) {
+        v_ctx->wait_for_present = (PFN_vkWaitForPresentKHR)vkGetDeviceProcAddr(v_ctx->device, "vkWaitForPresentKHR");
+    }
+
+    // Pipeline cache shared by all pipeline creation
+    begin_trace_scope("create_pipeline_cache");
+    v_ctx->pipeline_cache = create_pipeline_cache(v_ctx->device, v_ctx->physical_device, get_pipeline_cache_path());
+    end_trace_scope();
+    if (v_ctx->pipeline_cache == VK_NULL_HANDLE) {
+        fprintf(stderr, "failed to create pipeline cache\n");
+        return NULL;
+    }
+
+    // Buffers and images sub-allocate from pooled device memory
+    begin_trace_scope("create_gpu_allocator");
+    v_ctx->allocator = create_gpu_allocator(v_ctx->device, v_ctx->physical_device);
+    end_trace_scope();
+    if (v_ctx->allocator == NULL) {
+        fprintf(stderr, "failed to create gpu allocator\n");
+        return NULL;
+    }
+
+    reset_arena_to_mark(scratch, mark);
+    return v_ctx;
+}
+
+VulkanContext *create_vulkan_context(GLFWwindow *window, const PresentPolicy *present_policy) {
+    VulkanContext *v_ctx = create_base_vulkan_context(window, present_policy);
+    if (v_ctx == NULL) { return NULL; }
+
     // Swapchain
-    v_ctx->swapchain_ctx = create_swapchain_context(v_ctx, window);
+    begin_trace_scope("create_swapchain");
+    v_ctx->swapchain_ctx = create_swapchain_context(v_ctx, window, VK_NULL_HANDLE);
+    end_trace_scope();
     if (v_ctx->swapchain_ctx == NULL) {
         fprintf(stderr, "failed to create swapchain\n");
         return NULL;
     }
 
-    free(family_properties);
     return v_ctx;
 }
 
-SwapchainContext *create_swapchain_context(VulkanContext *v_ctx, GLFWwindow *window) {
+VulkanContext *create_headless_vulkan_context(VkExtent2D extent, uint32_t image_count, VkFormat format, const PresentPolicy *present_policy) {
+    VulkanContext *v_ctx = create_base_vulkan_context(NULL, present_policy);
+    if (v_ctx == NULL) { return NULL; }
+
+    // Offscreen render targets replace the swapchain
+    begin_trace_scope("create_offscreen_targets");
+    v_ctx->offscreen_ctx = create_offscreen_context(v_ctx, extent, image_count, format);
+    end_trace_scope();
+    if (v_ctx->offscreen_ctx == NULL) {
+        fprintf(stderr, "failed to create offscreen render targets\n");
+        return NULL;
+    }
+
+    return v_ctx;
+}
+
+// Passing the previous swapchain lets the driver reuse its images and keeps queued presents valid
+SwapchainContext *create_swapchain_context(VulkanContext *v_ctx, GLFWwindow *window, VkSwapchainKHR old_swapchain) {
     SwapchainContext *swapchain_ctx = malloc(sizeof(SwapchainContext));
     if (swapchain_ctx == NULL) { return NULL; }
 
-    SwapChainSupportDetails *details = query_swapchain_support_details(v_ctx->physical_device, v_ctx->surface);
+    Arena *scratch = get_scratch_arena();
+    ArenaMark mark = get_arena_mark(scratch);
+    SwapChainSupportDetails *details = query_swapchain_support_details(scratch, v_ctx->physical_device, v_ctx->surface);
     if (details == NULL) { return NULL; }
 
-    uint32_t image_count = details->capabilities.minImageCount + NO_BUFFERING;
-    if (details->capabilities.maxImageCount > 0 && image_count > details->capabilities.maxImageCount) {
-        image_count = details->capabilities.maxImageCount;
-    }
-
+    uint32_t image_count = select_policy_image_count(v_ctx->present_policy, &details->capabilities);
     VkSurfaceFormatKHR surface_format = get_swapchain_surface_format(details->formats, details->format_count);
-    VkPresentModeKHR present_mode = get_swapchain_present_mode(details->present_modes, details->present_mode_count);
+    VkPresentModeKHR present_mode = select_policy_present_mode(v_ctx->present_policy, details->present_modes, details->present_mode_count);
     VkExtent2D extent = get_swapchain_extent(details->capabilities, window);
 
     VkSwapchainCreateInfoKHR create_info;
@@ -123,38 +209,151 @@ SwapchainContext *create_swapchain_context(VulkanContext *v_ctx, GLFWwindow *win
 
     // Swapchain
     swapchain_ctx->image_count = image_count;
-    create_info.oldSwapchain = VK_NULL_HANDLE;
-    if (vkCreateSwapchainKHR(v_ctx->device, &create_info, NULL, &swapchain_ctx->swapchain) != VK_SUCCESS) {
+    create_info.oldSwapchain = old_swapchain;
+    VkResult result = vkCreateSwapchainKHR(v_ctx->device, &create_info, get_host_allocator(), &swapchain_ctx->swapchain);
+
+    // No longer need details
+    reset_arena_to_mark(scratch, mark);
+    if (result != VK_SUCCESS) {
+        free(swapchain_ctx);
         return NULL;
     }
-    // No longer need details
-    destroy_swapchain_support_details(details);
 
-    // Create swapchain images
+    // Create swapchain images, the driver may hand back more than the minimum we asked for
+    vkGetSwapchainImagesKHR(v_ctx->device, swapchain_ctx->swapchain, &image_count, NULL);
+    swapchain_ctx->image_count = image_count;
     swapchain_ctx->images = malloc(sizeof(VkImage) * image_count);
-    if (swapchain_ctx == NULL) { return NULL; }
+    if (swapchain_ctx->images == NULL) { return NULL; }
 
     vkGetSwapchainImagesKHR(v_ctx->device, swapchain_ctx->swapchain, &image_count, swapchain_ctx->images);
     swapchain_ctx->image_format = surface_format.format;
+    swapchain_ctx->present_mode = present_mode;
     swapchain_ctx->extent = extent;
+    printf("[PRESENT] %s policy, %s with %u images, %s\n", v_ctx->present_policy->name, get_present_mode_name(present_mode),
+        image_count, v_ctx->wait_for_present != NULL && v_ctx->present_policy->max_queued_presents > 0 ? "present wait pacing" : "fence pacing");
     swapchain_ctx->image_views = create_swapchain_image_views(v_ctx->device, swapchain_ctx, image_count);
-    if (swapchain_ctx == NULL) { return NULL; }
+    if (swapchain_ctx->image_views == NULL) { return NULL; }
+    swapchain_ctx->render_finished = create_swapchain_semaphores(v_ctx->device, image_count);
+    if (swapchain_ctx->render_finished == NULL) { return NULL; }
 
     return swapchain_ctx;
 }
 
+// Returns the replaced swapchain, the caller retires it once in flight frames are done with it
+SwapchainContext *recreate_swapchain_context(VulkanContext *v_ctx, GLFWwindow *window) {
+    SwapchainContext *old_swapchain_ctx = v_ctx->swapchain_ctx;
+
+    begin_trace_scope("recreate_swapchain");
+    SwapchainContext *swapchain_ctx = create_swapchain_context(v_ctx, window, old_swapchain_ctx->swapchain);
+    end_trace_scope();
+    if (swapchain_ctx == NULL) {
+        fprintf(stderr, "failed to recreate swapchain\n");
+        return NULL;
+    }
+
+    // The render pass and pipelines are built for the old format, rather than render with incompatible
+    // objects the recreate fails. The old swapchain is retired either way and is destroyed with the context
+    if (swapchain_ctx->image_format != old_swapchain_ctx->image_format) {
+        fprintf(stderr, "swapchain format changed, render pass no longer compatible\n");
+        destroy_swapchain_context(v_ctx->device, swapchain_ctx);
+        return NULL;
+    }
+
+    v_ctx->swapchain_ctx = swapchain_ctx;
+    return old_swapchain_ctx;
+}
+
+/*
+* Render targets
+*/
+VkExtent2D get_render_extent(VulkanContext *v_ctx) {
+    if (v_ctx->headless) {
+        return v_ctx->offscreen_ctx->extent;
+    }
+    return v_ctx->swapchain_ctx->extent;
+}
+
+VkFormat get_render_format(VulkanContext *v_ctx) {
+    if (v_ctx->headless) {
+        return v_ctx->offscreen_ctx->image_format;
+    }
+    return v_ctx->swapchain_ctx->image_format;
+}
+
+// Depth is sampled when the depth pyramid is built, D16 is the one format guaranteed to support both
+// VK_FORMAT_UNDEFINED when no candidate supports the usage, sampled depth feeds the depth pyramid
+VkFormat get_depth_format(VulkanContext *v_ctx, bool sampled) {
+    const VkFormat candidates[] = { VK_FORMAT_D32_SFLOAT, VK_FORMAT_X8_D24_UNORM_PACK32, VK_FORMAT_D16_UNORM };
+    VkFormatFeatureFlags required = VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT;
+    if (sampled) {
+        required |= VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT;
+    }
+    for (uint32_t i = 0; i < sizeof(candidates) / sizeof(candidates[0]); ++i) {
+        VkFormatProperties properties;
+        vkGetPhysicalDeviceFormatProperties(v_ctx->physical_device, candidates[i], &properties);
+        if ((properties.optimalTilingFeatures & required) == required) {
+            return candidates[i];
+        }
+    }
+    return VK_FORMAT_UNDEFINED;
+}
+
+uint32_t get_render_image_count(VulkanContext *v_ctx) {
+    if (v_ctx->headless) {
+        return v_ctx->offscreen_ctx->image_count;
+    }
+    return v_ctx->swapchain_ctx->image_count;
+}
+
+VkImage *get_render_images(VulkanContext *v_ctx) {
+    if (v_ctx->headless) {
+        return v_ctx->offscreen_ctx->images;
+    }
+    return v_ctx->swapchain_ctx->images;
+}
+
+VkImageView *get_render_image_views(VulkanContext *v_ctx) {
+    if (v_ctx->headless) {
+        return v_ctx->offscreen_ctx->image_views;
+    }
+    return v_ctx->swapchain_ctx->image_views;
+}
+
+/*
+* Pipeline cache
+*/
+bool flush_pipeline_cache(VulkanContext *v_ctx) {
+    return save_pipeline_cache(v_ctx->device, v_ctx->physical_device, v_ctx->pipeline_cache, get_pipeline_cache_path());
+}
+
 /*
 * Cleanup
 */
 void destroy_vulkan_context(VulkanContext *v_ctx) {
-    destroy_swapchain_context(v_ctx->device, v_ctx->swapchain_ctx);
-    vkDestroyDevice(v_ctx->device, NULL);
-    vkDestroySurfaceKHR(v_ctx->instance, v_ctx->surface, NULL);
+    print_gpu_allocator_stats(v_ctx->allocator);
+    if (v_ctx->headless) {
+        destroy_offscreen_context(v_ctx->device, v_ctx->allocator, v_ctx->offscreen_ctx);
+    } else {
+        destroy_swapchain_context(v_ctx->device, v_ctx->swapchain_ctx);
+    }
+
+    flush_pipeline_cache(v_ctx);
+    vkDestroyPipelineCache(v_ctx->device, v_ctx->pipeline_cache, get_host_allocator());
+    destroy_gpu_allocator(v_ctx->allocator);
+
+    vkDestroyDevice(v_ctx->device, get_host_allocator());
+    if (!v_ctx->headless) {
+        vkDestroySurfaceKHR(v_ctx->instance, v_ctx->surface, get_host_allocator());
+    }
     if (ENABLE_VALIDATION_LAYERS) {
-        destroy_debug_utils_msg_ext(v_ctx->instance, v_ctx->debug_messenger, NULL);
+        destroy_debug_utils_msg_ext(v_ctx->instance, v_ctx->debug_messenger, get_host_allocator());
     }
 
-    vkDestroyInstance(v_ctx->instance, NULL);
+    vkDestroyInstance(v_ctx->instance, get_host_allocator());
+
+    // Anything still live here was leaked by us or the driver
+    print_host_allocator_stats();
+    destroy_scratch_arena();
 
     free(v_ctx->indices);
     free(v_ctx);
@@ -4,35 +4,82 @@
 #define GLFW_INCLUDE_VULKAN
 #include "GLFW/glfw3.h"
 
+#include <stdbool.h>
+
+#include "arena.h"
+#include "device_features.h"
+#include "gpu_allocator.h"
+#include "host_allocator.h"
+#include "present_policy.h"
+#include "trace.h"
+
 typedef struct {
     VkSwapchainKHR swapchain;
     uint32_t image_count;
     VkImage *images;
     VkExtent2D extent;
     VkFormat image_format;
+    VkPresentModeKHR present_mode;
     VkImageView *image_views;
+    VkSemaphore *render_finished; // per image, only reused once the image is acquired again after its present
 } SwapchainContext;
 
+typedef struct {
+    uint32_t image_count;
+    VkImage *images;
+    GpuAllocation *allocations;
+    VkExtent2D extent;
+    VkFormat image_format;
+    VkImageView *image_views;
+} OffscreenContext;
+
 typedef struct {
     int16_t graphics_index, present_index;
+    int16_t compute_index, transfer_index;
 } QueueFamilyIndices;
 
 typedef struct {
+    bool headless;
     VkInstance instance;
     VkSurfaceKHR surface;
     VkDevice device;
     QueueFamilyIndices *indices;
+    VkQueue graphics_queue;
+    VkQueue present_queue;
+    VkQueue compute_queue;
+    VkQueue transfer_queue;
     VkPhysicalDevice physical_device;
+    DeviceFeatures features;
     VkDebugUtilsMessengerEXT debug_messenger;
+    VkPipelineCache pipeline_cache;
+    GpuAllocator *allocator;
+    const PresentPolicy *present_policy;
+    PFN_vkWaitForPresentKHR wait_for_present; // NULL without VK_KHR_present_wait
     SwapchainContext *swapchain_ctx;
+    OffscreenContext *offscreen_ctx;
 } VulkanContext;
 
 #include "device.h"
 #include "swapchain.h"
+#include "offscreen.h"
+#include "pipeline_cache.h"
 
 // Creation
-VulkanContext *create_vulkan_context(GLFWwindow *window);
-SwapchainContext *create_swapchain_context(VulkanContext *v_ctx, GLFWwindow *window);
+VulkanContext *create_vulkan_context(GLFWwindow *window, const PresentPolicy *present_policy);
+VulkanContext *create_headless_vulkan_context(VkExtent2D extent, uint32_t image_count, VkFormat format, const PresentPolicy *present_policy);
+SwapchainContext *create_swapchain_context(VulkanContext *v_ctx, GLFWwindow *window, VkSwapchainKHR old_swapchain);
+SwapchainContext *recreate_swapchain_context(VulkanContext *v_ctx, GLFWwindow *window);
+
+// Render targets
+VkExtent2D get_render_extent(VulkanContext *v_ctx);
+VkFormat get_render_format(VulkanContext *v_ctx);
+VkFormat get_depth_format(VulkanContext *v_ctx, bool sampled);
+uint32_t get_render_image_count(VulkanContext *v_ctx);
+VkImage *get_render_images(VulkanContext *v_ctx);
+VkImageView *get_render_image_views(VulkanContext *v_ctx);
+
+// Pipeline cache, also written on destroy
+bool flush_pipeline_cache(VulkanContext *v_ctx);
 
 // Cleanup
 void destroy_vulkan_context(VulkanContext *v_ctx);
@@ -1,20 +1,33 @@
 #version 450
 
+// MeshVertexFormat, quantized meshes store octahedral normals
+layout(constant_id = 0) const uint VERTEX_FORMAT = 0;
+const uint VERTEX_FORMAT_QUANTIZED = 1;
+
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec3 inNormal;
+layout(location = 2) in vec2 inUv;
+
 layout(location = 0) out vec3 fragColor;
 
-vec2 positions[3] = vec2[](
-    vec2(0.0, -0.5),
-    vec2(0.5, 0.5),
-    vec2(-0.5, 0.5)
-);
+// Dequantization folded together with the fit of the mesh bounds into clip space
+layout(push_constant) uniform MeshTransform {
+    vec4 position_scale;
+    vec4 position_offset;
+} transform;
 
-vec3 colors[3] = vec3[](
-    vec3(1.0, 0.0, 0.0),
-    vec3(0.0, 1.0, 0.0),
-    vec3(0.0, 0.0, 1.0)
-);
+vec3 decode_octahedral(vec2 encoded) {
+    vec3 n = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+    float fold = max(-n.z, 0.0);
+    n.x += n.x >= 0.0 ? -fold : fold;
+    n.y += n.y >= 0.0 ? -fold : fold;
+    return normalize(n);
+}
 
 void main() {
-    gl_Position = vec4(positions[gl_VertexIndex], 0.0, 1.0);
-    fragColor = colors[gl_VertexIndex];
-}
\ No newline at end of file
+    vec3 position = inPosition * transform.position_scale.xyz + transform.position_offset.xyz;
+    gl_Position = vec4(position.x, -position.y, 0.5 - position.z * 0.5, 1.0);
+
+    vec3 normal = VERTEX_FORMAT == VERTEX_FORMAT_QUANTIZED ? decode_octahedral(inNormal.xy) : inNormal;
+    fragColor = normal * 0.5 + 0.5;
+}
@@ -0,0 +1,1551 @@
+/*
+* Cooks OBJ and glTF meshes into the binary mesh format
+* usage: vrender_cook [--float] [--no-optimize] [--meshlets] <output.mesh> <input.obj|input.gltf|input.glb>
+* Vertices are quantized unless --float is given, and reordered for the vertex cache, overdraw
+* and vertex fetch unless --no-optimize is given
+*/
+#include "renderer/mesh_format.h"
+#include "optimize.h"
+
+#include <float.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_NODE_DEPTH 64
+
+typedef struct {
+    MeshVertex *vertices;
+    uint32_t vertex_count;
+    uint32_t vertex_capacity;
+    uint32_t *indices;
+    uint32_t index_count;
+    uint32_t index_capacity;
+    MeshFileSubmesh *submeshes;
+    uint32_t submesh_count;
+    uint32_t submesh_capacity;
+    MeshFileMeshlet *meshlets;
+    uint32_t meshlet_count;
+} CookedMesh;
+
+/*
+* Utilities
+*/
+static bool reserve_array(void **data, uint32_t *capacity, uint32_t count, size_t element_size) {
+    if (count <= *capacity) { return true; }
+
+    uint32_t new_capacity = *capacity == 0 ? 64 : *capacity;
+    while (new_capacity < count) {
+        new_capacity *= 2;
+    }
+
+    void *new_data = realloc(*data, new_capacity * element_size);
+    if (new_data == NULL) {
+        fprintf(stderr, "failed to grow array to %u elements\n", new_capacity);
+        return false;
+    }
+    *data = new_data;
+    *capacity = new_capacity;
+    return true;
+}
+
+static uint8_t *read_file(const char *path, size_t *size) {
+    FILE *fp = fopen(path, "rb");
+    if (fp == NULL) {
+        fprintf(stderr, "failed to open file: %s\n", path);
+        return NULL;
+    }
+
+    fseek(fp, 0, SEEK_END);
+    long fsize = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    if (fsize < 0) {
+        fclose(fp);
+        return NULL;
+    }
+
+    // Zero terminated so text formats can be parsed in place
+    uint8_t *buffer = malloc((size_t)fsize + 1);
+    if (buffer == NULL || fread(buffer, 1, (size_t)fsize, fp) != (size_t)fsize) {
+        fprintf(stderr, "failed to read file: %s\n", path);
+        free(buffer);
+        fclose(fp);
+        return NULL;
+    }
+
+    fclose(fp);
+    buffer[fsize] = '\0';
+    *size = (size_t)fsize;
+    return buffer;
+}
+
+static bool has_extension(const char *path, const char *extension) {
+    size_t path_length = strlen(path);
+    size_t extension_length = strlen(extension);
+    if (path_length < extension_length) { return false; }
+
+    const char *suffix = path + path_length - extension_length;
+    for (size_t i = 0; i < extension_length; ++i) {
+        char c = suffix[i];
+        if (c >= 'A' && c <= 'Z') {
+            c = (char)(c - 'A' + 'a');
+        }
+        if (c != extension[i]) { return false; }
+    }
+    return true;
+}
+
+static uint64_t align_up(uint64_t value, uint64_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+/*
+* Mesh building
+*/
+// Consecutive groups with no triangles collapse into the next one
+static MeshFileSubmesh *begin_submesh(CookedMesh *mesh) {
+    if (mesh->submesh_count > 0 && mesh->submeshes[mesh->submesh_count - 1].index_count == 0) {
+        MeshFileSubmesh *empty = &mesh->submeshes[mesh->submesh_count - 1];
+        mesh->vertex_count = empty->first_vertex;
+        empty->vertex_count = 0;
+        return empty;
+    }
+    if (!reserve_array((void **)&mesh->submeshes, &mesh->submesh_capacity, mesh->submesh_count + 1, sizeof(MeshFileSubmesh))) {
+        return NULL;
+    }
+
+    MeshFileSubmesh *submesh = &mesh->submeshes[mesh->submesh_count++];
+    memset(submesh, 0, sizeof(MeshFileSubmesh));
+    submesh->first_index = mesh->index_count;
+    submesh->first_vertex = mesh->vertex_count;
+    return submesh;
+}
+
+static bool push_vertex(CookedMesh *mesh, const MeshVertex *vertex) {
+    if (!reserve_array((void **)&mesh->vertices, &mesh->vertex_capacity, mesh->vertex_count + 1, sizeof(MeshVertex))) {
+        return false;
+    }
+    mesh->vertices[mesh->vertex_count++] = *vertex;
+    mesh->submeshes[mesh->submesh_count - 1].vertex_count++;
+    return true;
+}
+
+// Indices are relative to the current submesh's first vertex
+static bool push_index(CookedMesh *mesh, uint32_t index) {
+    if (!reserve_array((void **)&mesh->indices, &mesh->index_capacity, mesh->index_count + 1, sizeof(uint32_t))) {
+        return false;
+    }
+    mesh->indices[mesh->index_count++] = index;
+    mesh->submeshes[mesh->submesh_count - 1].index_count++;
+    return true;
+}
+
+static void drop_empty_submesh(CookedMesh *mesh) {
+    if (mesh->submesh_count > 0 && mesh->submeshes[mesh->submesh_count - 1].index_count == 0) {
+        mesh->vertex_count -= mesh->submeshes[mesh->submesh_count - 1].vertex_count;
+        --mesh->submesh_count;
+    }
+}
+
+static void normalize3(float *v) {
+    float length = sqrtf(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+    if (length > 0.0f) {
+        v[0] /= length;
+        v[1] /= length;
+        v[2] /= length;
+    }
+}
+
+// Area weighted face normals for vertices the source left without one
+static void generate_missing_normals(CookedMesh *mesh, const MeshFileSubmesh *submesh) {
+    MeshVertex *vertices = &mesh->vertices[submesh->first_vertex];
+    bool *missing = malloc(submesh->vertex_count * sizeof(bool));
+    if (missing == NULL) { return; }
+
+    bool any_missing = false;
+    for (uint32_t i = 0; i < submesh->vertex_count; ++i) {
+        const float *n = vertices[i].normal;
+        missing[i] = n[0] == 0.0f && n[1] == 0.0f && n[2] == 0.0f;
+        any_missing |= missing[i];
+    }
+
+    const uint32_t *indices = &mesh->indices[submesh->first_index];
+    for (uint32_t t = 0; any_missing && t + 2 < submesh->index_count; t += 3) {
+        const float *a = vertices[indices[t]].position;
+        const float *b = vertices[indices[t + 1]].position;
+        const float *c = vertices[indices[t + 2]].position;
+        float ab[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+        float ac[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+        float face[3] = {
+            ab[1] * ac[2] - ab[2] * ac[1],
+            ab[2] * ac[0] - ab[0] * ac[2],
+            ab[0] * ac[1] - ab[1] * ac[0]
+        };
+        for (uint32_t k = 0; k < 3; ++k) {
+            if (!missing[indices[t + k]]) { continue; }
+            float *n = vertices[indices[t + k]].normal;
+            n[0] += face[0];
+            n[1] += face[1];
+            n[2] += face[2];
+        }
+    }
+
+    for (uint32_t i = 0; i < submesh->vertex_count; ++i) {
+        normalize3(vertices[i].normal);
+    }
+    free(missing);
+}
+
+static void compute_bounds(CookedMesh *mesh, MeshFileSubmesh *submesh) {
+    for (uint32_t k = 0; k < 3; ++k) {
+        submesh->bounds_min[k] = FLT_MAX;
+        submesh->bounds_max[k] = -FLT_MAX;
+    }
+    for (uint32_t i = submesh->first_vertex; i < submesh->first_vertex + submesh->vertex_count; ++i) {
+        const float *p = mesh->vertices[i].position;
+        for (uint32_t k = 0; k < 3; ++k) {
+            submesh->bounds_min[k] = fminf(submesh->bounds_min[k], p[k]);
+            submesh->bounds_max[k] = fmaxf(submesh->bounds_max[k], p[k]);
+        }
+    }
+}
+
+/*
+* OBJ
+*/
+typedef struct {
+    int32_t position;
+    int32_t uv;
+    int32_t normal;
+    uint32_t vertex;
+} ObjVertexKey;
+
+// Open addressing over (position, uv, normal), cleared for every submesh
+typedef struct {
+    ObjVertexKey *slots;
+    uint32_t capacity;
+    uint32_t count;
+} ObjVertexMap;
+
+static uint32_t hash_obj_key(int32_t position, int32_t uv, int32_t normal) {
+    uint32_t hash = (uint32_t)position * 73856093u;
+    hash ^= (uint32_t)uv * 19349663u;
+    hash ^= (uint32_t)normal * 83492791u;
+    return hash;
+}
+
+static void clear_obj_vertex_map(ObjVertexMap *map) {
+    for (uint32_t i = 0; i < map->capacity; ++i) {
+        map->slots[i].position = 0;
+    }
+    map->count = 0;
+}
+
+static bool grow_obj_vertex_map(ObjVertexMap *map) {
+    uint32_t old_capacity = map->capacity;
+    ObjVertexKey *old_slots = map->slots;
+    map->capacity = old_capacity == 0 ? 1024 : old_capacity * 2;
+    map->slots = calloc(map->capacity, sizeof(ObjVertexKey));
+    if (map->slots == NULL) {
+        fprintf(stderr, "failed to alloc vertex map\n");
+        return false;
+    }
+
+    // Position indices are 1 based once resolved, 0 marks an empty slot
+    for (uint32_t i = 0; i < old_capacity; ++i) {
+        ObjVertexKey *key = &old_slots[i];
+        if (key->position == 0) { continue; }
+        uint32_t slot = hash_obj_key(key->position, key->uv, key->normal) & (map->capacity - 1);
+        while (map->slots[slot].position != 0) {
+            slot = (slot + 1) & (map->capacity - 1);
+        }
+        map->slots[slot] = *key;
+    }
+    free(old_slots);
+    return true;
+}
+
+typedef struct {
+    float *positions;
+    uint32_t position_count;
+    uint32_t position_capacity;
+    float *normals;
+    uint32_t normal_count;
+    uint32_t normal_capacity;
+    float *uvs;
+    uint32_t uv_count;
+    uint32_t uv_capacity;
+    ObjVertexMap vertex_map;
+} ObjState;
+
+// OBJ indices are 1 based, negative values count back from the latest element
+static int32_t resolve_obj_index(long index, uint32_t count) {
+    if (index < 0) {
+        index += (long)count + 1;
+    }
+    if (index <= 0 || index > (long)count) { return -1; }
+    return (int32_t)index;
+}
+
+static bool parse_obj_floats(const char **cursor, float *values, uint32_t count) {
+    for (uint32_t i = 0; i < count; ++i) {
+        char *end;
+        values[i] = strtof(*cursor, &end);
+        if (end == *cursor) { return false; }
+        *cursor = end;
+    }
+    return true;
+}
+
+static bool push_obj_floats(float **data, uint32_t *count, uint32_t *capacity, const float *values, uint32_t component_count) {
+    if (!reserve_array((void **)data, capacity, (*count + 1) * component_count, sizeof(float))) { return false; }
+    memcpy(*data + *count * component_count, values, component_count * sizeof(float));
+    ++*count;
+    return true;
+}
+
+static bool is_obj_index_start(char c) {
+    return c == '-' || (c >= '0' && c <= '9');
+}
+
+// Returns the vertex for one face corner, deduplicated within the current submesh
+static bool get_obj_vertex(CookedMesh *mesh, ObjState *obj, const char **cursor, uint32_t *vertex) {
+    char *end;
+    long position = strtol(*cursor, &end, 10);
+    if (end == *cursor) { return false; }
+    *cursor = end;
+
+    // Empty fields, as in "1//3" or "1/2/", leave that attribute out
+    long uv = 0;
+    long normal = 0;
+    if (**cursor == '/') {
+        ++*cursor;
+        if (is_obj_index_start(**cursor)) {
+            uv = strtol(*cursor, &end, 10);
+            *cursor = end;
+        }
+        if (**cursor == '/') {
+            ++*cursor;
+            if (is_obj_index_start(**cursor)) {
+                normal = strtol(*cursor, &end, 10);
+                *cursor = end;
+            }
+        }
+    }
+
+    int32_t position_index = resolve_obj_index(position, obj->position_count);
+    int32_t uv_index = uv != 0 ? resolve_obj_index(uv, obj->uv_count) : 0;
+    int32_t normal_index = normal != 0 ? resolve_obj_index(normal, obj->normal_count) : 0;
+    if (position_index < 0 || uv_index < 0 || normal_index < 0) {
+        fprintf(stderr, "face index out of range\n");
+        return false;
+    }
+
+    ObjVertexMap *map = &obj->vertex_map;
+    if ((map->count + 1) * 2 > map->capacity && !grow_obj_vertex_map(map)) { return false; }
+
+    uint32_t slot = hash_obj_key(position_index, uv_index, normal_index) & (map->capacity - 1);
+    while (map->slots[slot].position != 0) {
+        ObjVertexKey *key = &map->slots[slot];
+        if (key->position == position_index && key->uv == uv_index && key->normal == normal_index) {
+            *vertex = key->vertex;
+            return true;
+        }
+        slot = (slot + 1) & (map->capacity - 1);
+    }
+
+    MeshVertex cooked;
+    memset(&cooked, 0, sizeof(MeshVertex));
+    memcpy(cooked.position, &obj->positions[(position_index - 1) * 3], sizeof(cooked.position));
+    if (normal_index > 0) {
+        memcpy(cooked.normal, &obj->normals[(normal_index - 1) * 3], sizeof(cooked.normal));
+    }
+    if (uv_index > 0) {
+        cooked.uv[0] = obj->uvs[(uv_index - 1) * 2];
+        cooked.uv[1] = 1.0f - obj->uvs[(uv_index - 1) * 2 + 1]; // OBJ puts the origin at the bottom left
+    }
+
+    *vertex = mesh->submeshes[mesh->submesh_count - 1].vertex_count;
+    if (!push_vertex(mesh, &cooked)) { return false; }
+
+    map->slots[slot].position = position_index;
+    map->slots[slot].uv = uv_index;
+    map->slots[slot].normal = normal_index;
+    map->slots[slot].vertex = *vertex;
+    ++map->count;
+    return true;
+}
+
+// Polygons are triangulated as fans around their first corner
+static bool parse_obj_face(CookedMesh *mesh, ObjState *obj, const char *cursor) {
+    uint32_t first = 0;
+    uint32_t previous = 0;
+    uint32_t corner_count = 0;
+    while (true) {
+        while (*cursor == ' ' || *cursor == '\t') {
+            ++cursor;
+        }
+        if (*cursor == '\0' || *cursor == '\r' || *cursor == '#') { break; }
+
+        uint32_t vertex;
+        if (!get_obj_vertex(mesh, obj, &cursor, &vertex)) { return false; }
+
+        if (corner_count == 0) {
+            first = vertex;
+        } else if (corner_count >= 2) {
+            if (!push_index(mesh, first) || !push_index(mesh, previous) || !push_index(mesh, vertex)) { return false; }
+        }
+        previous = vertex;
+        ++corner_count;
+    }
+    return corner_count >= 3 || corner_count == 0;
+}
+
+static void finish_obj_submesh(CookedMesh *mesh) {
+    if (mesh->submesh_count == 0) { return; }
+    generate_missing_normals(mesh, &mesh->submeshes[mesh->submesh_count - 1]);
+}
+
+// Objects, groups and material changes each start a submesh
+static bool cook_obj(const char *path, CookedMesh *mesh) {
+    size_t size;
+    char *text = (char *)read_file(path, &size);
+    if (text == NULL) { return false; }
+
+    ObjState obj;
+    memset(&obj, 0, sizeof(ObjState));
+    bool success = begin_submesh(mesh) != NULL;
+
+    uint32_t line_number = 0;
+    char *line = text;
+    while (success && line != NULL && *line != '\0') {
+        char *next = strchr(line, '\n');
+        if (next != NULL) {
+            *next++ = '\0';
+        }
+        ++line_number;
+
+        while (*line == ' ' || *line == '\t') {
+            ++line;
+        }
+
+        const char *cursor = line + 2;
+        float values[3];
+        if (strncmp(line, "v ", 2) == 0) {
+            success = parse_obj_floats(&cursor, values, 3)
+                && push_obj_floats(&obj.positions, &obj.position_count, &obj.position_capacity, values, 3);
+        } else if (strncmp(line, "vn ", 3) == 0) {
+            cursor = line + 3;
+            success = parse_obj_floats(&cursor, values, 3)
+                && push_obj_floats(&obj.normals, &obj.normal_count, &obj.normal_capacity, values, 3);
+        } else if (strncmp(line, "vt ", 3) == 0) {
+            cursor = line + 3;
+            success = parse_obj_floats(&cursor, values, 2)
+                && push_obj_floats(&obj.uvs, &obj.uv_count, &obj.uv_capacity, values, 2);
+        } else if (strncmp(line, "f ", 2) == 0) {
+            success = parse_obj_face(mesh, &obj, cursor);
+        } else if (strncmp(line, "o ", 2) == 0 || strncmp(line, "g ", 2) == 0 || strncmp(line, "usemtl ", 7) == 0) {
+            finish_obj_submesh(mesh);
+            success = begin_submesh(mesh) != NULL;
+            clear_obj_vertex_map(&obj.vertex_map);
+        }
+
+        if (!success) {
+            fprintf(stderr, "%s:%u: failed to parse line\n", path, line_number);
+        }
+        line = next;
+    }
+
+    if (success) {
+        finish_obj_submesh(mesh);
+        drop_empty_submesh(mesh);
+    }
+
+    free(obj.positions);
+    free(obj.normals);
+    free(obj.uvs);
+    free(obj.vertex_map.slots);
+    free(text);
+    return success;
+}
+
+/*
+* JSON
+*/
+typedef enum {
+    JSON_NULL,
+    JSON_BOOL,
+    JSON_NUMBER,
+    JSON_STRING,
+    JSON_ARRAY,
+    JSON_OBJECT
+} JsonType;
+
+// Strings point into the source text and are not unescaped, glTF keys and URIs rarely need it
+typedef struct JsonValue {
+    JsonType type;
+    double number;
+    const char *string;
+    uint32_t length;
+    const char **keys; // objects only
+    uint32_t *key_lengths;
+    struct JsonValue *children;
+    uint32_t child_count;
+} JsonValue;
+
+typedef struct {
+    const char *cursor;
+    const char *end;
+} JsonParser;
+
+static void skip_json_whitespace(JsonParser *parser) {
+    while (parser->cursor < parser->end
+        && (*parser->cursor == ' ' || *parser->cursor == '\t' || *parser->cursor == '\n' || *parser->cursor == '\r')) {
+        ++parser->cursor;
+    }
+}
+
+static bool parse_json_string(JsonParser *parser, const char **string, uint32_t *length) {
+    if (parser->cursor >= parser->end || *parser->cursor != '"') { return false; }
+    const char *start = ++parser->cursor;
+    while (parser->cursor < parser->end && *parser->cursor != '"') {
+        if (*parser->cursor == '\\') {
+            ++parser->cursor;
+        }
+        ++parser->cursor;
+    }
+    if (parser->cursor >= parser->end) { return false; }
+
+    *string = start;
+    *length = (uint32_t)(parser->cursor - start);
+    ++parser->cursor;
+    return true;
+}
+
+static bool parse_json_value(JsonParser *parser, JsonValue *value, uint32_t depth);
+
+static bool parse_json_children(JsonParser *parser, JsonValue *value, bool object, uint32_t depth) {
+    uint32_t capacity = 0;
+    uint32_t key_capacity = 0;
+    uint32_t key_length_capacity = 0;
+    char close = object ? '}' : ']';
+
+    ++parser->cursor;
+    skip_json_whitespace(parser);
+    if (parser->cursor < parser->end && *parser->cursor == close) {
+        ++parser->cursor;
+        return true;
+    }
+
+    while (true) {
+        skip_json_whitespace(parser);
+        uint32_t index = value->child_count;
+        if (!reserve_array((void **)&value->children, &capacity, index + 1, sizeof(JsonValue))) { return false; }
+        memset(&value->children[index], 0, sizeof(JsonValue));
+
+        if (object) {
+            if (!reserve_array((void **)&value->keys, &key_capacity, index + 1, sizeof(const char *))
+                || !reserve_array((void **)&value->key_lengths, &key_length_capacity, index + 1, sizeof(uint32_t))
+                || !parse_json_string(parser, &value->keys[index], &value->key_lengths[index])) {
+                return false;
+            }
+            skip_json_whitespace(parser);
+            if (parser->cursor >= parser->end || *parser->cursor != ':') { return false; }
+            ++parser->cursor;
+        }
+
+        ++value->child_count;
+        if (!parse_json_value(parser, &value->children[index], depth + 1)) { return false; }
+
+        skip_json_whitespace(parser);
+        if (parser->cursor >= parser->end) { return false; }
+        if (*parser->cursor == close) {
+            ++parser->cursor;
+            return true;
+        }
+        if (*parser->cursor != ',') { return false; }
+        ++parser->cursor;
+    }
+}
+
+static bool parse_json_value(JsonParser *parser, JsonValue *value, uint32_t depth) {
+    if (depth > MAX_NODE_DEPTH) { return false; }
+
+    skip_json_whitespace(parser);
+    if (parser->cursor >= parser->end) { return false; }
+
+    char c = *parser->cursor;
+    if (c == '{' || c == '[') {
+        value->type = c == '{' ? JSON_OBJECT : JSON_ARRAY;
+        return parse_json_children(parser, value, c == '{', depth);
+    }
+    if (c == '"') {
+        value->type = JSON_STRING;
+        return parse_json_string(parser, &value->string, &value->length);
+    }
+
+    size_t remaining = (size_t)(parser->end - parser->cursor);
+    if (remaining >= 4 && strncmp(parser->cursor, "true", 4) == 0) {
+        value->type = JSON_BOOL;
+        value->number = 1.0;
+        parser->cursor += 4;
+        return true;
+    }
+    if (remaining >= 5 && strncmp(parser->cursor, "false", 5) == 0) {
+        value->type = JSON_BOOL;
+        parser->cursor += 5;
+        return true;
+    }
+    if (remaining >= 4 && strncmp(parser->cursor, "null", 4) == 0) {
+        value->type = JSON_NULL;
+        parser->cursor += 4;
+        return true;
+    }
+
+    // The source is zero terminated, so strtod cannot run past the end
+    char *end;
+    value->type = JSON_NUMBER;
+    value->number = strtod(parser->cursor, &end);
+    if (end == parser->cursor) { return false; }
+    parser->cursor = end;
+    return true;
+}
+
+static void free_json_value(JsonValue *value) {
+    for (uint32_t i = 0; i < value->child_count; ++i) {
+        free_json_value(&value->children[i]);
+    }
+    free(value->children);
+    free(value->keys);
+    free(value->key_lengths);
+}
+
+static const JsonValue *get_json_member(const JsonValue *object, const char *key) {
+    if (object == NULL || object->type != JSON_OBJECT) { return NULL; }
+
+    size_t length = strlen(key);
+    for (uint32_t i = 0; i < object->child_count; ++i) {
+        if (object->key_lengths[i] == length && strncmp(object->keys[i], key, length) == 0) {
+            return &object->children[i];
+        }
+    }
+    return NULL;
+}
+
+static const JsonValue *get_json_element(const JsonValue *array, uint32_t index) {
+    if (array == NULL || array->type != JSON_ARRAY || index >= array->child_count) { return NULL; }
+    return &array->children[index];
+}
+
+static double get_json_number(const JsonValue *value, double fallback) {
+    return value != NULL && value->type == JSON_NUMBER ? value->number : fallback;
+}
+
+// Indices, counts and byte offsets, a missing value takes the fallback but a fractional,
+// negative or out of range one fails instead of wrapping through the cast
+static bool get_json_uint(const JsonValue *value, uint32_t fallback, uint32_t *out) {
+    if (value == NULL) {
+        *out = fallback;
+        return true;
+    }
+    if (value->type != JSON_NUMBER || !(value->number >= 0.0) || value->number > (double)UINT32_MAX
+        || value->number != floor(value->number)) {
+        return false;
+    }
+    *out = (uint32_t)value->number;
+    return true;
+}
+
+static bool is_json_string(const JsonValue *value, const char *string) {
+    return value != NULL && value->type == JSON_STRING
+        && value->length == strlen(string) && strncmp(value->string, string, value->length) == 0;
+}
+
+/*
+* glTF
+*/
+#define GLB_MAGIC 0x46546C67 // "glTF"
+#define GLB_CHUNK_JSON 0x4E4F534A
+#define GLB_CHUNK_BIN 0x004E4942
+
+#define GLTF_BYTE 5120
+#define GLTF_UNSIGNED_BYTE 5121
+#define GLTF_SHORT 5122
+#define GLTF_UNSIGNED_SHORT 5123
+#define GLTF_UNSIGNED_INT 5125
+#define GLTF_FLOAT 5126
+#define GLTF_TRIANGLES 4
+#define GLTF_MAX_BYTE_STRIDE 252
+
+typedef struct {
+    const uint8_t *data;
+    size_t size;
+    uint8_t *owned; // NULL for the GLB binary chunk
+} GltfBuffer;
+
+typedef struct {
+    JsonValue root;
+    GltfBuffer *buffers;
+    uint32_t buffer_count;
+} Gltf;
+
+static int decode_base64_char(char c) {
+    if (c >= 'A' && c <= 'Z') { return c - 'A'; }
+    if (c >= 'a' && c <= 'z') { return c - 'a' + 26; }
+    if (c >= '0' && c <= '9') { return c - '0' + 52; }
+    if (c == '+' || c == '-') { return 62; }
+    if (c == '/' || c == '_') { return 63; }
+    return -1;
+}
+
+static uint8_t *decode_base64(const char *text, uint32_t length, size_t *size) {
+    uint8_t *data = malloc(length / 4 * 3 + 3);
+    if (data == NULL) { return NULL; }
+
+    uint32_t bits = 0;
+    uint32_t bit_count = 0;
+    size_t written = 0;
+    for (uint32_t i = 0; i < length; ++i) {
+        int value = decode_base64_char(text[i]);
+        if (value < 0) { continue; }
+        bits = (bits << 6) | (uint32_t)value;
+        bit_count += 6;
+        if (bit_count >= 8) {
+            bit_count -= 8;
+            data[written++] = (uint8_t)(bits >> bit_count);
+        }
+    }
+
+    *size = written;
+    return data;
+}
+
+static bool load_gltf_buffer(const char *path, const JsonValue *buffer, const uint8_t *glb_bin, size_t glb_bin_size, GltfBuffer *out) {
+    const JsonValue *uri = get_json_member(buffer, "uri");
+    out->owned = NULL;
+    if (uri == NULL) {
+        if (glb_bin == NULL) {
+            fprintf(stderr, "buffer without uri outside a GLB\n");
+            return false;
+        }
+        out->data = glb_bin;
+        out->size = glb_bin_size;
+        return true;
+    }
+    if (uri->type != JSON_STRING) { return false; }
+
+    static const char DATA_PREFIX[] = "data:";
+    if (uri->length > 5 && strncmp(uri->string, DATA_PREFIX, 5) == 0) {
+        const char *comma = memchr(uri->string, ',', uri->length);
+        if (comma == NULL) { return false; }
+        uint32_t offset = (uint32_t)(comma + 1 - uri->string);
+        out->owned = decode_base64(comma + 1, uri->length - offset, &out->size);
+        out->data = out->owned;
+        return out->owned != NULL;
+    }
+
+    // Relative to the glTF file, percent escapes are not decoded
+    const char *slash = NULL;
+    for (const char *c = path; *c != '\0'; ++c) {
+        if (*c == '/' || *c == '\\') {
+            slash = c;
+        }
+    }
+    size_t directory_length = slash != NULL ? (size_t)(slash - path + 1) : 0;
+    char *buffer_path = malloc(directory_length + uri->length + 1);
+    if (buffer_path == NULL) { return false; }
+    memcpy(buffer_path, path, directory_length);
+    memcpy(buffer_path + directory_length, uri->string, uri->length);
+    buffer_path[directory_length + uri->length] = '\0';
+
+    out->owned = read_file(buffer_path, &out->size);
+    out->data = out->owned;
+    free(buffer_path);
+    return out->owned != NULL;
+}
+
+static uint32_t get_component_size(uint32_t component_type) {
+    switch (component_type) {
+        case GLTF_BYTE:
+        case GLTF_UNSIGNED_BYTE:
+            return 1;
+        case GLTF_SHORT:
+        case GLTF_UNSIGNED_SHORT:
+            return 2;
+        case GLTF_UNSIGNED_INT:
+        case GLTF_FLOAT:
+            return 4;
+        default:
+            return 0;
+    }
+}
+
+static uint32_t get_type_component_count(const JsonValue *type) {
+    if (is_json_string(type, "SCALAR")) { return 1; }
+    if (is_json_string(type, "VEC2")) { return 2; }
+    if (is_json_string(type, "VEC3")) { return 3; }
+    if (is_json_string(type, "VEC4")) { return 4; }
+    return 0;
+}
+
+typedef struct {
+    const uint8_t *data;
+    uint32_t count;
+    uint32_t stride;
+    uint32_t component_type;
+    uint32_t component_count;
+    bool normalized;
+} GltfAccessor;
+
+// Resolves an accessor down to a strided view into its buffer, bounds checked once here
+static bool get_gltf_accessor(const Gltf *gltf, uint32_t index, GltfAccessor *accessor) {
+    const JsonValue *json = get_json_element(get_json_member(&gltf->root, "accessors"), index);
+    if (json == NULL) { return false; }
+    if (get_json_member(json, "sparse") != NULL) {
+        fprintf(stderr, "sparse accessors are not supported\n");
+        return false;
+    }
+
+    const JsonValue *view_index = get_json_member(json, "bufferView");
+    uint32_t view_number, buffer_index;
+    if (view_index == NULL || !get_json_uint(view_index, 0, &view_number)) { return false; }
+    const JsonValue *view = get_json_element(get_json_member(&gltf->root, "bufferViews"), view_number);
+    if (view == NULL) { return false; }
+
+    if (!get_json_uint(get_json_member(view, "buffer"), UINT32_MAX, &buffer_index) || buffer_index >= gltf->buffer_count) {
+        return false;
+    }
+    const GltfBuffer *buffer = &gltf->buffers[buffer_index];
+
+    if (!get_json_uint(get_json_member(json, "count"), 0, &accessor->count)
+        || !get_json_uint(get_json_member(json, "componentType"), 0, &accessor->component_type)) {
+        fprintf(stderr, "accessor %u has an invalid count or component type\n", index);
+        return false;
+    }
+    accessor->component_count = get_type_component_count(get_json_member(json, "type"));
+    const JsonValue *normalized = get_json_member(json, "normalized");
+    accessor->normalized = normalized != NULL && normalized->type == JSON_BOOL && normalized->number != 0.0;
+
+    uint32_t element_size = get_component_size(accessor->component_type) * accessor->component_count;
+    if (element_size == 0) { return false; }
+
+    // Every value is at most 32 bits, so none of the sums below can wrap in 64
+    uint32_t view_offset, view_length, accessor_offset;
+    bool valid = get_json_uint(get_json_member(view, "byteStride"), element_size, &accessor->stride)
+        && get_json_uint(get_json_member(view, "byteOffset"), 0, &view_offset)
+        && get_json_uint(get_json_member(view, "byteLength"), 0, &view_length)
+        && get_json_uint(get_json_member(json, "byteOffset"), 0, &accessor_offset);
+    if (!valid || accessor->stride < element_size || accessor->stride > GLTF_MAX_BYTE_STRIDE) {
+        fprintf(stderr, "accessor %u has an invalid layout\n", index);
+        return false;
+    }
+
+    uint64_t offset = (uint64_t)view_offset + accessor_offset;
+    uint64_t view_end = (uint64_t)view_offset + view_length;
+    uint64_t end = accessor->count == 0 ? offset : offset + (uint64_t)(accessor->count - 1) * accessor->stride + element_size;
+    if (end > view_end || view_end > buffer->size) {
+        fprintf(stderr, "accessor %u out of bounds\n", index);
+        return false;
+    }
+
+    accessor->data = buffer->data + offset;
+    return true;
+}
+
+// Layouts glTF allows per attribute, anything else would read past or misread each element
+static bool is_gltf_attribute_layout_valid(const GltfAccessor *accessor, uint32_t component_count, bool normalized_integers) {
+    if (accessor->component_count != component_count) { return false; }
+    if (accessor->component_type == GLTF_FLOAT) { return true; }
+    return normalized_integers && accessor->normalized
+        && (accessor->component_type == GLTF_UNSIGNED_BYTE || accessor->component_type == GLTF_UNSIGNED_SHORT);
+}
+
+static bool is_gltf_index_layout_valid(const GltfAccessor *accessor) {
+    return accessor->component_count == 1 && !accessor->normalized
+        && (accessor->component_type == GLTF_UNSIGNED_BYTE || accessor->component_type == GLTF_UNSIGNED_SHORT
+        || accessor->component_type == GLTF_UNSIGNED_INT);
+}
+
+static bool get_gltf_attribute(const Gltf *gltf, const JsonValue *index, const char *name, uint32_t component_count,
+    bool normalized_integers, GltfAccessor *accessor) {
+    uint32_t accessor_index;
+    if (!get_json_uint(index, 0, &accessor_index) || !get_gltf_accessor(gltf, accessor_index, accessor)) { return false; }
+    if (!is_gltf_attribute_layout_valid(accessor, component_count, normalized_integers)) {
+        fprintf(stderr, "accessor %u has an unsupported layout for %s\n", accessor_index, name);
+        return false;
+    }
+    return true;
+}
+
+static float read_gltf_component(const GltfAccessor *accessor, uint32_t element, uint32_t component) {
+    const uint8_t *p = accessor->data + (size_t)element * accessor->stride;
+    switch (accessor->component_type) {
+        case GLTF_FLOAT: {
+            float value;
+            memcpy(&value, p + component * 4, sizeof(float));
+            return value;
+        }
+        case GLTF_UNSIGNED_BYTE:
+            return accessor->normalized ? p[component] / 255.0f : p[component];
+        case GLTF_BYTE:
+            return accessor->normalized ? fmaxf((int8_t)p[component] / 127.0f, -1.0f) : (int8_t)p[component];
+        case GLTF_UNSIGNED_SHORT: {
+            uint16_t value;
+            memcpy(&value, p + component * 2, sizeof(uint16_t));
+            return accessor->normalized ? value / 65535.0f : value;
+        }
+        case GLTF_SHORT: {
+            int16_t value;
+            memcpy(&value, p + component * 2, sizeof(int16_t));
+            return accessor->normalized ? fmaxf(value / 32767.0f, -1.0f) : value;
+        }
+        default:
+            return 0.0f;
+    }
+}
+
+static uint32_t read_gltf_index(const GltfAccessor *accessor, uint32_t element) {
+    const uint8_t *p = accessor->data + (size_t)element * accessor->stride;
+    switch (accessor->component_type) {
+        case GLTF_UNSIGNED_BYTE:
+            return p[0];
+        case GLTF_UNSIGNED_SHORT: {
+            uint16_t value;
+            memcpy(&value, p, sizeof(uint16_t));
+            return value;
+        }
+        default: {
+            uint32_t value;
+            memcpy(&value, p, sizeof(uint32_t));
+            return value;
+        }
+    }
+}
+
+static void multiply_matrices(const float *a, const float *b, float *out) {
+    float result[16];
+    for (uint32_t column = 0; column < 4; ++column) {
+        for (uint32_t row = 0; row < 4; ++row) {
+            float sum = 0.0f;
+            for (uint32_t k = 0; k < 4; ++k) {
+                sum += a[k * 4 + row] * b[column * 4 + k];
+            }
+            result[column * 4 + row] = sum;
+        }
+    }
+    memcpy(out, result, sizeof(result));
+}
+
+// Column major, either the node's matrix or translation * rotation * scale
+static void get_node_matrix(const JsonValue *node, float *matrix) {
+    const JsonValue *values = get_json_member(node, "matrix");
+    if (values != NULL && values->child_count == 16) {
+        for (uint32_t i = 0; i < 16; ++i) {
+            matrix[i] = (float)get_json_number(&values->children[i], 0.0);
+        }
+        return;
+    }
+
+    float t[3] = { 0.0f, 0.0f, 0.0f };
+    float r[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+    float s[3] = { 1.0f, 1.0f, 1.0f };
+    const JsonValue *translation = get_json_member(node, "translation");
+    const JsonValue *rotation = get_json_member(node, "rotation");
+    const JsonValue *scale = get_json_member(node, "scale");
+    for (uint32_t i = 0; i < 3; ++i) {
+        t[i] = (float)get_json_number(get_json_element(translation, i), t[i]);
+        s[i] = (float)get_json_number(get_json_element(scale, i), s[i]);
+    }
+    for (uint32_t i = 0; i < 4; ++i) {
+        r[i] = (float)get_json_number(get_json_element(rotation, i), r[i]);
+    }
+
+    float x = r[0], y = r[1], z = r[2], w = r[3];
+    float rotation_matrix[9] = {
+        1.0f - 2.0f * (y * y + z * z), 2.0f * (x * y + z * w), 2.0f * (x * z - y * w),
+        2.0f * (x * y - z * w), 1.0f - 2.0f * (x * x + z * z), 2.0f * (y * z + x * w),
+        2.0f * (x * z + y * w), 2.0f * (y * z - x * w), 1.0f - 2.0f * (x * x + y * y)
+    };
+    for (uint32_t column = 0; column < 3; ++column) {
+        for (uint32_t row = 0; row < 3; ++row) {
+            matrix[column * 4 + row] = rotation_matrix[column * 3 + row] * s[column];
+        }
+        matrix[column * 4 + 3] = 0.0f;
+    }
+    matrix[12] = t[0];
+    matrix[13] = t[1];
+    matrix[14] = t[2];
+    matrix[15] = 1.0f;
+}
+
+static float get_matrix_determinant(const float *m) {
+    return m[0] * (m[5] * m[10] - m[9] * m[6])
+        - m[4] * (m[1] * m[10] - m[9] * m[2])
+        + m[8] * (m[1] * m[6] - m[5] * m[2]);
+}
+
+static void cross3(const float *a, const float *b, float *out) {
+    out[0] = a[1] * b[2] - a[2] * b[1];
+    out[1] = a[2] * b[0] - a[0] * b[2];
+    out[2] = a[0] * b[1] - a[1] * b[0];
+}
+
+// Inverse transpose of the upper 3x3, column major. The columns of the cofactor matrix are cross
+// products of the matrix columns, only the sign of 1 / det is kept since normals are renormalized
+static void get_normal_matrix(const float *m, float *normal_matrix) {
+    float sign = get_matrix_determinant(m) < 0.0f ? -1.0f : 1.0f;
+    cross3(&m[4], &m[8], &normal_matrix[0]);
+    cross3(&m[8], &m[0], &normal_matrix[3]);
+    cross3(&m[0], &m[4], &normal_matrix[6]);
+    for (uint32_t i = 0; i < 9; ++i) {
+        normal_matrix[i] *= sign;
+    }
+}
+
+// One submesh per triangle primitive, positions and normals baked into world space
+static bool cook_gltf_primitive(const Gltf *gltf, const JsonValue *primitive, const float *matrix, CookedMesh *mesh) {
+    uint32_t mode;
+    if (!get_json_uint(get_json_member(primitive, "mode"), GLTF_TRIANGLES, &mode)) {
+        fprintf(stderr, "primitive with an invalid mode\n");
+        return false;
+    }
+    if (mode != GLTF_TRIANGLES) {
+        fprintf(stderr, "skipping primitive with mode %u\n", mode);
+        return true;
+    }
+
+    const JsonValue *attributes = get_json_member(primitive, "attributes");
+    const JsonValue *position_index = get_json_member(attributes, "POSITION");
+    const JsonValue *normal_index = get_json_member(attributes, "NORMAL");
+    const JsonValue *uv_index = get_json_member(attributes, "TEXCOORD_0");
+    const JsonValue *indices_index = get_json_member(primitive, "indices");
+
+    GltfAccessor positions, normals, uvs, indices;
+    if (position_index == NULL) {
+        fprintf(stderr, "primitive without positions\n");
+        return false;
+    }
+    if (!get_gltf_attribute(gltf, position_index, "POSITION", 3, false, &positions)) { return false; }
+    if (normal_index != NULL && !get_gltf_attribute(gltf, normal_index, "NORMAL", 3, false, &normals)) { return false; }
+    if (uv_index != NULL && !get_gltf_attribute(gltf, uv_index, "TEXCOORD_0", 2, true, &uvs)) { return false; }
+    bool has_normals = normal_index != NULL && normals.count == positions.count;
+    bool has_uvs = uv_index != NULL && uvs.count == positions.count;
+
+    bool has_indices = indices_index != NULL;
+    uint32_t indices_accessor;
+    if (has_indices && (!get_json_uint(indices_index, 0, &indices_accessor) || !get_gltf_accessor(gltf, indices_accessor, &indices))) {
+        return false;
+    }
+    if (has_indices && !is_gltf_index_layout_valid(&indices)) {
+        fprintf(stderr, "accessor %u has an unsupported layout for indices\n", indices_accessor);
+        return false;
+    }
+
+    MeshFileSubmesh *submesh = begin_submesh(mesh);
+    if (submesh == NULL) { return false; }
+
+    // Normals go through the inverse transpose so non uniform scale keeps them perpendicular
+    float normal_matrix[9];
+    get_normal_matrix(matrix, normal_matrix);
+    for (uint32_t i = 0; i < positions.count; ++i) {
+        MeshVertex vertex;
+        memset(&vertex, 0, sizeof(MeshVertex));
+        float p[3], n[3] = { 0.0f, 0.0f, 0.0f };
+        for (uint32_t k = 0; k < 3; ++k) {
+            p[k] = read_gltf_component(&positions, i, k);
+            n[k] = has_normals ? read_gltf_component(&normals, i, k) : 0.0f;
+        }
+        for (uint32_t k = 0; k < 3; ++k) {
+            vertex.position[k] = matrix[k] * p[0] + matrix[4 + k] * p[1] + matrix[8 + k] * p[2] + matrix[12 + k];
+            vertex.normal[k] = normal_matrix[k] * n[0] + normal_matrix[3 + k] * n[1] + normal_matrix[6 + k] * n[2];
+        }
+        normalize3(vertex.normal);
+        if (has_uvs) {
+            vertex.uv[0] = read_gltf_component(&uvs, i, 0);
+            vertex.uv[1] = read_gltf_component(&uvs, i, 1);
+        }
+        if (!push_vertex(mesh, &vertex)) { return false; }
+    }
+
+    // Mirroring transforms flip the winding
+    bool flip = get_matrix_determinant(matrix) < 0.0f;
+    uint32_t index_count = has_indices ? indices.count : positions.count;
+    for (uint32_t t = 0; t + 2 < index_count; t += 3) {
+        uint32_t corners[3];
+        for (uint32_t k = 0; k < 3; ++k) {
+            corners[k] = has_indices ? read_gltf_index(&indices, t + k) : t + k;
+            if (corners[k] >= positions.count) {
+                fprintf(stderr, "index out of range\n");
+                return false;
+            }
+        }
+        if (!push_index(mesh, corners[0]) || !push_index(mesh, corners[flip ? 2 : 1]) || !push_index(mesh, corners[flip ? 1 : 2])) {
+            return false;
+        }
+    }
+
+    submesh = &mesh->submeshes[mesh->submesh_count - 1];
+    if (!has_normals) {
+        generate_missing_normals(mesh, submesh);
+    }
+    drop_empty_submesh(mesh);
+    return true;
+}
+
+static bool cook_gltf_mesh(const Gltf *gltf, uint32_t mesh_index, const float *matrix, CookedMesh *mesh) {
+    const JsonValue *json = get_json_element(get_json_member(&gltf->root, "meshes"), mesh_index);
+    const JsonValue *primitives = get_json_member(json, "primitives");
+    if (primitives == NULL) {
+        fprintf(stderr, "mesh %u has no primitives\n", mesh_index);
+        return false;
+    }
+
+    for (uint32_t i = 0; i < primitives->child_count; ++i) {
+        if (!cook_gltf_primitive(gltf, &primitives->children[i], matrix, mesh)) { return false; }
+    }
+    return true;
+}
+
+static bool cook_gltf_node(const Gltf *gltf, uint32_t node_index, const float *parent, uint32_t depth, CookedMesh *mesh) {
+    const JsonValue *node = get_json_element(get_json_member(&gltf->root, "nodes"), node_index);
+    if (node == NULL || depth > MAX_NODE_DEPTH) {
+        fprintf(stderr, "invalid node %u\n", node_index);
+        return false;
+    }
+
+    float local[16], world[16];
+    get_node_matrix(node, local);
+    multiply_matrices(parent, local, world);
+
+    const JsonValue *mesh_index = get_json_member(node, "mesh");
+    uint32_t index;
+    if (mesh_index != NULL && (!get_json_uint(mesh_index, 0, &index) || !cook_gltf_mesh(gltf, index, world, mesh))) {
+        fprintf(stderr, "invalid mesh in node %u\n", node_index);
+        return false;
+    }
+
+    const JsonValue *children = get_json_member(node, "children");
+    for (uint32_t i = 0; children != NULL && i < children->child_count; ++i) {
+        if (!get_json_uint(&children->children[i], 0, &index)) {
+            fprintf(stderr, "invalid child in node %u\n", node_index);
+            return false;
+        }
+        if (!cook_gltf_node(gltf, index, world, depth + 1, mesh)) { return false; }
+    }
+    return true;
+}
+
+// Cooks the default scene, files without scenes cook every mesh untransformed
+static bool cook_gltf(const char *path, CookedMesh *mesh) {
+    size_t size;
+    uint8_t *file = read_file(path, &size);
+    if (file == NULL) { return false; }
+
+    const char *json_text = (const char *)file;
+    size_t json_size = size;
+    const uint8_t *bin = NULL;
+    size_t bin_size = 0;
+
+    uint32_t header[3];
+    if (size >= 12 && (memcpy(header, file, sizeof(header)), header[0] == GLB_MAGIC)) {
+        uint32_t chunk[2];
+        size_t offset = 12;
+        json_text = NULL;
+        while (offset + 8 <= size) {
+            memcpy(chunk, file + offset, sizeof(chunk));
+            offset += 8;
+            if (chunk[0] > size - offset) { break; }
+            if (chunk[1] == GLB_CHUNK_JSON) {
+                json_text = (const char *)file + offset;
+                json_size = chunk[0];
+            } else if (chunk[1] == GLB_CHUNK_BIN) {
+                bin = file + offset;
+                bin_size = chunk[0];
+            }
+            offset += align_up(chunk[0], 4);
+        }
+        if (json_text == NULL) {
+            fprintf(stderr, "GLB without a JSON chunk: %s\n", path);
+            free(file);
+            return false;
+        }
+    }
+
+    Gltf gltf;
+    memset(&gltf, 0, sizeof(Gltf));
+
+    // Copied so the text is zero terminated for strtod
+    char *text = malloc(json_size + 1);
+    bool success = text != NULL;
+    if (success) {
+        memcpy(text, json_text, json_size);
+        text[json_size] = '\0';
+        JsonParser parser = { text, text + json_size };
+        success = parse_json_value(&parser, &gltf.root, 0) && gltf.root.type == JSON_OBJECT;
+        if (!success) {
+            fprintf(stderr, "failed to parse glTF JSON: %s\n", path);
+        }
+    }
+
+    const JsonValue *buffers = get_json_member(&gltf.root, "buffers");
+    if (success && buffers != NULL) {
+        gltf.buffers = calloc(buffers->child_count, sizeof(GltfBuffer));
+        success = gltf.buffers != NULL;
+        for (uint32_t i = 0; success && i < buffers->child_count; ++i) {
+            success = load_gltf_buffer(path, &buffers->children[i], bin, bin_size, &gltf.buffers[i]);
+            gltf.buffer_count += success ? 1 : 0;
+        }
+    }
+
+    static const float IDENTITY[16] = { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
+    const JsonValue *scenes = get_json_member(&gltf.root, "scenes");
+    uint32_t scene_index = 0;
+    if (success && !get_json_uint(get_json_member(&gltf.root, "scene"), 0, &scene_index)) {
+        fprintf(stderr, "invalid default scene: %s\n", path);
+        success = false;
+    }
+    const JsonValue *scene = get_json_element(scenes, scene_index);
+    if (success && scene != NULL) {
+        const JsonValue *nodes = get_json_member(scene, "nodes");
+        for (uint32_t i = 0; success && nodes != NULL && i < nodes->child_count; ++i) {
+            uint32_t node_index;
+            success = get_json_uint(&nodes->children[i], 0, &node_index) && cook_gltf_node(&gltf, node_index, IDENTITY, 0, mesh);
+        }
+    } else if (success) {
+        const JsonValue *meshes = get_json_member(&gltf.root, "meshes");
+        for (uint32_t i = 0; success && meshes != NULL && i < meshes->child_count; ++i) {
+            success = cook_gltf_mesh(&gltf, i, IDENTITY, mesh);
+        }
+    }
+
+    for (uint32_t i = 0; i < gltf.buffer_count; ++i) {
+        free(gltf.buffers[i].owned);
+    }
+    free(gltf.buffers);
+    free_json_value(&gltf.root);
+    free(text);
+    free(file);
+    return success;
+}
+
+/*
+* Optimization
+*/
+static void add_cache_stats(VertexCacheStats *total, const VertexCacheStats *stats) {
+    total->triangle_count += stats->triangle_count;
+    total->vertex_count += stats->vertex_count;
+    total->cache_misses += stats->cache_misses;
+}
+
+// Submeshes are optimized independently and their vertices compacted, unreferenced ones are dropped
+static bool optimize_mesh(CookedMesh *mesh) {
+    uint32_t *cluster_starts = malloc((mesh->index_count / 3 + 1) * sizeof(uint32_t));
+    if (cluster_starts == NULL) { return false; }
+
+    VertexCacheStats before, after;
+    memset(&before, 0, sizeof(VertexCacheStats));
+    memset(&after, 0, sizeof(VertexCacheStats));
+
+    bool optimized = true;
+    uint32_t vertex_count = 0;
+    for (uint32_t i = 0; optimized && i < mesh->submesh_count; ++i) {
+        MeshFileSubmesh *submesh = &mesh->submeshes[i];
+        uint32_t *indices = &mesh->indices[submesh->first_index];
+        MeshVertex *vertices = &mesh->vertices[submesh->first_vertex];
+
+        VertexCacheStats stats = analyze_vertex_cache(indices, submesh->index_count, submesh->vertex_count);
+        add_cache_stats(&before, &stats);
+
+        uint32_t cluster_count = 0;
+        uint32_t used_count = 0;
+        optimized = optimize_vertex_cache(indices, submesh->index_count, submesh->vertex_count, cluster_starts, &cluster_count)
+            && optimize_overdraw(indices, submesh->index_count, vertices, submesh->vertex_count,
+                cluster_starts, cluster_count, OVERDRAW_THRESHOLD)
+            && optimize_vertex_fetch(indices, submesh->index_count, vertices, submesh->vertex_count, &used_count);
+        if (!optimized) { break; }
+
+        memmove(&mesh->vertices[vertex_count], vertices, used_count * sizeof(MeshVertex));
+        submesh->first_vertex = vertex_count;
+        submesh->vertex_count = used_count;
+        vertex_count += used_count;
+
+        stats = analyze_vertex_cache(indices, submesh->index_count, submesh->vertex_count);
+        add_cache_stats(&after, &stats);
+    }
+    free(cluster_starts);
+
+    if (!optimized) {
+        fprintf(stderr, "failed to optimize mesh\n");
+        return false;
+    }
+
+    mesh->vertex_count = vertex_count;
+    printf("Vertex cache (%u entries): ACMR %.3f -> %.3f, ATVR %.3f -> %.3f\n", VERTEX_CACHE_SIZE,
+        get_acmr(&before), get_acmr(&after), get_atvr(&before), get_atvr(&after));
+    return true;
+}
+
+static bool build_mesh_meshlets(CookedMesh *mesh) {
+    mesh->meshlets = malloc((mesh->index_count / 3 + 1) * sizeof(MeshFileMeshlet));
+    if (mesh->meshlets == NULL) { return false; }
+
+    uint32_t vertex_sum = 0;
+    for (uint32_t i = 0; i < mesh->submesh_count; ++i) {
+        MeshFileSubmesh *submesh = &mesh->submeshes[i];
+        MeshFileMeshlet *meshlets = &mesh->meshlets[mesh->meshlet_count];
+        submesh->first_meshlet = mesh->meshlet_count;
+        submesh->meshlet_count = build_meshlets(&mesh->indices[submesh->first_index], submesh->index_count,
+            &mesh->vertices[submesh->first_vertex], submesh->vertex_count, meshlets);
+
+        for (uint32_t j = 0; j < submesh->meshlet_count; ++j) {
+            meshlets[j].first_index += submesh->first_index;
+            meshlets[j].first_vertex = submesh->first_vertex;
+            meshlets[j].submesh = i;
+            vertex_sum += meshlets[j].vertex_count;
+        }
+        mesh->meshlet_count += submesh->meshlet_count;
+    }
+
+    if (mesh->meshlet_count > 0) {
+        printf("Built %u meshlets, %.1f triangles and %.1f vertices each on average\n", mesh->meshlet_count,
+            mesh->index_count / 3.0f / mesh->meshlet_count, (float)vertex_sum / mesh->meshlet_count);
+    }
+    return true;
+}
+
+/*
+* Quantization
+*/
+static int16_t quantize_snorm16(float value) {
+    value = fminf(fmaxf(value, -1.0f), 1.0f);
+    return (int16_t)lroundf(value * INT16_MAX);
+}
+
+static uint16_t quantize_unorm16(float value) {
+    value = fminf(fmaxf(value, 0.0f), 1.0f);
+    return (uint16_t)lroundf(value * UINT16_MAX);
+}
+
+// Projects onto the octahedron and folds the lower half over, decoded by the vertex shader
+static void encode_octahedral(const float *n, int16_t *encoded) {
+    float length = fabsf(n[0]) + fabsf(n[1]) + fabsf(n[2]);
+    float x = length > 0.0f ? n[0] / length : 0.0f;
+    float y = length > 0.0f ? n[1] / length : 0.0f;
+    if (n[2] < 0.0f) {
+        float folded_x = (1.0f - fabsf(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+        float folded_y = (1.0f - fabsf(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+        x = folded_x;
+        y = folded_y;
+    }
+    encoded[0] = quantize_snorm16(x);
+    encoded[1] = quantize_snorm16(y);
+}
+
+// Positions span the mesh bounds and uvs their own range, so repeating uvs survive UNORM16
+static void compute_dequantization(const CookedMesh *mesh, MeshFileHeader *header) {
+    float uv_min[2] = { FLT_MAX, FLT_MAX };
+    float uv_max[2] = { -FLT_MAX, -FLT_MAX };
+    for (uint32_t i = 0; i < mesh->vertex_count; ++i) {
+        for (uint32_t k = 0; k < 2; ++k) {
+            uv_min[k] = fminf(uv_min[k], mesh->vertices[i].uv[k]);
+            uv_max[k] = fmaxf(uv_max[k], mesh->vertices[i].uv[k]);
+        }
+    }
+
+    for (uint32_t k = 0; k < 3; ++k) {
+        float half = (header->bounds_max[k] - header->bounds_min[k]) * 0.5f;
+        header->position_scale[k] = half > 0.0f ? half : 1.0f;
+        header->position_offset[k] = (header->bounds_min[k] + header->bounds_max[k]) * 0.5f;
+    }
+    for (uint32_t k = 0; k < 2; ++k) {
+        float range = uv_max[k] - uv_min[k];
+        header->uv_scale[k] = range > 0.0f ? range : 1.0f;
+        header->uv_offset[k] = uv_min[k];
+    }
+}
+
+static MeshQuantizedVertex *quantize_vertices(const CookedMesh *mesh, const MeshFileHeader *header, float *max_error) {
+    MeshQuantizedVertex *quantized = malloc((size_t)mesh->vertex_count * sizeof(MeshQuantizedVertex));
+    if (quantized == NULL) { return NULL; }
+
+    *max_error = 0.0f;
+    for (uint32_t i = 0; i < mesh->vertex_count; ++i) {
+        const MeshVertex *vertex = &mesh->vertices[i];
+        MeshQuantizedVertex *out = &quantized[i];
+        for (uint32_t k = 0; k < 3; ++k) {
+            out->position[k] = quantize_snorm16((vertex->position[k] - header->position_offset[k]) / header->position_scale[k]);
+            float decoded = out->position[k] / (float)INT16_MAX * header->position_scale[k] + header->position_offset[k];
+            *max_error = fmaxf(*max_error, fabsf(decoded - vertex->position[k]));
+        }
+        out->position[3] = 0;
+        encode_octahedral(vertex->normal, out->normal);
+        for (uint32_t k = 0; k < 2; ++k) {
+            out->uv[k] = quantize_unorm16((vertex->uv[k] - header->uv_offset[k]) / header->uv_scale[k]);
+        }
+    }
+    return quantized;
+}
+
+/*
+* Output
+*/
+static bool write_padding(FILE *fp, uint64_t *position, uint64_t offset) {
+    static const uint8_t padding[MESH_FILE_ALIGNMENT] = {0};
+    size_t pad = (size_t)(offset - *position);
+    *position = offset;
+    return fwrite(padding, 1, pad, fp) == pad;
+}
+
+static bool write_mesh_file(const char *path, CookedMesh *mesh, MeshVertexFormat vertex_format) {
+    MeshFileHeader header;
+    memset(&header, 0, sizeof(MeshFileHeader));
+    header.magic = MESH_FILE_MAGIC;
+    header.version = MESH_FILE_VERSION;
+    header.vertex_format = vertex_format;
+    header.vertex_stride = vertex_format == MESH_VERTEX_FORMAT_QUANTIZED ? sizeof(MeshQuantizedVertex) : sizeof(MeshVertex);
+    header.vertex_count = mesh->vertex_count;
+    header.index_count = mesh->index_count;
+    header.submesh_count = mesh->submesh_count;
+
+    // 16 bit indices whenever every submesh fits, which is what first_vertex is for
+    header.index_size = MESH_INDEX_SIZE_16;
+    for (uint32_t k = 0; k < 3; ++k) {
+        header.bounds_min[k] = FLT_MAX;
+        header.bounds_max[k] = -FLT_MAX;
+    }
+    for (uint32_t i = 0; i < mesh->submesh_count; ++i) {
+        MeshFileSubmesh *submesh = &mesh->submeshes[i];
+        compute_bounds(mesh, submesh);
+        for (uint32_t k = 0; k < 3; ++k) {
+            header.bounds_min[k] = fminf(header.bounds_min[k], submesh->bounds_min[k]);
+            header.bounds_max[k] = fmaxf(header.bounds_max[k], submesh->bounds_max[k]);
+        }
+        if (submesh->vertex_count > UINT16_MAX + 1) {
+            header.index_size = MESH_INDEX_SIZE_32;
+        }
+    }
+
+    const void *vertices = mesh->vertices;
+    MeshQuantizedVertex *quantized = NULL;
+    float max_error = 0.0f;
+    if (vertex_format == MESH_VERTEX_FORMAT_QUANTIZED) {
+        compute_dequantization(mesh, &header);
+        quantized = quantize_vertices(mesh, &header, &max_error);
+        if (quantized == NULL) {
+            fprintf(stderr, "failed to quantize vertices\n");
+            return false;
+        }
+        vertices = quantized;
+    } else {
+        for (uint32_t k = 0; k < 3; ++k) {
+            header.position_scale[k] = 1.0f;
+        }
+        header.uv_scale[0] = 1.0f;
+        header.uv_scale[1] = 1.0f;
+    }
+
+    header.meshlet_count = mesh->meshlet_count;
+    header.submesh_offset = sizeof(MeshFileHeader);
+    header.meshlet_offset = header.submesh_offset + (uint64_t)mesh->submesh_count * sizeof(MeshFileSubmesh);
+    header.vertex_offset = align_up(header.meshlet_offset + (uint64_t)mesh->meshlet_count * sizeof(MeshFileMeshlet), MESH_FILE_ALIGNMENT);
+    header.vertex_bytes = (uint64_t)mesh->vertex_count * header.vertex_stride;
+    header.index_offset = align_up(header.vertex_offset + header.vertex_bytes, MESH_FILE_ALIGNMENT);
+    header.index_bytes = (uint64_t)mesh->index_count * header.index_size;
+
+    FILE *fp = fopen(path, "wb");
+    if (fp == NULL) {
+        fprintf(stderr, "failed to open output: %s\n", path);
+        free(quantized);
+        return false;
+    }
+
+    uint64_t position = header.meshlet_offset + (uint64_t)mesh->meshlet_count * sizeof(MeshFileMeshlet);
+    bool written = fwrite(&header, sizeof(MeshFileHeader), 1, fp) == 1
+        && fwrite(mesh->submeshes, sizeof(MeshFileSubmesh), mesh->submesh_count, fp) == mesh->submesh_count
+        && (mesh->meshlet_count == 0 || fwrite(mesh->meshlets, sizeof(MeshFileMeshlet), mesh->meshlet_count, fp) == mesh->meshlet_count)
+        && write_padding(fp, &position, header.vertex_offset)
+        && fwrite(vertices, header.vertex_stride, mesh->vertex_count, fp) == mesh->vertex_count;
+    free(quantized);
+
+    position = header.vertex_offset + header.vertex_bytes;
+    written = written && write_padding(fp, &position, header.index_offset);
+    if (written && header.index_size == MESH_INDEX_SIZE_16) {
+        for (uint32_t i = 0; written && i < mesh->index_count; ++i) {
+            uint16_t index = (uint16_t)mesh->indices[i];
+            written = fwrite(&index, sizeof(uint16_t), 1, fp) == 1;
+        }
+    } else if (written) {
+        written = fwrite(mesh->indices, sizeof(uint32_t), mesh->index_count, fp) == mesh->index_count;
+    }
+
+    fclose(fp);
+    if (!written) {
+        fprintf(stderr, "failed to write mesh: %s\n", path);
+        remove(path);
+        return false;
+    }
+
+    printf("Cooked %u vertices, %u indices, %u submeshes into %s\n", mesh->vertex_count, mesh->index_count, mesh->submesh_count, path);
+    if (vertex_format == MESH_VERTEX_FORMAT_QUANTIZED) {
+        printf("Quantized to %u bytes per vertex, max position error %g\n", header.vertex_stride, max_error);
+    }
+    return true;
+}
+
+static void print_usage(const char *program) {
+    fprintf(stderr, "usage: %s [--float] [--no-optimize] [--meshlets] <output.mesh> <input.obj|input.gltf|input.glb>\n", program);
+}
+
+int main(int argc, char **argv) {
+    MeshVertexFormat vertex_format = MESH_VERTEX_FORMAT_QUANTIZED;
+    bool optimize = true;
+    bool meshlets = false;
+    int first_arg = 1;
+    for (; first_arg < argc && strncmp(argv[first_arg], "--", 2) == 0; ++first_arg) {
+        if (strcmp(argv[first_arg], "--float") == 0) {
+            vertex_format = MESH_VERTEX_FORMAT_FLOAT;
+        } else if (strcmp(argv[first_arg], "--no-optimize") == 0) {
+            optimize = false;
+        } else if (strcmp(argv[first_arg], "--meshlets") == 0) {
+            meshlets = true;
+        } else {
+            fprintf(stderr, "unknown option: %s\n", argv[first_arg]);
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+    if (argc - first_arg != 2) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    CookedMesh mesh;
+    memset(&mesh, 0, sizeof(CookedMesh));
+
+    const char *output = argv[first_arg];
+    const char *input = argv[first_arg + 1];
+    bool cooked;
+    if (has_extension(input, ".obj")) {
+        cooked = cook_obj(input, &mesh);
+    } else if (has_extension(input, ".gltf") || has_extension(input, ".glb")) {
+        cooked = cook_gltf(input, &mesh);
+    } else {
+        fprintf(stderr, "unsupported mesh format: %s\n", input);
+        return 1;
+    }
+
+    cooked = cooked && mesh.index_count > 0;
+    cooked = cooked && (!optimize || optimize_mesh(&mesh));
+    cooked = cooked && (!meshlets || build_mesh_meshlets(&mesh));
+    bool written = cooked && write_mesh_file(output, &mesh, vertex_format);
+    if (!cooked) {
+        fprintf(stderr, "failed to cook mesh: %s\n", input);
+    }
+    free(mesh.vertices);
+    free(mesh.indices);
+    free(mesh.submeshes);
+    free(mesh.meshlets);
+    return written ? 0 : 1;
+}
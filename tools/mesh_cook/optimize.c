@@ -0,0 +1,462 @@
+#include "optimize.h"
+
+#include <float.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NO_VERTEX UINT32_MAX
+
+/*
+* Utilities
+*/
+static void subtract3(const float *a, const float *b, float *out) {
+    out[0] = a[0] - b[0];
+    out[1] = a[1] - b[1];
+    out[2] = a[2] - b[2];
+}
+
+static void cross3(const float *a, const float *b, float *out) {
+    out[0] = a[1] * b[2] - a[2] * b[1];
+    out[1] = a[2] * b[0] - a[0] * b[2];
+    out[2] = a[0] * b[1] - a[1] * b[0];
+}
+
+static float dot3(const float *a, const float *b) {
+    return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+static float normalize3(float *v) {
+    float length = sqrtf(dot3(v, v));
+    if (length > 0.0f) {
+        v[0] /= length;
+        v[1] /= length;
+        v[2] /= length;
+    }
+    return length;
+}
+
+// Unnormalized, its length is twice the triangle's area
+static void get_face_normal(const uint32_t *triangle, const MeshVertex *vertices, float *normal) {
+    float ab[3], ac[3];
+    subtract3(vertices[triangle[1]].position, vertices[triangle[0]].position, ab);
+    subtract3(vertices[triangle[2]].position, vertices[triangle[0]].position, ac);
+    cross3(ab, ac, normal);
+}
+
+/*
+* Vertex cache analysis
+*/
+// FIFO cache, a vertex is resident while fewer than VERTEX_CACHE_SIZE misses happened since it was loaded.
+// Bumping time past the cache size flushes it without touching the timestamps
+static uint32_t simulate_triangle(const uint32_t *triangle, uint32_t *cache_time, uint32_t *time) {
+    uint32_t misses = 0;
+    for (uint32_t k = 0; k < 3; ++k) {
+        uint32_t v = triangle[k];
+        if (*time - cache_time[v] > VERTEX_CACHE_SIZE) {
+            cache_time[v] = (*time)++;
+            ++misses;
+        }
+    }
+    return misses;
+}
+
+VertexCacheStats analyze_vertex_cache(const uint32_t *indices, uint32_t index_count, uint32_t vertex_count) {
+    VertexCacheStats stats;
+    memset(&stats, 0, sizeof(VertexCacheStats));
+    stats.triangle_count = index_count / 3;
+
+    uint32_t *cache_time = calloc(vertex_count, sizeof(uint32_t));
+    if (cache_time == NULL) { return stats; }
+
+    uint32_t time = VERTEX_CACHE_SIZE + 1;
+    for (uint32_t i = 0; i + 2 < index_count; i += 3) {
+        stats.cache_misses += simulate_triangle(&indices[i], cache_time, &time);
+    }
+
+    // Anything ever loaded has a timestamp
+    for (uint32_t i = 0; i < vertex_count; ++i) {
+        stats.vertex_count += cache_time[i] != 0 ? 1 : 0;
+    }
+    free(cache_time);
+    return stats;
+}
+
+float get_acmr(const VertexCacheStats *stats) {
+    return stats->triangle_count > 0 ? (float)stats->cache_misses / stats->triangle_count : 0.0f;
+}
+
+float get_atvr(const VertexCacheStats *stats) {
+    return stats->vertex_count > 0 ? (float)stats->cache_misses / stats->vertex_count : 0.0f;
+}
+
+/*
+* Vertex cache optimization
+*/
+// Tipsify (Sander, Nehab and Barczak 2007), fans around one vertex at a time and moves on to the
+// candidate that stays resident longest, falling back to recently used vertices at dead ends
+bool optimize_vertex_cache(uint32_t *indices, uint32_t index_count, uint32_t vertex_count,
+    uint32_t *cluster_starts, uint32_t *cluster_count) {
+    uint32_t triangle_count = index_count / 3;
+    *cluster_count = 0;
+    if (triangle_count == 0) { return true; }
+
+    uint32_t *offsets = calloc(vertex_count + 1, sizeof(uint32_t));
+    uint32_t *adjacency = malloc(triangle_count * 3 * sizeof(uint32_t));
+    uint32_t *live = calloc(vertex_count, sizeof(uint32_t));
+    uint32_t *cache_time = calloc(vertex_count, sizeof(uint32_t));
+    uint32_t *dead_ends = malloc(triangle_count * 3 * sizeof(uint32_t));
+    uint32_t *output = malloc(triangle_count * 3 * sizeof(uint32_t));
+    bool *emitted = calloc(triangle_count, sizeof(bool));
+    bool allocated = offsets != NULL && adjacency != NULL && live != NULL && cache_time != NULL
+        && dead_ends != NULL && output != NULL && emitted != NULL;
+
+    if (allocated) {
+        // Triangles around each vertex, the cache timestamps double as fill cursors
+        for (uint32_t i = 0; i < triangle_count * 3; ++i) {
+            live[indices[i]]++;
+        }
+        for (uint32_t v = 0; v < vertex_count; ++v) {
+            offsets[v + 1] = offsets[v] + live[v];
+            cache_time[v] = offsets[v];
+        }
+        for (uint32_t i = 0; i < triangle_count * 3; ++i) {
+            adjacency[cache_time[indices[i]]++] = i / 3;
+        }
+        memset(cache_time, 0, vertex_count * sizeof(uint32_t));
+
+        uint32_t time = VERTEX_CACHE_SIZE + 1;
+        uint32_t cursor = 0;
+        uint32_t stack_size = 0;
+        uint32_t output_count = 0;
+        uint32_t fan = NO_VERTEX;
+        while (cursor < vertex_count && fan == NO_VERTEX) {
+            fan = live[cursor] > 0 ? cursor : NO_VERTEX;
+            ++cursor;
+        }
+        cluster_starts[(*cluster_count)++] = 0;
+
+        while (fan != NO_VERTEX) {
+            // Vertices of the triangles emitted around the fan are the next candidates
+            uint32_t candidates = stack_size;
+            for (uint32_t j = offsets[fan]; j < offsets[fan + 1]; ++j) {
+                uint32_t t = adjacency[j];
+                if (emitted[t]) { continue; }
+
+                for (uint32_t k = 0; k < 3; ++k) {
+                    uint32_t v = indices[t * 3 + k];
+                    output[output_count++] = v;
+                    dead_ends[stack_size++] = v;
+                    live[v]--;
+                    if (time - cache_time[v] > VERTEX_CACHE_SIZE) {
+                        cache_time[v] = time++;
+                    }
+                }
+                emitted[t] = true;
+            }
+
+            // Oldest candidate that is still resident after its remaining triangles are emitted
+            uint32_t next = NO_VERTEX;
+            int64_t best_priority = -1;
+            for (uint32_t j = candidates; j < stack_size; ++j) {
+                uint32_t v = dead_ends[j];
+                if (live[v] == 0) { continue; }
+
+                int64_t priority = 0;
+                if (time - cache_time[v] + 2 * live[v] <= VERTEX_CACHE_SIZE) {
+                    priority = time - cache_time[v];
+                }
+                if (priority > best_priority) {
+                    best_priority = priority;
+                    next = v;
+                }
+            }
+
+            // Dead end, the cache is effectively cold from here which starts a new cluster
+            if (next == NO_VERTEX) {
+                while (stack_size > 0 && next == NO_VERTEX) {
+                    uint32_t v = dead_ends[--stack_size];
+                    next = live[v] > 0 ? v : NO_VERTEX;
+                }
+                while (cursor < vertex_count && next == NO_VERTEX) {
+                    next = live[cursor] > 0 ? cursor : NO_VERTEX;
+                    ++cursor;
+                }
+                if (next != NO_VERTEX) {
+                    cluster_starts[(*cluster_count)++] = output_count / 3;
+                }
+            }
+            fan = next;
+        }
+        memcpy(indices, output, output_count * sizeof(uint32_t));
+    }
+
+    free(offsets);
+    free(adjacency);
+    free(live);
+    free(cache_time);
+    free(dead_ends);
+    free(output);
+    free(emitted);
+    return allocated;
+}
+
+/*
+* Overdraw optimization
+*/
+typedef struct {
+    uint32_t first_triangle;
+    uint32_t triangle_count;
+    float sort_key;
+} OverdrawCluster;
+
+// Outward facing clusters first, so they occlude what is drawn after them
+static int compare_overdraw_clusters(const void *a, const void *b) {
+    const OverdrawCluster *left = a;
+    const OverdrawCluster *right = b;
+    if (left->sort_key != right->sort_key) {
+        return left->sort_key > right->sort_key ? -1 : 1;
+    }
+    return left->first_triangle < right->first_triangle ? -1 : 1;
+}
+
+// Area weighted centroid and normal sum of a triangle range
+static void get_cluster_centroid(const uint32_t *indices, uint32_t triangle_count, const MeshVertex *vertices,
+    float *centroid, float *normal) {
+    float area_sum = 0.0f;
+    memset(centroid, 0, 3 * sizeof(float));
+    memset(normal, 0, 3 * sizeof(float));
+    for (uint32_t t = 0; t < triangle_count; ++t) {
+        const uint32_t *triangle = &indices[t * 3];
+        float face[3];
+        get_face_normal(triangle, vertices, face);
+        float area = sqrtf(dot3(face, face));
+        for (uint32_t k = 0; k < 3; ++k) {
+            float center = (vertices[triangle[0]].position[k] + vertices[triangle[1]].position[k] + vertices[triangle[2]].position[k]) / 3.0f;
+            centroid[k] += center * area;
+            normal[k] += face[k];
+        }
+        area_sum += area;
+    }
+
+    for (uint32_t k = 0; k < 3 && area_sum > 0.0f; ++k) {
+        centroid[k] /= area_sum;
+    }
+}
+
+// Linear-speed overdraw ordering from the Tipsify paper. Clusters whose ACMR stays within the threshold
+// are split further, then every cluster is sorted by how far it faces away from the mesh centroid
+bool optimize_overdraw(uint32_t *indices, uint32_t index_count, const MeshVertex *vertices, uint32_t vertex_count,
+    const uint32_t *cluster_starts, uint32_t cluster_count, float threshold) {
+    uint32_t triangle_count = index_count / 3;
+    if (triangle_count == 0 || cluster_count == 0) { return true; }
+
+    OverdrawCluster *clusters = malloc(triangle_count * sizeof(OverdrawCluster));
+    uint32_t *cache_time = calloc(vertex_count, sizeof(uint32_t));
+    uint32_t *reordered = malloc(triangle_count * 3 * sizeof(uint32_t));
+    if (clusters == NULL || cache_time == NULL || reordered == NULL) {
+        free(clusters);
+        free(cache_time);
+        free(reordered);
+        return false;
+    }
+
+    uint32_t time = VERTEX_CACHE_SIZE + 1;
+    uint32_t split_count = 0;
+    for (uint32_t c = 0; c < cluster_count; ++c) {
+        uint32_t begin = cluster_starts[c];
+        uint32_t end = c + 1 < cluster_count ? cluster_starts[c + 1] : triangle_count;
+
+        uint32_t cluster_misses = 0;
+        time += VERTEX_CACHE_SIZE + 1;
+        for (uint32_t t = begin; t < end; ++t) {
+            cluster_misses += simulate_triangle(&indices[t * 3], cache_time, &time);
+        }
+        float cluster_threshold = threshold * cluster_misses / (float)(end - begin);
+
+        // Each split starts on a cold cache, so only split once the run so far has paid that back
+        uint32_t split_begin = begin;
+        uint32_t split_misses = 0;
+        time += VERTEX_CACHE_SIZE + 1;
+        for (uint32_t t = begin; t < end; ++t) {
+            split_misses += simulate_triangle(&indices[t * 3], cache_time, &time);
+            if (t + 1 == end || split_misses <= cluster_threshold * (t + 1 - split_begin)) {
+                clusters[split_count].first_triangle = split_begin;
+                clusters[split_count].triangle_count = t + 1 - split_begin;
+                ++split_count;
+                split_begin = t + 1;
+                split_misses = 0;
+                time += VERTEX_CACHE_SIZE + 1;
+            }
+        }
+    }
+
+    float mesh_centroid[3], mesh_normal[3];
+    get_cluster_centroid(indices, triangle_count, vertices, mesh_centroid, mesh_normal);
+    for (uint32_t c = 0; c < split_count; ++c) {
+        OverdrawCluster *cluster = &clusters[c];
+        float centroid[3], normal[3], offset[3];
+        get_cluster_centroid(&indices[cluster->first_triangle * 3], cluster->triangle_count, vertices, centroid, normal);
+        normalize3(normal);
+        subtract3(centroid, mesh_centroid, offset);
+        cluster->sort_key = dot3(offset, normal);
+    }
+    qsort(clusters, split_count, sizeof(OverdrawCluster), compare_overdraw_clusters);
+
+    uint32_t written = 0;
+    for (uint32_t c = 0; c < split_count; ++c) {
+        memcpy(&reordered[written], &indices[clusters[c].first_triangle * 3], clusters[c].triangle_count * 3 * sizeof(uint32_t));
+        written += clusters[c].triangle_count * 3;
+    }
+    memcpy(indices, reordered, written * sizeof(uint32_t));
+
+    free(clusters);
+    free(cache_time);
+    free(reordered);
+    return true;
+}
+
+/*
+* Vertex fetch optimization
+*/
+bool optimize_vertex_fetch(uint32_t *indices, uint32_t index_count, MeshVertex *vertices, uint32_t vertex_count,
+    uint32_t *used_count) {
+    uint32_t *remap = malloc(vertex_count * sizeof(uint32_t));
+    MeshVertex *reordered = malloc(vertex_count * sizeof(MeshVertex));
+    if (remap == NULL || reordered == NULL) {
+        free(remap);
+        free(reordered);
+        return false;
+    }
+
+    memset(remap, 0xFF, vertex_count * sizeof(uint32_t));
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < index_count; ++i) {
+        uint32_t v = indices[i];
+        if (remap[v] == NO_VERTEX) {
+            remap[v] = count;
+            reordered[count++] = vertices[v];
+        }
+        indices[i] = remap[v];
+    }
+    memcpy(vertices, reordered, count * sizeof(MeshVertex));
+    *used_count = count;
+
+    free(remap);
+    free(reordered);
+    return true;
+}
+
+/*
+* Meshlets
+*/
+// Bounding sphere around the AABB center and a normal cone with its apex behind every triangle plane
+static void compute_meshlet_bounds(const uint32_t *indices, uint32_t index_count, const MeshVertex *vertices, MeshFileMeshlet *meshlet) {
+    float bounds_min[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+    float bounds_max[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+    for (uint32_t i = 0; i < index_count; ++i) {
+        for (uint32_t k = 0; k < 3; ++k) {
+            bounds_min[k] = fminf(bounds_min[k], vertices[indices[i]].position[k]);
+            bounds_max[k] = fmaxf(bounds_max[k], vertices[indices[i]].position[k]);
+        }
+    }
+
+    float radius = 0.0f;
+    for (uint32_t k = 0; k < 3; ++k) {
+        meshlet->center[k] = (bounds_min[k] + bounds_max[k]) * 0.5f;
+    }
+    for (uint32_t i = 0; i < index_count; ++i) {
+        float offset[3];
+        subtract3(vertices[indices[i]].position, meshlet->center, offset);
+        radius = fmaxf(radius, dot3(offset, offset));
+    }
+    meshlet->radius = sqrtf(radius);
+
+    float axis[3] = { 0.0f, 0.0f, 0.0f };
+    for (uint32_t t = 0; t + 2 < index_count; t += 3) {
+        float normal[3];
+        get_face_normal(&indices[t], vertices, normal);
+        if (normalize3(normal) == 0.0f) { continue; }
+        axis[0] += normal[0];
+        axis[1] += normal[1];
+        axis[2] += normal[2];
+    }
+    normalize3(axis);
+
+    float min_dot = 1.0f;
+    for (uint32_t t = 0; t + 2 < index_count; t += 3) {
+        float normal[3];
+        get_face_normal(&indices[t], vertices, normal);
+        if (normalize3(normal) == 0.0f) { continue; }
+        min_dot = fminf(min_dot, dot3(axis, normal));
+    }
+
+    // Wider than ~84 degrees the cone would almost never cull, a zero axis never passes the test
+    if (min_dot <= 0.1f) {
+        memset(meshlet->cone_axis, 0, sizeof(meshlet->cone_axis));
+        memcpy(meshlet->cone_apex, meshlet->center, sizeof(meshlet->cone_apex));
+        meshlet->cone_cutoff = 1.0f;
+        return;
+    }
+
+    // Pull the apex back along the axis until it is behind every triangle plane
+    float max_t = 0.0f;
+    for (uint32_t t = 0; t + 2 < index_count; t += 3) {
+        float normal[3], offset[3];
+        get_face_normal(&indices[t], vertices, normal);
+        if (normalize3(normal) == 0.0f) { continue; }
+        subtract3(meshlet->center, vertices[indices[t]].position, offset);
+        max_t = fmaxf(max_t, dot3(offset, normal) / dot3(axis, normal));
+    }
+
+    for (uint32_t k = 0; k < 3; ++k) {
+        meshlet->cone_axis[k] = axis[k];
+        meshlet->cone_apex[k] = meshlet->center[k] - axis[k] * max_t;
+    }
+    meshlet->cone_cutoff = sqrtf(1.0f - min_dot * min_dot);
+}
+
+// Greedy over the optimized order, so meshlets inherit its cache locality and stay contiguous in the index stream
+uint32_t build_meshlets(const uint32_t *indices, uint32_t index_count, const MeshVertex *vertices, uint32_t vertex_count,
+    MeshFileMeshlet *meshlets) {
+    uint32_t *owner = calloc(vertex_count, sizeof(uint32_t));
+    if (owner == NULL) { return 0; }
+
+    uint32_t meshlet_count = 0;
+    uint32_t first_index = 0;
+    uint32_t meshlet_vertices = 0;
+    for (uint32_t i = 0; i + 2 < index_count; i += 3) {
+        // Owners are meshlet index + 1, zero is unowned
+        uint32_t a = indices[i], b = indices[i + 1], c = indices[i + 2];
+        uint32_t id = meshlet_count + 1;
+        uint32_t added = (owner[a] != id) + (owner[b] != id && b != a) + (owner[c] != id && c != a && c != b);
+        if (meshlet_vertices + added > MESHLET_MAX_VERTICES || (i - first_index) / 3 >= MESHLET_MAX_TRIANGLES) {
+            MeshFileMeshlet *meshlet = &meshlets[meshlet_count++];
+            memset(meshlet, 0, sizeof(MeshFileMeshlet));
+            meshlet->first_index = first_index;
+            meshlet->index_count = i - first_index;
+            meshlet->vertex_count = meshlet_vertices;
+            compute_meshlet_bounds(&indices[first_index], meshlet->index_count, vertices, meshlet);
+
+            id = meshlet_count + 1;
+            first_index = i;
+            meshlet_vertices = 0;
+            added = 1 + (b != a) + (c != a && c != b);
+        }
+
+        owner[a] = owner[b] = owner[c] = id;
+        meshlet_vertices += added;
+    }
+
+    if (index_count - first_index >= 3) {
+        MeshFileMeshlet *meshlet = &meshlets[meshlet_count++];
+        memset(meshlet, 0, sizeof(MeshFileMeshlet));
+        meshlet->first_index = first_index;
+        meshlet->index_count = (index_count - first_index) / 3 * 3;
+        meshlet->vertex_count = meshlet_vertices;
+        compute_meshlet_bounds(&indices[first_index], meshlet->index_count, vertices, meshlet);
+    }
+
+    free(owner);
+    return meshlet_count;
+}
@@ -0,0 +1,46 @@
+#ifndef MESH_COOK_OPTIMIZE_H
+#define MESH_COOK_OPTIMIZE_H
+
+// Index and vertex reordering for one submesh, indices are relative to its first vertex
+
+#include "renderer/mesh_format.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Small enough to hold on every GPU's post-transform cache
+#define VERTEX_CACHE_SIZE 16
+
+// Overdraw ordering may cost this much extra ACMR per cluster
+#define OVERDRAW_THRESHOLD 1.05f
+
+typedef struct {
+    uint32_t triangle_count;
+    uint32_t vertex_count; // vertices referenced by the indices
+    uint32_t cache_misses;
+} VertexCacheStats;
+
+// Average cache miss ratio, transformed vertices per triangle (0.5 is ideal for large grids)
+// and per referenced vertex (1.0 is ideal)
+VertexCacheStats analyze_vertex_cache(const uint32_t *indices, uint32_t index_count, uint32_t vertex_count);
+float get_acmr(const VertexCacheStats *stats);
+float get_atvr(const VertexCacheStats *stats);
+
+// Tipsify, writes the first triangle of every cluster it had to restart from a dead end
+bool optimize_vertex_cache(uint32_t *indices, uint32_t index_count, uint32_t vertex_count,
+    uint32_t *cluster_starts, uint32_t *cluster_count);
+
+// Sorts clusters so outward facing ones draw first, splitting further while ACMR stays under the threshold
+bool optimize_overdraw(uint32_t *indices, uint32_t index_count, const MeshVertex *vertices, uint32_t vertex_count,
+    const uint32_t *cluster_starts, uint32_t cluster_count, float threshold);
+
+// Renumbers vertices in first use order and drops unreferenced ones from the end
+bool optimize_vertex_fetch(uint32_t *indices, uint32_t index_count, MeshVertex *vertices, uint32_t vertex_count,
+    uint32_t *used_count);
+
+// Splits the triangle order into contiguous meshlets and fills their culling bounds, meshlets must hold
+// one entry per triangle. first_index is relative to indices, first_vertex and submesh are left to the caller
+uint32_t build_meshlets(const uint32_t *indices, uint32_t index_count, const MeshVertex *vertices, uint32_t vertex_count,
+    MeshFileMeshlet *meshlets);
+
+#endif
@@ -0,0 +1,143 @@
+/*
+* Packs compiled SPIR-V into one indexed archive
+* usage: vrender_shaderpack <output.pack> <shader.spv>...
+*/
+#include "renderer/shader_pack_format.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    ShaderPackEntry entry;
+    uint8_t *code;
+} PackInput;
+
+static const char *get_base_name(const char *path) {
+    const char *name = path;
+    for (const char *c = path; *c != '\0'; ++c) {
+        if (*c == '/' || *c == '\\') {
+            name = c + 1;
+        }
+    }
+    return name;
+}
+
+static uint8_t *read_binary(const char *path, uint64_t *size) {
+    FILE *fp = fopen(path, "rb");
+    if (fp == NULL) {
+        fprintf(stderr, "failed to open file: %s\n", path);
+        return NULL;
+    }
+
+    fseek(fp, 0, SEEK_END);
+    long fsize = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    if (fsize <= 0 || fsize % sizeof(uint32_t) != 0) {
+        fprintf(stderr, "not a SPIR-V binary: %s\n", path);
+        fclose(fp);
+        return NULL;
+    }
+
+    uint8_t *buffer = malloc(fsize);
+    if (buffer == NULL || fread(buffer, 1, fsize, fp) != (size_t)fsize) {
+        fprintf(stderr, "failed to read file: %s\n", path);
+        free(buffer);
+        fclose(fp);
+        return NULL;
+    }
+
+    fclose(fp);
+    *size = (uint64_t)fsize;
+    return buffer;
+}
+
+static int compare_inputs(const void *a, const void *b) {
+    const ShaderPackEntry *entry_a = &((const PackInput *)a)->entry;
+    const ShaderPackEntry *entry_b = &((const PackInput *)b)->entry;
+    return compare_shader_pack_entries(entry_a->name_hash, entry_a->name, entry_b->name_hash, entry_b->name);
+}
+
+static uint64_t align_up(uint64_t value, uint64_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        fprintf(stderr, "usage: %s <output.pack> <shader.spv>...\n", argv[0]);
+        return 1;
+    }
+
+    uint32_t input_count = (uint32_t)(argc - 2);
+    PackInput *inputs = calloc(input_count, sizeof(PackInput));
+    if (inputs == NULL) { return 1; }
+
+    for (uint32_t i = 0; i < input_count; ++i) {
+        const char *path = argv[i + 2];
+        const char *name = get_base_name(path);
+        if (strlen(name) >= SHADER_PACK_NAME_MAX) {
+            fprintf(stderr, "shader name too long: %s\n", name);
+            return 1;
+        }
+
+        strncpy(inputs[i].entry.name, name, SHADER_PACK_NAME_MAX - 1);
+        inputs[i].entry.name_hash = hash_shader_name(name);
+        inputs[i].code = read_binary(path, &inputs[i].entry.size);
+        if (inputs[i].code == NULL) { return 1; }
+    }
+
+    qsort(inputs, input_count, sizeof(PackInput), compare_inputs);
+    for (uint32_t i = 1; i < input_count; ++i) {
+        if (compare_inputs(&inputs[i - 1], &inputs[i]) == 0) {
+            fprintf(stderr, "duplicate shader name: %s\n", inputs[i].entry.name);
+            return 1;
+        }
+    }
+
+    // Lay out aligned blobs after the entry table
+    uint64_t offset = sizeof(ShaderPackHeader) + (uint64_t)input_count * sizeof(ShaderPackEntry);
+    for (uint32_t i = 0; i < input_count; ++i) {
+        offset = align_up(offset, SHADER_PACK_ALIGNMENT);
+        inputs[i].entry.offset = offset;
+        offset += inputs[i].entry.size;
+    }
+
+    FILE *fp = fopen(argv[1], "wb");
+    if (fp == NULL) {
+        fprintf(stderr, "failed to open output: %s\n", argv[1]);
+        return 1;
+    }
+
+    ShaderPackHeader header;
+    header.magic = SHADER_PACK_MAGIC;
+    header.version = SHADER_PACK_VERSION;
+    header.entry_count = input_count;
+    header.alignment = SHADER_PACK_ALIGNMENT;
+
+    bool written = fwrite(&header, sizeof(header), 1, fp) == 1;
+    for (uint32_t i = 0; written && i < input_count; ++i) {
+        written = fwrite(&inputs[i].entry, sizeof(ShaderPackEntry), 1, fp) == 1;
+    }
+
+    static const uint8_t padding[SHADER_PACK_ALIGNMENT] = {0};
+    uint64_t position = sizeof(ShaderPackHeader) + (uint64_t)input_count * sizeof(ShaderPackEntry);
+    for (uint32_t i = 0; written && i < input_count; ++i) {
+        size_t pad = (size_t)(inputs[i].entry.offset - position);
+        written = fwrite(padding, 1, pad, fp) == pad
+            && fwrite(inputs[i].code, 1, inputs[i].entry.size, fp) == inputs[i].entry.size;
+        position = inputs[i].entry.offset + inputs[i].entry.size;
+        free(inputs[i].code);
+    }
+
+    fclose(fp);
+    free(inputs);
+    if (!written) {
+        fprintf(stderr, "failed to write shader pack: %s\n", argv[1]);
+        remove(argv[1]);
+        return 1;
+    }
+
+    printf("Packed %u shaders into %s\n", input_count, argv[1]);
+    return 0;
+}